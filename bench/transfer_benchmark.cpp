@@ -0,0 +1,611 @@
+/**
+ * @file transfer_benchmark.cpp
+ * @brief Measures SFTPTransferStrategy throughput against a throwaway sshd on loopback.
+ *
+ * The harness generates host and client keys, starts `sshd -D` on 127.0.0.1 with the internal
+ * SFTP server, and optionally routes traffic through an in-process proxy that delays every
+ * segment to emulate link latency. For each combination of artifact size, chunk size, pipeline
+ * depth, parallel streams and delay it uploads incompressible synthetic artifacts and records
+ * MiB/s and client CPU seconds per GiB. Results are written as JSON for regression tracking; the
+ * strategies' own progress lines go to stderr, so stdout carries nothing but the report.
+ *
+ * Usage:
+ *   transfer-benchmark [--sizes 64M,512M] [--chunk-sizes 32K,256K] [--pipeline 1,16]
+ *                      [--streams 1,4] [--delay-ms 0,10,50] [--repeat 3]
+ *                      [--sshd /usr/sbin/sshd] [--workdir DIR] [--output results.json]
+ */
+
+#include "backup.hpp"
+#include <json/json.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pwd.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint64_t kWarmupBytes = 64 * 1024; ///< Size of the files that open one pooled session per stream.
+
+struct Options {
+    std::vector<uint64_t> sizes{64ull << 20};
+    std::vector<uint64_t> chunkSizes{32768, 262144};
+    std::vector<uint64_t> pipelineDepths{1, 16};
+    std::vector<uint64_t> streams{1, 4};
+    std::vector<uint64_t> delaysMs{0, 10};
+    int repeat = 1;
+    std::string sshd = "/usr/sbin/sshd";
+    fs::path workdir;
+    std::string output;
+};
+
+std::expected<uint64_t, std::string> parseSize(const std::string& text) {
+    size_t consumed = 0;
+    uint64_t value = 0;
+    try {
+        value = std::stoull(text, &consumed);
+    } catch (const std::exception&) {
+        return std::unexpected(std::format("Invalid number: {}", text));
+    }
+    const std::string suffix = text.substr(consumed);
+    if (suffix == "K" || suffix == "k") {
+        value <<= 10;
+    } else if (suffix == "M" || suffix == "m") {
+        value <<= 20;
+    } else if (suffix == "G" || suffix == "g") {
+        value <<= 30;
+    } else if (!suffix.empty()) {
+        return std::unexpected(std::format("Invalid size suffix: {}", text));
+    }
+    return value;
+}
+
+std::expected<std::vector<uint64_t>, std::string> parseList(const std::string& text) {
+    std::vector<uint64_t> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        auto value = parseSize(item);
+        if (!value) {
+            return std::unexpected(value.error());
+        }
+        values.push_back(*value);
+    }
+    if (values.empty()) {
+        return std::unexpected("Empty list");
+    }
+    return values;
+}
+
+std::expected<Options, std::string> parseArguments(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return std::unexpected(std::format("Missing value for {}", arg));
+        }
+        const std::string value = argv[++i];
+        std::vector<uint64_t>* list = nullptr;
+        if (arg == "--sizes") {
+            list = &options.sizes;
+        } else if (arg == "--chunk-sizes") {
+            list = &options.chunkSizes;
+        } else if (arg == "--pipeline") {
+            list = &options.pipelineDepths;
+        } else if (arg == "--streams") {
+            list = &options.streams;
+        } else if (arg == "--delay-ms") {
+            list = &options.delaysMs;
+        } else if (arg == "--repeat") {
+            options.repeat = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--sshd") {
+            options.sshd = value;
+        } else if (arg == "--workdir") {
+            options.workdir = value;
+        } else if (arg == "--output") {
+            options.output = value;
+        } else {
+            return std::unexpected(std::format("Unknown option: {}", arg));
+        }
+        if (list) {
+            auto parsed = parseList(value);
+            if (!parsed) {
+                return std::unexpected(std::format("{}: {}", arg, parsed.error()));
+            }
+            *list = std::move(*parsed);
+        }
+    }
+    return options;
+}
+
+int runCommand(const std::string& command) {
+    return std::system(command.c_str());
+}
+
+/**
+ * @brief Binds an ephemeral loopback port and returns the listening socket and port.
+ */
+std::expected<std::pair<int, int>, std::string> listenLoopback() {
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return std::unexpected(std::strerror(errno));
+    }
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), length) != 0 || ::listen(fd, 16) != 0 ||
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        const std::string error = std::strerror(errno);
+        ::close(fd);
+        return std::unexpected(error);
+    }
+    return std::make_pair(fd, static_cast<int>(ntohs(address.sin_port)));
+}
+
+std::expected<int, std::string> connectLoopback(int port) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return std::unexpected(std::strerror(errno));
+    }
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        const std::string error = std::strerror(errno);
+        ::close(fd);
+        return std::unexpected(error);
+    }
+    return fd;
+}
+
+/**
+ * @brief sshd child process with generated keys, stopped on destruction.
+ */
+class LocalSshd {
+public:
+    ~LocalSshd() {
+        if (pid_ > 0) {
+            ::kill(pid_, SIGTERM);
+            ::waitpid(pid_, nullptr, 0);
+        }
+    }
+
+    std::expected<void, std::string> start(const std::string& sshdPath, const fs::path& directory) {
+        fs::create_directories(directory);
+        const fs::path hostKey = directory / "host_ed25519";
+        const fs::path clientKey = directory / "client_ed25519";
+        for (const auto& key : {hostKey, clientKey}) {
+            fs::remove(key);
+            fs::remove(key.string() + ".pub");
+            if (runCommand(std::format("ssh-keygen -q -t ed25519 -N '' -f '{}'", key.string())) != 0) {
+                return std::unexpected("ssh-keygen failed; is OpenSSH installed?");
+            }
+        }
+        fs::copy_file(clientKey.string() + ".pub", directory / "authorized_keys", fs::copy_options::overwrite_existing);
+
+        // Reserve a free port, then hand it to sshd.
+        auto reserved = listenLoopback();
+        if (!reserved) {
+            return std::unexpected(reserved.error());
+        }
+        port_ = reserved->second;
+        ::close(reserved->first);
+
+        std::ifstream hostPub(hostKey.string() + ".pub");
+        std::getline(hostPub, hostKeyLine_);
+        knownHosts_ = directory / "known_hosts";
+        fs::remove(knownHosts_);
+        trustPort(port_);
+        identity_ = clientKey;
+
+        const fs::path config = directory / "sshd_config";
+        std::ofstream(config) << std::format(
+            "ListenAddress 127.0.0.1\nPort {}\nHostKey {}\nPidFile {}\nAuthorizedKeysFile {}\n"
+            "StrictModes no\nPasswordAuthentication no\nKbdInteractiveAuthentication no\nUsePAM no\n"
+            "Subsystem sftp internal-sftp\n",
+            port_, hostKey.string(), (directory / "sshd.pid").string(), (directory / "authorized_keys").string());
+
+        pid_ = ::fork();
+        if (pid_ < 0) {
+            return std::unexpected("fork failed");
+        }
+        if (pid_ == 0) {
+            ::execl(sshdPath.c_str(), sshdPath.c_str(), "-D", "-e", "-f", config.c_str(), static_cast<char*>(nullptr));
+            std::_Exit(127);
+        }
+
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            auto probe = connectLoopback(port_);
+            if (probe) {
+                ::close(*probe);
+                return {};
+            }
+            if (::waitpid(pid_, nullptr, WNOHANG) == pid_) {
+                pid_ = -1;
+                return std::unexpected(std::format("{} exited during startup", sshdPath));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        return std::unexpected("sshd did not start listening");
+    }
+
+    /**
+     * @brief Adds the host key for 127.0.0.1:port to known_hosts, e.g. for a proxy in front of sshd.
+     */
+    void trustPort(int port) const {
+        std::ofstream(knownHosts_, std::ios::app) << std::format("[127.0.0.1]:{} {}\n", port, hostKeyLine_);
+    }
+
+    int port() const { return port_; }
+    const fs::path& identity() const { return identity_; }
+    const fs::path& knownHosts() const { return knownHosts_; }
+
+private:
+    pid_t pid_ = -1;
+    int port_ = 0;
+    fs::path identity_;
+    fs::path knownHosts_;
+    std::string hostKeyLine_;
+};
+
+/**
+ * @brief TCP proxy on loopback that delivers each segment after a fixed one-way delay.
+ *
+ * Bandwidth is not limited, so the delay isolates the cost of round trips the way
+ * `tc qdisc ... netem delay` would, without needing root.
+ */
+class DelayProxy {
+public:
+    DelayProxy(int targetPort, std::chrono::microseconds oneWayDelay) : targetPort_(targetPort), delay_(oneWayDelay) {}
+
+    ~DelayProxy() {
+        stopping_ = true;
+        if (listenFd_ >= 0) {
+            ::shutdown(listenFd_, SHUT_RDWR);
+        }
+        if (acceptThread_.joinable()) {
+            acceptThread_.join();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (int fd : sockets_) {
+                ::shutdown(fd, SHUT_RDWR);
+            }
+        }
+        for (auto& pump : pumps_) {
+            pump.join();
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int fd : sockets_) {
+            ::close(fd);
+        }
+        if (listenFd_ >= 0) {
+            ::close(listenFd_);
+        }
+    }
+
+    std::expected<int, std::string> start() {
+        auto listener = listenLoopback();
+        if (!listener) {
+            return std::unexpected(listener.error());
+        }
+        listenFd_ = listener->first;
+        acceptThread_ = std::thread([this]() { acceptLoop(); });
+        return listener->second;
+    }
+
+private:
+    struct Segment {
+        std::chrono::steady_clock::time_point due;
+        std::vector<char> bytes;
+    };
+
+    void acceptLoop() {
+        while (!stopping_) {
+            pollfd listenPoll{listenFd_, POLLIN, 0};
+            if (::poll(&listenPoll, 1, 200) <= 0) {
+                continue;
+            }
+            const int client = ::accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client < 0) {
+                continue;
+            }
+            auto server = connectLoopback(targetPort_);
+            if (!server) {
+                ::close(client);
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            sockets_.push_back(client);
+            sockets_.push_back(*server);
+            pumps_.emplace_back([this, client, target = *server]() { pump(client, target); });
+            pumps_.emplace_back([this, client, target = *server]() { pump(target, client); });
+        }
+    }
+
+    void pump(int from, int to) {
+        std::mutex queueMutex;
+        std::condition_variable queueReady;
+        std::deque<Segment> queue;
+        bool closed = false;
+
+        std::thread writer([&]() {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            while (true) {
+                queueReady.wait(lock, [&]() { return closed || !queue.empty(); });
+                if (queue.empty()) {
+                    break;
+                }
+                Segment segment = std::move(queue.front());
+                queue.pop_front();
+                lock.unlock();
+                std::this_thread::sleep_until(segment.due);
+                size_t sent = 0;
+                while (sent < segment.bytes.size()) {
+                    const ssize_t result = ::send(to, segment.bytes.data() + sent, segment.bytes.size() - sent, MSG_NOSIGNAL);
+                    if (result <= 0) {
+                        break;
+                    }
+                    sent += static_cast<size_t>(result);
+                }
+                lock.lock();
+            }
+            ::shutdown(to, SHUT_WR);
+        });
+
+        std::vector<char> buffer(256 * 1024);
+        while (true) {
+            const ssize_t received = ::recv(from, buffer.data(), buffer.size(), 0);
+            if (received <= 0) {
+                break;
+            }
+            std::lock_guard<std::mutex> lock(queueMutex);
+            queue.push_back({std::chrono::steady_clock::now() + delay_, std::vector<char>(buffer.begin(), buffer.begin() + received)});
+            queueReady.notify_one();
+        }
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            closed = true;
+        }
+        queueReady.notify_one();
+        writer.join();
+    }
+
+    int targetPort_;
+    std::chrono::microseconds delay_;
+    int listenFd_ = -1;
+    std::atomic<bool> stopping_{false};
+    std::thread acceptThread_;
+    std::mutex mutex_;
+    std::vector<int> sockets_;
+    std::vector<std::thread> pumps_;
+};
+
+std::expected<void, std::string> writeSyntheticArtifact(const fs::path& path, uint64_t size) {
+    if (fs::exists(path) && fs::file_size(path) == size) {
+        return {};
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return std::unexpected(std::format("Failed to create {}", path.string()));
+    }
+    // Random bytes keep the results independent of any compression on the path.
+    std::mt19937_64 generator(size);
+    std::vector<uint64_t> block(1 << 17);
+    for (uint64_t written = 0; written < size;) {
+        for (auto& word : block) {
+            word = generator();
+        }
+        const uint64_t length = std::min<uint64_t>(size - written, block.size() * sizeof(uint64_t));
+        out.write(reinterpret_cast<const char*>(block.data()), static_cast<std::streamsize>(length));
+        written += length;
+    }
+    return out ? std::expected<void, std::string>{} : std::unexpected(std::format("Failed to write {}", path.string()));
+}
+
+double cpuSeconds() {
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+struct RunResult {
+    double seconds = 0;
+    double cpuSeconds = 0;
+};
+
+/**
+ * @brief Uploads streams copies of an artifact concurrently through one strategy instance.
+ */
+std::expected<RunResult, std::string> runOnce(SFTPTransferStrategy& strategy, const std::vector<fs::path>& artifacts, const std::string& remoteSubdir) {
+    std::vector<std::string> errors(artifacts.size());
+    const double cpuStart = cpuSeconds();
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < artifacts.size(); ++i) {
+        workers.emplace_back([&, i]() {
+            auto result = strategy.transfer(artifacts[i].string(), remoteSubdir);
+            if (!result) {
+                errors[i] = result.error();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    for (const auto& error : errors) {
+        if (!error.empty()) {
+            return std::unexpected(error);
+        }
+    }
+    return RunResult{std::chrono::duration<double>(elapsed).count(), cpuSeconds() - cpuStart};
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    auto options = parseArguments(argc, argv);
+    if (!options) {
+        std::cerr << options.error() << std::endl;
+        return 2;
+    }
+    if (options->workdir.empty()) {
+        options->workdir = fs::temp_directory_path() / std::format("securevault-bench-{}", ::getpid());
+    }
+    const fs::path artifactsDir = options->workdir / "artifacts";
+    const fs::path remoteDir = options->workdir / "remote";
+    fs::create_directories(artifactsDir);
+
+    // Transfer strategies report each upload on stdout; keep it clean for the JSON report.
+    std::streambuf* const stdoutBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+
+    LocalSshd sshd;
+    auto started = sshd.start(options->sshd, options->workdir / "sshd");
+    if (!started) {
+        std::cerr << "Failed to start sshd: " << started.error() << std::endl;
+        return 1;
+    }
+
+    const passwd* account = ::getpwuid(::getuid());
+    const std::string user = account ? account->pw_name : "root";
+
+    Json::Value report;
+    report["tool"] = "transfer-benchmark";
+    report["timestamp"] = static_cast<Json::Int64>(std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    report["hardware_concurrency"] = std::thread::hardware_concurrency();
+    Json::Value& results = report["results"];
+    results = Json::arrayValue;
+
+    for (uint64_t delayMs : options->delaysMs) {
+        // Each direction gets half the delay so a round trip costs delayMs.
+        std::unique_ptr<DelayProxy> proxy;
+        int port = sshd.port();
+        if (delayMs > 0) {
+            proxy = std::make_unique<DelayProxy>(sshd.port(), std::chrono::microseconds(delayMs * 500));
+            auto proxyPort = proxy->start();
+            if (!proxyPort) {
+                std::cerr << "Failed to start delay proxy: " << proxyPort.error() << std::endl;
+                return 1;
+            }
+            port = *proxyPort;
+            sshd.trustPort(port);
+        }
+
+        for (uint64_t size : options->sizes) {
+            for (uint64_t streamCount : options->streams) {
+                std::vector<fs::path> artifacts;
+                std::vector<fs::path> warmupArtifacts;
+                for (uint64_t stream = 0; stream < streamCount; ++stream) {
+                    artifacts.push_back(artifactsDir / std::format("artifact-{}-{}.bin", size, stream));
+                    warmupArtifacts.push_back(artifactsDir / std::format("warmup-{}.bin", stream));
+                    for (const auto& [path, bytes] : {std::pair{artifacts.back(), size}, std::pair{warmupArtifacts.back(), kWarmupBytes}}) {
+                        auto written = writeSyntheticArtifact(path, bytes);
+                        if (!written) {
+                            std::cerr << written.error() << std::endl;
+                            return 1;
+                        }
+                    }
+                }
+
+                for (uint64_t chunkSize : options->chunkSizes) {
+                    for (uint64_t depth : options->pipelineDepths) {
+                        Json::Value config;
+                        config["host"] = "127.0.0.1";
+                        config["port"] = port;
+                        config["user"] = user;
+                        config["identity_file"] = sshd.identity().string();
+                        config["known_hosts"] = sshd.knownHosts().string();
+                        config["remote_dir"] = remoteDir.string();
+                        config["chunk_size"] = static_cast<Json::UInt64>(chunkSize);
+                        config["pipeline_depth"] = static_cast<Json::UInt64>(depth);
+                        config["verify_upload"] = false;
+                        SFTPTransferStrategy strategy(config);
+
+                        // Warm one pooled session per stream so the figures exclude handshakes.
+                        auto warmup = runOnce(strategy, warmupArtifacts, "warmup");
+                        if (!warmup) {
+                            std::cerr << "Warm-up failed: " << warmup.error() << std::endl;
+                            return 1;
+                        }
+
+                        double bestSeconds = 0;
+                        double cpuTotal = 0;
+                        for (int run = 0; run < options->repeat; ++run) {
+                            auto result = runOnce(strategy, artifacts, "data");
+                            if (!result) {
+                                std::cerr << "Transfer failed: " << result.error() << std::endl;
+                                return 1;
+                            }
+                            bestSeconds = run == 0 ? result->seconds : std::min(bestSeconds, result->seconds);
+                            cpuTotal += result->cpuSeconds;
+                        }
+
+                        const double totalBytes = static_cast<double>(size * streamCount);
+                        Json::Value entry;
+                        entry["artifact_bytes"] = static_cast<Json::UInt64>(size);
+                        entry["streams"] = static_cast<Json::UInt64>(streamCount);
+                        entry["chunk_size"] = static_cast<Json::UInt64>(chunkSize);
+                        entry["pipeline_depth"] = static_cast<Json::UInt64>(depth);
+                        entry["rtt_ms"] = static_cast<Json::UInt64>(delayMs);
+                        entry["seconds"] = bestSeconds;
+                        entry["mib_per_s"] = totalBytes / (1024.0 * 1024.0) / bestSeconds;
+                        entry["client_cpu_s_per_gib"] = cpuTotal / options->repeat / (totalBytes / (1024.0 * 1024.0 * 1024.0));
+                        results.append(entry);
+
+                        std::cerr << std::format("size={} streams={} chunk={} depth={} rtt={}ms: {:.1f} MiB/s",
+                                                 size, streamCount, chunkSize, depth, delayMs, entry["mib_per_s"].asDouble())
+                                  << std::endl;
+                        std::error_code ec;
+                        fs::remove_all(remoteDir, ec);
+                    }
+                }
+            }
+        }
+    }
+
+    // Latency sensitivity: throughput at each delay relative to the same configuration without delay.
+    for (auto& entry : results) {
+        for (const auto& baseline : results) {
+            if (baseline["rtt_ms"].asUInt64() == 0 &&
+                baseline["artifact_bytes"] == entry["artifact_bytes"] && baseline["streams"] == entry["streams"] &&
+                baseline["chunk_size"] == entry["chunk_size"] && baseline["pipeline_depth"] == entry["pipeline_depth"]) {
+                entry["relative_to_zero_rtt"] = entry["mib_per_s"].asDouble() / baseline["mib_per_s"].asDouble();
+            }
+        }
+    }
+
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "  ";
+    const std::string json = Json::writeString(writer, report);
+    std::cout.rdbuf(stdoutBuffer);
+    if (options->output.empty()) {
+        std::cout << json << std::endl;
+    } else {
+        std::ofstream(options->output) << json << '\n';
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+/**
+ * @file archive_index.hpp
+ * @brief Sorted entry index stored next to each file archive (`<archive>.idx`).
+ *
+ * The index lists every entry of the archive sorted by path, with size, mtime, SHA-256 and
+ * the entry's offset in the uncompressed tar stream (and frame, for framed archives). It uses
+ * the sorted-table layout of sorted_table.hpp, so listing, prefix search and globbing are
+ * binary searches over a memory-mapped file and never decompress the archive.
+ */
+
+#ifndef ARCHIVE_INDEX_HPP
+#define ARCHIVE_INDEX_HPP
+
+#include "catalog.hpp"
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <vector>
+
+/**
+ * @brief One archive entry as listed by the index.
+ */
+struct ArchiveIndexEntry {
+    std::string path; ///< Entry name inside the archive.
+    uint64_t size = 0; ///< Entry size.
+    int64_t mtime = 0; ///< Source modification time (seconds since the epoch).
+    uint64_t offset = ManifestEntry::kUnknownOffset; ///< Entry header offset in the tar stream.
+    uint32_t frame = ManifestEntry::kNoFrame; ///< Frame holding the entry header.
+    std::string sha256; ///< Hex content digest (empty if unknown).
+};
+
+/**
+ * @brief Returns the index path for an archive (`<archive>.idx`).
+ */
+std::string archiveIndexPath(const std::string& archivePath);
+
+/**
+ * @brief Writes the index of an archive.
+ *
+ * @param archivePath Archive the entries were written to.
+ * @param entries Archived files (ManifestEntry::stored); sorted by entry name here.
+ * @return std::expected<void, std::string> Success or an error message.
+ */
+std::expected<void, std::string> writeArchiveIndex(const std::string& archivePath, std::vector<ManifestEntry> entries);
+
+/**
+ * @brief Lists the entries of an archive matching a glob, using its index.
+ *
+ * @param archivePath Archive to list.
+ * @param pattern Glob (`*`, `?`, `[...]`; `*` also matches `/`) matched against entry names.
+ * @return std::expected<std::vector<ArchiveIndexEntry>, std::string> Matching entries sorted by
+ *         path, or an error if the archive has no readable index.
+ */
+std::expected<std::vector<ArchiveIndexEntry>, std::string> readArchiveIndex(const std::string& archivePath,
+                                                                           const std::string& pattern = "*");
+
+#endif // ARCHIVE_INDEX_HPP
@@ -0,0 +1,118 @@
+/**
+ * @file artifact_verifier.hpp
+ * @brief Concurrent integrity checks for every artifact of a backup run.
+ *
+ * Each artifact is read back completely once: compressed streams are inflated so that every
+ * gzip member's CRC-32 and length are checked, tar archives are walked entry by entry
+ * (libarchive validates header checksums and entry sizes), and SQL dumps are decompressed to
+ * their end and checked for the completion footer mysqldump and pg_dumpall write last, which is
+ * the only reliable sign that a dump was not cut short. Artifacts are checked on a small pool
+ * of threads as soon as they are submitted, so database dumps are verified while the file
+ * archive is still being built. Framed archives (see frame_archive.hpp) above a configured size
+ * can instead be sampled: a budgeted subset of frames is decompressed and checked each run.
+ */
+
+#ifndef ARTIFACT_VERIFIER_HPP
+#define ARTIFACT_VERIFIER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <expected>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <json/json.h>
+
+/**
+ * @brief Result of checking one artifact.
+ */
+struct VerificationResult {
+    std::string artifact; ///< Local artifact path.
+    std::string artifactClass; ///< Artifact class (e.g., "db", "sys").
+    std::expected<void, std::string> result; ///< Success or the reason the artifact is unusable.
+    uint64_t bytes = 0; ///< Uncompressed bytes read.
+    uint64_t entries = 0; ///< Archive entries checked (0 for dumps).
+    uint64_t framesChecked = 0; ///< Frames checked by sampled verification (0 for full checks).
+    uint64_t framesTotal = 0; ///< Frames in the archive when it was sampled.
+    std::string warning; ///< Non-fatal finding worth logging (empty if none).
+    std::chrono::duration<double> duration{}; ///< Verification wall time.
+};
+
+/**
+ * @brief Thread pool verifying artifacts in the background.
+ *
+ * Configured from the "verify" section:
+ * - threads: worker threads (default: hardware concurrency).
+ * - sample_budget_mb: compressed bytes per framed archive to check; larger archives are
+ *   sampled frame by frame instead of read in full (0, the default, always reads everything).
+ * - rotation_days: frame positions are split into this many slots and today's slot is always
+ *   checked, so every position is covered once per rotation (default 7). An archive larger than
+ *   rotation_days budgets gets one slot per budget instead, and a full pass takes longer.
+ */
+class ArtifactVerifier {
+public:
+    using CompletionHandler = std::function<void(const VerificationResult&)>;
+
+    /**
+     * @brief Starts the worker threads.
+     *
+     * @param verifyConfig The "verify" configuration section.
+     * @param onComplete Called on a worker thread after each artifact is checked.
+     */
+    ArtifactVerifier(const Json::Value& verifyConfig, CompletionHandler onComplete);
+
+    /**
+     * @brief Waits for submitted artifacts to be checked.
+     */
+    ~ArtifactVerifier();
+
+    ArtifactVerifier(const ArtifactVerifier&) = delete;
+    ArtifactVerifier& operator=(const ArtifactVerifier&) = delete;
+
+    /**
+     * @brief Queues an artifact for verification.
+     *
+     * @param file Local artifact path; the check is chosen by its extension.
+     * @param artifactClass Class name passed back in the result.
+     */
+    void submit(const std::string& file, const std::string& artifactClass);
+
+    /**
+     * @brief Stops accepting artifacts and waits until every queued check is done.
+     *
+     * @return std::vector<VerificationResult> Results in completion order.
+     */
+    std::vector<VerificationResult> finish();
+
+    /**
+     * @brief Checks one artifact on the calling thread.
+     *
+     * @param file Local artifact path (.tar.gz archive, .sql.gz dump, or another libarchive-readable archive).
+     * @param artifactClass Class name stored in the result.
+     * @return VerificationResult The check outcome.
+     */
+    static VerificationResult verify(const std::string& file, const std::string& artifactClass);
+
+private:
+    void workerLoop();
+
+    /**
+     * @brief Checks an artifact, sampling frames of large framed archives when a budget is set.
+     */
+    VerificationResult check(const std::string& file, const std::string& artifactClass) const;
+
+    CompletionHandler onComplete_; ///< Per-artifact callback.
+    uint64_t sampleBudget_; ///< Compressed bytes checked per sampled archive (0 disables sampling).
+    unsigned rotationDays_; ///< Number of rotation slots for sampled frames.
+    std::mutex mutex_; ///< Guards the fields below.
+    std::condition_variable wake_; ///< Signals new artifacts or closure.
+    std::deque<std::pair<std::string, std::string>> queue_; ///< Artifacts (path, class) not yet checked.
+    std::vector<VerificationResult> results_; ///< Finished checks.
+    bool closed_ = false; ///< True once finish() was called.
+    std::vector<std::thread> workers_; ///< Verification threads.
+};
+
+#endif // ARTIFACT_VERIFIER_HPP
@@ -18,14 +18,33 @@
 #include <vector>
 #include <memory>
 #include <expected>
+#include <optional>
 #include <filesystem>
 #include <chrono>
 #include <atomic>
 #include <mutex>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
 #include "backup_config.hpp"
 
 namespace fs = std::filesystem;
 struct archive;
+struct ssh_session_struct;
+struct sftp_session_struct;
+struct ssl_ctx_st;
+class StreamConnection;
+class TransferMetrics;
+class FrameWriter;
+class FileManifest;
+struct RetentionPolicy;
+class TrashCollector;
+class LoadMonitor;
+class ChangeJournal;
+struct CatalogRun;
+struct ManifestEntry;
+struct ScheduledJob;
+class JobScheduler;
 
 /**
  * @brief Abstract base class for database backup strategies.
@@ -50,6 +69,16 @@ public:
      * @note Ensure database tools (e.g., mysqldump, pg_dumpall) are in the system PATH.
      */
     virtual std::expected<std::string, std::string> execute(const std::string& outputPath) = 0;
+
+    /**
+     * @brief Sets the load monitor that slows compression of the dump while the host is busy.
+     *
+     * @param monitor Load monitor, or nullptr to run at full speed.
+     */
+    void attachLoadMonitor(LoadMonitor* monitor) { loadMonitor_ = monitor; }
+
+protected:
+    LoadMonitor* loadMonitor_ = nullptr; ///< Throttles the backup under load (may be null).
 };
 
 /**
@@ -130,6 +159,11 @@ public:
      */
     virtual ~FileBackupStrategy() = default;
 
+    /**
+     * @brief Level of an incremental backup of the changes since the previous run of any kind.
+     */
+    static constexpr int kSinceLastRun = -1;
+
     /**
      * @brief Executes a file backup.
      *
@@ -137,13 +171,46 @@ public:
      *
      * @param sourceDirs List of directories to back up.
      * @param outputFile Path for the output backup file.
-     * @param fullBackup If true, performs a full backup; otherwise, incremental.
-     * @return std::expected<void, std::string> Success or an error message.
+     * @param level Dump level: 0 backs up everything, N > 0 the changes since the last backup of
+     *        a lower level, kSinceLastRun the changes since the previous run.
+     * @param manifest Receives every file present in the source tree, stored or not (may be null).
+     * @return std::expected<std::chrono::system_clock::time_point, std::string> Start time of the
+     *         backup, to pass to recordCompleted(), or an error message.
      * @note Uses std::filesystem for portable path handling across Windows, macOS, and Linux.
      */
-    virtual std::expected<void, std::string> execute(const std::vector<std::string>& sourceDirs,
-                                                    const std::string& outputFile,
-                                                    bool fullBackup) = 0;
+    virtual std::expected<std::chrono::system_clock::time_point, std::string> execute(const std::vector<std::string>& sourceDirs,
+                                                                                     const std::string& outputFile,
+                                                                                     int level,
+                                                                                     FileManifest* manifest) = 0;
+
+    /**
+     * @brief Makes the last backup the reference of later incremental runs.
+     *
+     * Called only after the archive written by execute() was verified and cataloged, so a run
+     * that is discarded later never hides changes from the next one.
+     *
+     * @param level Dump level passed to execute().
+     * @param started Start time returned by execute().
+     */
+    virtual void recordCompleted([[maybe_unused]] int level, [[maybe_unused]] std::chrono::system_clock::time_point started) {}
+
+    /**
+     * @brief Sets the load monitor that slows the backup while the host is busy.
+     *
+     * @param monitor Load monitor, or nullptr to run at full speed.
+     */
+    void attachLoadMonitor(LoadMonitor* monitor) { loadMonitor_ = monitor; }
+
+    /**
+     * @brief Sets the change journal that replaces directory walks in incremental runs.
+     *
+     * @param journal Change journal of the source directories, or nullptr to walk them.
+     */
+    void attachChangeJournal(ChangeJournal* journal) { changeJournal_ = journal; }
+
+protected:
+    LoadMonitor* loadMonitor_ = nullptr; ///< Throttles the backup under load (may be null).
+    ChangeJournal* changeJournal_ = nullptr; ///< Records changes between runs (may be null).
 };
 
 /**
@@ -158,8 +225,13 @@ public:
      *
      * @param excludeExtensions File extensions to exclude (e.g., {".tmp", ".bak"}).
      * @param lastBackupFile Path to file storing the last backup timestamp.
+     * @param frameSize Uncompressed bytes per gzip frame; 0 writes a single gzip stream without a frame index.
+     * @param levelsFile Path to file storing the start time of the last backup of each dump level
+     *        (empty treats every level above 0 as an incremental since the last run).
      */
-    TarGzFileBackupStrategy(const std::vector<std::string>& excludeExtensions, const std::string& lastBackupFile);
+    TarGzFileBackupStrategy(const std::vector<std::string>& excludeExtensions, const std::string& lastBackupFile,
+                            uint64_t frameSize = 0, const std::string& levelsFile = "");
+    ~TarGzFileBackupStrategy() override;
 
     /**
      * @brief Executes a tar.gz file backup.
@@ -167,49 +239,159 @@ public:
      * Creates a compressed tar.gz backup of specified directories, supporting incremental backups
      * and excluding specified file extensions.
      *
+     * The run only becomes a reference for later runs in recordCompleted(): its start time is
+     * then recorded as its level's reference in the levels file.
+     *
+     * While an attached load monitor reports high load, file reads are paced to the throttled
+     * rate and new frames of a framed archive use the throttled compression level.
+     *
+     * With an attached change journal that covers the time since the previous run, an incremental
+     * backup only looks at the changed paths; the other files are carried over from the previous
+     * run's file list. Otherwise the source directories are walked.
+     *
      * @param sourceDirs List of directories to back up.
      * @param outputFile Path for the output .tar.gz file.
-     * @param fullBackup If true, performs a full backup; otherwise, incremental.
-     * @return std::expected<void, std::string> Success or an error message.
+     * @param level Dump level (0 for a full backup) or kSinceLastRun.
+     * @param manifest Receives every file present in the source tree (may be null). Archived files
+     *        are hashed while they are written and listed in the `<archive>.idx` entry index.
+     * @return std::expected<std::chrono::system_clock::time_point, std::string> Start time or an error message.
      * @note Requires libarchive. On Windows, install via vcpkg; on macOS, use Homebrew.
      */
-    std::expected<void, std::string> execute(const std::vector<std::string>& sourceDirs,
-                                             const std::string& outputFile,
-                                             bool fullBackup) override;
+    std::expected<std::chrono::system_clock::time_point, std::string> execute(const std::vector<std::string>& sourceDirs,
+                                                                              const std::string& outputFile,
+                                                                              int level,
+                                                                              FileManifest* manifest) override;
+
+    /**
+     * @brief Records the last backup's level, last-run time and file list.
+     *
+     * @param level Dump level passed to execute().
+     * @param started Start time returned by execute().
+     */
+    void recordCompleted(int level, std::chrono::system_clock::time_point started) override;
 
 private:
     std::vector<std::string> excludeExtensions; ///< File extensions to exclude.
     std::string lastBackupFile; ///< Path to last backup timestamp file.
+    uint64_t frameSize; ///< Uncompressed bytes per gzip frame (0 disables framing).
+    std::string levelsFile; ///< Path to the per-level reference time file.
+    std::vector<ManifestEntry> lastState; ///< Files seen by the last successful run (kept while a journal is attached).
+    std::chrono::system_clock::time_point lastStateStarted; ///< Start of the run lastState belongs to.
+    std::optional<std::chrono::system_clock::time_point> pendingFinished; ///< End of the last execute() that wrote an archive.
+    std::optional<std::vector<ManifestEntry>> pendingState; ///< File list of the last execute(), until recordCompleted().
+
+    /**
+     * @brief Returns the time after which a file counts as changed for a backup level.
+     *
+     * @param level Dump level or kSinceLastRun.
+     * @return std::chrono::system_clock::time_point Reference time; the minimum for a full backup.
+     */
+    std::chrono::system_clock::time_point referenceTime(int level) const;
+
+    /**
+     * @brief Records the start time of a completed backup as its level's reference.
+     *
+     * @param level Dump level.
+     * @param started Start time of the backup.
+     */
+    void recordLevel(int level, std::chrono::system_clock::time_point started) const;
 
     /**
      * @brief Counts files to back up.
      *
      * @param sourceDirs Directories to scan.
-     * @param fullBackup If true, ignores last backup time.
+     * @param since Files modified after this time are backed up.
+     * @param manifest Receives the files skipped as unchanged (may be null).
      * @return size_t Number of files to process.
      */
-    size_t countFiles(const std::vector<std::string>& sourceDirs, bool fullBackup);
+    size_t countFiles(const std::vector<std::string>& sourceDirs, std::chrono::system_clock::time_point since, FileManifest* manifest);
+
+    /**
+     * @brief Lists the files to back up from the change journal instead of walking the directories.
+     *
+     * @param sourceDirs Directories to back up.
+     * @param since Files modified after this time are backed up.
+     * @param manifest Receives the files skipped as unchanged.
+     * @return std::optional<std::vector<std::vector<std::filesystem::path>>> Files to archive for
+     *         each source directory, or nothing if the journal cannot tell (walk instead).
+     */
+    std::optional<std::vector<std::vector<std::filesystem::path>>> journalCandidates(const std::vector<std::string>& sourceDirs,
+                                                                                     std::chrono::system_clock::time_point since,
+                                                                                     FileManifest* manifest);
 
     /**
      * @brief Backs up a directory in a thread.
      *
      * @param dir Directory to back up.
      * @param outputFile Output .tar.gz file path (unused, kept for interface).
-     * @param fullBackup If true, full backup.
+     * @param since Files modified after this time are backed up.
      * @param archive Shared archive object.
      * @param processedFiles Processed file counter.
      * @param totalFiles Total files for progress.
      * @param mutex Thread-safe archive mutex.
      * @param writeFailed Shared error flag for archive write failures.
+     * @param frames Frame writer of a framed archive, or null.
+     * @param manifest Receives the archived files.
+     * @param files Files of the directory to consider instead of walking it (may be null).
      */
     void backupDirectory(const std::string& dir,
                          const std::string& outputFile,
-                         bool fullBackup,
+                         std::chrono::system_clock::time_point since,
                          struct archive* archive,
                          std::atomic<size_t>& processedFiles,
                          size_t totalFiles,
                          std::mutex& mutex,
-                         std::atomic<bool>& writeFailed);
+                         std::atomic<bool>& writeFailed,
+                         FrameWriter* frames,
+                         FileManifest* manifest,
+                         const std::vector<std::filesystem::path>* files = nullptr);
+};
+
+/**
+ * @brief Streaming upload of a single artifact to a remote destination.
+ *
+ * Obtained from TransferStrategy::openSink. Data is written in order and the remote
+ * file is finalized by commit(); destroying an uncommitted sink abandons the upload.
+ */
+class TransferSink {
+public:
+    /**
+     * @brief Virtual destructor for safe polymorphism.
+     */
+    virtual ~TransferSink() = default;
+
+    /**
+     * @brief Appends the next block of the artifact.
+     *
+     * @param data Bytes to upload.
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    virtual std::expected<void, std::string> write(std::span<const char> data) = 0;
+
+    /**
+     * @brief Appends the next block of the artifact, handing over its storage.
+     *
+     * Sinks that queue data (e.g., the fan-out stage) keep the block without copying it; the
+     * default forwards to write().
+     *
+     * @param data Bytes to upload.
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    virtual std::expected<void, std::string> writeBuffer(std::vector<char>&& data) { return write(data); }
+
+    /**
+     * @brief Signals that no data will follow for a while, e.g. because the upload was preempted.
+     *
+     * Sinks holding a connection may release it; later writes continue the same upload.
+     */
+    virtual void suspend() {}
+
+    /**
+     * @brief Finalizes the remote file once all data has been written.
+     *
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    virtual std::expected<void, std::string> commit() = 0;
 };
 
 /**
@@ -224,6 +406,38 @@ public:
      */
     virtual ~TransferStrategy() = default;
 
+    /**
+     * @brief Returns a short label identifying the destination in logs and errors.
+     *
+     * @return std::string Destination label (e.g., "sftp://backup.example.com:22/backups").
+     */
+    virtual std::string name() const { return "remote"; }
+
+    /**
+     * @brief Tells whether openSink() is implemented.
+     *
+     * Callers fall back to transfer() only for strategies without streaming support; an
+     * openSink() error from a streaming strategy is a real failure (connect, authentication).
+     *
+     * @return bool True if the strategy accepts streaming uploads.
+     */
+    virtual bool supportsStreaming() const { return false; }
+
+    /**
+     * @brief Opens a streaming upload for a file.
+     *
+     * Lets callers that already hold the artifact data (e.g., a fan-out stage) push it without
+     * the strategy re-reading the local file. Strategies without streaming support return an error.
+     *
+     * @param sourceFile Path to the local file; its name is used for the remote file.
+     * @param destinationPath Remote directory path.
+     * @return std::expected<std::unique_ptr<TransferSink>, std::string> Open sink or an error message.
+     */
+    virtual std::expected<std::unique_ptr<TransferSink>, std::string> openSink([[maybe_unused]] const std::string& sourceFile,
+                                                                                [[maybe_unused]] const std::string& destinationPath) {
+        return std::unexpected("Streaming uploads are not supported by this destination");
+    }
+
     /**
      * @brief Transfers a file to a remote location.
      *
@@ -234,6 +448,73 @@ public:
      * @return std::expected<void, std::string> Success or an error message.
      */
     virtual std::expected<void, std::string> transfer(const std::string& sourceFile, const std::string& destinationPath) = 0;
+
+    /**
+     * @brief Removes expired artifacts from the remote destination.
+     *
+     * Mirrors the local retention policy on the remote side. The default implementation
+     * leaves the destination untouched.
+     *
+     * @param directories Remote subdirectories to prune, relative to the configured root (e.g., {"sys", "db"}).
+     * @param threshold Artifacts last modified before this point in time are removed.
+     * @return std::expected<size_t, std::string> Number of removed artifacts or an error message.
+     */
+    virtual std::expected<size_t, std::string> pruneRemote([[maybe_unused]] const std::vector<std::string>& directories,
+                                                           [[maybe_unused]] std::chrono::system_clock::time_point threshold) {
+        return 0;
+    }
+
+    /**
+     * @brief Downloads a remote file.
+     *
+     * The default implementation reports that the destination cannot be read back.
+     *
+     * @param remotePath File path relative to the configured root (e.g., "sys/backup.tar.gz").
+     * @param localFile Local file to write; it is replaced if it exists.
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    virtual std::expected<void, std::string> fetch([[maybe_unused]] const std::string& remotePath,
+                                                   [[maybe_unused]] const std::string& localFile) {
+        return std::unexpected("Downloads are not supported by this destination");
+    }
+
+    /**
+     * @brief Removes individual remote files.
+     *
+     * Files that do not exist are skipped. The default implementation reports that the
+     * destination cannot remove single files.
+     *
+     * @param remotePaths File paths relative to the configured root.
+     * @return std::expected<size_t, std::string> Number of removed files or an error message.
+     */
+    virtual std::expected<size_t, std::string> removeRemote([[maybe_unused]] const std::vector<std::string>& remotePaths) {
+        return std::unexpected("Removing single files is not supported by this destination");
+    }
+
+    /**
+     * @brief Sets the collector for handshake, stall and retry measurements.
+     *
+     * Composite strategies forward the collector to the destinations they wrap.
+     *
+     * Uploads may be running while the collector changes; they record into the previous or the
+     * new collector, so a replaced collector must stay alive until those uploads finish.
+     *
+     * @param metrics Collector for the current run, or nullptr to stop recording.
+     */
+    virtual void attachMetrics(TransferMetrics* metrics) { metrics_ = metrics; }
+
+protected:
+    std::atomic<TransferMetrics*> metrics_{nullptr}; ///< Measurement collector for the current run (may be null).
+
+    /**
+     * @brief Uploads a local file through openSink in fixed-size chunks.
+     *
+     * @param sourceFile Path to the local file.
+     * @param destinationPath Remote directory path.
+     * @param chunkSize Read and write block size in bytes.
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    std::expected<void, std::string> streamFile(const std::string& sourceFile, const std::string& destinationPath, size_t chunkSize);
 };
 
 /**
@@ -246,9 +527,16 @@ public:
     /**
      * @brief Constructs an SFTP transfer strategy.
      *
-     * @param config JSON configuration with host, user, password, port, and remote_dir.
+     * @param config JSON configuration with host, user, password, port, remote_dir, and optional
+     *        identity_file, known_hosts, chunk_size, pipeline_depth and verify_upload.
+     * @param stateFolder Directory where known remote directories are cached between runs; empty disables persistence.
      */
-    SFTPTransferStrategy(const Json::Value& config);
+    SFTPTransferStrategy(const Json::Value& config, const std::string& stateFolder = "");
+
+    /**
+     * @brief Closes all pooled SFTP sessions.
+     */
+    ~SFTPTransferStrategy() override;
 
     /**
      * @brief Transfers a file via SFTP.
@@ -262,12 +550,486 @@ public:
      */
     std::expected<void, std::string> transfer(const std::string& sourceFile, const std::string& destinationPath) override;
 
+    std::string name() const override;
+
+    bool supportsStreaming() const override { return true; }
+
+    /**
+     * @brief Opens a remote file for streaming on a pooled session.
+     *
+     * A SHA-256 digest is computed while streaming; on commit it is compared with the digest the
+     * remote host computes over an SSH exec channel, unless verify_upload is disabled. A host
+     * without a shell or sha256sum leaves the upload unverified (recorded in the transfer
+     * metrics), or fails it when verify_upload is "required".
+     *
+     * @param sourceFile Path to the local file; its name is used for the remote file.
+     * @param destinationPath Remote directory path, relative to remote_dir.
+     * @return std::expected<std::unique_ptr<TransferSink>, std::string> Open sink or an error message.
+     */
+    std::expected<std::unique_ptr<TransferSink>, std::string> openSink(const std::string& sourceFile,
+                                                                        const std::string& destinationPath) override;
+
+    /**
+     * @brief Prunes expired artifacts from the remote directories over one pooled session.
+     *
+     * Each directory is listed once; the listing carries file attributes, so the expired set is
+     * derived from that manifest without a stat round trip per file.
+     *
+     * @param directories Remote subdirectories to prune, relative to remote_dir.
+     * @param threshold Artifacts last modified before this point in time are removed.
+     * @return std::expected<size_t, std::string> Number of removed artifacts or an error message.
+     */
+    std::expected<size_t, std::string> pruneRemote(const std::vector<std::string>& directories,
+                                                   std::chrono::system_clock::time_point threshold) override;
+
+    /**
+     * @brief Downloads a file below remote_dir over a pooled session.
+     *
+     * @param remotePath File path relative to remote_dir.
+     * @param localFile Local file to write.
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    std::expected<void, std::string> fetch(const std::string& remotePath, const std::string& localFile) override;
+
+    /**
+     * @brief Unlinks files below remote_dir over one pooled session.
+     *
+     * @param remotePaths File paths relative to remote_dir.
+     * @return std::expected<size_t, std::string> Number of removed files or an error message.
+     */
+    std::expected<size_t, std::string> removeRemote(const std::vector<std::string>& remotePaths) override;
+
 private:
+    struct Session; ///< Authenticated SSH/SFTP session kept open between transfers.
+    class Upload;   ///< TransferSink writing to a remote file on a leased session.
+
+    /**
+     * @brief Takes an idle session from the pool or opens a new one.
+     *
+     * @param artifact Local artifact the session is for, used to attribute handshake time; may be empty.
+     * @return std::expected<std::unique_ptr<Session>, std::string> Ready session or an error message.
+     */
+    std::expected<std::unique_ptr<Session>, std::string> acquireSession(const std::string& artifact);
+
+    /**
+     * @brief Returns a healthy session to the pool for reuse.
+     *
+     * Sessions involved in a failed operation must be dropped instead of released.
+     *
+     * @param session Session to keep open.
+     */
+    void releaseSession(std::unique_ptr<Session> session);
+
+    /**
+     * @brief Makes sure a remote directory exists, creating only the segments not known to exist.
+     *
+     * @param session Session to issue mkdir requests on.
+     * @param directory Normalized remote directory.
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    std::expected<void, std::string> ensureDirectory(Session& session, const std::string& directory);
+
+    /**
+     * @brief Forgets all cached remote directories, in memory and on disk.
+     */
+    void invalidateDirectoryCache();
+
     std::string host_; ///< SFTP host address.
     std::string user_; ///< SFTP username.
     std::string password_; ///< SFTP password.
     int port_; ///< SFTP port (e.g., 22).
     std::string remote_dir_; ///< Remote directory for backups.
+    std::string identityFile_; ///< Private key to authenticate with instead of the default identities.
+    std::string knownHostsFile_; ///< known_hosts file used for host key verification (empty for the default).
+    size_t chunkSize_; ///< Bytes per SFTP write request.
+    size_t pipelineDepth_; ///< SFTP write requests kept in flight (1 writes synchronously).
+    bool verifyUpload_; ///< Compare a streamed SHA-256 with a remote sha256sum after each upload.
+    bool requireVerification_; ///< Fail uploads the remote host cannot verify ("required").
+    std::string dirCacheFile_; ///< File persisting knownDirs_ between runs (empty if disabled).
+    std::mutex dirCacheMutex_; ///< Guards knownDirs_ and dirCacheLoaded_.
+    std::unordered_set<std::string> knownDirs_; ///< Remote directories known to exist.
+    bool dirCacheLoaded_ = false; ///< True once dirCacheFile_ has been read.
+    std::mutex poolMutex_; ///< Guards idleSessions_.
+    std::vector<std::unique_ptr<Session>> idleSessions_; ///< Sessions available for reuse.
+};
+
+/**
+ * @brief Transfer strategy for securevault-receiver over the framed TCP protocol.
+ *
+ * Intended for LAN targets where SSH encryption and SFTP framing cost more CPU than compression.
+ * Each artifact is split into byte ranges sent over parallel connections with zero-copy
+ * sendfile/SSL_sendfile; the receiver commits the file atomically once all ranges arrived.
+ *
+ * @note Available on POSIX builds with OpenSSL; see receiver_protocol.hpp for the wire format.
+ */
+class SecureVaultTransferStrategy : public TransferStrategy {
+public:
+    /**
+     * @brief Constructs a receiver transfer strategy.
+     *
+     * @param config JSON destination with host, port, token, and optional tls, ca_file,
+     *        verify_peer, streams and chunk_size.
+     * @throws std::runtime_error If the TLS context cannot be created.
+     */
+    SecureVaultTransferStrategy(const Json::Value& config);
+
+    /**
+     * @brief Releases the TLS context.
+     */
+    ~SecureVaultTransferStrategy() override;
+
+    /**
+     * @brief Sends a file over parallel streams and commits it on the receiver.
+     *
+     * @param sourceFile Path to the local file.
+     * @param destinationPath Directory relative to the receiver root.
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    std::expected<void, std::string> transfer(const std::string& sourceFile, const std::string& destinationPath) override;
+
+    std::string name() const override;
+
+    bool supportsStreaming() const override { return true; }
+
+    /**
+     * @brief Opens a single-stream upload fed from memory.
+     *
+     * @param sourceFile Path to the local file; its name and size describe the upload.
+     * @param destinationPath Directory relative to the receiver root.
+     * @return std::expected<std::unique_ptr<TransferSink>, std::string> Open sink or an error message.
+     */
+    std::expected<std::unique_ptr<TransferSink>, std::string> openSink(const std::string& sourceFile,
+                                                                        const std::string& destinationPath) override;
+
+private:
+    class Upload; ///< TransferSink sending Data frames on one connection.
+
+    /**
+     * @brief Connects and authenticates a new stream.
+     */
+    std::expected<std::unique_ptr<StreamConnection>, std::string> connect();
+
+    /**
+     * @brief Opens an upload on a fresh connection.
+     *
+     * @return std::expected<std::pair<std::unique_ptr<StreamConnection>, uint64_t>, std::string> Connection and upload id.
+     */
+    std::expected<std::pair<std::unique_ptr<StreamConnection>, uint64_t>, std::string> begin(const std::string& remotePath, uint64_t size);
+
+    std::string host_; ///< Receiver host.
+    int port_; ///< Receiver port.
+    std::string token_; ///< Shared authentication token.
+    bool tls_; ///< Use TLS (disable only on trusted networks or loopback).
+    bool verifyPeer_; ///< Verify the receiver certificate and host name.
+    int streams_; ///< Parallel connections per artifact.
+    size_t chunkSize_; ///< Maximum Data frame payload.
+    ssl_ctx_st* tlsContext_ = nullptr; ///< Client TLS context when tls_ is set.
+};
+
+/**
+ * @brief WebDAV / HTTP PUT transfer strategy built on libcurl.
+ *
+ * All requests of one destination run on a shared curl multi handle driven by a background
+ * thread, so the connection cache acts as a pool and concurrent uploads are multiplexed over a
+ * single HTTP/2 connection where the server supports it. Interrupted uploads are resumed with
+ * Content-Range PUTs from the size the server already holds; servers that reject partial PUTs
+ * get a full upload instead.
+ */
+class HttpTransferStrategy : public TransferStrategy {
+public:
+    /**
+     * @brief Constructs an HTTP transfer strategy.
+     *
+     * @param config JSON destination with url and optional user, password, auth, webdav, http2,
+     *        connections, resume, retries, ca_file and verify_peer.
+     * @throws std::runtime_error If url is missing or the multi handle cannot be created.
+     */
+    HttpTransferStrategy(const Json::Value& config);
+
+    /**
+     * @brief Stops the request driver after in-flight requests finish.
+     */
+    ~HttpTransferStrategy() override;
+
+    /**
+     * @brief Uploads a file with PUT, resuming from the remote size after failures.
+     *
+     * @param sourceFile Path to the local file.
+     * @param destinationPath Remote collection relative to url.
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    std::expected<void, std::string> transfer(const std::string& sourceFile, const std::string& destinationPath) override;
+
+    std::string name() const override;
+
+    bool supportsStreaming() const override { return true; }
+
+    /**
+     * @brief Opens a streaming PUT fed from memory.
+     *
+     * If the stream fails or is suspended, commit() uploads the rest from the local file with the
+     * same retries and Content-Range resume as transfer().
+     *
+     * @param sourceFile Path to the local file; its name and size describe the upload.
+     * @param destinationPath Remote collection relative to url.
+     * @return std::expected<std::unique_ptr<TransferSink>, std::string> Open sink or an error message.
+     */
+    std::expected<std::unique_ptr<TransferSink>, std::string> openSink(const std::string& sourceFile,
+                                                                        const std::string& destinationPath) override;
+
+    /**
+     * @brief Downloads a file with GET.
+     *
+     * @param remotePath File path relative to url.
+     * @param localFile Local file to write.
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    std::expected<void, std::string> fetch(const std::string& remotePath, const std::string& localFile) override;
+
+    /**
+     * @brief Removes files with DELETE.
+     *
+     * @param remotePaths File paths relative to url.
+     * @return std::expected<size_t, std::string> Number of removed files or an error message.
+     */
+    std::expected<size_t, std::string> removeRemote(const std::vector<std::string>& remotePaths) override;
+
+private:
+    class Driver; ///< Background thread running the curl multi handle.
+    class Upload; ///< TransferSink feeding a PUT request from written blocks.
+
+    /**
+     * @brief Creates an easy handle with URL, authentication, TLS and HTTP version options.
+     */
+    void* newRequest(const std::string& url) const;
+
+    /**
+     * @brief Runs a request on the driver and returns its HTTP status.
+     */
+    std::expected<long, std::string> perform(void* easy, const std::string& artifact);
+
+    /**
+     * @brief Creates every missing WebDAV collection of a remote directory (MKCOL).
+     */
+    std::expected<void, std::string> ensureCollection(const std::string& directory, const std::string& artifact);
+
+    /**
+     * @brief Returns the size of an existing remote file, or 0 if it does not exist.
+     */
+    std::expected<uint64_t, std::string> remoteSize(const std::string& url, const std::string& artifact);
+
+    /**
+     * @brief PUTs [offset, size) of a local file; offset > 0 sends a Content-Range header.
+     */
+    std::expected<long, std::string> putFile(const std::string& sourceFile, const std::string& url, uint64_t offset, uint64_t size);
+
+    /**
+     * @brief PUTs a local file with retries; resumeFirst looks for stored bytes before the first attempt.
+     */
+    std::expected<void, std::string> uploadFile(const std::string& sourceFile, const std::string& url, uint64_t size, bool resumeFirst);
+
+    /**
+     * @brief Builds the URL of a remote path below the base URL, percent-encoding each segment.
+     */
+    std::string urlFor(const std::string& remotePath) const;
+
+    std::string baseUrl_; ///< Base URL without trailing slash.
+    std::string user_; ///< User name (empty for anonymous access).
+    std::string password_; ///< Password.
+    long authMask_; ///< CURLAUTH_* mask.
+    bool webdav_; ///< Create collections with MKCOL before uploading.
+    bool http2_; ///< Negotiate HTTP/2 (ALPN over TLS).
+    bool resume_; ///< Resume interrupted uploads with Content-Range.
+    int retries_; ///< Extra attempts after a failed upload.
+    std::string caFile_; ///< CA bundle for server verification (empty for the system default).
+    bool verifyPeer_; ///< Verify the server certificate.
+    std::unique_ptr<Driver> driver_; ///< Shared multi handle and its thread.
+    std::mutex collectionsMutex_; ///< Guards knownCollections_.
+    std::unordered_set<std::string> knownCollections_; ///< Collections known to exist.
+};
+
+/**
+ * @brief Fan-out transfer stage copying each artifact to several destinations.
+ *
+ * The artifact is read from disk once into shared buffers that are streamed to every
+ * destination concurrently, one worker per destination. Each destination keeps its own
+ * progress and failure state; a destination that fails (or cannot stream) is retried on
+ * its own without affecting the others.
+ */
+class FanOutTransferStrategy : public TransferStrategy {
+public:
+    /**
+     * @brief Constructs a fan-out stage.
+     *
+     * @param destinations Destinations receiving every artifact.
+     * @param config JSON "transfer" section with optional chunk_size, queue_depth and retries.
+     */
+    FanOutTransferStrategy(std::vector<std::unique_ptr<TransferStrategy>> destinations, const Json::Value& config);
+
+    /**
+     * @brief Transfers a file to all destinations with a single local read.
+     *
+     * @param sourceFile Path to the local file.
+     * @param destinationPath Remote directory path.
+     * @return std::expected<void, std::string> Success, or an error listing the destinations that failed.
+     */
+    std::expected<void, std::string> transfer(const std::string& sourceFile, const std::string& destinationPath) override;
+
+    std::string name() const override;
+
+    bool supportsStreaming() const override { return true; }
+
+    /**
+     * @brief Opens a sink that forwards every block to all destinations.
+     *
+     * @param sourceFile Path to the local file, used for naming and per-destination retries.
+     * @param destinationPath Remote directory path.
+     * @return std::expected<std::unique_ptr<TransferSink>, std::string> Open sink or an error message.
+     */
+    std::expected<std::unique_ptr<TransferSink>, std::string> openSink(const std::string& sourceFile,
+                                                                        const std::string& destinationPath) override;
+
+    /**
+     * @brief Applies remote retention on every destination.
+     *
+     * @param directories Remote subdirectories to prune.
+     * @param threshold Artifacts last modified before this point in time are removed.
+     * @return std::expected<size_t, std::string> Total removed artifacts or an error message.
+     */
+    std::expected<size_t, std::string> pruneRemote(const std::vector<std::string>& directories,
+                                                   std::chrono::system_clock::time_point threshold) override;
+
+    /**
+     * @brief Downloads a file from the first destination that can provide it.
+     *
+     * @param remotePath File path relative to the destination roots.
+     * @param localFile Local file to write.
+     * @return std::expected<void, std::string> Success, or an error listing every destination's failure.
+     */
+    std::expected<void, std::string> fetch(const std::string& remotePath, const std::string& localFile) override;
+
+    void attachMetrics(TransferMetrics* metrics) override;
+
+private:
+    class Upload; ///< TransferSink distributing shared buffers to per-destination workers.
+
+    std::vector<std::unique_ptr<TransferStrategy>> destinations_; ///< Fan-out targets.
+    size_t chunkSize_; ///< Bytes per shared read buffer.
+    size_t queueDepth_; ///< Buffers queued per destination before the reader waits.
+    int retries_; ///< Extra attempts for a destination whose stream failed.
+};
+
+/**
+ * @brief Content-addressed repository layered on top of another destination.
+ *
+ * Artifacts are split into content-defined chunks (gear-hash rolling boundaries) identified by
+ * their SHA-256. Chunks already present remotely, according to a locally cached chunk index,
+ * are skipped; new chunks are grouped into pack files. Each upload also stores a small snapshot
+ * manifest describing the artifact's chunk layout, so offsite traffic scales with actual churn.
+ *
+ * Remote layout below the destination root: repo/packs/pack-<sha256>.pack and
+ * repo/snapshots/<destinationPath>/<artifact>.manifest.json. A copy of every manifest is kept in
+ * the state folder; the kept manifests decide which packs are still needed when the remote is
+ * pruned, so the repository assumes it is the only writer of its remote packs.
+ */
+class RepositoryTransferStrategy : public TransferStrategy {
+public:
+    /**
+     * @brief Constructs a repository on top of a destination.
+     *
+     * @param inner Destination that stores packs and manifests.
+     * @param config JSON destination section with optional avg_chunk_size and pack_size.
+     * @param stateFolder Local directory holding the chunk index cache and pack staging files.
+     */
+    RepositoryTransferStrategy(std::unique_ptr<TransferStrategy> inner, const Json::Value& config, const std::string& stateFolder);
+
+    /**
+     * @brief Uploads only the chunks of a file that the repository does not hold yet.
+     *
+     * @param sourceFile Path to the local file.
+     * @param destinationPath Snapshot group (e.g., "sys" or "db").
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    std::expected<void, std::string> transfer(const std::string& sourceFile, const std::string& destinationPath) override;
+
+    std::string name() const override;
+
+    bool supportsStreaming() const override { return true; }
+
+    /**
+     * @brief Opens a streaming upload that chunks written data as it arrives.
+     *
+     * Uploads share the chunk index; each write and the commit hold the repository lock, so a
+     * paused upload does not block others.
+     *
+     * @param sourceFile Path to the local file; its name is used for the snapshot manifest.
+     * @param destinationPath Snapshot group (e.g., "sys" or "db").
+     * @return std::expected<std::unique_ptr<TransferSink>, std::string> Open sink or an error message.
+     */
+    std::expected<std::unique_ptr<TransferSink>, std::string> openSink(const std::string& sourceFile,
+                                                                        const std::string& destinationPath) override;
+
+    /**
+     * @brief Removes expired snapshot manifests, then the packs no kept manifest references.
+     *
+     * Packs holding any chunk of a kept manifest stay whole. Needs a destination that can remove
+     * single files; otherwise only the manifests are pruned by age and packs are kept.
+     *
+     * @param directories Snapshot groups to prune.
+     * @param threshold Manifests uploaded before this point in time are removed.
+     * @return std::expected<size_t, std::string> Number of removed manifests and packs or an error message.
+     */
+    std::expected<size_t, std::string> pruneRemote(const std::vector<std::string>& directories,
+                                                   std::chrono::system_clock::time_point threshold) override;
+
+    /**
+     * @brief Rebuilds an artifact from its snapshot manifest and packs.
+     *
+     * Each pack is downloaded once; every chunk and the reassembled artifact are checked against
+     * their SHA-256 before the local file is put in place.
+     *
+     * @param remotePath Snapshot group and artifact name (e.g., "sys/backup.tar.gz").
+     * @param localFile Local file to write.
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    std::expected<void, std::string> fetch(const std::string& remotePath, const std::string& localFile) override;
+
+    void attachMetrics(TransferMetrics* metrics) override;
+
+private:
+    /**
+     * @brief Location of a stored chunk inside a pack.
+     */
+    struct ChunkLocation {
+        std::string pack; ///< Pack identifier (SHA-256 of the pack file).
+        uint64_t offset; ///< Byte offset of the chunk in the pack.
+        uint64_t length; ///< Chunk length in bytes.
+    };
+
+    class PackBuilder; ///< Accumulates new chunks and uploads them as pack files.
+    class Upload; ///< TransferSink chunking written data and uploading new packs and the manifest.
+
+    /**
+     * @brief Loads the cached chunk index on first use.
+     */
+    void loadIndex();
+
+    /**
+     * @brief Removes the remote packs that no kept manifest references and drops them from the index.
+     *
+     * @return std::expected<size_t, std::string> Number of removed packs or an error message.
+     */
+    std::expected<size_t, std::string> collectPacks();
+
+    std::unique_ptr<TransferStrategy> inner_; ///< Destination storing packs and manifests.
+    std::string stateFolder_; ///< Local directory for the index cache and staging files.
+    std::string indexFile_; ///< Cached remote chunk index (one chunk per line).
+    std::string snapshotFolder_; ///< Local copies of the uploaded manifests, one folder per group.
+    size_t avgChunkSize_; ///< Target average chunk size in bytes.
+    size_t packSize_; ///< Pack size that triggers an upload.
+    bool indexLoaded_ = false; ///< True once indexFile_ has been read.
+    std::unordered_map<std::string, ChunkLocation> index_; ///< Chunks known to be stored remotely.
+    std::mutex mutex_; ///< Serializes uploads sharing the index.
 };
 
 /**
@@ -321,6 +1083,7 @@ public:
 private:
     std::string botToken; ///< Telegram bot token.
     std::string chatId; ///< Telegram chat ID.
+    std::mutex mutex_; ///< Serializes sends from the run and the upload worker.
 };
 
 /**
@@ -351,6 +1114,15 @@ public:
 private:
     std::string emailTo; ///< Recipient email address.
     std::string smtpServer; ///< SMTP server address.
+    std::mutex mutex_; ///< Serializes sends from the run and the upload worker.
+};
+
+/**
+ * @brief Parts of the system a backup run covers.
+ */
+struct BackupTargets {
+    bool files = true; ///< Archive the backup directories.
+    bool databases = true; ///< Dump the configured databases.
 };
 
 /**
@@ -371,21 +1143,38 @@ public:
      */
     Backup(const std::string& configFile);
 
+    /**
+     * @brief Stops background deletion; files left in the trash are removed by the next instance.
+     */
+    ~Backup();
+
     /**
      * @brief Executes a backup.
      *
-     * Performs a backup of the specified type, coordinating database and file backups.
+     * Performs a backup of the specified type, coordinating database and file backups, and
+     * writes a run report with transfer measurements to the reports folder.
+     *
+     * Runs may overlap (e.g., when started by the scheduler): runs writing file archives are
+     * serialized with each other and with synthetic fulls, while database-only runs proceed
+     * alongside them.
      *
-     * @param type Backup type ("daily", "monthly", "yearly").
+     * @param type Backup type ("hourly", "daily", "weekly", "monthly", "yearly").
      * @param fullBackup If true, performs a full backup; otherwise, incremental.
+     * @param level Dump level (0 full, N > 0 changes since the last backup of a lower level);
+     *        overrides fullBackup unless it is FileBackupStrategy::kSinceLastRun.
+     * @param targets Whether to archive files, dump databases, or both.
      * @return std::expected<void, std::string> Success or an error message.
      */
-    std::expected<void, std::string> execute(const std::string& type, bool fullBackup = false);
+    std::expected<void, std::string> execute(const std::string& type, bool fullBackup = false,
+                                             int level = FileBackupStrategy::kSinceLastRun, BackupTargets targets = {});
 
     /**
      * @brief Cleans up old backup files.
      *
-     * Removes backups older than the retention period specified in the configuration.
+     * Removes backups older than the retention period specified in the configuration. When a
+     * GFS policy is configured ("retention" section) and the catalog is enabled, runs are pruned
+     * by that policy instead (see retention_policy.hpp). When remote retention is enabled, the
+     * remote sys/ and db/ folders are pruned up to the same age, or up to the oldest retained run.
      *
      * @return std::expected<void, std::string> Success or an error message.
      */
@@ -400,10 +1189,57 @@ public:
      */
     std::chrono::system_clock::time_point getNextBackupTime() const;
 
+    /**
+     * @brief Restores a file archive into scratch space and compares it with the live tree.
+     *
+     * Extracts the archive (frames in parallel, at background priority by default), hashes every
+     * restored file and compares it with the source file it was taken from. Files changed or
+     * removed since the backup are counted separately and do not fail the test. A JSON report is
+     * written to the reports folder and the scratch directory is removed afterwards.
+     *
+     * @param archivePath Archive to test; empty selects the newest file archive.
+     * @return std::expected<void, std::string> Success, or an error if the archive could not be
+     *         restored or restored content differs from unchanged source files.
+     */
+    std::expected<void, std::string> runRestoreTest(const std::string& archivePath = "");
+
+    /**
+     * @brief Builds a full file archive from the last full backup and the incrementals after it.
+     *
+     * Assembles the files of the latest catalog run from the archives that stored them (see
+     * synthetic_full.hpp), at background priority and without reading the source directories.
+     * The result is verified, recorded in the catalog as a full run, uploaded through the
+     * transfer scheduler, and retention is applied, so older chains can expire while incrementals
+     * continue from the new full. File backups wait only until the new run is cataloged. Like
+     * execute(), the run writes a report with its transfer metrics.
+     *
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    std::expected<void, std::string> synthesizeFull();
+
+    /**
+     * @brief Restores the state of a catalog run into a directory.
+     *
+     * Plans the restore from the catalog (see restore_planner.hpp) so every file is extracted once,
+     * from the archive holding its version at that run, with the frames of all archives of the
+     * chain extracted in parallel. Restored content is checked against the catalog digests.
+     *
+     * @param targetDir Directory the files are restored below; created if missing.
+     * @param run Run sequence number (0 selects the latest run).
+     * @param prefix Source path prefix to restore (empty restores every file).
+     * @return std::expected<void, std::string> Success, or an error if the restore could not be
+     *         planned, a file could not be restored or restored content differs from the catalog.
+     */
+    std::expected<void, std::string> restore(const std::string& targetDir, uint32_t run = 0, const std::string& prefix = "");
+
     /**
      * @brief Runs the backup system in daemon mode.
      *
-     * Executes scheduled backups in a loop until interrupted.
+     * Runs the jobs of the "scheduler" section (see job_scheduler.hpp) until interrupted, or,
+     * without jobs, the backup of the "schedule" section and the scheduled restore test.
+     *
+     * On Linux the configuration file is watched; a changed file is applied between jobs (see
+     * reloadConfig()), so schedule updates take effect without a restart.
      *
      * @note On Windows, signal handling is limited to SIGINT/SIGTERM. Use Ctrl+C to stop.
      */
@@ -411,20 +1247,133 @@ public:
 
 private:
     /**
-     * @brief Verifies the integrity of a backup file.
+     * @brief Performs the backup steps of execute().
+     *
+     * @param type Backup type ("hourly", "daily", "weekly", "monthly", "yearly").
+     * @param level Dump level (0 for a full backup) or FileBackupStrategy::kSinceLastRun.
+     * @param targets Whether to archive files, dump databases, or both.
+     * @param metrics Collector for transfer measurements of this run.
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    std::expected<void, std::string> runBackup(const std::string& type, int level, BackupTargets targets, TransferMetrics& metrics);
+
+    /**
+     * @brief Performs the steps of synthesizeFull().
+     *
+     * @param metrics Collector for transfer measurements of this run.
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    std::expected<void, std::string> runSynthesizeFull(TransferMetrics& metrics);
+
+    /**
+     * @brief Creates a run's transfer metrics collector and attaches it to the transfer strategy.
+     */
+    std::shared_ptr<TransferMetrics> attachRunMetrics();
+
+    /**
+     * @brief Detaches a finished run's collector, handing the strategy to the newest active run.
+     */
+    void detachRunMetrics(const std::shared_ptr<TransferMetrics>& metrics);
+
+    /**
+     * @brief Records a run without a file archive in the catalog, carrying the file state forward.
      *
-     * Checks if the backup file is a valid tar.gz archive.
+     * Keeps database-only runs listed with their artifacts, so retention treats them like other
+     * runs. Caller must hold catalogMutex_.
+     *
+     * @param run Run to commit.
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    std::expected<void, std::string> commitWithoutFiles(CatalogRun run);
+
+    /**
+     * @brief Builds the daemon's jobs from a configuration.
+     *
+     * @param source Configuration to read the jobs from.
+     * @return std::expected<std::vector<ScheduledJob>, std::string> Jobs or a configuration error.
+     */
+    std::expected<std::vector<ScheduledJob>, std::string> scheduledJobs(const BackupConfig& source);
+
+    /**
+     * @brief Applies a changed configuration file to the running daemon.
+     *
+     * Runs as a JobScheduler::whenIdle() task, so no job sees a half-applied configuration. The
+     * file is parsed and validated first and ignored (with an error logged) if it is invalid.
+     * Only components whose sections changed are rebuilt; the others, including open transfer
+     * sessions, are kept.
+     *
+     * @param scheduler The daemon's scheduler, reconfigured if the jobs changed.
+     */
+    void reloadConfig(JobScheduler& scheduler);
+
+    /**
+     * @brief Creates the file backup strategy from the configuration and attaches the load monitor and change journal.
+     */
+    void buildFileStrategy();
+
+    /**
+     * @brief Starts the change journal of the backup directories if the "journal" section asks for one.
+     */
+    void startChangeJournal();
+
+    /**
+     * @brief Logs a message from a background thread, safe against a concurrent reload.
+     */
+    void logBackgroundMessage(const std::string& message);
+
+    /**
+     * @brief Logs an error from a background thread, safe against a concurrent reload.
+     */
+    void logBackgroundError(const std::string& message);
+
+    /**
+     * @brief Deletes the artifacts of runs a GFS policy does not keep and removes them from the catalog.
+     *
+     * @param policy Retention policy.
+     * @return std::expected<std::chrono::system_clock::time_point, std::string> Start time of the
+     *         oldest retained run, or an error message.
+     */
+    std::expected<std::chrono::system_clock::time_point, std::string> applyRetentionPolicy(const RetentionPolicy& policy);
+
+    /**
+     * @brief Calculates the next run time of a schedule.
+     *
+     * @param scheduleType "daily", "weekly" or "monthly".
+     * @param scheduleTime Time of day ("HH:MM:SS").
+     * @param scheduleDayOfWeek Day name for weekly schedules.
+     * @param scheduleDayOfMonth Day for monthly schedules.
+     * @return std::chrono::system_clock::time_point The next run time.
+     * @throws std::runtime_error If the schedule is invalid.
+     */
+    std::chrono::system_clock::time_point nextRunTime(const std::string& scheduleType, const std::string& scheduleTime,
+                                                      const std::string& scheduleDayOfWeek, int scheduleDayOfMonth) const;
+
+    /**
+     * @brief Writes the JSON run report and, if configured, the Prometheus textfile.
      *
-     * @param backupFile Path to the backup file.
-     * @return std::expected<bool, std::string> True if valid, or an error message.
+     * @param type Backup type of the run.
+     * @param started Start time of the run.
+     * @param result Outcome of the run.
+     * @param metrics Transfer measurements of the run.
      */
-    std::expected<bool, std::string> verifyBackup(const std::string& backupFile);
+    void writeRunReport(const std::string& type, std::chrono::system_clock::time_point started,
+                        const std::expected<void, std::string>& result, const TransferMetrics& metrics);
 
+    std::string configFile_; ///< Path the configuration was read from.
+    std::mutex configMutex_; ///< Held while a reload replaces config, for loggers on background threads (outlives them).
     BackupConfig config; ///< Backup configuration.
     std::unique_ptr<DatabaseBackupStrategy> dbStrategy; ///< Database backup strategy.
     std::unique_ptr<FileBackupStrategy> fileStrategy; ///< File backup strategy.
     std::unique_ptr<TransferStrategy> transferStrategy; ///< Remote transfer strategy.
     std::unique_ptr<NotificationStrategy> notificationStrategy; ///< Notification strategy.
+    std::unique_ptr<TrashCollector> trash; ///< Background deleter for expired artifacts.
+    std::unique_ptr<LoadMonitor> loadMonitor; ///< Delays and throttles work while the host is busy (may be null).
+    std::unique_ptr<ChangeJournal> changeJournal; ///< Changes below the backup directories while the daemon runs (may be null).
+    std::mutex archiveMutex_; ///< Serializes runs that write file archives (taken before catalogMutex_).
+    std::mutex catalogMutex_; ///< Serializes catalog commits and retention.
+    std::mutex metricsMutex_; ///< Guards activeMetrics_ and retiredMetrics_.
+    std::vector<std::shared_ptr<TransferMetrics>> activeMetrics_; ///< Collectors of running backups; the newest is attached.
+    std::vector<std::shared_ptr<TransferMetrics>> retiredMetrics_; ///< Finished collectors that uploads of overlapping runs may still use.
 };
 
 #endif // BACKUP_HPP
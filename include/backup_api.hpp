@@ -13,8 +13,10 @@
 #ifndef BACKUP_API_HPP
 #define BACKUP_API_HPP
 
+#include "archive_index.hpp"
 #include <string>
 #include <expected>
+#include <vector>
 #include <json/json.h>
 
 /**
@@ -30,11 +32,13 @@ public:
      *
      * Initiates a backup of the specified type, using the configuration from backup_config.json.
      *
-     * @param type Backup type ("daily", "monthly", "yearly").
+     * @param type Backup type ("hourly", "daily", "weekly", "monthly", "yearly").
      * @param fullBackup If true, performs a full backup; otherwise, incremental.
+     * @param level Dump level (0 full, N > 0 changes since the last backup of a lower level);
+     *        -1 keeps the behavior selected by fullBackup.
      * @return std::expected<void, std::string> Success or an error message.
      */
-    static std::expected<void, std::string> startBackup(const std::string& type, bool fullBackup = false);
+    static std::expected<void, std::string> startBackup(const std::string& type, bool fullBackup = false, int level = -1);
 
     /**
      * @brief Updates the backup schedule.
@@ -46,6 +50,21 @@ public:
      * @note The JSON file path is defined in the configuration (e.g., backup_config.json).
      */
     static std::expected<void, std::string> updateSchedule(const Json::Value& schedule);
+
+    /**
+     * @brief Lists the entries of a file archive.
+     *
+     * Uses the archive's `.idx` entry index, so listing and searching take milliseconds
+     * regardless of archive size. Archives without an index (written by older versions) are
+     * scanned header by header instead.
+     *
+     * @param archivePath Archive to list.
+     * @param pattern Glob matched against entry names ("*" lists everything).
+     * @return std::expected<std::vector<ArchiveIndexEntry>, std::string> Matching entries sorted by
+     *         path, or an error message.
+     */
+    static std::expected<std::vector<ArchiveIndexEntry>, std::string> listArchive(const std::string& archivePath,
+                                                                                  const std::string& pattern = "*");
 };
 
 #endif // BACKUP_API_HPP
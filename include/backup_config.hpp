@@ -53,7 +53,7 @@ public:
      * @brief Logs a message to the configured log file.
      *
      * @param message Message to log.
-     * @note Ensures the log file directory exists on all platforms.
+     * @note Ensures the log file directory exists on all platforms. Safe to call from any thread.
      */
     void logMessage(const std::string& message) const;
 
@@ -61,7 +61,7 @@ public:
      * @brief Logs an error to the configured error log file.
      *
      * @param message Error message to log.
-     * @note Ensures the error log file directory exists on all platforms.
+     * @note Ensures the error log file directory exists on all platforms. Safe to call from any thread.
      */
     void logError(const std::string& message) const;
 
@@ -78,22 +78,41 @@ public:
     std::string backupBase;                         ///< Base directory for backups (e.g., "/var/backups/securevault/").
     std::string sysBackupFolder;                    ///< Directory for system backups.
     std::string dbBackupFolder;                     ///< Directory for database backups.
+    std::string stateFolder;                        ///< Directory for caches and indexes kept between runs.
+    std::string reportFolder;                       ///< Directory for per-run JSON reports.
+    std::string catalogFolder;                      ///< Directory of the backup catalog (empty disables it).
+    std::string metricsTextfile;                    ///< Prometheus textfile written after each run (empty disables).
     std::vector<std::string> backupDirs;            ///< Directories to back up.
     std::vector<std::string> excludeExtensions;     ///< File extensions to exclude.
+    uint64_t archiveFrameSize;                      ///< Uncompressed bytes per gzip frame of the file archive (0 disables framing).
     int retentionDays;                              ///< Number of days to retain backups.
+    Json::Value retentionConfig;                    ///< GFS retention counts (keep_hourly ... keep_yearly).
+    Json::Value trashConfig;                        ///< Background deletion pacing (rate, truncation step).
+    bool remoteRetention;                           ///< Apply the retention policy to the SFTP destination as well.
     std::string logFile;                            ///< Path to the log file.
     std::string errorLogFile;                       ///< Path to the error log file.
     std::string lastBackupFile;                     ///< Path to the last backup timestamp file.
+    std::string levelsFile;                         ///< Path to the per-level backup reference times.
     std::vector<DatabaseConfig> databases;          ///< List of database configurations.
     Json::Value sftpConfig;                         ///< SFTP configuration for remote transfers.
+    Json::Value destinationsConfig;                 ///< Additional transfer destinations (array of typed sections).
+    Json::Value transferConfig;                     ///< Transfer stage tuning (chunk size, queue depth, retries).
+    Json::Value verifyConfig;                       ///< Artifact verification tuning (thread count).
+    Json::Value restoreTestConfig;                  ///< Restore-test job settings (schedule, sample size, scratch space).
+    Json::Value schedulerConfig;                    ///< Scheduler slot pools and cron jobs.
+    Json::Value loadConfig;                         ///< Load limits that delay and throttle background work.
+    Json::Value journalConfig;                      ///< Change journal that replaces directory walks in the daemon.
     Json::Value telegramConfig;                     ///< Telegram configuration for notifications.
     Json::Value emailConfig;                        ///< Email configuration for notifications.
     std::string scheduleType;                       ///< Schedule type ("daily", "weekly", "monthly").
     std::string scheduleTime;                       ///< Schedule time (e.g., "15:25:00").
     std::string scheduleDayOfWeek;                  ///< Day of week for weekly schedules.
     int scheduleDayOfMonth;                         ///< Day of month for monthly schedules.
+    int scheduleLevel;                              ///< Dump level of scheduled backups (-1 for none).
     std::string username;                           ///< User for file ownership (Linux/macOS only).
 
+    Json::Value json;                               ///< The parsed file, to tell which sections a reload changed.
+
     std::string mysqlUser;                          ///< Legacy MySQL username.
     std::optional<std::string> mysqlPassword;       ///< Legacy MySQL password.
 };
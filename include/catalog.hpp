@@ -0,0 +1,212 @@
+/**
+ * @file catalog.hpp
+ * @brief Catalog of backup runs and the file versions they hold.
+ *
+ * Every run commits a state segment to `<backup_base>/state/catalog/`: one record per file
+ * present in the backed-up directories at the time of the run, sorted by path, with size,
+ * mtime, SHA-256 and the run and tar offset whose archive holds that content. Files unchanged
+ * by an incremental run point at the run that last stored them, so a single segment describes
+ * the complete tree of its run and deleted files are simply absent. Runs that archived no files
+ * (database-only runs) write no segment and share the one of the run whose state they carry.
+ * The path index lists every path ever seen with the runs that stored or changed it; each run
+ * writes its changes to a small delta, and deltas are merged into the main index once enough
+ * have accumulated. `runs.json` lists the runs and their artifacts.
+ *
+ * Segments and the path index are binary files of fixed-size records followed by a string
+ * blob. They are memory-mapped and binary-searched, so path lookups read a few pages per run
+ * and never touch an archive. The files use the host byte order and are rejected on a host
+ * with a different one.
+ */
+
+#ifndef CATALOG_HPP
+#define CATALOG_HPP
+
+#include <array>
+#include <cstdint>
+#include <expected>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A file seen by a backup run, as collected by the file backup strategy.
+ */
+struct ManifestEntry {
+    static constexpr uint64_t kUnknownOffset = std::numeric_limits<uint64_t>::max();
+    static constexpr uint32_t kNoFrame = std::numeric_limits<uint32_t>::max();
+
+    std::string sourcePath; ///< Absolute path of the source file.
+    std::string archivePath; ///< Entry name inside the archive.
+    uint64_t size = 0; ///< File size.
+    int64_t mtime = 0; ///< Modification time (seconds since the epoch).
+    bool stored = false; ///< The file was written to this run's archive.
+    uint64_t archiveOffset = kUnknownOffset; ///< Offset of the entry header in the uncompressed tar stream.
+    uint32_t frame = kNoFrame; ///< Frame holding the entry header (framed archives only).
+    std::array<uint8_t, 32> sha256{}; ///< Content digest (all zero when unknown).
+};
+
+/**
+ * @brief Thread-safe collection of the files seen by one run.
+ */
+class FileManifest {
+public:
+    /**
+     * @brief Records a file; later records for the same path replace unchanged ones.
+     */
+    void add(ManifestEntry entry);
+
+    /**
+     * @brief Returns the records sorted by source path, one per path.
+     */
+    std::vector<ManifestEntry> take();
+
+private:
+    std::mutex mutex_; ///< Guards entries_.
+    std::vector<ManifestEntry> entries_; ///< Records in arrival order.
+};
+
+/**
+ * @brief An artifact produced by a run.
+ */
+struct CatalogArtifact {
+    std::string path; ///< Local artifact path.
+    std::string artifactClass; ///< Artifact class ("sys", "db").
+    uint64_t size = 0; ///< Artifact size in bytes.
+};
+
+/**
+ * @brief A committed backup run.
+ */
+struct CatalogRun {
+    uint32_t sequence = 0; ///< Run number, assigned on commit (starting at 1).
+    std::string name; ///< Run timestamp ("YYYYmmdd-HHMMSS").
+    std::string type; ///< Backup type ("hourly" ... "yearly", or "synthetic").
+    int64_t started = 0; ///< Start time (seconds since the epoch).
+    bool full = false; ///< Full backup; incremental runs depend on earlier runs.
+    int level = -1; ///< Dump level of the run (-1 if it was run without one).
+    uint64_t files = 0; ///< Files present in the source tree.
+    uint64_t storedFiles = 0; ///< Files written to this run's archive.
+    uint64_t storedBytes = 0; ///< Bytes written to this run's archive.
+    std::vector<CatalogArtifact> artifacts; ///< Artifacts of the run.
+    std::vector<uint32_t> dependsOn; ///< Earlier runs whose archives hold files of this run's state.
+    uint32_t stateRun = 0; ///< Run whose state segment this run shares (0 if it has its own).
+};
+
+/**
+ * @brief A file as recorded in one run's state.
+ */
+struct FileVersion {
+    uint32_t run = 0; ///< Run whose state holds the record.
+    uint32_t storedRun = 0; ///< Run whose archive holds the content (0 if unknown).
+    std::string sourcePath; ///< Absolute path of the source file.
+    std::string archivePath; ///< Entry name inside the archive.
+    uint64_t size = 0; ///< File size.
+    int64_t mtime = 0; ///< Modification time (seconds since the epoch).
+    std::string sha256; ///< Hex content digest (empty if unknown).
+    uint64_t archiveOffset = ManifestEntry::kUnknownOffset; ///< Entry header offset in the tar stream.
+    uint32_t frame = ManifestEntry::kNoFrame; ///< Frame holding the entry header.
+};
+
+/**
+ * @brief Reads and updates the backup catalog.
+ */
+class Catalog {
+public:
+    /**
+     * @brief Opens the catalog in a directory (created on the first commit).
+     *
+     * @param directory Catalog directory.
+     */
+    explicit Catalog(std::string directory);
+
+    /**
+     * @brief Commits a run: writes its state segment, merges the path index and lists the run.
+     *
+     * Unchanged files are resolved against the previous run's state, so they keep pointing at
+     * the archive that stored them.
+     *
+     * @param run Run to commit; its sequence number is assigned.
+     * @param entries Files seen by the run, sorted by source path (see FileManifest::take()).
+     * @return std::expected<CatalogRun, std::string> The committed run or an error message.
+     */
+    std::expected<CatalogRun, std::string> commitRun(CatalogRun run, const std::vector<ManifestEntry>& entries);
+
+    /**
+     * @brief Commits a run that archived no files, carrying the latest run's file state forward.
+     *
+     * No segment is written: the run shares the latest run's and depends on the same archives.
+     *
+     * @param run Run to commit; its sequence number is assigned.
+     * @return std::expected<CatalogRun, std::string> The committed run, or an error if the catalog has no runs.
+     */
+    std::expected<CatalogRun, std::string> commitRunWithoutFiles(CatalogRun run);
+
+    /**
+     * @brief Lists the committed runs, oldest first.
+     */
+    std::expected<std::vector<CatalogRun>, std::string> runs() const;
+
+    /**
+     * @brief Removes runs from the run list and deletes their state segments.
+     *
+     * Segments still shared by a remaining run are kept. The path index keeps the paths;
+     * lookups skip runs whose segment is gone.
+     *
+     * @param sequences Runs to remove.
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    std::expected<void, std::string> removeRuns(const std::vector<uint32_t>& sequences);
+
+    /**
+     * @brief Finds paths ever backed up that match a glob pattern.
+     *
+     * @param pattern Glob (`*`, `?`, `[...]`) matched against absolute source paths; `*` also matches `/`.
+     * @return std::expected<std::vector<std::string>, std::string> Matching paths, sorted.
+     */
+    std::expected<std::vector<std::string>, std::string> find(const std::string& pattern) const;
+
+    /**
+     * @brief Lists the distinct stored versions of a file, oldest first.
+     *
+     * Reads only the segments of runs the path index lists as having stored or changed the path.
+     *
+     * @param path Absolute source path.
+     * @return std::expected<std::vector<FileVersion>, std::string> One record per run that stored new content.
+     */
+    std::expected<std::vector<FileVersion>, std::string> versions(const std::string& path) const;
+
+    /**
+     * @brief Returns the state of a run below a path prefix.
+     *
+     * @param run Run sequence number (0 selects the latest run).
+     * @param prefix Source path prefix (empty returns every file).
+     * @return std::expected<std::vector<FileVersion>, std::string> Records sorted by path.
+     */
+    std::expected<std::vector<FileVersion>, std::string> snapshot(uint32_t run, const std::string& prefix = "") const;
+
+private:
+    std::string segmentPath(uint32_t run) const;
+    std::string pathDeltaPath(uint32_t run) const;
+
+    /**
+     * @brief Returns the run whose segment holds a run's file state.
+     */
+    static uint32_t stateRunOf(const CatalogRun& run);
+
+    /**
+     * @brief Lists the main path index (if any) followed by the deltas, oldest first.
+     */
+    std::vector<std::string> pathIndexFiles() const;
+
+    /**
+     * @brief Folds every delta into the main path index, dropping runs no longer listed.
+     */
+    std::expected<void, std::string> mergePathIndex(const std::vector<CatalogRun>& listed) const;
+
+    std::expected<void, std::string> writeRuns(const std::vector<CatalogRun>& runs) const;
+
+    std::string directory_; ///< Catalog directory.
+};
+
+#endif // CATALOG_HPP
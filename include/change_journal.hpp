@@ -0,0 +1,163 @@
+/**
+ * @file change_journal.hpp
+ * @brief Records changes below the backup directories between runs, so incremental runs need not walk them.
+ *
+ * While the daemon runs, the journal collects the paths of files and directories created,
+ * modified, removed or renamed below the watched roots, each with the time it was seen. An
+ * incremental run asks for the paths changed since its reference time and only looks at those
+ * (a directory stands for its whole subtree) instead of walking and stat'ing every file.
+ *
+ * Two Linux backends exist. fanotify with filesystem marks (Linux 5.9, CAP_SYS_ADMIN and
+ * CAP_DAC_READ_SEARCH) watches whole filesystems with a single mark each and never misses a new
+ * directory; recursive inotify needs one watch per directory (limited by
+ * fs.inotify.max_user_watches) and is used when fanotify is not permitted. A journal only answers
+ * for periods it covered completely: after a start, or after its event queue overflowed, it
+ * answers nothing for earlier reference times, and runs fall back to a full walk.
+ */
+
+#ifndef CHANGE_JOURNAL_HPP
+#define CHANGE_JOURNAL_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <expected>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <json/json.h>
+
+/**
+ * @brief Change journal of a set of directory trees.
+ *
+ * Configured from the "journal" section: "backend" ("auto", "fanotify" or "inotify"; default
+ * "auto") and "max_paths" (default 1000000; more distinct changed paths reset the journal).
+ */
+class ChangeJournal {
+public:
+    using Clock = std::chrono::system_clock;
+    using Logger = std::function<void(const std::string& message)>;
+
+    /**
+     * @brief Reads the settings; call start() to begin watching.
+     *
+     * @param journalConfig The "journal" configuration section.
+     * @param onMessage Called with the backend in use (from any thread).
+     * @param onError Called when the journal resets or stops working (from any thread).
+     */
+    ChangeJournal(const Json::Value& journalConfig, Logger onMessage, Logger onError);
+
+    /**
+     * @brief Stops watching.
+     */
+    ~ChangeJournal();
+
+    ChangeJournal(const ChangeJournal&) = delete;
+    ChangeJournal& operator=(const ChangeJournal&) = delete;
+
+    /**
+     * @brief Starts watching directory trees on a background thread.
+     *
+     * With inotify, every directory below the roots is added before this returns, which takes
+     * about as long as one walk of the tree.
+     *
+     * @param roots Directories to watch.
+     * @return std::expected<void, std::string> Error if no backend can watch the roots.
+     */
+    std::expected<void, std::string> start(const std::vector<std::string>& roots);
+
+    /**
+     * @brief Stops watching; the journal answers nothing afterwards.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the paths changed since a point in time.
+     *
+     * Events already queued by the kernel are read first, so every change made before the call
+     * is included.
+     *
+     * @param since Reference time of an incremental run.
+     * @return std::optional<std::vector<std::string>> Canonical paths, sorted; a directory covers
+     *         its subtree. Nothing if the journal did not watch the whole period.
+     */
+    std::optional<std::vector<std::string>> changedSince(Clock::time_point since);
+
+    /**
+     * @brief Drops changes seen before a point in time that no run will ask about again.
+     */
+    void forgetBefore(Clock::time_point time);
+
+private:
+    /**
+     * @brief Waits for events and records them until stopped.
+     */
+    void readLoop();
+
+    /**
+     * @brief Reads and records every queued event; caller must hold mutex_.
+     */
+    void drain();
+
+    /**
+     * @brief Records a changed path if it lies below a root; caller must hold mutex_.
+     */
+    void record(const std::string& path);
+
+    /**
+     * @brief Forgets all changes and restarts coverage now; caller must hold mutex_.
+     */
+    void reset(const std::string& reason);
+
+    /**
+     * @brief Tries fanotify filesystem marks on all roots.
+     */
+    std::expected<void, std::string> startFanotify();
+
+    /**
+     * @brief Adds inotify watches for all roots.
+     */
+    std::expected<void, std::string> startInotify();
+
+    void drainFanotify();
+    void drainInotify();
+
+    /**
+     * @brief Resolves the directory of a fanotify event from its file handle.
+     */
+    std::optional<std::string> resolveHandle(void* handle) const;
+
+    /**
+     * @brief Adds inotify watches for a directory and everything below it.
+     *
+     * @return false if the watch limit was reached.
+     */
+    bool watchTree(const std::string& dir);
+
+    /**
+     * @brief Removes the inotify watches of a directory and everything below it.
+     */
+    void unwatchTree(const std::string& dir);
+
+    std::string backend_; ///< Requested backend.
+    size_t maxPaths_; ///< Distinct paths kept before the journal resets.
+    Logger onMessage_; ///< Reports the backend.
+    Logger onError_; ///< Reports resets and failures.
+    std::vector<std::string> roots_; ///< Watched directories (canonical).
+
+    int fd_ = -1; ///< fanotify or inotify descriptor.
+    int stopFd_ = -1; ///< eventfd that ends readLoop().
+    bool fanotify_ = false; ///< fd_ is a fanotify group.
+    std::vector<int> mountFds_; ///< Open roots, for resolving fanotify file handles.
+    std::thread reader_; ///< Runs readLoop().
+
+    std::mutex mutex_; ///< Guards the fields below and reading from fd_.
+    std::unordered_map<int, std::string> watches_; ///< inotify watch descriptor to directory.
+    std::unordered_map<std::string, Clock::time_point> changes_; ///< Changed path to the time it was last seen.
+    std::optional<Clock::time_point> coveredSince_; ///< Changes since this time are all recorded (none if broken).
+};
+
+#endif // CHANGE_JOURNAL_HPP
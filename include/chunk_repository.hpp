@@ -0,0 +1,6 @@
+#ifndef CHUNK_REPOSITORY_HPP
+#define CHUNK_REPOSITORY_HPP
+
+#include "backup.hpp"
+
+#endif // CHUNK_REPOSITORY_HPP
@@ -0,0 +1,67 @@
+/**
+ * @file config_watcher.hpp
+ * @brief Notices changes of the configuration file while the daemon runs.
+ *
+ * The watcher adds an inotify watch on the directory holding the file, so it sees the file being
+ * rewritten in place as well as replaced by a rename (as editors and atomic writers do), and
+ * reports a change once the file has been quiet for a short moment, so a burst of writes
+ * produces a single reload.
+ */
+
+#ifndef CONFIG_WATCHER_HPP
+#define CONFIG_WATCHER_HPP
+
+#include <chrono>
+#include <expected>
+#include <functional>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Calls a function whenever a file changes.
+ */
+class ConfigWatcher {
+public:
+    /**
+     * @brief Prepares a watcher; call start() to begin watching.
+     *
+     * @param path File to watch.
+     * @param onChange Called on the watcher's thread after the file changed.
+     */
+    ConfigWatcher(std::string path, std::function<void()> onChange);
+
+    /**
+     * @brief Stops watching.
+     */
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    /**
+     * @brief Starts watching on a background thread.
+     *
+     * @return std::expected<void, std::string> Error if the file's directory cannot be watched.
+     */
+    std::expected<void, std::string> start();
+
+    /**
+     * @brief Stops watching and waits for the watcher's thread.
+     */
+    void stop();
+
+private:
+    /**
+     * @brief Waits for events until stopped.
+     */
+    void readLoop();
+
+    std::string path_; ///< Watched file.
+    std::function<void()> onChange_; ///< Change callback.
+    std::chrono::milliseconds settle_{500}; ///< Quiet time after the last event before reporting.
+    int fd_ = -1; ///< inotify descriptor.
+    int stopFd_ = -1; ///< eventfd that ends readLoop().
+    std::thread reader_; ///< Runs readLoop().
+};
+
+#endif // CONFIG_WATCHER_HPP
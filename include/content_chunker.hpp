@@ -0,0 +1,52 @@
+/**
+ * @file content_chunker.hpp
+ * @brief FastCDC-style content-defined chunking for the chunk repository.
+ *
+ * Boundaries follow content rather than offsets, so an insertion early in a file only changes
+ * the chunks around it. The gear table is fixed, which keeps boundaries stable across runs
+ * and hosts.
+ */
+
+#ifndef CONTENT_CHUNKER_HPP
+#define CONTENT_CHUNKER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Normalized content-defined chunking with min/avg/max bounds.
+ *
+ * Uses a stricter mask before the average size and a looser one after it, which narrows the
+ * chunk size distribution around the average.
+ */
+class Chunker {
+public:
+    /**
+     * @brief Creates a chunker cutting chunks of a quarter to four times the average size.
+     *
+     * @param averageSize Target chunk size (a power of two).
+     */
+    explicit Chunker(size_t averageSize);
+
+    size_t minSize() const { return minSize_; }
+
+    size_t maxSize() const { return maxSize_; }
+
+    /**
+     * @brief Returns the length of the next chunk at the start of data.
+     *
+     * @param data Unchunked bytes; the final chunk of a file is whatever remains.
+     * @param size Number of bytes available.
+     * @return size_t Chunk length, at most maxSize() and, unless size is smaller, above minSize().
+     */
+    size_t cut(const uint8_t* data, size_t size) const;
+
+private:
+    size_t minSize_; ///< Bytes never cut before.
+    size_t averageSize_; ///< Length after which the looser mask applies.
+    size_t maxSize_; ///< Bytes always cut at.
+    uint64_t strictMask_ = 0; ///< Mask used before averageSize_.
+    uint64_t looseMask_ = 0; ///< Mask used after averageSize_.
+};
+
+#endif // CONTENT_CHUNKER_HPP
@@ -0,0 +1,64 @@
+/**
+ * @file cron_schedule.hpp
+ * @brief Cron expressions evaluated in local time.
+ *
+ * Supports the usual five fields (minute, hour, day of month, month, day of week) and an
+ * optional leading seconds field. Each field takes `*`, numbers, ranges (`1-5`), lists
+ * (`1,15`) and steps (`0-59/15`, `10-50/20`, or a step after `*`); months and weekdays also
+ * take three-letter names, and weekday 7 is Sunday like 0. As in cron, when both the day of
+ * month and the day of week are restricted, a day matching either runs; a field starting with
+ * `*`, a step after `*` included, does not count as restricted. `@hourly`, `@daily`, `@weekly`,
+ * `@monthly` and `@yearly` are accepted as shorthands.
+ */
+
+#ifndef CRON_SCHEDULE_HPP
+#define CRON_SCHEDULE_HPP
+
+#include <bitset>
+#include <chrono>
+#include <expected>
+#include <string>
+
+/**
+ * @brief A parsed cron expression.
+ */
+class CronSchedule {
+public:
+    /**
+     * @brief Parses a cron expression.
+     *
+     * @param expression Five or six fields, or an `@` shorthand.
+     * @return std::expected<CronSchedule, std::string> The schedule, or an error naming the bad field.
+     */
+    static std::expected<CronSchedule, std::string> parse(const std::string& expression);
+
+    /**
+     * @brief Returns the first matching time strictly after a point in time.
+     *
+     * Local times that do not exist on the day clocks go forward run at the first instant after
+     * the gap; times repeated on the day clocks go back match once.
+     *
+     * @param after Point in time.
+     * @return std::chrono::system_clock::time_point The next run, or time_point::max() if the
+     *         expression matches no date within the next five years (e.g., February 30).
+     */
+    std::chrono::system_clock::time_point next(std::chrono::system_clock::time_point after) const;
+
+    /**
+     * @brief Returns the expression the schedule was parsed from.
+     */
+    const std::string& expression() const { return expression_; }
+
+private:
+    std::string expression_; ///< Source expression.
+    std::bitset<60> seconds_; ///< Matching seconds.
+    std::bitset<60> minutes_; ///< Matching minutes.
+    std::bitset<24> hours_; ///< Matching hours.
+    std::bitset<32> days_; ///< Matching days of the month (1-31).
+    std::bitset<13> months_; ///< Matching months (1-12).
+    std::bitset<7> weekdays_; ///< Matching weekdays (0 is Sunday).
+    bool anyDay_ = true; ///< The day-of-month field starts with `*`.
+    bool anyWeekday_ = true; ///< The day-of-week field starts with `*`.
+};
+
+#endif // CRON_SCHEDULE_HPP
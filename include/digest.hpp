@@ -0,0 +1,77 @@
+/**
+ * @file digest.hpp
+ * @brief Incremental SHA-256 digest used for artifact integrity checks.
+ *
+ * A small self-contained implementation so streamed data can be hashed on the fly
+ * without pulling in a crypto library dependency.
+ */
+
+#ifndef DIGEST_HPP
+#define DIGEST_HPP
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Incremental SHA-256 hasher.
+ *
+ * Feed data with update() in any block sizes, then call hexDigest() once.
+ */
+class Sha256 {
+public:
+    /**
+     * @brief Constructs a hasher in its initial state.
+     */
+    Sha256();
+
+    /**
+     * @brief Adds data to the digest.
+     *
+     * @param data Bytes to hash.
+     */
+    void update(std::span<const char> data);
+
+    /**
+     * @brief Finalizes the digest.
+     *
+     * @return std::array<uint8_t, 32> Raw digest bytes.
+     * @note The hasher must not be updated after finalization.
+     */
+    std::array<uint8_t, 32> digest();
+
+    /**
+     * @brief Finalizes the digest and returns it as lowercase hex.
+     *
+     * @return std::string 64-character hex digest.
+     */
+    std::string hexDigest();
+
+    /**
+     * @brief Formats raw digest bytes as lowercase hex.
+     *
+     * @param bytes Digest bytes.
+     * @return std::string Hex representation.
+     */
+    static std::string toHex(std::span<const uint8_t> bytes);
+
+    /**
+     * @brief Parses a hex digest as produced by toHex().
+     *
+     * @param hex 64-character hex digest.
+     * @return std::array<uint8_t, 32> Digest bytes (all zero if hex is not a valid digest).
+     */
+    static std::array<uint8_t, 32> fromHex(std::string_view hex);
+
+private:
+    void processBlock(const uint8_t* block);
+
+    std::array<uint32_t, 8> state_; ///< Intermediate hash state.
+    std::array<uint8_t, 64> buffer_; ///< Pending partial block.
+    size_t bufferSize_ = 0; ///< Bytes currently held in buffer_.
+    uint64_t totalBytes_ = 0; ///< Total bytes hashed so far.
+};
+
+#endif // DIGEST_HPP
@@ -0,0 +1,24 @@
+/**
+ * @file file_util.hpp
+ * @brief Durable file replacement for state, index and report files.
+ */
+
+#ifndef FILE_UTIL_HPP
+#define FILE_UTIL_HPP
+
+#include <expected>
+#include <string>
+
+/**
+ * @brief Writes a file atomically by renaming a temporary sibling into place.
+ *
+ * The temporary file is flushed to disk before the rename and, on POSIX systems, the directory
+ * afterwards, so after a crash the path holds either the old or the new contents in full.
+ *
+ * @param path Destination file; parent directories are created.
+ * @param contents File contents.
+ * @return std::expected<void, std::string> Success or an error message.
+ */
+std::expected<void, std::string> writeFileAtomically(const std::string& path, const std::string& contents);
+
+#endif // FILE_UTIL_HPP
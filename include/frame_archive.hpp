@@ -0,0 +1,199 @@
+/**
+ * @file frame_archive.hpp
+ * @brief Framed tar.gz archives: independently decompressible gzip members with a frame index.
+ *
+ * The file archive is written as a sequence of gzip members ("frames") of roughly equal
+ * uncompressed size, each starting at a tar entry boundary. The result is still an ordinary
+ * .tar.gz that any gzip or tar can read, but with the `<archive>.frames` sidecar every frame can
+ * be located, decompressed and checked on its own. This lets verification sample frames instead
+ * of reading the whole archive, and lets restores decompress frames in parallel.
+ *
+ * Sidecar format (text): a "securevault-frames 1" header line, then one line per frame with
+ * compressed offset, compressed size, uncompressed offset, uncompressed size, CRC-32 (hex) and
+ * the number of tar entries that start in the frame.
+ */
+
+#ifndef FRAME_ARCHIVE_HPP
+#define FRAME_ARCHIVE_HPP
+
+#include <archive.h>
+#include <cstdint>
+#include <expected>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+/**
+ * @brief Location and checksum of one gzip member of a framed archive.
+ */
+struct ArchiveFrame {
+    uint64_t compressedOffset = 0; ///< Byte offset of the member in the archive file.
+    uint64_t compressedSize = 0; ///< Member size in the archive file.
+    uint64_t uncompressedOffset = 0; ///< Offset of the frame's data in the tar stream.
+    uint64_t uncompressedSize = 0; ///< Frame size in the tar stream.
+    uint32_t crc32 = 0; ///< CRC-32 of the uncompressed frame (as in the gzip trailer).
+    uint64_t entries = 0; ///< Tar entries whose header starts in this frame.
+};
+
+/**
+ * @brief Returns the frame index path for an archive (`<archive>.frames`).
+ */
+std::string frameIndexPath(const std::string& archivePath);
+
+/**
+ * @brief Loads the frame index of an archive.
+ *
+ * @param archivePath Path to the framed archive.
+ * @return std::expected<std::vector<ArchiveFrame>, std::string> Frames in file order, or an error
+ *         if the sidecar is missing or malformed.
+ */
+std::expected<std::vector<ArchiveFrame>, std::string> readFrameIndex(const std::string& archivePath);
+
+/**
+ * @brief Streaming decompression of one frame, checked against its index entry.
+ *
+ * The CRC-32 and size are checked when the end of the frame is reached, so a frame is only
+ * known to be intact once next() returned an empty block.
+ */
+class FrameReader {
+public:
+    /**
+     * @brief Prepares to read a frame.
+     *
+     * @param archive Open archive file; positioned by the reader.
+     * @param frame Frame to read.
+     */
+    FrameReader(std::ifstream& archive, const ArchiveFrame& frame);
+    ~FrameReader();
+
+    FrameReader(const FrameReader&) = delete;
+    FrameReader& operator=(const FrameReader&) = delete;
+
+    /**
+     * @brief Returns the next block of the frame's tar bytes; an empty span marks a verified end.
+     */
+    std::expected<std::span<const char>, std::string> next();
+
+private:
+    std::ifstream& archive_; ///< Archive file.
+    ArchiveFrame frame_; ///< Frame being read.
+    z_stream stream_; ///< Inflate state.
+    bool ready_ = false; ///< stream_ was initialized.
+    bool ended_ = false; ///< The gzip member ended.
+    uint64_t remainingInput_; ///< Compressed bytes of the frame not yet read from the file.
+    uint64_t produced_ = 0; ///< Uncompressed bytes returned so far.
+    uint32_t crc_ = 0; ///< Running CRC-32 of the returned bytes.
+    std::vector<Bytef> in_; ///< Compressed input buffer.
+    std::vector<Bytef> out_; ///< Decompressed output buffer.
+};
+
+/**
+ * @brief Read state for feeding one frame to libarchive with archive_read_open().
+ */
+struct FrameSource {
+    FrameReader* reader; ///< Frame being read.
+    std::string error; ///< First read error.
+};
+
+/**
+ * @brief libarchive read callback returning the next block of a FrameSource.
+ */
+la_ssize_t readFrameBlock(struct archive* a, void* data, const void** buffer);
+
+/**
+ * @brief libarchive output that compresses the tar stream into frames.
+ *
+ * Install with open(), call startEntry() before each archive_write_header() (after the previous
+ * entry was finished with archive_write_finish_entry(), so its padding stays in its frame), and
+ * call finish() after archive_write_close().
+ */
+class FrameWriter {
+public:
+    /**
+     * @brief Prepares a writer.
+     *
+     * @param path Output archive path.
+     * @param frameSize Uncompressed bytes after which a new frame starts at the next entry.
+     */
+    FrameWriter(std::string path, uint64_t frameSize);
+    ~FrameWriter();
+
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    /**
+     * @brief Opens the output file and attaches the writer to a libarchive handle.
+     *
+     * @param a Archive handle with a format set and no compression filter.
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    std::expected<void, std::string> open(struct archive* a);
+
+    /**
+     * @brief Marks an entry boundary; starts a new frame if the current one is full.
+     */
+    void startEntry();
+
+    /**
+     * @brief Sets the zlib compression level of frames started from now on.
+     *
+     * The current frame keeps its level, so a frame is always compressed uniformly.
+     *
+     * @param level zlib level (Z_DEFAULT_COMPRESSION or 1-9).
+     */
+    void setCompressionLevel(int level) { level_ = level; }
+
+    /**
+     * @brief Returns the offset in the uncompressed tar stream where the next entry starts.
+     */
+    uint64_t position() const { return current_.uncompressedOffset + current_.uncompressedSize; }
+
+    /**
+     * @brief Returns the index of the frame the next entry starts in.
+     */
+    uint32_t frameNumber() const { return static_cast<uint32_t>(frames_.size()); }
+
+    /**
+     * @brief Copies a compressed frame of another framed archive into the output unchanged.
+     *
+     * Ends the current frame first. Call between entries, like startEntry(); the copied frame
+     * must hold whole entries and no end-of-archive marker.
+     *
+     * @param source Open source archive; positioned by the writer.
+     * @param frame Source frame to copy.
+     * @return std::expected<ArchiveFrame, std::string> The frame as placed in the output, or an error message.
+     */
+    std::expected<ArchiveFrame, std::string> appendFrame(std::ifstream& source, const ArchiveFrame& frame);
+
+    /**
+     * @brief Writes the frame index sidecar once the archive is closed.
+     *
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    std::expected<void, std::string> finish();
+
+private:
+    static la_ssize_t writeCallback(struct archive* a, void* data, const void* buffer, size_t length);
+    static int closeCallback(struct archive* a, void* data);
+
+    std::expected<void, std::string> compress(const void* buffer, size_t length);
+    std::expected<void, std::string> endFrame();
+
+    std::string path_; ///< Output archive path.
+    uint64_t frameSize_; ///< Target uncompressed frame size.
+    std::ofstream output_; ///< Archive file.
+    z_stream stream_; ///< Deflate state of the current member.
+    bool deflateReady_ = false; ///< stream_ was initialized.
+    bool frameOpen_ = false; ///< Data was compressed into the current frame.
+    bool closed_ = false; ///< The close callback ran.
+    int level_ = Z_DEFAULT_COMPRESSION; ///< Level for frames started from now on.
+    int appliedLevel_ = Z_DEFAULT_COMPRESSION; ///< Level of stream_.
+    std::string error_; ///< First write error.
+    std::vector<Bytef> buffer_; ///< Deflate output buffer.
+    ArchiveFrame current_; ///< Frame under construction.
+    std::vector<ArchiveFrame> frames_; ///< Completed frames.
+};
+
+#endif // FRAME_ARCHIVE_HPP
@@ -0,0 +1,6 @@
+#ifndef HTTP_TRANSFER_HPP
+#define HTTP_TRANSFER_HPP
+
+#include "backup.hpp"
+
+#endif // HTTP_TRANSFER_HPP
@@ -0,0 +1,16 @@
+/**
+ * @file io_priority.hpp
+ * @brief Scheduling priority helpers for background work.
+ */
+
+#ifndef IO_PRIORITY_HPP
+#define IO_PRIORITY_HPP
+
+/**
+ * @brief Moves the calling thread to the idle I/O class and lowest CPU priority.
+ *
+ * Only the calling thread is affected. A no-op on platforms other than Linux.
+ */
+void enterBackgroundPriority();
+
+#endif // IO_PRIORITY_HPP
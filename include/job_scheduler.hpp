@@ -0,0 +1,232 @@
+/**
+ * @file job_scheduler.hpp
+ * @brief Cron-driven scheduler running several jobs concurrently within shared slots.
+ *
+ * Each job has a cron schedule and needs a number of units from named slot pools (by default
+ * one "cpu" and one "io" unit). Due jobs start on their own thread and wait until all the units
+ * they need are free, so jobs run concurrently only as far as the pools allow. A job that is
+ * still running when it is due again is an overlap: the new run is skipped or queued behind the
+ * running one. The time of every started run is kept in a state file; runs that fell into a
+ * period the daemon was down (or the host was suspended) are missed runs, which are either
+ * skipped or caught up with a single run.
+ */
+
+#ifndef JOB_SCHEDULER_HPP
+#define JOB_SCHEDULER_HPP
+
+#include "cron_schedule.hpp"
+#include "wake_event.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <expected>
+#include <functional>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <json/json.h>
+
+class LoadMonitor;
+
+/**
+ * @brief A job run by the scheduler.
+ */
+struct ScheduledJob {
+    /**
+     * @brief What happens when a job is due while its previous run is still going.
+     */
+    enum class Overlap {
+        Skip, ///< Drop the new run and report it.
+        Queue ///< Run once more as soon as the current run finishes (further runs are coalesced).
+    };
+
+    /**
+     * @brief What happens to runs that were due while the scheduler was not running.
+     */
+    enum class Missed {
+        Skip, ///< Report them and wait for the next scheduled time.
+        RunOnce ///< Run the job once, immediately.
+    };
+
+    std::string name; ///< Unique job name, the key in the state file.
+    CronSchedule schedule; ///< When the job is due.
+    std::map<std::string, unsigned> slots; ///< Units needed from each slot pool.
+    Overlap overlap = Overlap::Skip; ///< Overlap policy.
+    Missed missed = Missed::Skip; ///< Missed-run policy.
+    std::chrono::seconds grace{300}; ///< Lateness after which a due run counts as missed.
+    bool deferUnderLoad = true; ///< Wait for the host's load to drop before starting.
+    std::function<std::expected<void, std::string>()> run; ///< The job itself.
+
+    /**
+     * @brief Reads the scheduling settings of a job (everything except run).
+     *
+     * Keys: "name" (required), "cron" (required), "slots" (object of pool name to units, default
+     * cpu 1 and io 1), "overlap" ("skip" or "queue", default "skip"), "missed" ("skip" or
+     * "run_once", default "skip"), "grace_seconds" (default 300), "defer_under_load" (default true).
+     *
+     * @param job One entry of the "jobs" array.
+     * @return std::expected<ScheduledJob, std::string> The job or an error message.
+     */
+    static std::expected<ScheduledJob, std::string> fromJson(const Json::Value& job);
+};
+
+/**
+ * @brief Runs scheduled jobs until asked to stop.
+ *
+ * Configured from the "scheduler" section: "slots" maps pool names to capacities (default cpu 2,
+ * io 1). A job needing more units of a pool than it has is limited to the pool's capacity.
+ *
+ * Between events the scheduler sleeps until the next due time: it wakes only when a job is due,
+ * a run finishes, wake() is called, a signal handler calls WakeEvent::notifyFromSignal() or the
+ * system clock is set. After the clock was set back, due times are recomputed from the new time;
+ * after it was set forward, the runs it skipped are handled like runs missed during a suspend.
+ */
+class JobScheduler {
+public:
+    using Logger = std::function<void(const std::string& message)>;
+
+    /**
+     * @brief Configures the slot pools.
+     *
+     * @param schedulerConfig The "scheduler" configuration section.
+     * @param stateFile File recording the last started run of each job.
+     * @param onMessage Called with progress messages (from any thread).
+     * @param onError Called with overlaps, missed runs and job failures (from any thread).
+     */
+    JobScheduler(const Json::Value& schedulerConfig, std::string stateFile, Logger onMessage, Logger onError);
+
+    /**
+     * @brief Waits for running jobs.
+     */
+    ~JobScheduler();
+
+    JobScheduler(const JobScheduler&) = delete;
+    JobScheduler& operator=(const JobScheduler&) = delete;
+
+    /**
+     * @brief Adds a job; call before run().
+     *
+     * @return std::expected<void, std::string> Error if the name is taken or a slot pool is unknown.
+     */
+    std::expected<void, std::string> addJob(ScheduledJob job);
+
+    /**
+     * @brief Replaces the slot pools and jobs; call from a whenIdle() task or before run().
+     *
+     * Jobs whose name and cron expression are unchanged keep their next due time; new or
+     * rescheduled jobs are due at the next matching time. Nothing changes if a job is invalid.
+     *
+     * @param schedulerConfig The "scheduler" configuration section.
+     * @param jobs The new jobs.
+     * @return std::expected<void, std::string> Error if a name is taken twice or a slot pool is unknown.
+     */
+    std::expected<void, std::string> reconfigure(const Json::Value& schedulerConfig, std::vector<ScheduledJob> jobs);
+
+    /**
+     * @brief Runs a task on the run() thread as soon as no job is running; callable from any thread.
+     *
+     * Jobs that become due while a task waits still start; the task runs at the next moment none
+     * is running, before any further job starts.
+     *
+     * @param task Task to run (e.g., applying a new configuration).
+     */
+    void whenIdle(std::function<void()> task);
+
+    /**
+     * @brief Runs jobs as they become due until the flag is set, then waits for running jobs.
+     *
+     * Jobs waiting for slots when the flag is set do not start. Signal wake-ups
+     * (WakeEvent::notifyFromSignal()) are routed to this scheduler while it runs.
+     *
+     * @param stopFlag Checked whenever the scheduler wakes; call wake() (or notifyFromSignal() from
+     *        a signal handler) after setting it.
+     */
+    void run(const volatile std::sig_atomic_t& stopFlag);
+
+    /**
+     * @brief Makes run() re-check its stop flag and due times now; callable from any thread.
+     */
+    void wake();
+
+    /**
+     * @brief Delays due jobs while the monitor reports high load; call before run().
+     *
+     * A delayed job waits before taking its slots, so it does not hold them while idle, and
+     * starts once load is normal again or after the monitor's maximum delay.
+     *
+     * @param monitor Load monitor, or nullptr to start jobs on time.
+     */
+    void setLoadMonitor(LoadMonitor* monitor) { loadMonitor_ = monitor; }
+
+private:
+    using Clock = std::chrono::system_clock;
+
+    struct JobState {
+        ScheduledJob job; ///< Job definition.
+        Clock::time_point next; ///< Next due time.
+        bool running = false; ///< A run is in progress or waiting for slots.
+        bool pending = false; ///< An overlapping run was queued.
+        std::thread thread; ///< Thread of the current or last run.
+    };
+
+    /**
+     * @brief Starts a run of a job on its own thread; caller must hold mutex_.
+     */
+    void start(JobState& state, Clock::time_point due);
+
+    /**
+     * @brief Handles a due time of a job: starts, queues or skips the run; caller must hold mutex_.
+     */
+    void dispatch(JobState& state, Clock::time_point due, Clock::time_point now);
+
+    /**
+     * @brief Waits while load is high, up to the monitor's maximum delay.
+     *
+     * @return false if the scheduler is stopping.
+     */
+    bool waitForLowLoad(const ScheduledJob& job);
+
+    /**
+     * @brief Waits until the units a job needs are free and takes them.
+     *
+     * @return false if the scheduler is stopping.
+     */
+    bool acquireSlots(const ScheduledJob& job);
+
+    void releaseSlots(const ScheduledJob& job);
+
+    /**
+     * @brief Reads the slot pool capacities of a "scheduler" section.
+     */
+    static std::map<std::string, unsigned> readCapacity(const Json::Value& schedulerConfig);
+
+    /**
+     * @brief Limits a job's units to the pools' capacities.
+     *
+     * @return std::expected<void, std::string> Error if the job uses an unknown pool.
+     */
+    static std::expected<void, std::string> fitSlots(ScheduledJob& job, const std::map<std::string, unsigned>& capacity);
+
+    void loadState();
+    void saveState();
+
+    std::string stateFile_; ///< Last started run per job.
+    Logger onMessage_; ///< Progress messages.
+    Logger onError_; ///< Overlaps, missed runs and failures.
+    std::map<std::string, unsigned> capacity_; ///< Units per slot pool.
+    std::map<std::string, int64_t> lastRuns_; ///< Scheduled time of the last started run per job.
+    WakeEvent wake_; ///< Wakes run() between due times.
+    LoadMonitor* loadMonitor_ = nullptr; ///< Delays starts under high load (may be null).
+
+    std::mutex mutex_; ///< Guards the fields below and job states.
+    std::condition_variable changed_; ///< Signals finished runs and freed slots.
+    std::map<std::string, unsigned> used_; ///< Units taken per slot pool.
+    std::list<JobState> jobs_; ///< Jobs (stable addresses for their threads).
+    std::vector<std::function<void()>> idleTasks_; ///< Tasks waiting for a moment without running jobs.
+    bool stopping_ = false; ///< Waiting runs should give up.
+};
+
+#endif // JOB_SCHEDULER_HPP
@@ -0,0 +1,130 @@
+/**
+ * @file load_monitor.hpp
+ * @brief Host load detection from pressure stall information (PSI) and the load average.
+ *
+ * The monitor samples the "some avg10" values of `/proc/pressure/{cpu,io,memory}` (the share of
+ * the last ten seconds in which at least one task stalled on that resource) and the one-minute
+ * load average per CPU, at most once per check interval. Load counts as high once any sample
+ * exceeds its limit and as normal again once every sample is below 80% of its limit, so
+ * pipelines do not flap around a threshold. Limits of 0 are ignored; signals a platform does not
+ * provide (PSI needs Linux 4.20, Windows has neither) never count as high.
+ *
+ * While load is high, scheduled jobs wait before they start and running pipelines slow down:
+ * reads are paced to a configured rate, new compression frames use a cheaper level and restore
+ * workers beyond a configured count pause. All of it returns to normal when load drops.
+ */
+
+#ifndef LOAD_MONITOR_HPP
+#define LOAD_MONITOR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <json/json.h>
+
+/**
+ * @brief One reading of the host's load signals.
+ */
+struct LoadSample {
+    std::optional<double> cpuPressure; ///< PSI cpu "some avg10" in percent.
+    std::optional<double> ioPressure; ///< PSI io "some avg10" in percent.
+    std::optional<double> memoryPressure; ///< PSI memory "some avg10" in percent.
+    std::optional<double> loadPerCpu; ///< One-minute load average divided by the number of CPUs.
+};
+
+/**
+ * @brief Decides whether the host is busy and how much background work should back off.
+ *
+ * Configured from the "load" section: "cpu_pressure", "io_pressure", "memory_pressure" (PSI
+ * percentages), "load_per_cpu", "check_seconds" (default 10), "max_delay_minutes" (default 60),
+ * "throttled_rate_mb" (default 20, 0 leaves rates alone), "throttled_compression_level"
+ * (default 1) and "throttled_threads" (default 1). Safe to use from several threads.
+ */
+class LoadMonitor {
+public:
+    using Logger = std::function<void(const std::string& message)>;
+
+    /**
+     * @brief Reads the limits.
+     *
+     * @param loadConfig The "load" configuration section.
+     * @param onMessage Called when load becomes high or normal again (from any thread).
+     */
+    LoadMonitor(const Json::Value& loadConfig, Logger onMessage);
+
+    /**
+     * @brief Reads the current load signals.
+     */
+    static LoadSample sample();
+
+    /**
+     * @brief Returns why load is high (e.g., "io pressure 41.2% (limit 30%)"), or nothing.
+     */
+    std::optional<std::string> highLoad();
+
+    /**
+     * @brief Returns whether load is high; cheap enough to call for every block.
+     */
+    bool throttled();
+
+    /**
+     * @brief Sleeps as needed to keep reads at the throttled rate while load is high.
+     *
+     * @param bytes Bytes just read.
+     */
+    void pace(uint64_t bytes);
+
+    /**
+     * @brief Returns the compression level to use now.
+     *
+     * @param normal Level used while load is normal.
+     */
+    int compressionLevel(int normal);
+
+    /**
+     * @brief Returns how many of a pool's workers may run now (at least one).
+     *
+     * @param normal Size of the pool.
+     */
+    unsigned workers(unsigned normal);
+
+    /**
+     * @brief Time between two samples.
+     */
+    std::chrono::seconds checkInterval() const { return checkInterval_; }
+
+    /**
+     * @brief Longest a scheduled job waits for load to drop before starting anyway.
+     */
+    std::chrono::seconds maxDelay() const { return maxDelay_; }
+
+private:
+    /**
+     * @brief Takes a new sample if the last one is older than the check interval.
+     */
+    void refresh();
+
+    double cpuLimit_; ///< PSI cpu limit in percent (0 ignores it).
+    double ioLimit_; ///< PSI io limit in percent (0 ignores it).
+    double memoryLimit_; ///< PSI memory limit in percent (0 ignores it).
+    double loadLimit_; ///< Load average per CPU limit (0 ignores it).
+    std::chrono::seconds checkInterval_; ///< Time between samples.
+    std::chrono::seconds maxDelay_; ///< Longest start delay.
+    uint64_t throttledRate_; ///< Read rate in bytes per second while throttled (0 disables pacing).
+    int throttledLevel_; ///< Compression level while throttled.
+    unsigned throttledWorkers_; ///< Workers per pool while throttled.
+    Logger onMessage_; ///< Reports changes of state.
+
+    std::atomic<bool> high_{false}; ///< Load is currently high.
+    std::atomic<int64_t> nextCheck_{0}; ///< steady_clock nanoseconds after which to sample again.
+    std::mutex mutex_; ///< Guards the fields below.
+    std::string reason_; ///< Why load is high.
+    std::chrono::steady_clock::time_point paceStart_; ///< Start of the current pacing period.
+    uint64_t pacedBytes_ = 0; ///< Bytes read in the current pacing period.
+};
+
+#endif // LOAD_MONITOR_HPP
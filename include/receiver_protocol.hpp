@@ -0,0 +1,221 @@
+/**
+ * @file receiver_protocol.hpp
+ * @brief Framed streaming protocol shared by securevault-receiver and its transfer strategy.
+ *
+ * Every frame is a 1-byte type and a 4-byte big-endian payload length followed by the payload.
+ * A session starts with Hello (magic + shared token). An upload is opened with Begin on one
+ * connection and may be joined by further connections with Attach, each sending Data frames
+ * (8-byte offset + bytes) for its own byte range; ranges must not overlap. Commit on the opening
+ * connection carries the digest of the whole file (see UploadDigest), which the receiver checks
+ * against the bytes it stored before it fsyncs the file and renames it into place atomically.
+ *
+ * Connections run over TLS (AEAD ciphers, kernel TLS when available) or, for trusted networks
+ * and loopback testing, plain TCP.
+ *
+ * @note POSIX only. Requires OpenSSL 1.1.1 or newer; zero-copy TLS sends need OpenSSL 3 with kTLS.
+ */
+
+#ifndef RECEIVER_PROTOCOL_HPP
+#define RECEIVER_PROTOCOL_HPP
+
+#include "digest.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+struct ssl_st;
+struct ssl_ctx_st;
+
+constexpr uint32_t kReceiverProtocolMagic = 0x53565232; ///< "SVR2", sent in Hello.
+constexpr uint32_t kMaxControlPayload = 64 * 1024;     ///< Upper bound for non-Data payloads.
+constexpr uint64_t kDigestBlockSize = 64ull << 20;     ///< Block size of UploadDigest.
+
+/**
+ * @brief Frame types of the receiver protocol.
+ */
+enum class FrameType : uint8_t {
+    Hello = 1,  ///< Client greeting: u32 magic, token bytes.
+    Begin = 2,  ///< Open upload: u64 total size, u16 path length, relative path. Reply: Ok with u64 upload id.
+    Attach = 3, ///< Join an upload from another connection: u64 upload id.
+    Data = 4,   ///< u64 offset followed by file bytes; must not overlap bytes already sent.
+    End = 5,    ///< All Data of this connection has been sent; acknowledged with Ok.
+    Commit = 6, ///< u64 total size, 32-byte UploadDigest; receiver verifies, syncs and atomically renames the file.
+    Ok = 7,     ///< Success reply, optional payload.
+    Error = 8   ///< Failure reply, UTF-8 message payload.
+};
+
+/**
+ * @brief Blocking TCP connection, optionally wrapped in TLS.
+ */
+class StreamConnection {
+public:
+    /**
+     * @brief Takes ownership of a connected socket and optional TLS session.
+     *
+     * @param fd Connected socket.
+     * @param ssl Established TLS session on fd, or nullptr for plain TCP.
+     */
+    StreamConnection(int fd, ssl_st* ssl);
+
+    /**
+     * @brief Shuts down TLS and closes the socket.
+     */
+    ~StreamConnection();
+
+    StreamConnection(const StreamConnection&) = delete;
+    StreamConnection& operator=(const StreamConnection&) = delete;
+
+    /**
+     * @brief Connects to a receiver, performing the TLS handshake when a context is given.
+     *
+     * @param host Receiver host name or address.
+     * @param port Receiver TCP port.
+     * @param tls Client TLS context, or nullptr for plain TCP.
+     * @param verifyHost If true, the certificate must match host.
+     * @return std::expected<std::unique_ptr<StreamConnection>, std::string> Connection or an error message.
+     */
+    static std::expected<std::unique_ptr<StreamConnection>, std::string> connect(const std::string& host,
+                                                                                 int port,
+                                                                                 ssl_ctx_st* tls,
+                                                                                 bool verifyHost);
+
+    /**
+     * @brief Makes reads and writes fail after the connection was idle for the given time.
+     *
+     * @param timeout Longest wait for the peer; zero waits forever.
+     */
+    void setTimeout(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Writes all bytes.
+     */
+    std::expected<void, std::string> writeAll(std::span<const char> data);
+
+    /**
+     * @brief Reads exactly data.size() bytes.
+     */
+    std::expected<void, std::string> readExact(std::span<char> data);
+
+    /**
+     * @brief Sends a complete frame.
+     */
+    std::expected<void, std::string> sendFrame(FrameType type, std::span<const char> payload);
+
+    /**
+     * @brief Sends a Data frame whose bytes come straight from a file.
+     *
+     * Uses sendfile(2) on plain TCP and SSL_sendfile when kernel TLS is active, so file data
+     * never passes through user space; otherwise falls back to pread + write.
+     *
+     * @param fileFd Readable file descriptor.
+     * @param offset File offset of the range, also sent as the Data offset.
+     * @param length Number of bytes to send.
+     */
+    std::expected<void, std::string> sendFileRange(int fileFd, uint64_t offset, uint64_t length);
+
+    /**
+     * @brief Reads the next frame header.
+     *
+     * @return std::expected<std::pair<FrameType, uint32_t>, std::string> Frame type and payload length.
+     */
+    std::expected<std::pair<FrameType, uint32_t>, std::string> readFrameHeader();
+
+    /**
+     * @brief Reads a control payload of the given length.
+     */
+    std::expected<std::vector<char>, std::string> readPayload(uint32_t length);
+
+    /**
+     * @brief Reads a reply frame, turning Error replies into an error message.
+     *
+     * @return std::expected<std::vector<char>, std::string> Ok payload or an error message.
+     */
+    std::expected<std::vector<char>, std::string> expectOk();
+
+private:
+    int fd_;      ///< Socket descriptor.
+    ssl_st* ssl_; ///< TLS session, or nullptr for plain TCP.
+};
+
+/**
+ * @brief Digest of an upload: SHA-256 over the SHA-256 of each kDigestBlockSize block of the file.
+ *
+ * Unlike a plain SHA-256, the blocks of a large file can be hashed on several cores, so checking
+ * an upload keeps up with a fast link on both ends.
+ */
+class UploadDigest {
+public:
+    /**
+     * @brief Adds the next bytes of the file, in order.
+     */
+    void update(std::span<const char> data);
+
+    /**
+     * @brief Finalizes the digest; no further updates are allowed.
+     */
+    std::array<uint8_t, 32> finish();
+
+private:
+    Sha256 outer_; ///< Hash of the finished block digests.
+    Sha256 block_; ///< Hash of the current block.
+    uint64_t blockBytes_ = 0; ///< Bytes of the current block hashed so far.
+};
+
+/**
+ * @brief Computes the UploadDigest of a file, hashing blocks on several threads.
+ *
+ * @param fileFd Readable file descriptor.
+ * @param size Number of bytes to hash from offset 0.
+ * @param threads Upper bound for hashing threads.
+ * @return std::expected<std::array<uint8_t, 32>, std::string> Digest or an error message.
+ */
+std::expected<std::array<uint8_t, 32>, std::string> digestFile(int fileFd, uint64_t size, unsigned threads);
+
+/**
+ * @brief Appends big-endian integers to a payload buffer.
+ */
+void appendU16(std::vector<char>& out, uint16_t value);
+void appendU32(std::vector<char>& out, uint32_t value);
+void appendU64(std::vector<char>& out, uint64_t value);
+
+/**
+ * @brief Reads big-endian integers from a payload buffer.
+ */
+uint16_t readU16(const char* data);
+uint32_t readU32(const char* data);
+uint64_t readU64(const char* data);
+
+/**
+ * @brief Creates a client TLS context restricted to TLS 1.2+ AEAD ciphers with kTLS enabled.
+ *
+ * @param caFile PEM bundle to verify the receiver, or empty for the system default store.
+ * @param verifyPeer If false, the receiver certificate is not verified (testing only).
+ * @return std::expected<ssl_ctx_st*, std::string> Context (free with freeTlsContext) or an error message.
+ */
+std::expected<ssl_ctx_st*, std::string> createClientTlsContext(const std::string& caFile, bool verifyPeer);
+
+/**
+ * @brief Creates a server TLS context from a certificate chain and private key.
+ *
+ * @param certFile PEM certificate chain.
+ * @param keyFile PEM private key.
+ * @return std::expected<ssl_ctx_st*, std::string> Context (free with freeTlsContext) or an error message.
+ */
+std::expected<ssl_ctx_st*, std::string> createServerTlsContext(const std::string& certFile, const std::string& keyFile);
+
+/**
+ * @brief Releases a TLS context.
+ */
+void freeTlsContext(ssl_ctx_st* context);
+
+/**
+ * @brief Returns the most recent OpenSSL error as text.
+ */
+std::string lastTlsError();
+
+#endif // RECEIVER_PROTOCOL_HPP
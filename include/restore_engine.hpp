@@ -0,0 +1,108 @@
+/**
+ * @file restore_engine.hpp
+ * @brief Parallel extraction of file archives.
+ *
+ * Framed archives (see frame_archive.hpp) are restored frame by frame on a pool of threads:
+ * every frame starts at an entry boundary, so each worker decompresses and extracts its frames
+ * independently, and every frame's CRC-32 is checked as it is read. Archives without a frame
+ * index are extracted sequentially. Each restored file is hashed while it is written, so callers
+ * can compare content without reading the restored tree again.
+ */
+
+#ifndef RESTORE_ENGINE_HPP
+#define RESTORE_ENGINE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <string>
+#include <vector>
+
+class LoadMonitor;
+
+/**
+ * @brief A file written by the restore engine.
+ */
+struct RestoredEntry {
+    std::string archivePath; ///< Path of the entry inside the archive.
+    std::string restoredPath; ///< Path of the restored file.
+    uint64_t size = 0; ///< Bytes written.
+    std::string sha256; ///< Hex SHA-256 of the restored content.
+};
+
+/**
+ * @brief Totals of one extraction.
+ */
+struct RestoreSummary {
+    uint64_t entries = 0; ///< Files restored.
+    uint64_t skipped = 0; ///< Entries not selected by the filter.
+    uint64_t bytes = 0; ///< Bytes restored.
+    uint64_t frames = 0; ///< Frames processed (0 for sequential extraction).
+    std::chrono::duration<double> duration{}; ///< Wall time of the extraction.
+    std::vector<std::string> errors; ///< Entries or frames that could not be restored.
+};
+
+/**
+ * @brief Extracts archives into a directory, in parallel when a frame index is available.
+ */
+class RestoreEngine {
+public:
+    using EntryFilter = std::function<bool(const std::string& archivePath)>;
+    using EntryHandler = std::function<void(const RestoredEntry& entry)>;
+
+    /**
+     * @brief Part of an archive to restore.
+     */
+    struct ArchiveSelection {
+        std::string archivePath; ///< Path to the .tar.gz archive.
+        std::vector<uint32_t> frames; ///< Frames to read (empty, or no frame index, reads the whole archive).
+        EntryFilter filter; ///< Selects entries to restore (null restores everything read).
+    };
+
+    /**
+     * @brief Configures the engine.
+     *
+     * @param threads Worker threads for framed archives (0 uses the hardware concurrency).
+     * @param background Run workers at idle I/O priority and lowest CPU priority (Linux).
+     * @param loadMonitor While it reports high load, workers beyond its throttled count pause
+     *        between frames (may be null).
+     */
+    explicit RestoreEngine(unsigned threads = 0, bool background = false, LoadMonitor* loadMonitor = nullptr);
+
+    /**
+     * @brief Extracts an archive.
+     *
+     * @param archivePath Path to the .tar.gz archive.
+     * @param targetDir Directory the entries are restored below; created if missing.
+     * @param filter Selects entries to restore (null restores everything).
+     * @param onEntry Called on a worker thread after each file is restored (may be null).
+     * @return std::expected<RestoreSummary, std::string> Totals, with per-entry failures listed in
+     *         errors, or an error message if the archive cannot be read at all.
+     */
+    std::expected<RestoreSummary, std::string> extract(const std::string& archivePath, const std::string& targetDir,
+                                                      const EntryFilter& filter = nullptr, const EntryHandler& onEntry = nullptr) const;
+
+    /**
+     * @brief Extracts parts of several archives into one directory.
+     *
+     * The selected frames of all archives share one worker pool, so restoring from a chain of
+     * archives is as parallel as restoring from one. Entries with the same name in different
+     * archives overwrite each other in no particular order; selections are expected not to overlap.
+     *
+     * @param archives Archives, frames and entries to restore.
+     * @param targetDir Directory the entries are restored below; created if missing.
+     * @param onEntry Called on a worker thread after each file is restored (may be null).
+     * @return std::expected<RestoreSummary, std::string> Totals, with per-entry, per-frame and
+     *         per-archive failures listed in errors, or an error if targetDir cannot be created.
+     */
+    std::expected<RestoreSummary, std::string> extract(const std::vector<ArchiveSelection>& archives, const std::string& targetDir,
+                                                      const EntryHandler& onEntry = nullptr) const;
+
+private:
+    unsigned threads_; ///< Worker threads for framed archives.
+    bool background_; ///< Lower the workers' I/O and CPU priority.
+    LoadMonitor* loadMonitor_; ///< Shrinks the pool under high load (may be null).
+};
+
+#endif // RESTORE_ENGINE_HPP
@@ -0,0 +1,57 @@
+/**
+ * @file restore_planner.hpp
+ * @brief Point-in-time restore plans built from the backup catalog.
+ *
+ * The catalog state of a run lists every file of the tree at that time together with the run
+ * whose archive stored its content and the frame holding it. A restore plan turns that state into
+ * one selection per archive: the frames to read and the entries to keep. Each file is extracted
+ * exactly once, from the archive holding the version current at the chosen run; superseded
+ * versions in other archives of the chain are never read, and deleted files are not part of the
+ * state. With frame indexes, the data read is proportional to the restored files rather than to
+ * the length of the chain.
+ */
+
+#ifndef RESTORE_PLANNER_HPP
+#define RESTORE_PLANNER_HPP
+
+#include "catalog.hpp"
+#include "restore_engine.hpp"
+#include <cstdint>
+#include <expected>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief What to extract to restore a run's state.
+ */
+struct RestorePlan {
+    uint32_t run = 0; ///< Run whose state is restored.
+    std::vector<RestoreEngine::ArchiveSelection> archives; ///< One selection per archive, oldest run first.
+    std::unordered_map<std::string, std::string> expectedSha256; ///< Catalog digest by entry name (empty if unknown).
+    uint64_t files = 0; ///< Files to restore.
+    uint64_t bytes = 0; ///< Bytes to restore.
+    uint64_t frames = 0; ///< Frames to read (archives without a frame index count as one).
+};
+
+/**
+ * @brief Finds the last run started at or before a point in time.
+ *
+ * @param runs Committed runs, oldest first (see Catalog::runs()).
+ * @param time Point in time (seconds since the epoch).
+ * @return std::expected<uint32_t, std::string> Run sequence number, or an error if no run is that old.
+ */
+std::expected<uint32_t, std::string> runAt(const std::vector<CatalogRun>& runs, int64_t time);
+
+/**
+ * @brief Plans the restore of a run's state below a path prefix.
+ *
+ * @param catalog Catalog holding the run.
+ * @param run Run sequence number (0 selects the latest run).
+ * @param prefix Source path prefix (empty restores every file).
+ * @return std::expected<RestorePlan, std::string> The plan, or an error if the run is unknown or
+ *         an archive holding one of its files is no longer listed in the catalog.
+ */
+std::expected<RestorePlan, std::string> planRestore(const Catalog& catalog, uint32_t run, const std::string& prefix = "");
+
+#endif // RESTORE_PLANNER_HPP
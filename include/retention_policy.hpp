@@ -0,0 +1,63 @@
+/**
+ * @file retention_policy.hpp
+ * @brief Grandfather-father-son retention evaluated against the backup catalog.
+ *
+ * Runs are grouped into hourly, daily, ISO-weekly, monthly and yearly periods (local time).
+ * For each period kind with a non-zero count, the newest run of each of the most recent
+ * periods is kept. The newest run is always kept, and so is every run whose archive still
+ * holds content a kept run refers to (CatalogRun::dependsOn), so an incremental chain is never
+ * broken.
+ */
+
+#ifndef RETENTION_POLICY_HPP
+#define RETENTION_POLICY_HPP
+
+#include "catalog.hpp"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <json/json.h>
+
+/**
+ * @brief Number of periods to keep per period kind (0 keeps none of that kind).
+ */
+struct RetentionPolicy {
+    unsigned hourly = 0; ///< Hours with a kept run.
+    unsigned daily = 0; ///< Days with a kept run.
+    unsigned weekly = 0; ///< ISO weeks with a kept run.
+    unsigned monthly = 0; ///< Months with a kept run.
+    unsigned yearly = 0; ///< Years with a kept run.
+
+    /**
+     * @brief Reads keep_hourly, keep_daily, keep_weekly, keep_monthly and keep_yearly.
+     *
+     * @param retentionConfig The "retention" configuration section.
+     * @return RetentionPolicy The policy (all zero if the section is absent).
+     */
+    static RetentionPolicy fromJson(const Json::Value& retentionConfig);
+
+    /**
+     * @brief Returns true if any period kind is kept, i.e. the policy replaces retention_days.
+     */
+    bool enabled() const;
+};
+
+/**
+ * @brief Outcome of evaluating a policy.
+ */
+struct RetentionPlan {
+    std::map<uint32_t, std::string> kept; ///< Kept runs and why ("daily", "dependency", ...).
+    std::vector<uint32_t> pruned; ///< Runs to delete, oldest first.
+};
+
+/**
+ * @brief Decides which runs to keep.
+ *
+ * @param runs Catalog runs, oldest first.
+ * @param policy Retention policy.
+ * @return RetentionPlan Every run appears either in kept or in pruned.
+ */
+RetentionPlan planRetention(const std::vector<CatalogRun>& runs, const RetentionPolicy& policy);
+
+#endif // RETENTION_POLICY_HPP
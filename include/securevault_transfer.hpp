@@ -0,0 +1,6 @@
+#ifndef SECUREVAULT_TRANSFER_HPP
+#define SECUREVAULT_TRANSFER_HPP
+
+#include "backup.hpp"
+
+#endif // SECUREVAULT_TRANSFER_HPP
@@ -0,0 +1,160 @@
+/**
+ * @file sorted_table.hpp
+ * @brief Memory-mapped tables of fixed-size records sorted by path.
+ *
+ * Shared layout of the catalog files and archive indexes: a header starting with an 8-byte
+ * magic and a byte-order mark, followed by the records and a string blob holding the paths.
+ * Headers must declare `magic`, `byteOrder`, `recordCount` and `stringsSize`; records must
+ * declare `pathOffset` and `pathLength`. Records are sorted by path (byte order), so lookups
+ * and prefix ranges are binary searches over the mapping.
+ */
+
+#ifndef SORTED_TABLE_HPP
+#define SORTED_TABLE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <format>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Byte-order mark stored in table headers; files from other hosts are rejected.
+ */
+inline constexpr uint32_t kSortedTableByteOrder = 0x01020304;
+
+/**
+ * @brief Read-only view of a whole file, memory-mapped where available.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps a file.
+     *
+     * @param path File to map.
+     * @return std::expected<void, std::string> Success or an error message.
+     */
+    std::expected<void, std::string> open(const std::string& path);
+
+    /**
+     * @brief Returns the mapped bytes.
+     */
+    std::string_view bytes() const;
+
+private:
+#ifdef _WIN32
+    std::string buffer_; ///< File contents.
+#else
+    void* data_ = nullptr; ///< Mapping base.
+    size_t size_ = 0; ///< Mapping length.
+#endif
+};
+
+/**
+ * @brief Sorted table of fixed-size records keyed by a path in the string blob.
+ */
+template <typename Header, typename Record>
+class TableView {
+public:
+    std::expected<void, std::string> open(const std::string& path, const char (&magic)[8]) {
+        auto mapped = file_.open(path);
+        if (!mapped) {
+            return mapped;
+        }
+        const std::string_view bytes = file_.bytes();
+        if (bytes.size() < sizeof(Header)) {
+            return std::unexpected(std::format("Index file {} is truncated", path));
+        }
+        std::memcpy(&header_, bytes.data(), sizeof(Header));
+        if (std::memcmp(header_.magic, magic, sizeof(header_.magic)) != 0) {
+            return std::unexpected(std::format("Index file {} has an unknown format", path));
+        }
+        if (header_.byteOrder != kSortedTableByteOrder) {
+            return std::unexpected(std::format("Index file {} was written on a host with a different byte order", path));
+        }
+        stringsOffset_ = sizeof(Header) + header_.recordCount * sizeof(Record);
+        if (header_.recordCount > bytes.size() / sizeof(Record) || stringsOffset_ + header_.stringsSize != bytes.size()) {
+            return std::unexpected(std::format("Index file {} is truncated", path));
+        }
+        return {};
+    }
+
+    const Header& header() const { return header_; }
+
+    uint64_t count() const { return header_.recordCount; }
+
+    Record record(uint64_t index) const {
+        Record record;
+        std::memcpy(&record, file_.bytes().data() + sizeof(Header) + index * sizeof(Record), sizeof(Record));
+        return record;
+    }
+
+    std::string_view string(uint64_t offset, uint32_t length) const {
+        if (offset + length > header_.stringsSize) {
+            return {};
+        }
+        return file_.bytes().substr(stringsOffset_ + offset, length);
+    }
+
+    std::string_view path(uint64_t index) const {
+        const Record entry = record(index);
+        return string(entry.pathOffset, entry.pathLength);
+    }
+
+    /**
+     * @brief Returns the first record whose path is not less than key.
+     */
+    uint64_t lowerBound(std::string_view key) const {
+        uint64_t low = 0;
+        uint64_t high = count();
+        while (low < high) {
+            const uint64_t middle = low + (high - low) / 2;
+            if (path(middle) < key) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return low;
+    }
+
+private:
+    MappedFile file_; ///< Mapped file.
+    Header header_{}; ///< Copy of the header.
+    uint64_t stringsOffset_ = 0; ///< Start of the string blob.
+};
+
+/**
+ * @brief Lays out a table file: header, records, string blob.
+ */
+template <typename Header, typename Record>
+std::string serializeTable(const Header& header, const std::vector<Record>& records, const std::string& strings) {
+    std::string contents;
+    contents.reserve(sizeof(Header) + records.size() * sizeof(Record) + strings.size());
+    contents.append(reinterpret_cast<const char*>(&header), sizeof(Header));
+    contents.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+    contents.append(strings);
+    return contents;
+}
+
+/**
+ * @brief Matches a glob with `*`, `?` and `[...]` classes; `*` also matches `/`.
+ */
+bool globMatch(std::string_view pattern, std::string_view text);
+
+/**
+ * @brief Returns the literal prefix of a glob, i.e. the part before its first wildcard.
+ *
+ * Only paths starting with it can match, which in a sorted table is one contiguous range.
+ */
+std::string_view globPrefix(std::string_view pattern);
+
+#endif // SORTED_TABLE_HPP
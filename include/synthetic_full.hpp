@@ -0,0 +1,51 @@
+/**
+ * @file synthetic_full.hpp
+ * @brief Synthetic full archives assembled from earlier archives instead of the source tree.
+ *
+ * The catalog state of a run lists every file of the tree at that time and the run, frame and
+ * tar offset whose archive holds its content. A synthetic full archive contains exactly those
+ * entries, read from the full and incremental archives that stored them: deleted files are
+ * absent from the state and superseded versions are not referenced, so both are dropped. Frames
+ * whose entries are all still referenced are copied as compressed bytes without being
+ * decompressed; only frames that mix live and dropped entries (and the final frame of each
+ * source, which holds its end-of-archive marker) are decompressed and their live entries
+ * recompressed. The source tree is never read.
+ */
+
+#ifndef SYNTHETIC_FULL_HPP
+#define SYNTHETIC_FULL_HPP
+
+#include "catalog.hpp"
+#include <cstdint>
+#include <expected>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Outcome of assembling a synthetic full archive.
+ */
+struct SynthesisSummary {
+    std::vector<ManifestEntry> entries; ///< Files of the new archive, with their new offsets and frames.
+    uint64_t framesCopied = 0; ///< Source frames copied without recompression.
+    uint64_t framesRewritten = 0; ///< Source frames (or unframed archives) decompressed and filtered.
+    uint64_t framesSkipped = 0; ///< Source frames without any live entry.
+    uint64_t bytesCopied = 0; ///< Compressed bytes copied verbatim.
+    uint64_t bytesRewritten = 0; ///< File bytes recompressed.
+};
+
+/**
+ * @brief Writes a framed full archive holding the files of a catalog state.
+ *
+ * @param state Files of the run to synthesize (see Catalog::snapshot()).
+ * @param archives File archive of every run the state refers to, by run sequence number.
+ * @param outputFile Path of the new .tar.gz archive; its `.frames` index is written too.
+ * @param frameSize Uncompressed bytes per frame for recompressed entries.
+ * @return std::expected<SynthesisSummary, std::string> Summary, or an error if an archive is
+ *         missing or unreadable or a file of the state is not found in its archive.
+ */
+std::expected<SynthesisSummary, std::string> synthesizeFullArchive(const std::vector<FileVersion>& state,
+                                                                   const std::map<uint32_t, std::string>& archives,
+                                                                   const std::string& outputFile, uint64_t frameSize);
+
+#endif // SYNTHETIC_FULL_HPP
@@ -0,0 +1,141 @@
+/**
+ * @file transfer_metrics.hpp
+ * @brief Per-artifact and per-session transfer measurements for run reports and monitoring.
+ *
+ * The transfer scheduler records what it can see from outside a destination (bytes, wall time,
+ * time spent reading the local file versus blocked in the destination), and strategies add
+ * what only they know: round trips spent waiting for acknowledgements, connection handshakes
+ * and retries. The result is written into the JSON run report and, optionally, a Prometheus
+ * textfile for node_exporter's textfile collector.
+ */
+
+#ifndef TRANSFER_METRICS_HPP
+#define TRANSFER_METRICS_HPP
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <json/json.h>
+
+/**
+ * @brief Outcome of a destination-side integrity check of an uploaded artifact.
+ */
+enum class RemoteVerification {
+    NotChecked, ///< The destination does not check uploads, or checking is disabled.
+    Verified, ///< The destination's digest matched the uploaded bytes.
+    Unverified, ///< Checking was requested but the destination could not compute a digest.
+};
+
+/**
+ * @brief Measurements for one uploaded artifact.
+ */
+struct ArtifactTransferMetrics {
+    std::string artifact; ///< Local artifact path.
+    std::string artifactClass; ///< Artifact class (e.g., "db", "sys").
+    uint64_t bytes = 0; ///< Bytes handed to the destination.
+    std::chrono::duration<double> duration{}; ///< Upload wall time excluding scheduler pauses.
+    std::chrono::duration<double> readTime{}; ///< Time spent reading the local file.
+    std::chrono::duration<double> sinkTime{}; ///< Time blocked in destination writes and commit.
+    std::chrono::duration<double> stallTime{}; ///< Time waiting on network round trips (acknowledgements, replies).
+    std::chrono::duration<double> handshakeTime{}; ///< Connection setup attributed to this artifact.
+    unsigned retries = 0; ///< Retried operations (reopened files, repeated destination uploads).
+    RemoteVerification verification = RemoteVerification::NotChecked; ///< Destination-side integrity check.
+    std::string verificationNote; ///< Why the artifact is unverified, if it is.
+    bool success = false; ///< True if the upload committed.
+    std::string error; ///< Failure reason when success is false.
+};
+
+/**
+ * @brief Connection statistics for one destination.
+ */
+struct SessionTransferMetrics {
+    unsigned established = 0; ///< New connections (full handshake).
+    unsigned reused = 0; ///< Uploads served by a pooled connection.
+    std::chrono::duration<double> handshakeTime{}; ///< Total connect, key exchange and authentication time.
+};
+
+/**
+ * @brief Thread-safe collector of transfer measurements for one backup run.
+ *
+ * Records for artifacts that were not registered with beginArtifact() (e.g., repository pack
+ * files uploaded on behalf of an artifact) only update session statistics.
+ */
+class TransferMetrics {
+public:
+    /**
+     * @brief Registers an artifact before its upload starts.
+     *
+     * @param artifact Local artifact path, the key for all later records.
+     * @param artifactClass Artifact class for aggregation.
+     */
+    void beginArtifact(const std::string& artifact, const std::string& artifactClass);
+
+    /**
+     * @brief Records the outcome of an artifact upload.
+     *
+     * @param artifact Local artifact path.
+     * @param bytes Bytes handed to the destination.
+     * @param duration Upload wall time excluding pauses.
+     * @param readTime Time spent reading the local file.
+     * @param sinkTime Time blocked in the destination.
+     * @param error Empty on success, otherwise the failure reason.
+     */
+    void finishArtifact(const std::string& artifact, uint64_t bytes, std::chrono::duration<double> duration,
+                        std::chrono::duration<double> readTime, std::chrono::duration<double> sinkTime,
+                        const std::string& error);
+
+    /**
+     * @brief Adds time spent waiting for network round trips.
+     */
+    void addStall(const std::string& artifact, std::chrono::duration<double> stall);
+
+    /**
+     * @brief Counts one retried operation.
+     */
+    void addRetry(const std::string& artifact);
+
+    /**
+     * @brief Records the destination-side integrity check of an upload.
+     *
+     * @param artifact Local artifact path.
+     * @param verification Check outcome.
+     * @param note Reason the check could not run, for unverified uploads.
+     */
+    void recordVerification(const std::string& artifact, RemoteVerification verification, const std::string& note = "");
+
+    /**
+     * @brief Records a new connection to a destination.
+     *
+     * @param destination Destination name (TransferStrategy::name()).
+     * @param artifact Artifact the connection was opened for, or empty.
+     * @param handshake Connect, key exchange and authentication time.
+     */
+    void recordHandshake(const std::string& destination, const std::string& artifact, std::chrono::duration<double> handshake);
+
+    /**
+     * @brief Records an upload served by an already established connection.
+     */
+    void recordSessionReuse(const std::string& destination);
+
+    /**
+     * @brief Returns all measurements as JSON ("artifacts" and "sessions" members).
+     */
+    Json::Value toJson() const;
+
+    /**
+     * @brief Renders per-class and per-destination aggregates in Prometheus text format.
+     *
+     * @param runSucceeded Whether the backup run as a whole succeeded.
+     */
+    std::string toPrometheus(bool runSucceeded) const;
+
+private:
+    mutable std::mutex mutex_; ///< Guards all fields.
+    std::vector<std::string> order_; ///< Artifacts in registration order.
+    std::map<std::string, ArtifactTransferMetrics> artifacts_; ///< Measurements per artifact.
+    std::map<std::string, SessionTransferMetrics> sessions_; ///< Connection statistics per destination.
+};
+
+#endif // TRANSFER_METRICS_HPP
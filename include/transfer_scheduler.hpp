@@ -0,0 +1,155 @@
+/**
+ * @file transfer_scheduler.hpp
+ * @brief Priority- and deadline-aware ordering of artifact uploads.
+ *
+ * Artifacts are submitted as soon as they exist and uploaded in the background, highest
+ * priority class first and smallest first within a class. A running upload of a lower class is
+ * paused between chunks when a more important artifact arrives, and resumed afterwards. With a
+ * transfer window configured, the scheduler forecasts from observed throughput which queued
+ * artifacts will not reach the destination in time and reports them.
+ */
+
+#ifndef TRANSFER_SCHEDULER_HPP
+#define TRANSFER_SCHEDULER_HPP
+
+#include "backup.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief One artifact waiting for or undergoing upload.
+ */
+struct TransferJob {
+    std::string file; ///< Local artifact path.
+    std::string destination; ///< Remote directory passed to the transfer strategy.
+    std::string artifactClass; ///< Class name used for priority lookup (e.g., "db", "sys").
+    int priority = 0; ///< Higher values are uploaded first.
+    uint64_t size = 0; ///< Artifact size in bytes.
+    uint64_t sequence = 0; ///< Submission order, the final tie breaker.
+};
+
+/**
+ * @brief Result of one scheduled upload.
+ */
+struct TransferOutcome {
+    TransferJob job; ///< The uploaded artifact.
+    std::expected<void, std::string> result; ///< Success or the transfer error.
+    std::chrono::steady_clock::duration elapsed{}; ///< Time from first byte to commit, excluding pauses.
+    unsigned pauses = 0; ///< Times the upload was paused for a higher-priority artifact.
+    bool missedWindow = false; ///< True if the upload finished after the configured deadline.
+};
+
+/**
+ * @brief Background uploader that orders artifacts by priority and watches a deadline.
+ *
+ * Configured from the "transfer" section:
+ * - priorities: object mapping artifact class to priority (default db 100, sys 10).
+ * - window_minutes: upload deadline relative to scheduler creation (0 disables).
+ * - expected_mbps: throughput in MiB/s assumed for forecasts before any upload finished.
+ * - preempt: pause lower-priority uploads for higher-priority ones (default true); a paused
+ *   upload's sink is suspended so it can release its connection.
+ * - chunk_size: read size between preemption checks (default 1 MiB).
+ *
+ * @note Preemption needs a strategy that supportsStreaming(); others upload each artifact in one
+ * call. An openSink() error from a streaming strategy fails the upload like any other error.
+ */
+class TransferScheduler {
+public:
+    using CompletionHandler = std::function<void(const TransferOutcome&)>;
+
+    /**
+     * @brief Starts the upload worker.
+     *
+     * @param strategy Destination for all uploads; must outlive the scheduler.
+     * @param transferConfig The "transfer" configuration section.
+     * @param onComplete Called on the worker thread after each upload finishes or fails; it runs
+     *        concurrently with the submitting thread, so it must only use thread-safe sinks.
+     * @param metrics Collector for per-artifact measurements; may be null.
+     */
+    TransferScheduler(TransferStrategy& strategy, const Json::Value& transferConfig, CompletionHandler onComplete,
+                      TransferMetrics* metrics = nullptr);
+
+    /**
+     * @brief Waits for submitted uploads to finish.
+     */
+    ~TransferScheduler();
+
+    TransferScheduler(const TransferScheduler&) = delete;
+    TransferScheduler& operator=(const TransferScheduler&) = delete;
+
+    /**
+     * @brief Queues an artifact for upload.
+     *
+     * @param file Local artifact path.
+     * @param destination Remote directory passed to the transfer strategy.
+     * @param artifactClass Class name used for priority lookup.
+     */
+    void submit(const std::string& file, const std::string& destination, const std::string& artifactClass);
+
+    /**
+     * @brief Stops accepting artifacts and waits until every queued upload is done.
+     *
+     * @return std::vector<TransferOutcome> Outcomes in completion order.
+     */
+    std::vector<TransferOutcome> finish();
+
+    /**
+     * @brief Lists queued artifacts that are forecast to miss the transfer window.
+     *
+     * @return std::vector<std::string> Human-readable forecast lines; empty without a window.
+     */
+    std::vector<std::string> forecastMisses();
+
+private:
+    struct Active; ///< Upload in progress or paused.
+
+    /**
+     * @brief Orders jobs: higher priority, then smaller, then earlier submission first.
+     */
+    static bool runsBefore(const TransferJob& lhs, const TransferJob& rhs);
+
+    void workerLoop();
+
+    /**
+     * @brief Uploads chunks of an active job until it completes or should yield.
+     *
+     * @return bool True if the job finished (successfully or not), false if it was paused.
+     */
+    bool advance(Active& active);
+
+    void complete(Active& active, std::expected<void, std::string> result);
+
+    /**
+     * @brief Forecast lines for the current queue; caller must hold mutex_.
+     */
+    std::vector<std::string> forecastLocked() const;
+
+    TransferStrategy& strategy_; ///< Upload destination.
+    CompletionHandler onComplete_; ///< Per-upload callback.
+    TransferMetrics* metrics_; ///< Measurement collector (may be null).
+    std::map<std::string, int> priorities_; ///< Priority per artifact class.
+    std::optional<std::chrono::steady_clock::time_point> deadline_; ///< End of the transfer window.
+    double bytesPerSecond_; ///< Throughput estimate used for forecasts.
+    bool preempt_; ///< Pause lower-priority uploads for higher-priority arrivals.
+    size_t chunkSize_; ///< Bytes read between preemption checks.
+
+    std::mutex mutex_; ///< Guards the fields below.
+    std::condition_variable wake_; ///< Signals new jobs or closure.
+    std::vector<TransferJob> queue_; ///< Jobs not yet started.
+    std::vector<TransferOutcome> outcomes_; ///< Finished uploads.
+    uint64_t nextSequence_ = 0; ///< Sequence number for the next submission.
+    uint64_t bytesDone_ = 0; ///< Bytes uploaded so far, for throughput estimates.
+    std::chrono::steady_clock::duration busyTime_{}; ///< Time spent uploading, for throughput estimates.
+    uint64_t startedRemaining_ = 0; ///< Unsent bytes of active and paused uploads.
+    bool closed_ = false; ///< True once finish() was called.
+    std::thread worker_; ///< Upload thread.
+};
+
+#endif // TRANSFER_SCHEDULER_HPP
@@ -0,0 +1,6 @@
+#ifndef TRANSFER_STREAM_HPP
+#define TRANSFER_STREAM_HPP
+
+#include "backup.hpp"
+
+#endif // TRANSFER_STREAM_HPP
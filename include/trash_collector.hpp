@@ -0,0 +1,95 @@
+/**
+ * @file trash_collector.hpp
+ * @brief Deferred, rate-limited deletion of expired artifacts.
+ *
+ * Expired artifacts are renamed into a trash directory on the same filesystem, which is
+ * instant, and a background thread at idle I/O priority deletes them afterwards. Unlinking a
+ * file of hundreds of gigabytes frees all of its extents at once and can stall other I/O on
+ * ext4 and XFS for seconds, so large files are first shrunk with ftruncate in steps, paced to
+ * a configured rate, and unlinked once they are small. Files still in the trash when the
+ * process exits are picked up again by the next collector.
+ */
+
+#ifndef TRASH_COLLECTOR_HPP
+#define TRASH_COLLECTOR_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <json/json.h>
+
+/**
+ * @brief Background deleter for a trash directory.
+ *
+ * Configured from the "trash" section:
+ * - rate_mb: bytes freed per second, in MiB (default 1024; 0 disables pacing).
+ * - truncate_step_mb: shrink files larger than this in steps of this size before unlinking
+ *   them (default 1024; 0 unlinks directly).
+ */
+class TrashCollector {
+public:
+    using ErrorHandler = std::function<void(const std::string& message)>;
+
+    /**
+     * @brief Starts the worker and queues files left in the trash by earlier runs.
+     *
+     * @param trashFolder Trash directory; must be on the same filesystem as the artifacts.
+     * @param trashConfig The "trash" configuration section.
+     * @param onError Called on the worker thread when a file cannot be deleted.
+     */
+    TrashCollector(std::string trashFolder, const Json::Value& trashConfig, ErrorHandler onError);
+
+    /**
+     * @brief Stops the worker after its current step; the rest stays in the trash.
+     */
+    ~TrashCollector();
+
+    TrashCollector(const TrashCollector&) = delete;
+    TrashCollector& operator=(const TrashCollector&) = delete;
+
+    /**
+     * @brief Moves a file into the trash and queues it for deletion.
+     *
+     * Falls back to deleting the file directly if it cannot be renamed into the trash (e.g.,
+     * it is on another filesystem).
+     *
+     * @param path File to delete.
+     * @return std::expected<bool, std::string> True if the file was moved or deleted, false if
+     *         it did not exist, or an error message.
+     */
+    std::expected<bool, std::string> moveToTrash(const std::string& path);
+
+private:
+    void workerLoop();
+
+    /**
+     * @brief Shrinks and unlinks one file, pacing the freed bytes.
+     *
+     * @return false if the collector is stopping and the file was left in the trash.
+     */
+    bool purge(const std::filesystem::path& file);
+
+    /**
+     * @brief Waits long enough to keep freed bytes under the rate; returns false when stopping.
+     */
+    bool pace(uint64_t bytes);
+
+    std::filesystem::path trashFolder_; ///< Trash directory.
+    uint64_t rate_; ///< Bytes freed per second (0 disables pacing).
+    uint64_t truncateStep_; ///< Bytes removed per truncation step (0 disables truncation).
+    ErrorHandler onError_; ///< Deletion failure callback.
+    std::mutex mutex_; ///< Guards the fields below.
+    std::condition_variable wake_; ///< Signals new files or shutdown.
+    std::deque<std::filesystem::path> queue_; ///< Files waiting for deletion.
+    uint64_t counter_ = 0; ///< Suffix keeping trash names unique.
+    bool stopping_ = false; ///< Set by the destructor.
+    std::thread worker_; ///< Deletion thread.
+};
+
+#endif // TRASH_COLLECTOR_HPP
@@ -0,0 +1,86 @@
+/**
+ * @file wake_event.hpp
+ * @brief Sleeps until a wall-clock deadline, an explicit wake-up or a change of the system clock.
+ *
+ * On Linux the wait is a single poll() on a timerfd armed for the absolute deadline and an
+ * eventfd for wake-ups, so an idle daemon does not wake at all between deadlines. The timer is
+ * cancelled when the system clock is set, which reports clock changes as they happen, and the
+ * eventfd may be written from a signal handler (the self-pipe technique). Other platforms wait
+ * on a condition variable in steps of at most one second, so a flag set by a signal handler is
+ * still noticed, and detect clocks set backwards by comparing the wall clock with a monotonic one.
+ */
+
+#ifndef WAKE_EVENT_HPP
+#define WAKE_EVENT_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+/**
+ * @brief A wake-up source for a single waiting thread.
+ */
+class WakeEvent {
+public:
+    /**
+     * @brief Why waitUntil() returned.
+     */
+    enum class Reason {
+        Deadline, ///< The deadline passed, or the wait ended early and should be re-evaluated.
+        Notified, ///< notify() or notifyFromSignal() was called.
+        ClockChanged ///< The system clock was set; times computed from it may be stale.
+    };
+
+    /**
+     * @brief Creates the timer and wake-up descriptors where available.
+     */
+    WakeEvent();
+
+    /**
+     * @brief Closes the descriptors and stops routing signal wake-ups here.
+     */
+    ~WakeEvent();
+
+    WakeEvent(const WakeEvent&) = delete;
+    WakeEvent& operator=(const WakeEvent&) = delete;
+
+    /**
+     * @brief Blocks until the deadline, a notification or a clock change.
+     *
+     * Notifications sent while nobody waits are kept, so the next wait returns at once.
+     *
+     * @param deadline Wall-clock time to wake at (time_point::max() waits for a notification).
+     * @return Reason Why the wait ended.
+     */
+    Reason waitUntil(std::chrono::system_clock::time_point deadline);
+
+    /**
+     * @brief Wakes the waiting thread; callable from any thread.
+     */
+    void notify();
+
+    /**
+     * @brief Makes notifyFromSignal() wake this event.
+     */
+    void receiveSignalWakeups();
+
+    /**
+     * @brief Wakes the event registered with receiveSignalWakeups(); async-signal-safe.
+     *
+     * Does nothing where the platform offers no signal-safe wake-up; waits there are short
+     * enough to notice a flag set by the handler.
+     */
+    static void notifyFromSignal();
+
+private:
+#ifdef __linux__
+    int timerFd_ = -1; ///< Absolute CLOCK_REALTIME timer, cancelled on clock changes.
+    int eventFd_ = -1; ///< Counter written by notify().
+#else
+    std::mutex mutex_; ///< Guards notified_.
+    std::condition_variable changed_; ///< Signals notify().
+    bool notified_ = false; ///< A notification has not been consumed yet.
+#endif
+};
+
+#endif // WAKE_EVENT_HPP
@@ -0,0 +1,103 @@
+/**
+ * @file archive_index.cpp
+ * @brief Writing and querying `<archive>.idx` entry indexes.
+ */
+
+#include "archive_index.hpp"
+#include "digest.hpp"
+#include "sorted_table.hpp"
+#include "file_util.hpp"
+#include <algorithm>
+#include <cstring>
+#include <format>
+
+namespace {
+
+constexpr char kArchiveIndexMagic[8] = {'S', 'V', 'A', 'I', 'D', 'X', '0', '1'};
+
+struct ArchiveIndexHeader {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t reserved;
+    uint64_t recordCount;
+    uint64_t stringsSize;
+};
+
+struct ArchiveIndexRecord {
+    uint64_t pathOffset;
+    uint32_t pathLength;
+    uint32_t frame;
+    uint64_t size;
+    int64_t mtime;
+    uint64_t offset;
+    uint8_t sha256[32];
+};
+
+static_assert(sizeof(ArchiveIndexHeader) == 32 && sizeof(ArchiveIndexRecord) == 72);
+
+} // namespace
+
+std::string archiveIndexPath(const std::string& archivePath) {
+    return archivePath + ".idx";
+}
+
+std::expected<void, std::string> writeArchiveIndex(const std::string& archivePath, std::vector<ManifestEntry> entries) {
+    std::ranges::sort(entries, {}, &ManifestEntry::archivePath);
+    std::vector<ArchiveIndexRecord> records;
+    records.reserve(entries.size());
+    std::string strings;
+    for (const auto& entry : entries) {
+        ArchiveIndexRecord record{};
+        record.pathOffset = strings.size();
+        record.pathLength = static_cast<uint32_t>(entry.archivePath.size());
+        strings += entry.archivePath;
+        record.frame = entry.frame;
+        record.size = entry.size;
+        record.mtime = entry.mtime;
+        record.offset = entry.archiveOffset;
+        std::memcpy(record.sha256, entry.sha256.data(), sizeof(record.sha256));
+        records.push_back(record);
+    }
+    ArchiveIndexHeader header{};
+    std::memcpy(header.magic, kArchiveIndexMagic, sizeof(header.magic));
+    header.byteOrder = kSortedTableByteOrder;
+    header.recordCount = records.size();
+    header.stringsSize = strings.size();
+    auto result = writeFileAtomically(archiveIndexPath(archivePath), serializeTable(header, records, strings));
+    if (!result) {
+        return std::unexpected(std::format("Failed to write archive index: {}", result.error()));
+    }
+    return {};
+}
+
+std::expected<std::vector<ArchiveIndexEntry>, std::string> readArchiveIndex(const std::string& archivePath, const std::string& pattern) {
+    TableView<ArchiveIndexHeader, ArchiveIndexRecord> index;
+    auto opened = index.open(archiveIndexPath(archivePath), kArchiveIndexMagic);
+    if (!opened) {
+        return std::unexpected(opened.error());
+    }
+    std::vector<ArchiveIndexEntry> entries;
+    const std::string_view prefix = globPrefix(pattern);
+    const bool literal = prefix.size() == pattern.size();
+    for (uint64_t i = index.lowerBound(prefix); i < index.count(); ++i) {
+        const std::string_view path = index.path(i);
+        if (!path.starts_with(prefix) || (literal && path != prefix)) {
+            break;
+        }
+        if (!literal && !globMatch(pattern, path)) {
+            continue;
+        }
+        const ArchiveIndexRecord record = index.record(i);
+        ArchiveIndexEntry entry;
+        entry.path = path;
+        entry.size = record.size;
+        entry.mtime = record.mtime;
+        entry.offset = record.offset;
+        entry.frame = record.frame;
+        if (std::ranges::any_of(record.sha256, [](uint8_t byte) { return byte != 0; })) {
+            entry.sha256 = Sha256::toHex(record.sha256);
+        }
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
@@ -0,0 +1,486 @@
+/**
+ * @file artifact_verifier.cpp
+ * @brief Archive and database dump verification on a worker pool.
+ */
+
+#include "artifact_verifier.hpp"
+#include "frame_archive.hpp"
+#include <archive.h>
+#include <archive_entry.h>
+#include <zlib.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <random>
+#include <span>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t kBufferSize = 1 << 20;
+constexpr size_t kFooterWindow = 4096; ///< Tail of a dump searched for the completion footer.
+
+/**
+ * @brief Inflates a (possibly multi-member) gzip file, checking each member's CRC-32 and length.
+ */
+class GzipSource {
+public:
+    explicit GzipSource(const std::string& path)
+        : input_(path, std::ios::binary), in_(kBufferSize), out_(kBufferSize) {
+        std::memset(&stream_, 0, sizeof(stream_));
+        // 15 + 16: gzip wrapper only, so a raw zlib stream is rejected as corrupt.
+        initialized_ = inflateInit2(&stream_, 15 + 16) == Z_OK;
+    }
+
+    ~GzipSource() {
+        if (initialized_) {
+            inflateEnd(&stream_);
+        }
+    }
+
+    GzipSource(const GzipSource&) = delete;
+    GzipSource& operator=(const GzipSource&) = delete;
+
+    /**
+     * @brief Returns the next block of decompressed data; an empty span marks a clean end.
+     */
+    std::expected<std::span<const char>, std::string> next() {
+        if (!input_.is_open()) {
+            return std::unexpected("Failed to open file");
+        }
+        if (!initialized_) {
+            return std::unexpected("Failed to initialize zlib");
+        }
+        stream_.next_out = out_.data();
+        stream_.avail_out = static_cast<uInt>(out_.size());
+        while (stream_.avail_out == out_.size()) {
+            if (stream_.avail_in == 0) {
+                if (eof_) {
+                    if (memberOpen_ || members_ == 0) {
+                        return std::unexpected("Truncated gzip stream");
+                    }
+                    return std::span<const char>();
+                }
+                input_.read(reinterpret_cast<char*>(in_.data()), static_cast<std::streamsize>(in_.size()));
+                if (input_.bad()) {
+                    return std::unexpected("Failed to read file");
+                }
+                stream_.next_in = in_.data();
+                stream_.avail_in = static_cast<uInt>(input_.gcount());
+                eof_ = input_.eof();
+                continue;
+            }
+
+            if (!memberOpen_) {
+                // Block-padded writers may leave zero bytes after the last member.
+                if (members_ > 0 && stream_.next_in[0] == 0) {
+                    if (!onlyZerosRemain()) {
+                        return std::unexpected("Unexpected data after gzip stream");
+                    }
+                    return std::span<const char>();
+                }
+                inflateReset(&stream_);
+                memberOpen_ = true;
+            }
+
+            const int rc = inflate(&stream_, Z_NO_FLUSH);
+            if (rc == Z_STREAM_END) {
+                memberOpen_ = false;
+                ++members_;
+            } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+                return std::unexpected(std::format("Corrupt gzip data: {}", stream_.msg ? stream_.msg : zError(rc)));
+            }
+        }
+        return std::span<const char>(reinterpret_cast<const char*>(out_.data()), out_.size() - stream_.avail_out);
+    }
+
+    uint64_t members() const { return members_; }
+
+private:
+    bool onlyZerosRemain() {
+        while (true) {
+            if (std::any_of(stream_.next_in, stream_.next_in + stream_.avail_in, [](Bytef b) { return b != 0; })) {
+                return false;
+            }
+            stream_.avail_in = 0;
+            if (eof_) {
+                return true;
+            }
+            input_.read(reinterpret_cast<char*>(in_.data()), static_cast<std::streamsize>(in_.size()));
+            stream_.next_in = in_.data();
+            stream_.avail_in = static_cast<uInt>(input_.gcount());
+            eof_ = input_.eof() || input_.bad();
+        }
+    }
+
+    std::ifstream input_;
+    std::vector<Bytef> in_;
+    std::vector<Bytef> out_;
+    z_stream stream_;
+    bool initialized_ = false;
+    bool eof_ = false;
+    bool memberOpen_ = false;
+    uint64_t members_ = 0;
+};
+
+using BlockReader = std::function<std::expected<std::span<const char>, std::string>()>;
+
+struct TarSource {
+    BlockReader next; ///< Produces decompressed tar bytes; an empty block ends the stream.
+    std::string error; ///< Decompression error, reported instead of libarchive's generic message.
+    uint64_t bytes = 0;
+};
+
+la_ssize_t readInflated(struct archive* a, void* data, const void** buffer) {
+    auto* source = static_cast<TarSource*>(data);
+    auto block = source->next();
+    if (!block) {
+        source->error = block.error();
+        archive_set_error(a, EIO, "%s", source->error.c_str());
+        return -1;
+    }
+    source->bytes += block->size();
+    *buffer = block->data();
+    return static_cast<la_ssize_t>(block->size());
+}
+
+/**
+ * @brief Walks every entry of a tar archive read through the given libarchive handle.
+ */
+std::expected<uint64_t, std::string> walkEntries(struct archive* a) {
+    uint64_t entries = 0;
+    struct archive_entry* entry;
+    while (true) {
+        const int rc = archive_read_next_header(a, &entry);
+        if (rc == ARCHIVE_EOF) {
+            return entries;
+        }
+        if (rc < ARCHIVE_WARN) {
+            return std::unexpected(std::format("Bad archive header after {} entries: {}", entries, archive_error_string(a)));
+        }
+        // Skipping reads the entry body, so a short or corrupt body surfaces here.
+        if (archive_read_data_skip(a) < ARCHIVE_WARN) {
+            return std::unexpected(std::format("Bad archive entry {}: {}", archive_entry_pathname(entry), archive_error_string(a)));
+        }
+        ++entries;
+    }
+}
+
+/**
+ * @brief Walks the tar entries of a decompressed stream and then reads the stream to its end,
+ *        so trailing checksums are verified too.
+ *
+ * @return std::expected<uint64_t, std::string> Entries found or an error message.
+ */
+std::expected<uint64_t, std::string> walkTarStream(TarSource& source) {
+    struct archive* a = archive_read_new();
+    archive_read_support_format_tar(a);
+    if (archive_read_open(a, &source, nullptr, readInflated, nullptr) != ARCHIVE_OK) {
+        std::string error = source.error.empty() ? archive_error_string(a) : source.error;
+        archive_read_free(a);
+        return std::unexpected(error);
+    }
+
+    auto entries = walkEntries(a);
+    if (entries) {
+        // libarchive stops at the end-of-archive marker; the compressed trailer still has to be checked.
+        while (true) {
+            auto block = source.next();
+            if (!block) {
+                entries = std::unexpected(block.error());
+                break;
+            }
+            if (block->empty()) {
+                break;
+            }
+            source.bytes += block->size();
+        }
+    } else if (!source.error.empty()) {
+        entries = std::unexpected(source.error);
+    }
+    archive_read_free(a);
+    return entries;
+}
+
+void verifyGzipArchive(const std::string& file, VerificationResult& result) {
+    GzipSource gzip(file);
+    TarSource source{[&gzip]() { return gzip.next(); }, {}, 0};
+    auto entries = walkTarStream(source);
+    result.bytes = source.bytes;
+    if (!entries) {
+        result.result = std::unexpected(entries.error());
+        return;
+    }
+    result.entries = *entries;
+}
+
+/**
+ * @brief Returns the number of rotation slots for an archive.
+ *
+ * At least rotationDays, and enough that one slot's share of the archive fits the budget.
+ */
+uint64_t rotationSlots(const std::vector<ArchiveFrame>& frames, uint64_t budget, unsigned rotationDays) {
+    const ArchiveFrame& last = frames.back();
+    const uint64_t archiveSize = last.compressedOffset + last.compressedSize;
+    return std::max<uint64_t>(rotationDays, (archiveSize + budget - 1) / budget);
+}
+
+/**
+ * @brief Chooses the frames checked in this run.
+ *
+ * Frame i belongs to rotation slot i % slots; today's slot is always checked, so every frame
+ * position is covered once every slots days. The last frame (tar trailer, end of file) is always
+ * checked. Remaining budget goes to frames chosen at random.
+ */
+std::vector<size_t> chooseFrames(const std::vector<ArchiveFrame>& frames, uint64_t budget, uint64_t slots) {
+    const auto days = std::chrono::duration_cast<std::chrono::days>(std::chrono::system_clock::now().time_since_epoch()).count();
+    const size_t slot = static_cast<size_t>(static_cast<uint64_t>(days) % slots);
+
+    std::vector<bool> chosen(frames.size(), false);
+    uint64_t spent = 0;
+    auto take = [&](size_t index) {
+        if (!chosen[index]) {
+            chosen[index] = true;
+            spent += frames[index].compressedSize;
+        }
+    };
+    take(frames.size() - 1);
+    for (size_t i = slot; i < frames.size(); i += slots) {
+        take(i);
+    }
+
+    std::vector<size_t> others;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (!chosen[i]) {
+            others.push_back(i);
+        }
+    }
+    std::shuffle(others.begin(), others.end(), std::mt19937_64(std::random_device{}()));
+    for (size_t index : others) {
+        if (spent + frames[index].compressedSize > budget) {
+            continue;
+        }
+        take(index);
+    }
+
+    std::vector<size_t> selection;
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (chosen[i]) {
+            selection.push_back(i);
+        }
+    }
+    return selection;
+}
+
+void verifySampledArchive(const std::string& file, const std::vector<ArchiveFrame>& frames, uint64_t budget,
+                          unsigned rotationDays, VerificationResult& result) {
+    result.framesTotal = frames.size();
+    std::error_code ec;
+    const uint64_t fileSize = fs::file_size(file, ec);
+    const ArchiveFrame& last = frames.back();
+    if (ec || fileSize != last.compressedOffset + last.compressedSize) {
+        result.result = std::unexpected("Archive size does not match its frame index (truncated or rewritten)");
+        return;
+    }
+
+    std::ifstream archive(file, std::ios::binary);
+    if (!archive) {
+        result.result = std::unexpected("Failed to open file");
+        return;
+    }
+    const uint64_t slots = rotationSlots(frames, budget, rotationDays);
+    if (slots > rotationDays) {
+        result.warning = std::format("a full pass over {} takes {} days, longer than rotation_days ({}); raise sample_budget_mb to shorten it",
+                                     file, slots, rotationDays);
+    }
+    for (size_t index : chooseFrames(frames, budget, slots)) {
+        const ArchiveFrame& frame = frames[index];
+        FrameReader reader(archive, frame);
+        TarSource source{[&reader]() { return reader.next(); }, {}, 0};
+        auto entries = walkTarStream(source);
+        result.bytes += source.bytes;
+        if (!entries) {
+            result.result = std::unexpected(std::format("Frame {}: {}", index, entries.error()));
+            return;
+        }
+        if (*entries != frame.entries) {
+            result.result = std::unexpected(std::format("Frame {}: {} entries, index records {}", index, *entries, frame.entries));
+            return;
+        }
+        result.entries += *entries;
+        ++result.framesChecked;
+    }
+}
+
+void verifyOtherArchive(const std::string& file, VerificationResult& result) {
+    struct archive* a = archive_read_new();
+    archive_read_support_filter_all(a);
+    archive_read_support_format_all(a);
+    if (archive_read_open_filename(a, file.c_str(), kBufferSize) != ARCHIVE_OK) {
+        result.result = std::unexpected(archive_error_string(a));
+        archive_read_free(a);
+        return;
+    }
+    auto entries = walkEntries(a);
+    archive_read_free(a);
+    if (!entries) {
+        result.result = std::unexpected(entries.error());
+        return;
+    }
+    result.entries = *entries;
+}
+
+void verifySqlDump(const std::string& file, VerificationResult& result) {
+    GzipSource gzip(file);
+    std::string tail;
+    while (true) {
+        auto block = gzip.next();
+        if (!block) {
+            result.result = std::unexpected(block.error());
+            return;
+        }
+        if (block->empty()) {
+            break;
+        }
+        result.bytes += block->size();
+        tail.append(block->data(), block->size());
+        if (tail.size() > 2 * kFooterWindow) {
+            tail.erase(0, tail.size() - kFooterWindow);
+        }
+    }
+
+    if (result.bytes == 0) {
+        result.result = std::unexpected("Dump is empty");
+        return;
+    }
+    // mysqldump ends with "-- Dump completed on <date>", pg_dumpall with "-- PostgreSQL database cluster dump complete".
+    if (tail.find("-- Dump completed") == std::string::npos &&
+        tail.find("-- PostgreSQL database cluster dump complete") == std::string::npos &&
+        tail.find("-- PostgreSQL database dump complete") == std::string::npos) {
+        result.result = std::unexpected("Dump completion footer missing; the dump was probably cut short");
+    }
+}
+
+bool endsWith(const std::string& value, const std::string& suffix) {
+    return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+ArtifactVerifier::ArtifactVerifier(const Json::Value& verifyConfig, CompletionHandler onComplete)
+    : onComplete_(std::move(onComplete)),
+      sampleBudget_(verifyConfig.get("sample_budget_mb", 0).asUInt64() * 1024 * 1024),
+      rotationDays_(std::max(verifyConfig.get("rotation_days", 7).asUInt(), 1u)) {
+    unsigned threads = verifyConfig.get("threads", 0).asUInt();
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        workers_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ArtifactVerifier::~ArtifactVerifier() {
+    finish();
+}
+
+void ArtifactVerifier::submit(const std::string& file, const std::string& artifactClass) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            return;
+        }
+        queue_.emplace_back(file, artifactClass);
+    }
+    wake_.notify_one();
+}
+
+std::vector<VerificationResult> ArtifactVerifier::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    return results_;
+}
+
+void ArtifactVerifier::workerLoop() {
+    while (true) {
+        std::pair<std::string, std::string> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&]() { return closed_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            job = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        VerificationResult result = check(job.first, job.second);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            results_.push_back(result);
+        }
+        if (onComplete_) {
+            onComplete_(result);
+        }
+    }
+}
+
+VerificationResult ArtifactVerifier::verify(const std::string& file, const std::string& artifactClass) {
+    VerificationResult result;
+    result.artifact = file;
+    result.artifactClass = artifactClass;
+    const auto start = std::chrono::steady_clock::now();
+
+    std::error_code ec;
+    if (!fs::is_regular_file(file, ec)) {
+        result.result = std::unexpected("File does not exist");
+    } else if (endsWith(file, ".sql.gz")) {
+        verifySqlDump(file, result);
+    } else if (endsWith(file, ".tar.gz") || endsWith(file, ".tgz")) {
+        verifyGzipArchive(file, result);
+    } else {
+        verifyOtherArchive(file, result);
+    }
+
+    if (!result.result) {
+        result.result = std::unexpected(std::format("{}: {}", file, result.result.error()));
+    }
+    result.duration = std::chrono::steady_clock::now() - start;
+    return result;
+}
+
+VerificationResult ArtifactVerifier::check(const std::string& file, const std::string& artifactClass) const {
+    std::error_code ec;
+    if (sampleBudget_ == 0 || !endsWith(file, ".tar.gz") || fs::file_size(file, ec) <= sampleBudget_ || ec) {
+        return verify(file, artifactClass);
+    }
+    auto frames = readFrameIndex(file);
+    if (!frames) {
+        // Archives written without frames can only be checked in full.
+        return verify(file, artifactClass);
+    }
+
+    VerificationResult result;
+    result.artifact = file;
+    result.artifactClass = artifactClass;
+    const auto start = std::chrono::steady_clock::now();
+    verifySampledArchive(file, *frames, sampleBudget_, rotationDays_, result);
+    if (!result.result) {
+        result.result = std::unexpected(std::format("{}: {}", file, result.result.error()));
+    }
+    result.duration = std::chrono::steady_clock::now() - start;
+    return result;
+}
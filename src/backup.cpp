@@ -1,7 +1,27 @@
 #include "backup.hpp"
 #include "backup_api.hpp"
-#include <archive.h>
-#include <archive_entry.h>
+#include "chunk_repository.hpp"
+#include "http_transfer.hpp"
+#include "securevault_transfer.hpp"
+#include "archive_index.hpp"
+#include "artifact_verifier.hpp"
+#include "catalog.hpp"
+#include "frame_archive.hpp"
+#include "retention_policy.hpp"
+#include "digest.hpp"
+#include "file_util.hpp"
+#include "restore_engine.hpp"
+#include "restore_planner.hpp"
+#include "synthetic_full.hpp"
+#include "transfer_scheduler.hpp"
+#include "trash_collector.hpp"
+#include "io_priority.hpp"
+#include "load_monitor.hpp"
+#include "change_journal.hpp"
+#include "config_watcher.hpp"
+#include "job_scheduler.hpp"
+#include "wake_event.hpp"
+#include "transfer_metrics.hpp"
 #include <iostream>
 #include <thread>
 #include <sstream>
@@ -10,6 +30,11 @@
 #include <csignal>
 #include <cerrno>
 #include <filesystem>
+#include <algorithm>
+#include <optional>
+#include <set>
+#include <print>
+#include <charconv>
 #ifndef _WIN32
 #include <pwd.h>
 #include <grp.h>
@@ -24,8 +49,116 @@ volatile std::sig_atomic_t gShutdownFlag = 0;
 
 void signalHandler(int /*sig*/) {
     gShutdownFlag = 1;
+    WakeEvent::notifyFromSignal();
 }
 
+namespace {
+
+/**
+ * @brief Translates a "schedule"-style section (type, time, day) into a cron expression.
+ */
+std::expected<std::string, std::string> legacyCron(const std::string& scheduleType, const std::string& scheduleTime,
+                                                   const std::string& scheduleDayOfWeek, int scheduleDayOfMonth) {
+    int hour, minute, second;
+    std::istringstream ss(scheduleTime);
+    char colon;
+    ss >> hour >> colon >> minute >> colon >> second;
+    if (ss.fail() || hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 59) {
+        return std::unexpected(std::format("Invalid schedule time format: {}", scheduleTime));
+    }
+    if (scheduleType == "daily") {
+        return std::format("{} {} {} * * *", second, minute, hour);
+    }
+    if (scheduleType == "weekly") {
+        static const std::set<std::string> days = {"monday", "tuesday", "wednesday", "thursday", "friday", "saturday", "sunday"};
+        if (!days.contains(scheduleDayOfWeek)) {
+            return std::unexpected(std::format("Invalid day of week: {}", scheduleDayOfWeek));
+        }
+        return std::format("{} {} {} * * {}", second, minute, hour, scheduleDayOfWeek.substr(0, 3));
+    }
+    if (scheduleType == "monthly") {
+        if (scheduleDayOfMonth < 1 || scheduleDayOfMonth > 31) {
+            return std::unexpected(std::format("Invalid day of month: {}", scheduleDayOfMonth));
+        }
+        return std::format("{} {} {} {} * *", second, minute, hour, scheduleDayOfMonth);
+    }
+    return std::unexpected(std::format("Invalid schedule type: {}", scheduleType));
+}
+
+std::unique_ptr<TransferStrategy> makeTransferStrategy(const Json::Value& destination, const std::string& stateFolder) {
+    const std::string type = destination.get("type", "sftp").asString();
+    std::unique_ptr<TransferStrategy> strategy;
+    if (type == "sftp") {
+        strategy = std::make_unique<SFTPTransferStrategy>(destination, stateFolder);
+    } else if (type == "securevault") {
+        strategy = std::make_unique<SecureVaultTransferStrategy>(destination);
+    } else if (type == "webdav" || type == "http") {
+        strategy = std::make_unique<HttpTransferStrategy>(destination);
+    } else {
+        throw std::runtime_error(std::format("Unsupported destination type: {}", type));
+    }
+    if (destination.get("repository", false).asBool()) {
+        strategy = std::make_unique<RepositoryTransferStrategy>(std::move(strategy), destination, stateFolder);
+    }
+    return strategy;
+}
+
+/**
+ * @brief Creates the transfer strategy of the "sftp", "destinations" and "transfer" sections.
+ *
+ * @return std::unique_ptr<TransferStrategy> The strategy, or null without destinations.
+ */
+std::unique_ptr<TransferStrategy> makeTransferStrategy(const BackupConfig& config) {
+    std::vector<std::unique_ptr<TransferStrategy>> destinations;
+    if (!config.sftpConfig.empty() &&
+        !config.sftpConfig.get("host", "").asString().empty() &&
+        !config.sftpConfig.get("user", "").asString().empty()) {
+        destinations.push_back(makeTransferStrategy(config.sftpConfig, config.stateFolder));
+    }
+    for (const auto& destination : config.destinationsConfig) {
+        destinations.push_back(makeTransferStrategy(destination, config.stateFolder));
+    }
+    if (destinations.size() == 1) {
+        return std::move(destinations.front());
+    }
+    if (destinations.size() > 1) {
+        return std::make_unique<FanOutTransferStrategy>(std::move(destinations), config.transferConfig);
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Creates the notification strategy of the "telegram" or "email" section.
+ *
+ * @return std::unique_ptr<NotificationStrategy> The strategy, or null if neither is set.
+ */
+std::unique_ptr<NotificationStrategy> makeNotificationStrategy(const BackupConfig& config) {
+    if (!config.telegramConfig.empty()) {
+        return std::make_unique<TelegramNotificationStrategy>(config.telegramConfig);
+    }
+    if (!config.emailConfig.empty()) {
+        return std::make_unique<EmailNotificationStrategy>(config.emailConfig);
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Checks the settings a Backup cannot run without.
+ */
+std::expected<void, std::string> validateConfig(const BackupConfig& config) {
+    if (config.databases.empty()) {
+        return std::unexpected("No database configuration provided");
+    }
+    for (const auto& db : config.databases) {
+        if (db.type != "mysql" && db.type != "postgresql") {
+            return std::unexpected(std::format("Unsupported database type: {}", db.type));
+        }
+    }
+    return {};
+}
+
+} // namespace
+
 void changeOwnership(const std::string& path, const std::string& user, const std::string& groupName) {
 #ifndef _WIN32
     struct passwd* pwd = getpwnam(user.c_str());
@@ -41,40 +174,143 @@ void changeOwnership(const std::string& path, const std::string& user, const std
 #endif
 }
 
-Backup::Backup(const std::string& configFile) : config(configFile) {
-    if (config.databases.empty()) {
-        throw std::runtime_error("No database configuration provided");
+Backup::Backup(const std::string& configFile) : configFile_(configFile), config(configFile) {
+    auto valid = validateConfig(config);
+    if (!valid) {
+        throw std::runtime_error(valid.error());
     }
-    for (const auto& db : config.databases) {
-        if (db.type != "mysql" && db.type != "postgresql") {
-            throw std::runtime_error(std::format("Unsupported database type: {}", db.type));
-        }
+
+    // Busy hosts delay scheduled jobs and slow running pipelines down (see the "load" section).
+    if (config.loadConfig.isObject()) {
+        loadMonitor = std::make_unique<LoadMonitor>(config.loadConfig, [this](const std::string& message) {
+            logBackgroundMessage(message);
+        });
     }
+    buildFileStrategy();
+    transferStrategy = makeTransferStrategy(config);
+    // Expired artifacts are renamed into the trash and deleted gradually in the background.
+    trash = std::make_unique<TrashCollector>(config.backupBase + "trash/", config.trashConfig, [this](const std::string& message) {
+        logBackgroundError(message);
+    });
+    notificationStrategy = makeNotificationStrategy(config);
+}
 
-    fileStrategy = std::make_unique<TarGzFileBackupStrategy>(config.excludeExtensions, config.lastBackupFile);
-    if (!config.sftpConfig.empty() &&
-        !config.sftpConfig.get("host", "").asString().empty() &&
-        !config.sftpConfig.get("user", "").asString().empty()) {
-        transferStrategy = std::make_unique<SFTPTransferStrategy>(config.sftpConfig);
+Backup::~Backup() = default;
+
+void Backup::buildFileStrategy() {
+    fileStrategy = std::make_unique<TarGzFileBackupStrategy>(config.excludeExtensions, config.lastBackupFile, config.archiveFrameSize,
+                                                             config.levelsFile);
+    fileStrategy->attachLoadMonitor(loadMonitor.get());
+    fileStrategy->attachChangeJournal(changeJournal.get());
+}
+
+void Backup::logBackgroundMessage(const std::string& message) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    config.logMessage(message);
+}
+
+void Backup::logBackgroundError(const std::string& message) {
+    std::lock_guard<std::mutex> lock(configMutex_);
+    config.logError(message);
+}
+
+std::shared_ptr<TransferMetrics> Backup::attachRunMetrics() {
+    auto metrics = std::make_shared<TransferMetrics>();
+    // Overlapping runs share the transfer strategy; its handshake, stall and retry records go to
+    // the newest run, and collectors stay alive until no run is left that might still use them.
+    if (transferStrategy) {
+        std::lock_guard<std::mutex> lock(metricsMutex_);
+        activeMetrics_.push_back(metrics);
+        transferStrategy->attachMetrics(metrics.get());
     }
-    if (!config.telegramConfig.empty()) {
-        notificationStrategy = std::make_unique<TelegramNotificationStrategy>(config.telegramConfig);
-    } else if (!config.emailConfig.empty()) {
-        notificationStrategy = std::make_unique<EmailNotificationStrategy>(config.emailConfig);
+    return metrics;
+}
+
+void Backup::detachRunMetrics(const std::shared_ptr<TransferMetrics>& metrics) {
+    if (!transferStrategy) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(metricsMutex_);
+    std::erase(activeMetrics_, metrics);
+    if (activeMetrics_.empty()) {
+        transferStrategy->attachMetrics(nullptr);
+        retiredMetrics_.clear();
+    } else {
+        transferStrategy->attachMetrics(activeMetrics_.back().get());
+        retiredMetrics_.push_back(metrics);
+    }
+}
+
+std::expected<void, std::string> Backup::execute(const std::string& type, bool fullBackup, int level, BackupTargets targets) {
+    const auto started = std::chrono::system_clock::now();
+    auto metrics = attachRunMetrics();
+    if (level == FileBackupStrategy::kSinceLastRun && fullBackup) {
+        level = 0;
+    }
+    auto result = runBackup(type, level, targets, *metrics);
+    detachRunMetrics(metrics);
+    writeRunReport(type, started, result, *metrics);
+    return result;
+}
+
+void Backup::writeRunReport(const std::string& type, std::chrono::system_clock::time_point started,
+                            const std::expected<void, std::string>& result, const TransferMetrics& metrics) {
+    auto formatTime = [](std::chrono::system_clock::time_point time, const char* pattern) {
+        auto timeT = std::chrono::system_clock::to_time_t(time);
+        char buffer[32];
+        std::strftime(buffer, sizeof(buffer), pattern, std::localtime(&timeT));
+        return std::string(buffer);
+    };
+
+    const auto finished = std::chrono::system_clock::now();
+    Json::Value report;
+    report["type"] = type;
+    report["started"] = formatTime(started, "%Y-%m-%dT%H:%M:%S");
+    report["finished"] = formatTime(finished, "%Y-%m-%dT%H:%M:%S");
+    report["duration_seconds"] = std::chrono::duration<double>(finished - started).count();
+    report["success"] = result.has_value();
+    if (!result) {
+        report["error"] = result.error();
+    }
+    report["transfers"] = metrics.toJson();
+
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "  ";
+    const std::string json = Json::writeString(writer, report);
+    for (const auto& name : {std::format("run-{}.json", formatTime(started, "%Y%m%d-%H%M%S")), std::string("latest.json")}) {
+        auto writeResult = writeFileAtomically(config.reportFolder + name, json);
+        if (!writeResult) {
+            config.logError(std::format("Failed to write run report: {}", writeResult.error()));
+        }
+    }
+
+    if (!config.metricsTextfile.empty()) {
+        auto writeResult = writeFileAtomically(config.metricsTextfile, metrics.toPrometheus(result.has_value()));
+        if (!writeResult) {
+            config.logError(std::format("Failed to write metrics textfile: {}", writeResult.error()));
+        }
     }
 }
 
-std::expected<void, std::string> Backup::execute(const std::string& type, bool fullBackup) {
+std::expected<void, std::string> Backup::runBackup(const std::string& type, int level, BackupTargets targets, TransferMetrics& metrics) {
     std::string dateFormat;
-    if (type == "daily") {
+    if (type == "hourly") {
+        dateFormat = "%H";
+    } else if (type == "daily") {
         dateFormat = "%d";
+    } else if (type == "weekly") {
+        dateFormat = "%V";
     } else if (type == "monthly") {
         dateFormat = "%m";
     } else if (type == "yearly") {
         dateFormat = "%Y";
     } else {
         config.logError(std::format("Invalid backup type: {}", type));
-        return std::unexpected("Invalid backup type. Use daily, monthly, or yearly.");
+        return std::unexpected("Invalid backup type. Use hourly, daily, weekly, monthly, or yearly.");
+    }
+    if (level < FileBackupStrategy::kSinceLastRun || level > 9) {
+        config.logError(std::format("Invalid backup level: {}", level));
+        return std::unexpected("Invalid backup level. Use 0 to 9.");
     }
 
     auto now = std::chrono::system_clock::now();
@@ -83,13 +319,62 @@ std::expected<void, std::string> Backup::execute(const std::string& type, bool f
     std::strftime(dateBuf, sizeof(dateBuf), dateFormat.c_str(), std::localtime(&timeT));
     char timestampBuf[32];
     std::strftime(timestampBuf, sizeof(timestampBuf), "%Y%m%d-%H%M%S", std::localtime(&timeT));
-    std::string targetFilename = std::format("sys-{}-{}-{}.tar.gz", type, dateBuf, timestampBuf);
+    std::string targetFilename = level >= 0 ? std::format("sys-{}-{}-L{}-{}.tar.gz", type, dateBuf, level, timestampBuf)
+                                            : std::format("sys-{}-{}-{}.tar.gz", type, dateBuf, timestampBuf);
     std::string targetPath = config.sysBackupFolder + targetFilename;
 
     std::vector<std::string> dbBackupFiles;
     dbBackupFiles.reserve(config.databases.size());
 
-    for (size_t i = 0; i < config.databases.size(); ++i) {
+    // Uploads start as soon as each artifact exists, so dumps go offsite while the file archive
+    // is still being built; the scheduler orders them by class priority.
+    std::unique_ptr<TransferScheduler> scheduler;
+    if (transferStrategy) {
+        scheduler = std::make_unique<TransferScheduler>(*transferStrategy, config.transferConfig, [this](const TransferOutcome& outcome) {
+            if (outcome.result) {
+                const double seconds = std::chrono::duration<double>(outcome.elapsed).count();
+                const double mebibytes = static_cast<double>(outcome.job.size) / (1024.0 * 1024.0);
+                const std::string pauses = outcome.pauses > 0
+                    ? std::format(", paused {} time(s) for higher-priority artifacts", outcome.pauses)
+                    : std::string();
+                config.logMessage(std::format("Transferred {} ({:.1f} MiB in {:.1f} s, {:.1f} MiB/s{})", outcome.job.file, mebibytes,
+                                              seconds, seconds > 0 ? mebibytes / seconds : 0.0, pauses));
+                if (outcome.missedWindow) {
+                    config.logError(std::format("Transfer of {} finished after the transfer window", outcome.job.file));
+                }
+                return;
+            }
+            auto errorMsg = outcome.job.artifactClass == "db"
+                ? std::format("Database transfer failed for {}: {}", outcome.job.file, outcome.result.error())
+                : std::format("File transfer failed: {}", outcome.result.error());
+            config.logError(errorMsg);
+            if (notificationStrategy) {
+                notificationStrategy->notify(errorMsg);
+            }
+        }, &metrics);
+    }
+
+    // Every artifact is read back on the verification pool as soon as it exists; only verified
+    // artifacts are handed to the scheduler, so a truncated dump never replaces a good remote copy.
+    ArtifactVerifier verifier(config.verifyConfig, [this, &scheduler](const VerificationResult& verification) {
+        if (!verification.result) {
+            return;
+        }
+        const std::string coverage = verification.framesTotal > 0
+            ? std::format(", sampled {} of {} frames", verification.framesChecked, verification.framesTotal)
+            : std::string();
+        config.logMessage(std::format("Verified {} ({} entries, {:.1f} MiB in {:.1f} s{})", verification.artifact, verification.entries,
+                                      static_cast<double>(verification.bytes) / (1024.0 * 1024.0), verification.duration.count(),
+                                      coverage));
+        if (!verification.warning.empty()) {
+            config.logError(std::format("Verification warning: {}", verification.warning));
+        }
+        if (scheduler) {
+            scheduler->submit(verification.artifact, verification.artifactClass, verification.artifactClass);
+        }
+    });
+
+    for (size_t i = 0; targets.databases && i < config.databases.size(); ++i) {
         const auto& db = config.databases[i];
         std::unique_ptr<DatabaseBackupStrategy> currentDbStrategy;
         if (db.type == "mysql") {
@@ -101,6 +386,7 @@ std::expected<void, std::string> Backup::execute(const std::string& type, bool f
         if (!currentDbStrategy) {
             continue;
         }
+        currentDbStrategy->attachLoadMonitor(loadMonitor.get());
 
         std::string dbBaseFilename = std::format("{}_all_databases_{}_{}", db.type, i + 1, timestampBuf);
         std::string dbTargetPath = config.dbBackupFolder + dbBaseFilename;
@@ -115,21 +401,51 @@ std::expected<void, std::string> Backup::execute(const std::string& type, bool f
             continue;
         }
         dbBackupFiles.push_back(*dbResult);
+        verifier.submit(*dbResult, "db");
     }
 
-    auto fileResult = fileStrategy->execute(config.backupDirs, targetPath, fullBackup);
-    if (!fileResult) {
-        auto errorMsg = std::format("File backup failed: {}", fileResult.error());
-        config.logError(errorMsg);
-        if (notificationStrategy) {
-            notificationStrategy->notify(errorMsg);
+    // File runs share the reference times of incremental levels and the catalog chain, so only
+    // one of them (or a synthetic full) works on file archives at a time.
+    std::unique_lock<std::mutex> archiveLock(archiveMutex_, std::defer_lock);
+    std::unique_ptr<FileManifest> manifest;
+    std::optional<std::chrono::system_clock::time_point> fileStarted;
+    if (targets.files) {
+        if (!archiveLock.try_lock()) {
+            config.logMessage("Waiting for the running file backup to finish");
+            archiveLock.lock();
         }
-        return std::unexpected(errorMsg);
+        if (!config.catalogFolder.empty()) {
+            manifest = std::make_unique<FileManifest>();
+        }
+        auto fileResult = fileStrategy->execute(config.backupDirs, targetPath, level, manifest.get());
+        if (!fileResult) {
+            auto errorMsg = std::format("File backup failed: {}", fileResult.error());
+            config.logError(errorMsg);
+            if (notificationStrategy) {
+                notificationStrategy->notify(errorMsg);
+            }
+            return std::unexpected(errorMsg);
+        }
+        fileStarted = *fileResult;
+    }
+    // An incremental run without changed files writes no archive.
+    const bool archiveWritten = targets.files && fs::exists(targetPath);
+    if (archiveWritten) {
+        verifier.submit(targetPath, "sys");
     }
 
-    auto verifyResult = verifyBackup(targetPath);
-    if (!verifyResult || !*verifyResult) {
-        auto errorMsg = std::format("Backup verification failed: {}", verifyResult.error());
+    std::vector<std::string> verificationErrors;
+    for (const auto& verification : verifier.finish()) {
+        if (!verification.result) {
+            verificationErrors.push_back(verification.result.error());
+        }
+    }
+    if (!verificationErrors.empty()) {
+        std::string errorMsg = "Backup verification failed:";
+        for (const auto& error : verificationErrors) {
+            errorMsg += std::format(" {};", error);
+        }
+        errorMsg.pop_back();
         config.logError(errorMsg);
         if (notificationStrategy) {
             notificationStrategy->notify(errorMsg);
@@ -138,7 +454,9 @@ std::expected<void, std::string> Backup::execute(const std::string& type, bool f
     }
 
     try {
-        changeOwnership(targetPath, config.username, config.username);
+        if (archiveWritten) {
+            changeOwnership(targetPath, config.username, config.username);
+        }
         for (const auto& dbBackupFile : dbBackupFiles) {
             changeOwnership(dbBackupFile, config.username, config.username);
         }
@@ -151,25 +469,61 @@ std::expected<void, std::string> Backup::execute(const std::string& type, bool f
         return std::unexpected(errorMsg);
     }
 
-    if (transferStrategy) {
-        auto transferResult = transferStrategy->transfer(targetPath, "sys");
-        if (!transferResult) {
-            auto errorMsg = std::format("File transfer failed: {}", transferResult.error());
+    if (!config.catalogFolder.empty() && (manifest || !dbBackupFiles.empty())) {
+        CatalogRun run;
+        run.name = timestampBuf;
+        run.type = type;
+        run.level = level;
+        run.started = static_cast<int64_t>(timeT);
+        std::error_code sizeEc;
+        if (archiveWritten) {
+            run.artifacts.push_back({targetPath, "sys", static_cast<uint64_t>(fs::file_size(targetPath, sizeEc))});
+        }
+        for (const auto& dbBackupFile : dbBackupFiles) {
+            run.artifacts.push_back({dbBackupFile, "db", static_cast<uint64_t>(fs::file_size(dbBackupFile, sizeEc))});
+        }
+        std::lock_guard<std::mutex> catalogLock(catalogMutex_);
+        std::expected<void, std::string> recorded;
+        if (manifest) {
+            auto entries = manifest->take();
+            // A first incremental run stores everything and depends on nothing, like a full one.
+            run.full = level == 0 || std::ranges::all_of(entries, &ManifestEntry::stored);
+            auto committed = Catalog(config.catalogFolder).commitRun(std::move(run), entries);
+            if (committed) {
+                config.logMessage(std::format("Catalog: recorded run {} ({} files, {} stored)", committed->sequence, committed->files,
+                                              committed->storedFiles));
+            } else {
+                recorded = std::unexpected(committed.error());
+            }
+        } else {
+            recorded = commitWithoutFiles(std::move(run));
+        }
+        if (!recorded) {
+            auto errorMsg = std::format("Failed to update the backup catalog: {}", recorded.error());
             config.logError(errorMsg);
             if (notificationStrategy) {
                 notificationStrategy->notify(errorMsg);
             }
+            // Without a catalog entry the next incremental run must not build on this one.
+            fileStarted.reset();
         }
-        for (const auto& dbBackupFile : dbBackupFiles) {
-            transferResult = transferStrategy->transfer(dbBackupFile, "db");
-            if (!transferResult) {
-                auto errorMsg = std::format("Database transfer failed for {}: {}", dbBackupFile, transferResult.error());
-                config.logError(errorMsg);
-                if (notificationStrategy) {
-                    notificationStrategy->notify(errorMsg);
-                }
+    }
+    if (fileStarted) {
+        fileStrategy->recordCompleted(level, *fileStarted);
+    }
+    if (archiveLock.owns_lock()) {
+        archiveLock.unlock();
+    }
+
+    if (scheduler) {
+        for (const auto& miss : scheduler->forecastMisses()) {
+            auto warningMsg = std::format("Transfer window warning: {}", miss);
+            config.logError(warningMsg);
+            if (notificationStrategy) {
+                notificationStrategy->notify(warningMsg);
             }
         }
+        scheduler->finish();
     }
 
     auto cleanupResult = cleanupOldBackups();
@@ -182,7 +536,7 @@ std::expected<void, std::string> Backup::execute(const std::string& type, bool f
     }
 
     auto successMsg = std::format("Backup completed: {} and {}",
-                                  targetPath,
+                                  targets.files ? targetPath : std::string("no file archive"),
                                   dbBackupFiles.empty()
                                       ? "no database backups"
                                       : std::format("{} database backup(s)", dbBackupFiles.size()));
@@ -194,64 +548,519 @@ std::expected<void, std::string> Backup::execute(const std::string& type, bool f
     return {};
 }
 
+std::expected<void, std::string> Backup::commitWithoutFiles(CatalogRun run) {
+    Catalog catalog(config.catalogFolder);
+    auto runs = catalog.runs();
+    if (!runs) {
+        return std::unexpected(runs.error());
+    }
+    // Before the first file run there is no state to carry forward; an empty state would make
+    // the next incremental run look like it started from nothing.
+    if (runs->empty()) {
+        return {};
+    }
+    auto committed = catalog.commitRunWithoutFiles(std::move(run));
+    if (!committed) {
+        return std::unexpected(committed.error());
+    }
+    config.logMessage(std::format("Catalog: recorded run {} without a file archive ({} artifact(s))", committed->sequence,
+                                  committed->artifacts.size()));
+    return {};
+}
+
 std::expected<void, std::string> Backup::cleanupOldBackups() {
     auto now = std::chrono::system_clock::now();
-    auto threshold = now - std::chrono::hours(24 * config.retentionDays);
+    const auto ageThreshold = now - std::chrono::hours(24 * config.retentionDays);
+    auto threshold = ageThreshold;
+
+    // With a GFS policy, cataloged artifacts are pruned by run from the catalog. Reports and files
+    // the catalog does not know (runs that failed before being recorded, stray sidecars) still
+    // expire by age.
+    std::set<std::string> cataloged;
+    const RetentionPolicy policy = RetentionPolicy::fromJson(config.retentionConfig);
+    if (policy.enabled() && !config.catalogFolder.empty()) {
+        std::lock_guard<std::mutex> catalogLock(catalogMutex_);
+        auto oldestKept = applyRetentionPolicy(policy);
+        if (!oldestKept) {
+            config.logError(std::format("Failed to apply retention policy: {}", oldestKept.error()));
+            return std::unexpected(std::format("Failed to apply retention policy: {}", oldestKept.error()));
+        }
+        // Remote copies cannot be pruned per run; keep everything from the oldest retained run on.
+        threshold = *oldestKept;
+        auto runs = Catalog(config.catalogFolder).runs();
+        if (!runs) {
+            config.logError(std::format("Failed to read the backup catalog: {}", runs.error()));
+            return std::unexpected(std::format("Failed to read the backup catalog: {}", runs.error()));
+        }
+        for (const auto& run : *runs) {
+            for (const auto& artifact : run.artifacts) {
+                for (const auto& path : {artifact.path, frameIndexPath(artifact.path), archiveIndexPath(artifact.path)}) {
+                    cataloged.insert(fs::path(path).lexically_normal().string());
+                }
+            }
+        }
+    }
 
-    for (const auto& folder : {config.sysBackupFolder, config.dbBackupFolder}) {
+    for (const auto& folder : {config.sysBackupFolder, config.dbBackupFolder, config.reportFolder}) {
+        if (!fs::exists(folder)) {
+            continue;
+        }
         for (const auto& entry : fs::directory_iterator(folder)) {
-            if (entry.is_regular_file()) {
+            if (entry.is_regular_file() && !cataloged.contains(entry.path().lexically_normal().string())) {
                 auto lastWrite = fs::last_write_time(entry);
                 auto fileTime = std::chrono::system_clock::now() - (std::chrono::system_clock::now() - std::chrono::file_clock::to_sys(lastWrite));
-                if (fileTime < threshold) {
-                    try {
-                        fs::remove(entry);
-                        config.logMessage(std::format("Removed old backup: {}", entry.path().string()));
-                    } catch (const std::exception& e) {
-                        config.logError(std::format("Failed to remove old backup: {} (error: {})", entry.path().string(), e.what()));
-                        return std::unexpected(std::format("Failed to remove old backup: {}", e.what()));
+                if (fileTime < ageThreshold) {
+                    auto removed = trash->moveToTrash(entry.path().string());
+                    if (!removed) {
+                        config.logError(std::format("Failed to remove old backup: {} (error: {})", entry.path().string(), removed.error()));
+                        return std::unexpected(std::format("Failed to remove old backup: {}", removed.error()));
                     }
+                    config.logMessage(std::format("Removed old backup: {}", entry.path().string()));
                 }
             }
         }
     }
+
+    if (transferStrategy && config.remoteRetention) {
+        auto pruneResult = transferStrategy->pruneRemote({"sys", "db"}, threshold);
+        if (!pruneResult) {
+            config.logError(std::format("Failed to prune remote backups: {}", pruneResult.error()));
+            return std::unexpected(std::format("Failed to prune remote backups: {}", pruneResult.error()));
+        }
+        if (*pruneResult > 0) {
+            config.logMessage(std::format("Removed {} old remote backup(s)", *pruneResult));
+        }
+    }
     return {};
 }
 
-std::expected<bool, std::string> Backup::verifyBackup(const std::string& backupFile) {
-    struct archive* a = archive_read_new();
-    archive_read_support_filter_gzip(a);
-    archive_read_support_format_tar(a);
-    if (archive_read_open_filename(a, backupFile.c_str(), 10240) != ARCHIVE_OK) {
-        std::string errorMsg = std::format("Failed to open archive for verification: {} (error: {})", backupFile, archive_error_string(a));
+std::expected<std::chrono::system_clock::time_point, std::string> Backup::applyRetentionPolicy(const RetentionPolicy& policy) {
+    Catalog catalog(config.catalogFolder);
+    auto runs = catalog.runs();
+    if (!runs) {
+        return std::unexpected(runs.error());
+    }
+    if (runs->empty()) {
+        return std::chrono::system_clock::time_point{};
+    }
+    const RetentionPlan plan = planRetention(*runs, policy);
+
+    std::vector<uint32_t> removed;
+    for (uint32_t sequence : plan.pruned) {
+        const auto& run = *std::ranges::find(*runs, sequence, &CatalogRun::sequence);
+        bool complete = true;
+        for (const auto& artifact : run.artifacts) {
+            for (const auto& path : {artifact.path, frameIndexPath(artifact.path), archiveIndexPath(artifact.path)}) {
+                auto removedFile = trash->moveToTrash(path);
+                if (!removedFile) {
+                    config.logError(std::format("Failed to remove old backup: {} (error: {})", path, removedFile.error()));
+                    complete = false;
+                } else if (*removedFile) {
+                    config.logMessage(std::format("Removed old backup: {}", path));
+                }
+            }
+        }
+        // A run stays listed until all of its artifacts are gone, so a failed removal is retried.
+        if (complete) {
+            removed.push_back(sequence);
+        }
+    }
+    if (!removed.empty()) {
+        auto removeResult = catalog.removeRuns(removed);
+        if (!removeResult) {
+            return std::unexpected(removeResult.error());
+        }
+        config.logMessage(std::format("Retention: pruned {} run(s), keeping {}", removed.size(), plan.kept.size()));
+    }
+
+    int64_t oldest = std::numeric_limits<int64_t>::max();
+    for (const auto& run : *runs) {
+        if (plan.kept.contains(run.sequence)) {
+            oldest = std::min(oldest, run.started);
+        }
+    }
+    return std::chrono::system_clock::from_time_t(static_cast<std::time_t>(oldest));
+}
+
+std::expected<void, std::string> Backup::runRestoreTest(const std::string& archivePath) {
+    const Json::Value& settings = config.restoreTestConfig;
+    std::string archive = archivePath;
+    if (archive.empty()) {
+        // Newest file archive by modification time.
+        std::error_code ec;
+        fs::file_time_type newest{};
+        for (const auto& entry : fs::directory_iterator(config.sysBackupFolder, ec)) {
+            const std::string name = entry.path().filename().string();
+            if (entry.is_regular_file() && name.starts_with("sys-") && name.ends_with(".tar.gz") && entry.last_write_time() > newest) {
+                newest = entry.last_write_time();
+                archive = entry.path().string();
+            }
+        }
+        if (archive.empty()) {
+            return std::unexpected(std::format("Restore test: no file archive found in {}", config.sysBackupFolder));
+        }
+    }
+    std::error_code ec;
+    const auto archiveTime = fs::last_write_time(archive, ec);
+    if (ec) {
+        return std::unexpected(std::format("Restore test: cannot access {}: {}", archive, ec.message()));
+    }
+
+    const auto started = std::chrono::system_clock::now();
+    const auto startedT = std::chrono::system_clock::to_time_t(started);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", std::localtime(&startedT));
+    const fs::path scratch = fs::path(settings.get("scratch_dir", config.backupBase + "restore-test/").asString()) / std::format("run-{}", stamp);
+
+    // Entries are sampled by a hash of their path with a per-run seed, so each run covers a different subset.
+    const double samplePercent = std::clamp(settings.get("sample_percent", 100.0).asDouble(), 0.0, 100.0);
+    const size_t seed = std::hash<std::string>{}(stamp);
+    RestoreEngine::EntryFilter filter;
+    if (samplePercent < 100.0) {
+        filter = [samplePercent, seed](const std::string& path) {
+            return static_cast<double>((std::hash<std::string>{}(path) ^ seed) % 10000) < samplePercent * 100.0;
+        };
+    }
+
+    // Archive paths are "<last component of the backup dir>/<relative path>" (or just the relative
+    // path for directories given with a trailing slash).
+    auto livePathFor = [this](const std::string& archivePath) -> std::optional<fs::path> {
+        const fs::path relative(archivePath);
+        for (const auto& dir : config.backupDirs) {
+            const fs::path base(dir);
+            const fs::path prefix = base.filename();
+            fs::path candidate;
+            if (prefix.empty()) {
+                candidate = base / relative;
+            } else if (!relative.empty() && *relative.begin() == prefix) {
+                candidate = base.parent_path() / relative;
+            } else {
+                continue;
+            }
+            std::error_code existsEc;
+            if (fs::is_regular_file(candidate, existsEc)) {
+                return candidate;
+            }
+        }
+        return std::nullopt;
+    };
+
+    std::mutex resultsMutex;
+    uint64_t matched = 0;
+    uint64_t changed = 0;
+    std::vector<std::string> missing;
+    std::vector<std::string> mismatches;
+    auto compare = [&](const RestoredEntry& restored) {
+        auto live = livePathFor(restored.archivePath);
+        std::error_code timeEc;
+        if (!live) {
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            missing.push_back(restored.archivePath);
+        } else if (fs::last_write_time(*live, timeEc) > archiveTime || timeEc) {
+            // Modified after the archive was written; a difference proves nothing.
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            ++changed;
+        } else {
+            Sha256 hasher;
+            std::ifstream in(*live, std::ios::binary);
+            std::vector<char> buffer(1 << 20);
+            while (in) {
+                in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                hasher.update(std::span<const char>(buffer.data(), static_cast<size_t>(in.gcount())));
+            }
+            const bool same = !in.bad() && hasher.hexDigest() == restored.sha256;
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            if (same) {
+                ++matched;
+            } else {
+                mismatches.push_back(restored.archivePath);
+            }
+        }
+        // Restored files are only needed for the comparison; keep scratch usage to one file per worker.
+        std::error_code removeEc;
+        fs::remove(restored.restoredPath, removeEc);
+    };
+
+    config.logMessage(std::format("Restore test: extracting {:.0f}% of {} into {}", samplePercent, archive, scratch.string()));
+    RestoreEngine engine(settings.get("threads", 0).asUInt(), settings.get("background", true).asBool(), loadMonitor.get());
+    auto summary = engine.extract(archive, scratch.string(), filter, compare);
+    fs::remove_all(scratch, ec);
+
+    Json::Value report;
+    report["archive"] = archive;
+    report["started"] = std::format("{:%Y-%m-%dT%H:%M:%S}", std::chrono::floor<std::chrono::seconds>(started));
+    report["sample_percent"] = samplePercent;
+    report["success"] = summary.has_value() && summary->errors.empty() && mismatches.empty();
+    if (summary) {
+        const double seconds = summary->duration.count();
+        report["restored_files"] = static_cast<Json::UInt64>(summary->entries);
+        report["skipped_files"] = static_cast<Json::UInt64>(summary->skipped);
+        report["restored_bytes"] = static_cast<Json::UInt64>(summary->bytes);
+        report["frames"] = static_cast<Json::UInt64>(summary->frames);
+        report["duration_seconds"] = seconds;
+        report["mib_per_second"] = seconds > 0 ? static_cast<double>(summary->bytes) / (1024.0 * 1024.0) / seconds : 0.0;
+        report["matched"] = static_cast<Json::UInt64>(matched);
+        report["changed_since_backup"] = static_cast<Json::UInt64>(changed);
+        for (const auto& path : missing) {
+            report["missing_from_source"].append(path);
+        }
+        for (const auto& path : mismatches) {
+            report["mismatches"].append(path);
+        }
+        for (const auto& error : summary->errors) {
+            report["errors"].append(error);
+        }
+    } else {
+        report["error"] = summary.error();
+    }
+    fs::create_directories(config.reportFolder, ec);
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "  ";
+    const std::string json = Json::writeString(writer, report);
+    for (const auto& name : {std::format("restore-test-{}.json", stamp), std::string("restore-test-latest.json")}) {
+        auto writeResult = writeFileAtomically(config.reportFolder + name, json);
+        if (!writeResult) {
+            config.logError(std::format("Failed to write restore test report: {}", writeResult.error()));
+        }
+    }
+
+    if (!summary) {
+        auto errorMsg = std::format("Restore test failed for {}: {}", archive, summary.error());
+        config.logError(errorMsg);
+        if (notificationStrategy) {
+            notificationStrategy->notify(errorMsg);
+        }
+        return std::unexpected(errorMsg);
+    }
+    const double seconds = summary->duration.count();
+    config.logMessage(std::format("Restore test of {}: {} files ({:.1f} MiB) restored in {:.1f} s ({:.1f} MiB/s), {} matched, "
+                                  "{} changed since backup, {} no longer in source, {} mismatched, {} errors",
+                                  archive, summary->entries, static_cast<double>(summary->bytes) / (1024.0 * 1024.0), seconds,
+                                  seconds > 0 ? static_cast<double>(summary->bytes) / (1024.0 * 1024.0) / seconds : 0.0,
+                                  matched, changed, missing.size(), mismatches.size(), summary->errors.size()));
+    if (!mismatches.empty() || !summary->errors.empty()) {
+        auto errorMsg = std::format("Restore test failed for {}: {} mismatched file(s), {} restore error(s){}", archive,
+                                    mismatches.size(), summary->errors.size(),
+                                    summary->errors.empty() ? std::string() : std::format(" (first: {})", summary->errors.front()));
         config.logError(errorMsg);
-        archive_read_free(a);
+        if (notificationStrategy) {
+            notificationStrategy->notify(errorMsg);
+        }
         return std::unexpected(errorMsg);
     }
+    return {};
+}
+
+std::expected<void, std::string> Backup::synthesizeFull() {
+    const auto started = std::chrono::system_clock::now();
+    auto metrics = attachRunMetrics();
+    auto result = runSynthesizeFull(*metrics);
+    detachRunMetrics(metrics);
+    writeRunReport("synthetic", started, result, *metrics);
+    return result;
+}
 
-    struct archive_entry* entry;
-    bool success = true;
-    while (archive_read_next_header(a, &entry) == ARCHIVE_OK) {
-        archive_read_data_skip(a);
+std::expected<void, std::string> Backup::runSynthesizeFull(TransferMetrics& metrics) {
+    auto fail = [this](const std::string& errorMsg) {
+        config.logError(errorMsg);
+        if (notificationStrategy) {
+            notificationStrategy->notify(errorMsg);
+        }
+        return std::unexpected(errorMsg);
+    };
+    if (config.catalogFolder.empty()) {
+        return fail("Synthetic full backups need the backup catalog (catalog.enabled)");
+    }
+    // The new full has to describe the latest state, so no file backup may commit meanwhile.
+    std::unique_lock<std::mutex> archiveLock(archiveMutex_);
+    Catalog catalog(config.catalogFolder);
+    auto runs = catalog.runs();
+    if (!runs) {
+        return fail(std::format("Synthetic full backup failed: {}", runs.error()));
+    }
+    if (runs->empty()) {
+        return fail("Synthetic full backup failed: the catalog has no runs");
+    }
+    const CatalogRun latest = runs->back();
+    // Runs without a file archive (database-only) only carry the state of the run before them.
+    const bool onlyFull = latest.storedFiles == 0 && latest.dependsOn.size() == 1 &&
+                          std::ranges::any_of(*runs, [&latest](const CatalogRun& run) {
+                              return run.sequence == latest.dependsOn.front() && run.full;
+                          });
+    if (latest.full || onlyFull) {
+        config.logMessage(std::format("Synthetic full backup skipped: run {} is already a full backup", latest.sequence));
+        return {};
+    }
+    auto state = catalog.snapshot(latest.sequence);
+    if (!state) {
+        return fail(std::format("Synthetic full backup failed: {}", state.error()));
+    }
+    std::map<uint32_t, std::string> archives;
+    for (const auto& run : *runs) {
+        for (const auto& artifact : run.artifacts) {
+            if (artifact.artifactClass == "sys") {
+                archives[run.sequence] = artifact.path;
+            }
+        }
     }
 
-    archive_read_close(a);
-    archive_read_free(a);
-    return success;
+    const auto now = std::chrono::system_clock::now();
+    const auto timeT = std::chrono::system_clock::to_time_t(now);
+    char timestampBuf[32];
+    std::strftime(timestampBuf, sizeof(timestampBuf), "%Y%m%d-%H%M%S", std::localtime(&timeT));
+    const std::string targetPath = config.sysBackupFolder + std::format("sys-synthetic-{}.tar.gz", timestampBuf);
+    // Copied frames keep their size; this only sizes the frames of recompressed entries.
+    const uint64_t frameSize = config.archiveFrameSize > 0 ? config.archiveFrameSize : 64ull * 1024 * 1024;
+
+    // Assembling reads and writes whole archives; keep it out of the way of other I/O.
+    std::expected<SynthesisSummary, std::string> synthesis = std::unexpected(std::string());
+    std::thread worker([&] {
+        enterBackgroundPriority();
+        synthesis = synthesizeFullArchive(*state, archives, targetPath, frameSize);
+    });
+    worker.join();
+    if (!synthesis) {
+        return fail(std::format("Synthetic full backup failed: {}", synthesis.error()));
+    }
+
+    auto verification = ArtifactVerifier::verify(targetPath, "sys");
+    if (!verification.result) {
+        return fail(std::format("Synthetic full backup verification failed: {}", verification.result.error()));
+    }
+    auto indexResult = writeArchiveIndex(targetPath, synthesis->entries);
+    if (!indexResult) {
+        return fail(std::format("Synthetic full backup failed: {}", indexResult.error()));
+    }
+    try {
+        changeOwnership(targetPath, config.username, config.username);
+    } catch (const std::exception& e) {
+        return fail(std::format("Failed to change ownership: {}", e.what()));
+    }
+
+    CatalogRun run;
+    run.name = timestampBuf;
+    run.type = "synthetic";
+    run.started = static_cast<int64_t>(timeT);
+    run.full = true;
+    std::error_code sizeEc;
+    run.artifacts.push_back({targetPath, "sys", static_cast<uint64_t>(fs::file_size(targetPath, sizeEc))});
+    std::ranges::sort(synthesis->entries, {}, &ManifestEntry::sourcePath);
+    std::unique_lock<std::mutex> catalogLock(catalogMutex_);
+    auto committed = catalog.commitRun(std::move(run), synthesis->entries);
+    catalogLock.unlock();
+    // Once cataloged, file backups may build on the new full; the upload and retention below
+    // must not hold them up.
+    archiveLock.unlock();
+    if (!committed) {
+        return fail(std::format("Failed to update the backup catalog: {}", committed.error()));
+    }
+    config.logMessage(std::format("Synthetic full backup {} from runs up to {}: {} files, {} frames copied ({:.1f} MiB), "
+                                  "{} rewritten ({:.1f} MiB recompressed), {} skipped",
+                                  targetPath, latest.sequence, synthesis->entries.size(), synthesis->framesCopied,
+                                  static_cast<double>(synthesis->bytesCopied) / (1024.0 * 1024.0), synthesis->framesRewritten,
+                                  static_cast<double>(synthesis->bytesRewritten) / (1024.0 * 1024.0), synthesis->framesSkipped));
+
+    if (transferStrategy) {
+        // Same path as run artifacts: class priority, transfer window and per-artifact metrics.
+        TransferScheduler scheduler(*transferStrategy, config.transferConfig, nullptr, &metrics);
+        scheduler.submit(targetPath, "sys", "sys");
+        for (const auto& miss : scheduler.forecastMisses()) {
+            auto warningMsg = std::format("Transfer window warning: {}", miss);
+            config.logError(warningMsg);
+            if (notificationStrategy) {
+                notificationStrategy->notify(warningMsg);
+            }
+        }
+        for (const auto& outcome : scheduler.finish()) {
+            if (!outcome.result) {
+                return fail(std::format("File transfer failed: {}", outcome.result.error()));
+            }
+            const double seconds = std::chrono::duration<double>(outcome.elapsed).count();
+            const double mebibytes = static_cast<double>(outcome.job.size) / (1024.0 * 1024.0);
+            config.logMessage(std::format("Transferred {} ({:.1f} MiB in {:.1f} s, {:.1f} MiB/s)", outcome.job.file, mebibytes, seconds,
+                                          seconds > 0 ? mebibytes / seconds : 0.0));
+            if (outcome.missedWindow) {
+                config.logError(std::format("Transfer of {} finished after the transfer window", outcome.job.file));
+            }
+        }
+    }
+    auto cleanupResult = cleanupOldBackups();
+    if (!cleanupResult) {
+        auto errorMsg = std::format("Cleanup failed: {}", cleanupResult.error());
+        config.logError(errorMsg);
+        if (notificationStrategy) {
+            notificationStrategy->notify(errorMsg);
+        }
+    }
+    if (notificationStrategy) {
+        notificationStrategy->notify(std::format("Synthetic full backup completed: {}", targetPath));
+    }
+    return {};
+}
+
+std::expected<void, std::string> Backup::restore(const std::string& targetDir, uint32_t run, const std::string& prefix) {
+    if (config.catalogFolder.empty()) {
+        return std::unexpected("Point-in-time restores need the backup catalog (catalog.enabled)");
+    }
+    Catalog catalog(config.catalogFolder);
+    auto plan = planRestore(catalog, run, prefix);
+    if (!plan) {
+        return std::unexpected(std::format("Restore failed: {}", plan.error()));
+    }
+    config.logMessage(std::format("Restoring run {} into {}: {} files ({:.1f} MiB) from {} archive(s), {} frame(s)", plan->run, targetDir,
+                                  plan->files, static_cast<double>(plan->bytes) / (1024.0 * 1024.0), plan->archives.size(),
+                                  plan->frames));
+
+    std::mutex mutex;
+    std::vector<std::string> mismatches;
+    auto check = [&](const RestoredEntry& restored) {
+        auto expected = plan->expectedSha256.find(restored.archivePath);
+        if (expected != plan->expectedSha256.end() && !expected->second.empty() && expected->second != restored.sha256) {
+            std::lock_guard<std::mutex> lock(mutex);
+            mismatches.push_back(restored.archivePath);
+        }
+    };
+    RestoreEngine engine;
+    auto summary = engine.extract(plan->archives, targetDir, check);
+    if (!summary) {
+        return std::unexpected(std::format("Restore failed: {}", summary.error()));
+    }
+    for (const auto& error : summary->errors) {
+        config.logError(std::format("Restore: {}", error));
+    }
+    for (const auto& path : mismatches) {
+        config.logError(std::format("Restore: content of {} differs from the catalog", path));
+    }
+    const double seconds = summary->duration.count();
+    config.logMessage(std::format("Restored run {}: {} of {} files ({:.1f} MiB) in {:.1f} s ({:.1f} MiB/s), {} frame(s) read, "
+                                  "{} entries skipped",
+                                  plan->run, summary->entries, plan->files, static_cast<double>(summary->bytes) / (1024.0 * 1024.0),
+                                  seconds, seconds > 0 ? static_cast<double>(summary->bytes) / (1024.0 * 1024.0) / seconds : 0.0, summary->frames,
+                                  summary->skipped));
+    if (!summary->errors.empty() || !mismatches.empty() || summary->entries != plan->files) {
+        return std::unexpected(std::format("Restore of run {} incomplete: {} of {} files restored, {} mismatched, {} error(s)", plan->run,
+                                           summary->entries, plan->files, mismatches.size(), summary->errors.size()));
+    }
+    return {};
 }
 
 std::chrono::system_clock::time_point Backup::getNextBackupTime() const {
+    return nextRunTime(config.scheduleType, config.scheduleTime, config.scheduleDayOfWeek, config.scheduleDayOfMonth);
+}
+
+std::chrono::system_clock::time_point Backup::nextRunTime(const std::string& scheduleType, const std::string& scheduleTime,
+                                                          const std::string& scheduleDayOfWeek, int scheduleDayOfMonth) const {
     auto now = std::chrono::system_clock::now();
     auto nowT = std::chrono::system_clock::to_time_t(now);
     std::tm tmNow = *std::localtime(&nowT);
 
     int hour, minute, second;
-    std::istringstream ss(config.scheduleTime);
+    std::istringstream ss(scheduleTime);
     char colon;
     ss >> hour >> colon >> minute >> colon >> second;
     if (ss.fail() || hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 59) {
-        config.logError(std::format("Invalid schedule time format: {}", config.scheduleTime));
-        throw std::runtime_error(std::format("Invalid schedule time format: {}", config.scheduleTime));
+        config.logError(std::format("Invalid schedule time format: {}", scheduleTime));
+        throw std::runtime_error(std::format("Invalid schedule time format: {}", scheduleTime));
     }
 
     std::tm tmNext = tmNow;
@@ -261,25 +1070,21 @@ std::chrono::system_clock::time_point Backup::getNextBackupTime() const {
     tmNext.tm_isdst = -1;
 
     auto nextTime = std::chrono::system_clock::from_time_t(std::mktime(&tmNext));
-    config.logMessage(std::format("Debug: Initial next backup time: {}-{:02d}-{:02d} {:02d}:{:02d}:{:02d}",
-                                  tmNext.tm_year + 1900, tmNext.tm_mon + 1, tmNext.tm_mday, tmNext.tm_hour, tmNext.tm_min, tmNext.tm_sec));
 
-    if (config.scheduleType == "daily") {
+    if (scheduleType == "daily") {
         if (nextTime <= now) {
             tmNext.tm_mday += 1;
             nextTime = std::chrono::system_clock::from_time_t(std::mktime(&tmNext));
-            config.logMessage(std::format("Debug: Adjusted to next day: {}-{:02d}-{:02d} {:02d}:{:02d}:{:02d}",
-                                          tmNext.tm_year + 1900, tmNext.tm_mon + 1, tmNext.tm_mday, tmNext.tm_hour, tmNext.tm_min, tmNext.tm_sec));
         }
-    } else if (config.scheduleType == "weekly") {
+    } else if (scheduleType == "weekly") {
         std::map<std::string, int> dayMap = {
             {"monday", 1}, {"tuesday", 2}, {"wednesday", 3}, {"thursday", 4},
             {"friday", 5}, {"saturday", 6}, {"sunday", 0}
         };
-        auto it = dayMap.find(config.scheduleDayOfWeek);
+        auto it = dayMap.find(scheduleDayOfWeek);
         if (it == dayMap.end()) {
-            config.logError(std::format("Invalid day of week: {}", config.scheduleDayOfWeek));
-            throw std::runtime_error(std::format("Invalid day of week: {}", config.scheduleDayOfWeek));
+            config.logError(std::format("Invalid day of week: {}", scheduleDayOfWeek));
+            throw std::runtime_error(std::format("Invalid day of week: {}", scheduleDayOfWeek));
         }
         int targetDay = it->second;
         int currentDay = tmNow.tm_wday;
@@ -289,10 +1094,8 @@ std::chrono::system_clock::time_point Backup::getNextBackupTime() const {
         }
         tmNext.tm_mday += daysToAdd;
         nextTime = std::chrono::system_clock::from_time_t(std::mktime(&tmNext));
-        config.logMessage(std::format("Debug: Adjusted to next week: {}-{:02d}-{:02d} {:02d}:{:02d}:{:02d}",
-                                      tmNext.tm_year + 1900, tmNext.tm_mon + 1, tmNext.tm_mday, tmNext.tm_hour, tmNext.tm_min, tmNext.tm_sec));
-    } else if (config.scheduleType == "monthly") {
-        int targetDay = config.scheduleDayOfMonth;
+    } else if (scheduleType == "monthly") {
+        int targetDay = scheduleDayOfMonth;
         if (targetDay < 1 || targetDay > 31) {
             config.logError(std::format("Invalid day of month: {}", targetDay));
             throw std::runtime_error(std::format("Invalid day of month: {}", targetDay));
@@ -306,17 +1109,93 @@ std::chrono::system_clock::time_point Backup::getNextBackupTime() const {
             }
             tmNext.tm_mday = targetDay;
             nextTime = std::chrono::system_clock::from_time_t(std::mktime(&tmNext));
-            config.logMessage(std::format("Debug: Adjusted to next month: {}-{:02d}-{:02d} {:02d}:{:02d}:{:02d}",
-                                          tmNext.tm_year + 1900, tmNext.tm_mon + 1, tmNext.tm_mday, tmNext.tm_hour, tmNext.tm_min, tmNext.tm_sec));
         }
     } else {
-        config.logError(std::format("Invalid schedule type: {}", config.scheduleType));
-        throw std::runtime_error(std::format("Invalid schedule type: {}", config.scheduleType));
+        config.logError(std::format("Invalid schedule type: {}", scheduleType));
+        throw std::runtime_error(std::format("Invalid schedule type: {}", scheduleType));
     }
 
     return nextTime;
 }
 
+std::expected<std::vector<ScheduledJob>, std::string> Backup::scheduledJobs(const BackupConfig& source) {
+    Json::Value definitions = source.schedulerConfig["jobs"];
+    if (!definitions.isArray() || definitions.empty()) {
+        // Without jobs, the "schedule" section and the restore test's schedule are the jobs.
+        definitions = Json::Value(Json::arrayValue);
+        auto cron = legacyCron(source.scheduleType, source.scheduleTime, source.scheduleDayOfWeek, source.scheduleDayOfMonth);
+        if (!cron) {
+            return std::unexpected(cron.error());
+        }
+        Json::Value backupJob;
+        backupJob["name"] = "backup";
+        backupJob["cron"] = *cron;
+        backupJob["type"] = source.scheduleType;
+        backupJob["level"] = source.scheduleLevel;
+        definitions.append(backupJob);
+        const Json::Value& restoreSchedule = source.restoreTestConfig["schedule"];
+        if (restoreSchedule.isObject()) {
+            auto restoreCron = legacyCron(restoreSchedule.get("type", "weekly").asString(), restoreSchedule.get("time", "04:00:00").asString(),
+                                          restoreSchedule.get("day_of_week", "sunday").asString(),
+                                          restoreSchedule.get("day_of_month", 1).asInt());
+            if (!restoreCron) {
+                return std::unexpected(restoreCron.error());
+            }
+            Json::Value restoreJob;
+            restoreJob["name"] = "restore-test";
+            restoreJob["cron"] = *restoreCron;
+            restoreJob["action"] = "restore-test";
+            definitions.append(restoreJob);
+        }
+    }
+
+    std::vector<ScheduledJob> jobs;
+    for (const auto& definition : definitions) {
+        auto job = ScheduledJob::fromJson(definition);
+        if (!job) {
+            return std::unexpected(job.error());
+        }
+        const std::string action = definition.get("action", "backup").asString();
+        if (action == "backup") {
+            const std::string type = definition.get("type", "daily").asString();
+            const bool fullBackup = definition.get("full", false).asBool();
+            const int level = definition.get("level", FileBackupStrategy::kSinceLastRun).asInt();
+            BackupTargets targets;
+            if (definition["targets"].isArray()) {
+                targets.files = false;
+                targets.databases = false;
+                for (const auto& target : definition["targets"]) {
+                    if (target.asString() == "files") {
+                        targets.files = true;
+                    } else if (target.asString() == "databases") {
+                        targets.databases = true;
+                    } else {
+                        return std::unexpected(std::format("Job {}: unknown target '{}' (use files or databases)", job->name,
+                                                           target.asString()));
+                    }
+                }
+            }
+            job->run = [this, type, fullBackup, level, targets]() {
+                auto result = execute(type, fullBackup, level, targets);
+                if (!result && notificationStrategy) {
+                    notificationStrategy->notify(result.error());
+                }
+                return result;
+            };
+        } else if (action == "restore-test") {
+            const std::string archive = definition.get("archive", "").asString();
+            job->run = [this, archive]() { return runRestoreTest(archive); };
+        } else if (action == "synthesize-full") {
+            job->run = [this]() { return synthesizeFull(); };
+        } else {
+            return std::unexpected(std::format("Job {}: unknown action '{}' (use backup, restore-test or synthesize-full)", job->name,
+                                               action));
+        }
+        jobs.push_back(std::move(*job));
+    }
+    return jobs;
+}
+
 void Backup::runDaemon() {
     fs::path logPath(config.logFile);
     fs::create_directories(logPath.parent_path());
@@ -342,62 +1221,392 @@ void Backup::runDaemon() {
 
     std::cout << "Daemon mode started. Check " << config.logFile << " for logs." << std::endl;
 
-    while (!gShutdownFlag) {
-        try {
-            auto nextBackup = getNextBackupTime();
-            auto now = std::chrono::system_clock::now();
-            auto sleepDuration = std::chrono::duration_cast<std::chrono::seconds>(nextBackup - now);
-
-            std::stringstream ss;
-            auto nextT = std::chrono::system_clock::to_time_t(nextBackup);
-            ss << std::put_time(std::localtime(&nextT), "%Y-%m-%d %H:%M:%S");
-
-            auto nowT = std::chrono::system_clock::to_time_t(now);
-            std::stringstream ssNow;
-            ssNow << std::put_time(std::localtime(&nowT), "%Y-%m-%d %H:%M:%S");
-
-            config.logMessage(std::format("Debug: Current time: {}", ssNow.str()));
-            config.logMessage(std::format("Debug: Calculated next backup at {}", ss.str()));
-            config.logMessage(std::format("Debug: Sleep duration: {} seconds", sleepDuration.count()));
-
-            if (sleepDuration.count() > 0 && !gShutdownFlag) {
-                config.logMessage(std::format("Next backup scheduled at {}", ss.str()));
-                auto remaining = sleepDuration.count();
-                while (remaining > 0 && !gShutdownFlag) {
-                    auto sleepFor = std::min(remaining, static_cast<std::chrono::seconds::rep>(1));
-                    std::this_thread::sleep_for(std::chrono::seconds(sleepFor));
-                    remaining -= sleepFor;
-                }
-            } else if (!gShutdownFlag) {
-                config.logMessage("Debug: Sleep duration is zero or negative, proceeding to backup immediately");
-                auto result = execute(config.scheduleType);
-                if (!result) {
-                    config.logError(std::format("Backup failed: {}", result.error()));
-                    if (notificationStrategy) {
-                        notificationStrategy->notify(result.error());
-                    }
-                } else {
-                    config.logMessage("Backup completed successfully");
-                }
-            } else {
-                break;
+    auto jobs = scheduledJobs(config);
+    if (!jobs) {
+        config.logError(std::format("Daemon error: {}", jobs.error()));
+        std::cerr << "Daemon error: " << jobs.error() << std::endl;
+        return;
+    }
+    JobScheduler scheduler(config.schedulerConfig, config.stateFolder + "scheduler.json",
+                           [this](const std::string& message) { config.logMessage(message); },
+                           [this](const std::string& message) {
+                               config.logError(message);
+                               if (notificationStrategy) {
+                                   notificationStrategy->notify(message);
+                               }
+                           });
+    scheduler.setLoadMonitor(loadMonitor.get());
+    for (auto& job : *jobs) {
+        auto added = scheduler.addJob(std::move(job));
+        if (!added) {
+            config.logError(std::format("Daemon error: {}", added.error()));
+            std::cerr << "Daemon error: " << added.error() << std::endl;
+            return;
+        }
+    }
+    startChangeJournal();
+
+    // Configuration changes are applied between jobs, so a run never sees half of them.
+    ConfigWatcher watcher(configFile_, [this, &scheduler]() { scheduler.whenIdle([this, &scheduler]() { reloadConfig(scheduler); }); });
+    auto watching = watcher.start();
+    if (watching) {
+        config.logMessage(std::format("Watching {} for configuration changes", configFile_));
+    } else {
+        config.logError(std::format("Configuration changes need a daemon restart: {}", watching.error()));
+    }
+
+    scheduler.run(gShutdownFlag);
+    watcher.stop();
+    fileStrategy->attachChangeJournal(nullptr);
+    changeJournal.reset();
+    config.logMessage("Daemon shutting down gracefully");
+}
+
+void Backup::startChangeJournal() {
+    fileStrategy->attachChangeJournal(nullptr);
+    changeJournal.reset();
+    if (!config.journalConfig.isObject()) {
+        return;
+    }
+    // Incremental runs read the journal instead of walking the backup directories.
+    changeJournal = std::make_unique<ChangeJournal>(
+        config.journalConfig, [this](const std::string& message) { logBackgroundMessage(message); },
+        [this](const std::string& message) { logBackgroundError(message); });
+    auto started = changeJournal->start(config.backupDirs);
+    if (started) {
+        fileStrategy->attachChangeJournal(changeJournal.get());
+    } else {
+        config.logError(std::format("Change journal unavailable, incremental runs walk the backup directories: {}", started.error()));
+        changeJournal.reset();
+    }
+}
+
+void Backup::reloadConfig(JobScheduler& scheduler) {
+    std::optional<BackupConfig> loaded;
+    try {
+        loaded.emplace(configFile_);
+    } catch (const std::exception& e) {
+        config.logError(std::format("Configuration reload failed, keeping the running configuration: {}", e.what()));
+        return;
+    }
+    auto valid = validateConfig(*loaded);
+    if (!valid) {
+        config.logError(std::format("Configuration reload failed, keeping the running configuration: {}", valid.error()));
+        return;
+    }
+
+    std::set<std::string> sections;
+    for (const auto* json : {&config.json, &loaded->json}) {
+        for (const auto& name : json->getMemberNames()) {
+            if (config.json[name] != loaded->json[name]) {
+                sections.insert(name);
             }
-        } catch (const std::exception& e) {
-            config.logError(std::format("Daemon error: {}", e.what()));
-            std::cerr << "Daemon error: " << e.what() << std::endl;
-            std::this_thread::sleep_for(std::chrono::seconds(60));
-            if (gShutdownFlag) {
-                break;
+        }
+    }
+    if (sections.empty()) {
+        return;
+    }
+    auto changed = [&sections](std::initializer_list<const char*> names) {
+        return std::ranges::any_of(names, [&sections](const char* name) { return sections.contains(name); });
+    };
+
+    // Everything that can fail is prepared before anything is replaced.
+    std::unique_ptr<TransferStrategy> transfer;
+    std::unique_ptr<NotificationStrategy> notification;
+    try {
+        if (changed({"sftp", "destinations", "transfer", "backup_base"})) {
+            transfer = makeTransferStrategy(*loaded);
+        }
+        if (changed({"telegram", "email"})) {
+            notification = makeNotificationStrategy(*loaded);
+        }
+    } catch (const std::exception& e) {
+        config.logError(std::format("Configuration reload failed, keeping the running configuration: {}", e.what()));
+        return;
+    }
+    if (changed({"scheduler", "schedule", "restore_test"})) {
+        auto jobs = scheduledJobs(*loaded);
+        auto reconfigured = jobs ? scheduler.reconfigure(loaded->schedulerConfig, std::move(*jobs))
+                                 : std::expected<void, std::string>(std::unexpected(jobs.error()));
+        if (!reconfigured) {
+            config.logError(std::format("Configuration reload failed, keeping the running configuration: {}", reconfigured.error()));
+            return;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(configMutex_);
+        config = std::move(*loaded);
+    }
+    std::vector<std::string> rebuilt;
+    if (changed({"sftp", "destinations", "transfer", "backup_base"})) {
+        transferStrategy = std::move(transfer);
+        rebuilt.push_back("transfers");
+    }
+    if (changed({"telegram", "email"})) {
+        notificationStrategy = std::move(notification);
+        rebuilt.push_back("notifications");
+    }
+    if (changed({"load", "backup_base"})) {
+        loadMonitor.reset();
+        if (config.loadConfig.isObject()) {
+            loadMonitor = std::make_unique<LoadMonitor>(config.loadConfig, [this](const std::string& message) {
+                logBackgroundMessage(message);
+            });
+        }
+        scheduler.setLoadMonitor(loadMonitor.get());
+        fileStrategy->attachLoadMonitor(loadMonitor.get());
+        rebuilt.push_back("load monitor");
+    }
+    if (changed({"exclude_extensions", "archive", "backup_base"})) {
+        buildFileStrategy();
+        rebuilt.push_back("file backup");
+    }
+    if (changed({"trash", "backup_base"})) {
+        trash = std::make_unique<TrashCollector>(config.backupBase + "trash/", config.trashConfig, [this](const std::string& message) {
+            logBackgroundError(message);
+        });
+        rebuilt.push_back("trash");
+    }
+    if (changed({"journal", "backup_dirs", "backup_base"})) {
+        // A journal of other directories says nothing about the new ones.
+        startChangeJournal();
+        rebuilt.push_back("change journal");
+    }
+    if (changed({"scheduler", "schedule", "restore_test"})) {
+        rebuilt.push_back("jobs");
+    }
+
+    auto join = [](const auto& names) {
+        std::string text;
+        for (const auto& name : names) {
+            text += (text.empty() ? "" : ", ") + std::string(name);
+        }
+        return text;
+    };
+    config.logMessage(std::format("Configuration reloaded; changed: {}; rebuilt: {}", join(sections),
+                                  rebuilt.empty() ? std::string("nothing (read at the next run)") : join(rebuilt)));
+}
+
+namespace {
+
+std::string formatEpoch(int64_t seconds) {
+    const auto timeT = static_cast<std::time_t>(seconds);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", std::localtime(&timeT));
+    return buffer;
+}
+
+/**
+ * @brief Answers a catalog query ("runs", "find", "versions", "ls") on standard output.
+ *
+ * @return int Process exit code.
+ */
+int runCatalogCommand(const std::string& configFile, const std::vector<std::string>& args, uint32_t run) {
+    const std::string usage = "Usage: catalog {runs | find <glob> | versions <path> | ls <dir> [--run <n>]}";
+    BackupConfig config(configFile);
+    if (config.catalogFolder.empty()) {
+        std::cerr << "Error: The catalog is disabled in " << configFile << std::endl;
+        return 1;
+    }
+    if (args.empty() || (args[0] != "runs" && args.size() < 2)) {
+        std::cerr << usage << std::endl;
+        return 1;
+    }
+    Catalog catalog(config.catalogFolder);
+    auto listed = catalog.runs();
+    if (!listed) {
+        std::cerr << "Error: " << listed.error() << std::endl;
+        return 1;
+    }
+    auto runName = [&listed](uint32_t sequence) {
+        auto it = std::ranges::find(*listed, sequence, &CatalogRun::sequence);
+        return it == listed->end() ? std::string("?") : it->name;
+    };
+
+    const std::string& command = args[0];
+    if (command == "runs") {
+        for (const auto& entry : *listed) {
+            const std::string kind = entry.level >= 0 ? std::format("level {}", entry.level) : entry.full ? "full" : "incremental";
+            std::println("{:>6}  {}  {:<8} {:<11} {:>9} files  {:>9} stored  {:>10.1f} MiB", entry.sequence, entry.name, entry.type,
+                         kind, entry.files, entry.storedFiles,
+                         static_cast<double>(entry.storedBytes) / (1024.0 * 1024.0));
+        }
+    } else if (command == "find") {
+        auto matches = catalog.find(args[1]);
+        if (!matches) {
+            std::cerr << "Error: " << matches.error() << std::endl;
+            return 1;
+        }
+        for (const auto& path : *matches) {
+            std::println("{}", path);
+        }
+    } else if (command == "versions") {
+        auto versions = catalog.versions(args[1]);
+        if (!versions) {
+            std::cerr << "Error: " << versions.error() << std::endl;
+            return 1;
+        }
+        for (const auto& version : *versions) {
+            std::println("run {:>6} ({})  {:>12} bytes  modified {}  sha256 {}", version.run, runName(version.run), version.size,
+                         formatEpoch(version.mtime), version.sha256.empty() ? "unknown" : version.sha256);
+        }
+    } else if (command == "ls") {
+        std::string prefix = args[1];
+        if (!prefix.ends_with('/')) {
+            prefix += '/';
+        }
+        auto files = catalog.snapshot(run, prefix);
+        if (!files) {
+            std::cerr << "Error: " << files.error() << std::endl;
+            return 1;
+        }
+        // Entries below subdirectories collapse into one line per subdirectory.
+        std::string lastDirectory;
+        for (const auto& file : *files) {
+            const std::string rest = file.sourcePath.substr(prefix.size());
+            const size_t slash = rest.find('/');
+            if (slash != std::string::npos) {
+                const std::string directory = rest.substr(0, slash + 1);
+                if (directory != lastDirectory) {
+                    std::println("{:>12}  {:<19}  {}", "-", "", directory);
+                    lastDirectory = directory;
+                }
+                continue;
             }
+            std::println("{:>12}  {}  {}", file.size, formatEpoch(file.mtime), rest);
         }
+    } else {
+        std::cerr << usage << std::endl;
+        return 1;
     }
-    config.logMessage("Daemon shutting down gracefully");
+    return 0;
 }
 
+/**
+ * @brief Lists the entries of an archive matching a glob on standard output.
+ *
+ * @return int Process exit code.
+ */
+int runListCommand(const std::vector<std::string>& args) {
+    if (args.empty()) {
+        std::cerr << "Usage: list <archive> [<glob>]" << std::endl;
+        return 1;
+    }
+    std::string pattern = args.size() > 1 ? args[1] : "*";
+    if (pattern.ends_with('/')) {
+        pattern += '*';
+    }
+    auto entries = BackupAPI::listArchive(args[0], pattern);
+    if (!entries) {
+        std::cerr << "Error: " << entries.error() << std::endl;
+        return 1;
+    }
+    for (const auto& entry : *entries) {
+        std::println("{:>12}  {}  {}", entry.size, formatEpoch(entry.mtime), entry.path);
+    }
+    return 0;
+}
+
+/**
+ * @brief Downloads an artifact from the configured destinations, reassembling repository snapshots.
+ *
+ * @return int Process exit code.
+ */
+int runFetchCommand(const std::string& configFile, const std::vector<std::string>& args) {
+    if (args.size() < 2) {
+        std::cerr << "Usage: fetch <sys|db>/<artifact> <local-file>" << std::endl;
+        return 1;
+    }
+    BackupConfig config(configFile);
+    auto strategy = makeTransferStrategy(config);
+    if (!strategy) {
+        std::cerr << "Error: No destination is configured in " << configFile << std::endl;
+        return 1;
+    }
+    auto result = strategy->fetch(args[0], args[1]);
+    if (!result) {
+        std::cerr << "Error: " << result.error() << std::endl;
+        return 1;
+    }
+    std::cout << "Fetched " << args[0] << " to " << args[1] << std::endl;
+    return 0;
+}
+
+/**
+ * @brief Parses a local time given as "YYYY-mm-dd HH:MM[:SS]" (or with a "T" separator).
+ *
+ * @return std::expected<int64_t, std::string> Seconds since the epoch or an error message.
+ */
+std::expected<int64_t, std::string> parseLocalTime(std::string text) {
+    std::ranges::replace(text, 'T', ' ');
+    std::tm tm{};
+    for (const char* format : {"%Y-%m-%d %H:%M:%S", "%Y-%m-%d %H:%M", "%Y-%m-%d"}) {
+        std::istringstream in(text);
+        tm = {};
+        in >> std::get_time(&tm, format);
+        if (!in.fail() && in.peek() == std::char_traits<char>::eof()) {
+            tm.tm_isdst = -1;
+            return static_cast<int64_t>(std::mktime(&tm));
+        }
+    }
+    return std::unexpected(std::format("Invalid time: {} (expected YYYY-mm-dd HH:MM[:SS])", text));
+}
+
+/**
+ * @brief Restores a catalog run, chosen by number or point in time, into a directory.
+ *
+ * @return int Process exit code.
+ */
+int runRestoreCommand(const std::string& configFile, const std::vector<std::string>& args, uint32_t run, const std::string& at) {
+    if (args.empty()) {
+        std::cerr << "Usage: restore <target-dir> [<path-prefix>] [--run <n> | --at <YYYY-mm-dd HH:MM[:SS]>]" << std::endl;
+        return 1;
+    }
+    if (!at.empty()) {
+        auto time = parseLocalTime(at);
+        if (!time) {
+            std::cerr << "Error: " << time.error() << std::endl;
+            return 1;
+        }
+        BackupConfig config(configFile);
+        if (config.catalogFolder.empty()) {
+            std::cerr << "Error: The catalog is disabled in " << configFile << std::endl;
+            return 1;
+        }
+        auto runs = Catalog(config.catalogFolder).runs();
+        if (!runs) {
+            std::cerr << "Error: " << runs.error() << std::endl;
+            return 1;
+        }
+        auto found = runAt(*runs, *time);
+        if (!found) {
+            std::cerr << "Error: " << found.error() << std::endl;
+            return 1;
+        }
+        run = *found;
+    }
+    Backup backup(configFile);
+    auto result = backup.restore(args[0], run, args.size() > 1 ? args[1] : "");
+    if (!result) {
+        std::cerr << "Error: " << result.error() << std::endl;
+        return 1;
+    }
+    std::cout << "Restore completed successfully." << std::endl;
+    return 0;
+}
+
+} // namespace
+
 int main(int argc, char* argv[]) {
     bool daemonMode = false;
     bool fullBackup = false;
     std::string backupType;
+    std::string archivePath;
+    std::vector<std::string> arguments;
+    uint32_t catalogRun = 0;
+    std::string restoreAt;
+    int level = FileBackupStrategy::kSinceLastRun;
     std::string configFile = "backup_config.json";
 
     for (int i = 1; i < argc; ++i) {
@@ -408,8 +1617,59 @@ int main(int argc, char* argv[]) {
             fullBackup = true;
         } else if (arg == "--config" && i + 1 < argc) {
             configFile = argv[++i];
-        } else {
+        } else if (arg == "--archive" && i + 1 < argc) {
+            archivePath = argv[++i];
+        } else if (arg == "--level" && i + 1 < argc) {
+            const std::string_view value = argv[++i];
+            const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), level);
+            if (ec != std::errc() || end != value.data() + value.size() || level < 0 || level > 9) {
+                std::cerr << "Error: --level expects a dump level from 0 to 9, got '" << value << "'" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--at" && i + 1 < argc) {
+            restoreAt = argv[++i];
+        } else if (arg == "--run" && i + 1 < argc) {
+            catalogRun = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (backupType.empty()) {
             backupType = arg;
+        } else {
+            arguments.push_back(arg);
+        }
+    }
+
+    if (backupType == "catalog") {
+        try {
+            return runCatalogCommand(configFile, arguments, catalogRun);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (backupType == "list") {
+        try {
+            return runListCommand(arguments);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (backupType == "fetch") {
+        try {
+            return runFetchCommand(configFile, arguments);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (backupType == "restore") {
+        try {
+            return runRestoreCommand(configFile, arguments, catalogRun, restoreAt);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
         }
     }
 
@@ -424,12 +1684,52 @@ int main(int argc, char* argv[]) {
     }
 
     if (backupType.empty()) {
-        std::cerr << "Usage: " << argv[0] << " [--daemon] [--full] [--config <path>] {daily|monthly|yearly}" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " [--daemon] [--full | --level <0-9>] [--config <path>] {hourly|daily|weekly|monthly|yearly}" << std::endl;
+        std::cerr << "       " << argv[0] << " [--config <path>] restore-test [--archive <file>]" << std::endl;
+        std::cerr << "       " << argv[0] << " [--config <path>] synthesize-full" << std::endl;
+        std::cerr << "       " << argv[0] << " [--config <path>] catalog {runs | find <glob> | versions <path> | ls <dir> [--run <n>]}"
+                  << std::endl;
+        std::cerr << "       " << argv[0] << " [--config <path>] restore <target-dir> [<path-prefix>] [--run <n> | --at <time>]"
+                  << std::endl;
+        std::cerr << "       " << argv[0] << " list <archive> [<glob>]" << std::endl;
+        std::cerr << "       " << argv[0] << " [--config <path>] fetch <sys|db>/<artifact> <local-file>" << std::endl;
         return 1;
     }
 
+    if (backupType == "synthesize-full" && !daemonMode) {
+        try {
+            Backup backup(configFile);
+            auto result = backup.synthesizeFull();
+            if (!result) {
+                std::cerr << "Error: " << result.error() << std::endl;
+                return 1;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << "Synthetic full backup completed successfully." << std::endl;
+        return 0;
+    }
+
+    if (backupType == "restore-test" && !daemonMode) {
+        try {
+            Backup backup(configFile);
+            auto result = backup.runRestoreTest(archivePath);
+            if (!result) {
+                std::cerr << "Error: " << result.error() << std::endl;
+                return 1;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << "Restore test completed successfully." << std::endl;
+        return 0;
+    }
+
     if (!daemonMode) {
-        auto result = BackupAPI::startBackup(backupType, fullBackup);
+        auto result = BackupAPI::startBackup(backupType, fullBackup, level);
         if (!result) {
             std::cerr << "Error: " << result.error() << std::endl;
             return 1;
@@ -1,11 +1,17 @@
 #include "backup_api.hpp"
 #include "backup.hpp"
+#include "sorted_table.hpp"
+#include "file_util.hpp"
+#include <algorithm>
+#include <archive.h>
+#include <archive_entry.h>
+#include <filesystem>
 #include <fstream>
 
-std::expected<void, std::string> BackupAPI::startBackup(const std::string& type, bool fullBackup) {
+std::expected<void, std::string> BackupAPI::startBackup(const std::string& type, bool fullBackup, int level) {
     try {
         Backup backup("backup_config.json");
-        return backup.execute(type, fullBackup);
+        return backup.execute(type, fullBackup, level);
     } catch (const std::exception& e) {
         return std::unexpected(std::format("Failed to start backup: {}", e.what()));
     }
@@ -27,17 +33,56 @@ std::expected<void, std::string> BackupAPI::updateSchedule(const Json::Value& sc
 
         configJson["schedule"] = schedule;
 
-        std::ofstream outFile(configFile);
-        if (!outFile.is_open()) {
-            return std::unexpected("Failed to open config file for writing: " + configFile);
-        }
+        // Replaced in one rename, so a watching daemon never reads a half-written file.
         Json::StreamWriterBuilder builder;
-        std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
-        writer->write(configJson, &outFile);
-        outFile.close();
-
+        auto written = writeFileAtomically(configFile, Json::writeString(builder, configJson));
+        if (!written) {
+            return std::unexpected(std::format("Failed to write config file {}: {}", configFile, written.error()));
+        }
         return {};
     } catch (const std::exception& e) {
         return std::unexpected(std::format("Failed to update schedule: {}", e.what()));
     }
 }
+
+std::expected<std::vector<ArchiveIndexEntry>, std::string> BackupAPI::listArchive(const std::string& archivePath,
+                                                                               const std::string& pattern) {
+    if (std::filesystem::exists(archiveIndexPath(archivePath))) {
+        return readArchiveIndex(archivePath, pattern);
+    }
+    if (!std::filesystem::exists(archivePath)) {
+        return std::unexpected("Archive not found: " + archivePath);
+    }
+
+    // No index: walk the entry headers, skipping the data.
+    struct archive* reader = archive_read_new();
+    archive_read_support_filter_all(reader);
+    archive_read_support_format_all(reader);
+    if (archive_read_open_filename(reader, archivePath.c_str(), 1024 * 1024) != ARCHIVE_OK) {
+        std::string error = std::format("Failed to open archive {}: {}", archivePath, archive_error_string(reader));
+        archive_read_free(reader);
+        return std::unexpected(error);
+    }
+    std::vector<ArchiveIndexEntry> entries;
+    struct archive_entry* entry;
+    int status;
+    while ((status = archive_read_next_header(reader, &entry)) == ARCHIVE_OK) {
+        const char* name = archive_entry_pathname(entry);
+        if (name && archive_entry_filetype(entry) == AE_IFREG && globMatch(pattern, name)) {
+            ArchiveIndexEntry listed;
+            listed.path = name;
+            listed.size = static_cast<uint64_t>(archive_entry_size(entry));
+            listed.mtime = archive_entry_mtime(entry);
+            entries.push_back(std::move(listed));
+        }
+        archive_read_data_skip(reader);
+    }
+    if (status != ARCHIVE_EOF) {
+        std::string error = std::format("Failed to read archive {}: {}", archivePath, archive_error_string(reader));
+        archive_read_free(reader);
+        return std::unexpected(error);
+    }
+    archive_read_free(reader);
+    std::ranges::sort(entries, {}, &ArchiveIndexEntry::path);
+    return entries;
+}
@@ -3,6 +3,7 @@
 #include <chrono>
 #include <format>
 #include <print>
+#include <mutex>
 #ifndef _WIN32
 #include <pwd.h>
 #endif
@@ -17,10 +18,14 @@ BackupConfig::BackupConfig(const std::string& configFile) {
     if (!reader.parse(file, configJson)) {
         throw std::runtime_error(std::format("Failed to parse config file: {}", configFile));
     }
+    json = configJson;
 
     backupBase = configJson.get("backup_base", "./backups/").asString();
     sysBackupFolder = backupBase + "sys/";
     dbBackupFolder = backupBase + "db/";
+    stateFolder = backupBase + "state/";
+    reportFolder = backupBase + "reports/";
+    catalogFolder = configJson["catalog"].get("enabled", true).asBool() ? stateFolder + "catalog/" : std::string();
     for (const auto& dir : configJson["backup_dirs"]) {
         backupDirs.push_back(dir.asString());
     }
@@ -31,9 +36,12 @@ BackupConfig::BackupConfig(const std::string& configFile) {
         excludeExtensions.push_back(ext.asString());
     }
     retentionDays = configJson.get("retention_days", 7).asInt();
+    retentionConfig = configJson["retention"];
+    trashConfig = configJson["trash"];
     logFile = backupBase + "backup.log";
     errorLogFile = backupBase + "errors.log";
     lastBackupFile = backupBase + "last_backup.txt";
+    levelsFile = backupBase + "backup_levels.txt";
 
     // Parse databases section
     if (configJson.isMember("databases")) {
@@ -58,6 +66,16 @@ BackupConfig::BackupConfig(const std::string& configFile) {
     }
 
     sftpConfig = configJson["sftp"];
+    remoteRetention = sftpConfig.get("prune_remote", false).asBool();
+    destinationsConfig = configJson["destinations"];
+    transferConfig = configJson["transfer"];
+    verifyConfig = configJson["verify"];
+    restoreTestConfig = configJson["restore_test"];
+    schedulerConfig = configJson["scheduler"];
+    loadConfig = configJson["load"];
+    journalConfig = configJson["journal"];
+    archiveFrameSize = configJson["archive"].get("frame_size_mb", 64).asUInt64() * 1024 * 1024;
+    metricsTextfile = configJson["metrics"].get("textfile", "").asString();
     telegramConfig = configJson["telegram"];
     emailConfig = configJson["email"];
 
@@ -66,6 +84,7 @@ BackupConfig::BackupConfig(const std::string& configFile) {
     scheduleTime = schedule.get("time", "15:25:00").asString();
     scheduleDayOfWeek = schedule.get("day_of_week", "monday").asString();
     scheduleDayOfMonth = schedule.get("day_of_month", 1).asInt();
+    scheduleLevel = schedule.get("level", -1).asInt();
 
 #ifdef _WIN32
     username = "Administrator"; // Default for Windows
@@ -78,7 +97,15 @@ BackupConfig::BackupConfig(const std::string& configFile) {
 #endif
 }
 
+namespace {
+
+/// Serializes log writes: upload, verification and monitor threads log alongside the run.
+std::mutex gLogMutex;
+
+} // namespace
+
 void BackupConfig::logMessage(const std::string& message) const {
+    std::lock_guard<std::mutex> lock(gLogMutex);
     std::ofstream log(logFile, std::ios::app);
     auto now = std::chrono::system_clock::now();
     auto timeT = std::chrono::system_clock::to_time_t(now);
@@ -97,6 +124,7 @@ void BackupConfig::logMessage(const std::string& message) const {
 }
 
 void BackupConfig::logError(const std::string& message) const {
+    std::lock_guard<std::mutex> lock(gLogMutex);
     std::ofstream log(errorLogFile, std::ios::app);
     auto now = std::chrono::system_clock::now();
     auto timeT = std::chrono::system_clock::to_time_t(now);
@@ -0,0 +1,565 @@
+/**
+ * @file catalog.cpp
+ * @brief Backup catalog: per-run state segments, path index and run list.
+ */
+
+#include "catalog.hpp"
+#include "digest.hpp"
+#include "sorted_table.hpp"
+#include "file_util.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <optional>
+#include <set>
+#include <string_view>
+#include <json/json.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char kSegmentMagic[8] = {'S', 'V', 'C', 'S', 'E', 'G', '0', '1'};
+constexpr char kPathIndexMagic[8] = {'S', 'V', 'C', 'P', 'I', 'X', '0', '2'};
+
+/// Path index deltas kept before they are merged into the main index.
+constexpr size_t kMaxPathDeltas = 16;
+
+struct SegmentHeader {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t run;
+    uint64_t recordCount;
+    uint64_t stringsSize;
+};
+
+struct SegmentRecord {
+    uint64_t pathOffset;
+    uint64_t archivePathOffset;
+    uint32_t pathLength;
+    uint32_t archivePathLength;
+    uint64_t size;
+    int64_t mtime;
+    uint64_t archiveOffset;
+    uint32_t storedRun;
+    uint32_t frame;
+    uint8_t sha256[32];
+};
+
+struct PathIndexHeader {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t reserved;
+    uint64_t recordCount;
+    uint64_t stringsSize;
+};
+
+struct PathIndexRecord {
+    uint64_t pathOffset;
+    uint64_t changesOffset; ///< Blob offset of changeCount uint32_t run numbers, ascending.
+    uint32_t pathLength;
+    uint32_t changeCount;
+};
+
+static_assert(sizeof(SegmentHeader) == 32 && sizeof(SegmentRecord) == 88);
+static_assert(sizeof(PathIndexHeader) == 32 && sizeof(PathIndexRecord) == 24);
+
+using SegmentView = TableView<SegmentHeader, SegmentRecord>;
+using PathIndexView = TableView<PathIndexHeader, PathIndexRecord>;
+
+/**
+ * @brief A path and the runs in which it was stored or changed.
+ */
+struct PathChanges {
+    std::string path;
+    std::vector<uint32_t> runs;
+};
+
+std::vector<uint32_t> changeRuns(const PathIndexView& index, uint64_t position) {
+    const PathIndexRecord record = index.record(position);
+    const std::string_view bytes = index.string(record.changesOffset, record.changeCount * static_cast<uint32_t>(sizeof(uint32_t)));
+    std::vector<uint32_t> runs(bytes.size() / sizeof(uint32_t));
+    std::memcpy(runs.data(), bytes.data(), runs.size() * sizeof(uint32_t));
+    return runs;
+}
+
+std::expected<void, std::string> writePathIndex(const std::string& file, const std::vector<PathChanges>& paths) {
+    std::vector<PathIndexRecord> records;
+    records.reserve(paths.size());
+    std::string strings;
+    for (const auto& entry : paths) {
+        PathIndexRecord record{};
+        record.pathOffset = strings.size();
+        record.pathLength = static_cast<uint32_t>(entry.path.size());
+        strings += entry.path;
+        record.changesOffset = strings.size();
+        record.changeCount = static_cast<uint32_t>(entry.runs.size());
+        strings.append(reinterpret_cast<const char*>(entry.runs.data()), entry.runs.size() * sizeof(uint32_t));
+        records.push_back(record);
+    }
+    PathIndexHeader header{};
+    std::memcpy(header.magic, kPathIndexMagic, sizeof(header.magic));
+    header.byteOrder = kSortedTableByteOrder;
+    header.recordCount = records.size();
+    header.stringsSize = strings.size();
+    return writeFileAtomically(file, serializeTable(header, records, strings));
+}
+
+FileVersion toVersion(const SegmentView& segment, uint64_t index) {
+    const SegmentRecord record = segment.record(index);
+    FileVersion version;
+    version.run = segment.header().run;
+    version.storedRun = record.storedRun;
+    version.sourcePath = segment.string(record.pathOffset, record.pathLength);
+    version.archivePath = segment.string(record.archivePathOffset, record.archivePathLength);
+    version.size = record.size;
+    version.mtime = record.mtime;
+    if (std::ranges::any_of(record.sha256, [](uint8_t byte) { return byte != 0; })) {
+        version.sha256 = Sha256::toHex(record.sha256);
+    }
+    version.archiveOffset = record.archiveOffset;
+    version.frame = record.frame;
+    return version;
+}
+
+} // namespace
+
+void FileManifest::add(ManifestEntry entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back(std::move(entry));
+}
+
+std::vector<ManifestEntry> FileManifest::take() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<ManifestEntry> entries = std::move(entries_);
+    entries_.clear();
+    // A file counted as unchanged may still have been written if it changed during the run;
+    // the stored record wins.
+    std::ranges::stable_sort(entries, [](const ManifestEntry& a, const ManifestEntry& b) {
+        return a.sourcePath != b.sourcePath ? a.sourcePath < b.sourcePath : a.stored > b.stored;
+    });
+    auto duplicates = std::ranges::unique(entries, {}, &ManifestEntry::sourcePath);
+    entries.erase(duplicates.begin(), duplicates.end());
+    return entries;
+}
+
+Catalog::Catalog(std::string directory) : directory_(std::move(directory)) {}
+
+std::string Catalog::segmentPath(uint32_t run) const {
+    return (fs::path(directory_) / "segments" / std::format("{:08d}.seg", run)).string();
+}
+
+std::string Catalog::pathDeltaPath(uint32_t run) const {
+    return (fs::path(directory_) / "path_deltas" / std::format("{:08d}.idx", run)).string();
+}
+
+uint32_t Catalog::stateRunOf(const CatalogRun& run) {
+    return run.stateRun != 0 ? run.stateRun : run.sequence;
+}
+
+std::vector<std::string> Catalog::pathIndexFiles() const {
+    std::vector<std::string> files;
+    const fs::path mainIndex = fs::path(directory_) / "paths.idx";
+    std::error_code ec;
+    if (fs::exists(mainIndex, ec)) {
+        files.push_back(mainIndex.string());
+    }
+    std::vector<std::string> deltas;
+    for (const auto& entry : fs::directory_iterator(fs::path(directory_) / "path_deltas", ec)) {
+        if (entry.path().extension() == ".idx") {
+            deltas.push_back(entry.path().string());
+        }
+    }
+    // Zero-padded run numbers sort chronologically.
+    std::ranges::sort(deltas);
+    files.insert(files.end(), deltas.begin(), deltas.end());
+    return files;
+}
+
+std::expected<void, std::string> Catalog::mergePathIndex(const std::vector<CatalogRun>& listed) const {
+    const std::vector<std::string> files = pathIndexFiles();
+    std::vector<PathIndexView> indexes(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        auto opened = indexes[i].open(files[i], kPathIndexMagic);
+        if (!opened) {
+            return opened;
+        }
+    }
+    // Change points of runs no longer listed (expired, or never committed) are dropped; the
+    // paths themselves stay, as the index lists every path ever backed up.
+    std::set<uint32_t> live;
+    for (const auto& run : listed) {
+        live.insert(run.sequence);
+    }
+
+    std::vector<PathChanges> merged;
+    std::vector<uint64_t> cursors(indexes.size(), 0);
+    while (true) {
+        std::optional<std::string_view> next;
+        for (size_t i = 0; i < indexes.size(); ++i) {
+            if (cursors[i] < indexes[i].count() && (!next || indexes[i].path(cursors[i]) < *next)) {
+                next = indexes[i].path(cursors[i]);
+            }
+        }
+        if (!next) {
+            break;
+        }
+        PathChanges entry{std::string(*next), {}};
+        for (size_t i = 0; i < indexes.size(); ++i) {
+            if (cursors[i] < indexes[i].count() && indexes[i].path(cursors[i]) == entry.path) {
+                for (uint32_t run : changeRuns(indexes[i], cursors[i])) {
+                    if (live.contains(run)) {
+                        entry.runs.push_back(run);
+                    }
+                }
+                ++cursors[i];
+            }
+        }
+        std::ranges::sort(entry.runs);
+        entry.runs.erase(std::ranges::unique(entry.runs).begin(), entry.runs.end());
+        merged.push_back(std::move(entry));
+    }
+
+    auto written = writePathIndex((fs::path(directory_) / "paths.idx").string(), merged);
+    if (!written) {
+        return written;
+    }
+    // A delta left behind by an interruption only repeats change points already merged.
+    for (const auto& file : files) {
+        if (fs::path(file).filename() != "paths.idx") {
+            std::error_code ec;
+            fs::remove(file, ec);
+        }
+    }
+    return {};
+}
+
+std::expected<std::vector<CatalogRun>, std::string> Catalog::runs() const {
+    const fs::path runsFile = fs::path(directory_) / "runs.json";
+    std::vector<CatalogRun> result;
+    std::ifstream in(runsFile);
+    if (!in) {
+        return result;
+    }
+    Json::Value root;
+    Json::Reader reader;
+    if (!reader.parse(in, root) || !root["runs"].isArray()) {
+        return std::unexpected(std::format("Failed to parse catalog run list {}", runsFile.string()));
+    }
+    for (const auto& entry : root["runs"]) {
+        CatalogRun run;
+        run.sequence = entry["sequence"].asUInt();
+        run.name = entry["name"].asString();
+        run.type = entry["type"].asString();
+        run.started = entry["started"].asInt64();
+        run.full = entry["full"].asBool();
+        run.level = entry.get("level", -1).asInt();
+        run.files = entry["files"].asUInt64();
+        run.storedFiles = entry["stored_files"].asUInt64();
+        run.storedBytes = entry["stored_bytes"].asUInt64();
+        for (const auto& artifact : entry["artifacts"]) {
+            run.artifacts.push_back({artifact["path"].asString(), artifact["class"].asString(), artifact["size"].asUInt64()});
+        }
+        for (const auto& dependency : entry["depends_on"]) {
+            run.dependsOn.push_back(dependency.asUInt());
+        }
+        run.stateRun = entry.get("state_run", 0).asUInt();
+        result.push_back(std::move(run));
+    }
+    return result;
+}
+
+std::expected<CatalogRun, std::string> Catalog::commitRun(CatalogRun run, const std::vector<ManifestEntry>& entries) {
+    auto existing = runs();
+    if (!existing) {
+        return std::unexpected(existing.error());
+    }
+    run.sequence = existing->empty() ? 1 : existing->back().sequence + 1;
+    run.stateRun = 0;
+
+    // Unchanged files inherit the location and digest recorded by the previous run, found by a
+    // merge walk since both lists are sorted by path.
+    SegmentView previous;
+    const bool hasPrevious = !existing->empty() && previous.open(segmentPath(stateRunOf(existing->back())), kSegmentMagic).has_value();
+    uint64_t cursor = 0;
+
+    std::set<uint32_t> dependencies;
+    std::vector<SegmentRecord> records;
+    records.reserve(entries.size());
+    std::string strings;
+    // Paths stored or changed by this run; only these go into the run's path index delta.
+    std::vector<PathChanges> changes;
+    run.files = entries.size();
+    run.storedFiles = 0;
+    run.storedBytes = 0;
+    for (const auto& entry : entries) {
+        SegmentRecord record{};
+        record.pathOffset = strings.size();
+        record.pathLength = static_cast<uint32_t>(entry.sourcePath.size());
+        strings += entry.sourcePath;
+        record.archivePathOffset = strings.size();
+        record.archivePathLength = static_cast<uint32_t>(entry.archivePath.size());
+        strings += entry.archivePath;
+        record.size = entry.size;
+        record.mtime = entry.mtime;
+        record.archiveOffset = ManifestEntry::kUnknownOffset;
+        record.frame = ManifestEntry::kNoFrame;
+
+        bool changed = true;
+        if (entry.stored) {
+            record.storedRun = run.sequence;
+            record.archiveOffset = entry.archiveOffset;
+            record.frame = entry.frame;
+            std::memcpy(record.sha256, entry.sha256.data(), sizeof(record.sha256));
+            ++run.storedFiles;
+            run.storedBytes += entry.size;
+        } else if (hasPrevious) {
+            while (cursor < previous.count() && previous.path(cursor) < entry.sourcePath) {
+                ++cursor;
+            }
+            if (cursor < previous.count() && previous.path(cursor) == entry.sourcePath) {
+                const SegmentRecord prior = previous.record(cursor);
+                if (prior.size == entry.size && prior.mtime == entry.mtime) {
+                    changed = false;
+                    record.storedRun = prior.storedRun;
+                    record.archiveOffset = prior.archiveOffset;
+                    record.frame = prior.frame;
+                    std::memcpy(record.sha256, prior.sha256, sizeof(record.sha256));
+                    if (prior.storedRun != 0) {
+                        dependencies.insert(prior.storedRun);
+                    }
+                }
+            }
+        }
+        if (changed) {
+            changes.push_back({entry.sourcePath, {run.sequence}});
+        }
+        records.push_back(record);
+    }
+    run.dependsOn.assign(dependencies.begin(), dependencies.end());
+
+    SegmentHeader segmentHeader{};
+    std::memcpy(segmentHeader.magic, kSegmentMagic, sizeof(segmentHeader.magic));
+    segmentHeader.byteOrder = kSortedTableByteOrder;
+    segmentHeader.run = run.sequence;
+    segmentHeader.recordCount = records.size();
+    segmentHeader.stringsSize = strings.size();
+    auto segmentResult = writeFileAtomically(segmentPath(run.sequence), serializeTable(segmentHeader, records, strings));
+    if (!segmentResult) {
+        return std::unexpected(std::format("Failed to write catalog segment: {}", segmentResult.error()));
+    }
+
+    // The run's changes go into a small delta instead of rewriting the index of every path;
+    // deltas are folded into the main index once kMaxPathDeltas have accumulated.
+    if (pathIndexFiles().size() > kMaxPathDeltas) {
+        auto mergeResult = mergePathIndex(*existing);
+        if (!mergeResult) {
+            return std::unexpected(std::format("Failed to merge catalog path index: {}", mergeResult.error()));
+        }
+    }
+    if (!changes.empty()) {
+        auto deltaResult = writePathIndex(pathDeltaPath(run.sequence), changes);
+        if (!deltaResult) {
+            return std::unexpected(std::format("Failed to write catalog path index: {}", deltaResult.error()));
+        }
+    }
+
+    // The run list is written last: a run is part of the catalog once it is listed here.
+    existing->push_back(run);
+    auto runsResult = writeRuns(*existing);
+    if (!runsResult) {
+        return std::unexpected(runsResult.error());
+    }
+    return run;
+}
+
+std::expected<CatalogRun, std::string> Catalog::commitRunWithoutFiles(CatalogRun run) {
+    auto existing = runs();
+    if (!existing) {
+        return std::unexpected(existing.error());
+    }
+    if (existing->empty()) {
+        return std::unexpected("The catalog has no run whose file state could be carried forward");
+    }
+    const CatalogRun& latest = existing->back();
+    run.sequence = latest.sequence + 1;
+    run.stateRun = stateRunOf(latest);
+    run.full = false;
+    run.files = latest.files;
+    run.storedFiles = 0;
+    run.storedBytes = 0;
+    // The shared state refers to the same archives as the latest run's, plus its own.
+    std::set<uint32_t> dependencies(latest.dependsOn.begin(), latest.dependsOn.end());
+    if (latest.storedFiles > 0) {
+        dependencies.insert(latest.sequence);
+    }
+    run.dependsOn.assign(dependencies.begin(), dependencies.end());
+
+    existing->push_back(run);
+    auto runsResult = writeRuns(*existing);
+    if (!runsResult) {
+        return std::unexpected(runsResult.error());
+    }
+    return run;
+}
+
+std::expected<void, std::string> Catalog::writeRuns(const std::vector<CatalogRun>& runs) const {
+    Json::Value root;
+    root["runs"] = Json::arrayValue;
+    for (const auto& listed : runs) {
+        Json::Value entry;
+        entry["sequence"] = listed.sequence;
+        entry["name"] = listed.name;
+        entry["type"] = listed.type;
+        entry["started"] = static_cast<Json::Int64>(listed.started);
+        entry["full"] = listed.full;
+        entry["level"] = listed.level;
+        entry["files"] = static_cast<Json::UInt64>(listed.files);
+        entry["stored_files"] = static_cast<Json::UInt64>(listed.storedFiles);
+        entry["stored_bytes"] = static_cast<Json::UInt64>(listed.storedBytes);
+        entry["artifacts"] = Json::arrayValue;
+        for (const auto& artifact : listed.artifacts) {
+            Json::Value item;
+            item["path"] = artifact.path;
+            item["class"] = artifact.artifactClass;
+            item["size"] = static_cast<Json::UInt64>(artifact.size);
+            entry["artifacts"].append(item);
+        }
+        entry["depends_on"] = Json::arrayValue;
+        for (uint32_t dependency : listed.dependsOn) {
+            entry["depends_on"].append(dependency);
+        }
+        if (listed.stateRun != 0) {
+            entry["state_run"] = listed.stateRun;
+        }
+        root["runs"].append(entry);
+    }
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "  ";
+    auto result = writeFileAtomically((fs::path(directory_) / "runs.json").string(), Json::writeString(writer, root));
+    if (!result) {
+        return std::unexpected(std::format("Failed to write catalog run list: {}", result.error()));
+    }
+    return {};
+}
+
+std::expected<void, std::string> Catalog::removeRuns(const std::vector<uint32_t>& sequences) {
+    auto existing = runs();
+    if (!existing) {
+        return std::unexpected(existing.error());
+    }
+    const std::set<uint32_t> removed(sequences.begin(), sequences.end());
+    std::set<uint32_t> unreferenced;
+    for (const auto& run : *existing) {
+        if (removed.contains(run.sequence)) {
+            unreferenced.insert(stateRunOf(run));
+        }
+    }
+    std::erase_if(*existing, [&removed](const CatalogRun& run) { return removed.contains(run.sequence); });
+    // Runs without a file archive share an earlier run's segment, which stays while they do.
+    for (const auto& run : *existing) {
+        unreferenced.erase(stateRunOf(run));
+    }
+    // Unlist first, so an interrupted removal never leaves a listed run without its segment.
+    auto result = writeRuns(*existing);
+    if (!result) {
+        return result;
+    }
+    for (uint32_t sequence : unreferenced) {
+        std::error_code ec;
+        fs::remove(segmentPath(sequence), ec);
+    }
+    return {};
+}
+
+std::expected<std::vector<std::string>, std::string> Catalog::find(const std::string& pattern) const {
+    std::set<std::string> matches;
+    // Only paths sharing the pattern's literal prefix can match; each index is sorted, so that is one range.
+    const std::string_view prefix = globPrefix(pattern);
+    for (const auto& file : pathIndexFiles()) {
+        PathIndexView index;
+        auto opened = index.open(file, kPathIndexMagic);
+        if (!opened) {
+            return std::unexpected(opened.error());
+        }
+        for (uint64_t i = index.lowerBound(prefix); i < index.count(); ++i) {
+            const std::string_view path = index.path(i);
+            if (!path.starts_with(prefix)) {
+                break;
+            }
+            if (globMatch(pattern, path)) {
+                matches.emplace(path);
+            }
+        }
+    }
+    return std::vector<std::string>(matches.begin(), matches.end());
+}
+
+std::expected<std::vector<FileVersion>, std::string> Catalog::versions(const std::string& path) const {
+    // The path index lists the runs that stored or changed the path, so only their segments are read.
+    std::vector<uint32_t> changes;
+    for (const auto& file : pathIndexFiles()) {
+        PathIndexView index;
+        auto opened = index.open(file, kPathIndexMagic);
+        if (!opened) {
+            return std::unexpected(opened.error());
+        }
+        const uint64_t position = index.lowerBound(path);
+        if (position < index.count() && index.path(position) == path) {
+            const std::vector<uint32_t> runs = changeRuns(index, position);
+            changes.insert(changes.end(), runs.begin(), runs.end());
+        }
+    }
+    std::ranges::sort(changes);
+    changes.erase(std::ranges::unique(changes).begin(), changes.end());
+
+    std::vector<FileVersion> result;
+    for (uint32_t run : changes) {
+        SegmentView segment;
+        if (!segment.open(segmentPath(run), kSegmentMagic)) {
+            continue; // Run pruned from the catalog.
+        }
+        const uint64_t i = segment.lowerBound(path);
+        if (i == segment.count() || segment.path(i) != path) {
+            continue;
+        }
+        FileVersion version = toVersion(segment, i);
+        // Content of unknown origin (recorded before the catalog existed) that reappears
+        // unchanged after a deletion is the same version.
+        const bool storedHere = version.storedRun == run;
+        const bool unknownChanged = version.storedRun == 0 &&
+                                    (result.empty() || result.back().size != version.size || result.back().mtime != version.mtime);
+        if (storedHere || unknownChanged) {
+            result.push_back(std::move(version));
+        }
+    }
+    return result;
+}
+
+std::expected<std::vector<FileVersion>, std::string> Catalog::snapshot(uint32_t run, const std::string& prefix) const {
+    auto listed = runs();
+    if (!listed) {
+        return std::unexpected(listed.error());
+    }
+    if (run == 0) {
+        if (listed->empty()) {
+            return std::vector<FileVersion>{};
+        }
+        run = listed->back().sequence;
+    }
+    // Runs without a file archive share the segment of the run whose state they carry.
+    auto entry = std::ranges::find(*listed, run, &CatalogRun::sequence);
+    const uint32_t stateRun = entry != listed->end() ? stateRunOf(*entry) : run;
+    SegmentView segment;
+    auto opened = segment.open(segmentPath(stateRun), kSegmentMagic);
+    if (!opened) {
+        return std::unexpected(std::format("Run {} is not in the catalog: {}", run, opened.error()));
+    }
+    std::vector<FileVersion> result;
+    for (uint64_t i = segment.lowerBound(prefix); i < segment.count() && segment.path(i).starts_with(prefix); ++i) {
+        result.push_back(toVersion(segment, i));
+    }
+    return result;
+}
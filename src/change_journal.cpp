@@ -0,0 +1,398 @@
+/**
+ * @file change_journal.cpp
+ * @brief Records changes below the backup directories between runs, so incremental runs need not walk them.
+ */
+
+#include "change_journal.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <format>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/fanotify.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/// Changes seen this long before a reference time still count, for events read late.
+constexpr auto kEventSlack = std::chrono::seconds(2);
+
+/**
+ * @brief Returns whether a path is a directory or lies below it.
+ */
+bool isWithin(const std::string& path, const std::string& dir) {
+    return path.size() >= dir.size() && path.compare(0, dir.size(), dir) == 0 &&
+           (path.size() == dir.size() || path[dir.size()] == '/' || dir == "/");
+}
+
+} // namespace
+
+ChangeJournal::ChangeJournal(const Json::Value& journalConfig, Logger onMessage, Logger onError)
+    : backend_(journalConfig.get("backend", "auto").asString()),
+      maxPaths_(std::max<size_t>(1, journalConfig.get("max_paths", 1000000).asUInt64())),
+      onMessage_(std::move(onMessage)),
+      onError_(std::move(onError)) {}
+
+ChangeJournal::~ChangeJournal() {
+    stop();
+}
+
+#ifdef __linux__
+
+std::expected<void, std::string> ChangeJournal::start(const std::vector<std::string>& roots) {
+    if (backend_ != "auto" && backend_ != "fanotify" && backend_ != "inotify") {
+        return std::unexpected(std::format("Invalid journal backend '{}' (use auto, fanotify or inotify)", backend_));
+    }
+    for (const auto& root : roots) {
+        // Events name resolved paths, so the roots are resolved too.
+        std::error_code ec;
+        const fs::path path = fs::canonical(root, ec);
+        if (!ec && fs::is_directory(path, ec)) {
+            roots_.push_back(path.generic_string());
+        }
+    }
+    if (roots_.empty()) {
+        return std::unexpected("None of the backup directories exists");
+    }
+
+    std::expected<void, std::string> started = std::unexpected("");
+    if (backend_ != "inotify") {
+        started = startFanotify();
+        if (!started && backend_ == "fanotify") {
+            return started;
+        }
+    }
+    if (!started) {
+        const std::string fanotifyError = started.error();
+        started = startInotify();
+        if (!started) {
+            return started;
+        }
+        if (!fanotifyError.empty()) {
+            onMessage_(std::format("Change journal: fanotify unavailable ({}), using inotify", fanotifyError));
+        }
+    }
+
+    stopFd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        coveredSince_ = Clock::now();
+    }
+    onMessage_(std::format("Change journal watching {} director{} with {}{}", roots_.size(), roots_.size() == 1 ? "y" : "ies",
+                           fanotify_ ? "fanotify" : "inotify",
+                           fanotify_ ? "" : std::format(" ({} watches)", watches_.size())));
+    reader_ = std::thread([this]() { readLoop(); });
+    return {};
+}
+
+void ChangeJournal::stop() {
+    if (reader_.joinable()) {
+        const uint64_t one = 1;
+        [[maybe_unused]] const auto written = ::write(stopFd_, &one, sizeof(one));
+        reader_.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    coveredSince_.reset();
+    changes_.clear();
+    watches_.clear();
+    roots_.clear();
+    for (int fd : mountFds_) {
+        ::close(fd);
+    }
+    mountFds_.clear();
+    for (int* fd : {&fd_, &stopFd_}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+std::expected<void, std::string> ChangeJournal::startFanotify() {
+#ifdef FAN_REPORT_DFID_NAME
+    fd_ = ::fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK | FAN_REPORT_DFID_NAME, O_RDONLY | O_CLOEXEC | O_LARGEFILE);
+    if (fd_ < 0) {
+        return std::unexpected(std::format("fanotify_init: {}", std::strerror(errno)));
+    }
+    const uint64_t mask = FAN_CREATE | FAN_DELETE | FAN_MOVED_FROM | FAN_MOVED_TO | FAN_MODIFY | FAN_ATTRIB | FAN_CLOSE_WRITE |
+                          FAN_DELETE_SELF | FAN_MOVE_SELF | FAN_ONDIR;
+    std::string error;
+    for (const auto& root : roots_) {
+        if (::fanotify_mark(fd_, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, mask, AT_FDCWD, root.c_str()) != 0) {
+            error = std::format("fanotify_mark {}: {}", root, std::strerror(errno));
+            break;
+        }
+        const int mountFd = ::open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (mountFd < 0) {
+            error = std::format("open {}: {}", root, std::strerror(errno));
+            break;
+        }
+        mountFds_.push_back(mountFd);
+    }
+    if (error.empty()) {
+        // Event directories arrive as file handles; opening them needs CAP_DAC_READ_SEARCH.
+        struct {
+            file_handle handle;
+            unsigned char bytes[MAX_HANDLE_SZ];
+        } probe{};
+        probe.handle.handle_bytes = MAX_HANDLE_SZ;
+        int mountId = 0;
+        if (::name_to_handle_at(AT_FDCWD, roots_.front().c_str(), &probe.handle, &mountId, 0) != 0 || !resolveHandle(&probe.handle)) {
+            error = std::format("cannot resolve file handles: {}", std::strerror(errno));
+        }
+    }
+    if (!error.empty()) {
+        for (int fd : mountFds_) {
+            ::close(fd);
+        }
+        mountFds_.clear();
+        ::close(fd_);
+        fd_ = -1;
+        return std::unexpected(error);
+    }
+    fanotify_ = true;
+    return {};
+#else
+    return std::unexpected("built without FAN_REPORT_DFID_NAME");
+#endif
+}
+
+std::expected<void, std::string> ChangeJournal::startInotify() {
+    fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0) {
+        return std::unexpected(std::format("inotify_init1: {}", std::strerror(errno)));
+    }
+    fanotify_ = false;
+    for (const auto& root : roots_) {
+        if (!watchTree(root)) {
+            ::close(fd_);
+            fd_ = -1;
+            watches_.clear();
+            return std::unexpected(std::format("inotify watch limit reached below {} (raise fs.inotify.max_user_watches)", root));
+        }
+    }
+    return {};
+}
+
+bool ChangeJournal::watchTree(const std::string& dir) {
+    constexpr uint32_t kMask = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                               IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+    auto add = [this](const std::string& path) {
+        const int wd = ::inotify_add_watch(fd_, path.c_str(), kMask);
+        if (wd >= 0) {
+            // Re-adding a moved directory returns its old descriptor; the path is updated.
+            watches_[wd] = path;
+            return true;
+        }
+        return errno != ENOSPC;
+    };
+    if (!add(dir)) {
+        return false;
+    }
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(dir, fs::directory_options::skip_permission_denied, ec);
+         it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec) {
+            break;
+        }
+        if (it->is_directory(ec) && !it->is_symlink(ec) && !add(it->path().generic_string())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ChangeJournal::unwatchTree(const std::string& dir) {
+    for (auto it = watches_.begin(); it != watches_.end();) {
+        if (isWithin(it->second, dir)) {
+            ::inotify_rm_watch(fd_, it->first);
+            it = watches_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ChangeJournal::readLoop() {
+    pollfd fds[2] = {{fd_, POLLIN, 0}, {stopFd_, POLLIN, 0}};
+    while (true) {
+        if (::poll(fds, 2, -1) < 0 && errno != EINTR) {
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            drain();
+        }
+    }
+}
+
+void ChangeJournal::drain() {
+    if (fd_ < 0) {
+        return;
+    }
+    if (fanotify_) {
+        drainFanotify();
+    } else {
+        drainInotify();
+    }
+}
+
+void ChangeJournal::drainFanotify() {
+#ifdef FAN_REPORT_DFID_NAME
+    alignas(fanotify_event_metadata) char buffer[64 * 1024];
+    while (true) {
+        ssize_t length = ::read(fd_, buffer, sizeof(buffer));
+        if (length <= 0) {
+            return;
+        }
+        for (auto* event = reinterpret_cast<fanotify_event_metadata*>(buffer); FAN_EVENT_OK(event, length);
+             event = FAN_EVENT_NEXT(event, length)) {
+            if (event->fd >= 0) {
+                ::close(event->fd);
+            }
+            if (event->mask & FAN_Q_OVERFLOW) {
+                reset("the fanotify event queue overflowed");
+                continue;
+            }
+            auto* info = reinterpret_cast<fanotify_event_info_fid*>(event + 1);
+            if (event->event_len <= sizeof(*event) ||
+                (info->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID_NAME && info->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID)) {
+                continue;
+            }
+            auto* handle = reinterpret_cast<file_handle*>(info->handle);
+            // A directory that no longer exists cannot be resolved; its removal was reported
+            // (and recorded) in its parent directory.
+            auto dir = resolveHandle(handle);
+            if (!dir) {
+                continue;
+            }
+            std::string path = *dir;
+            if (info->hdr.info_type == FAN_EVENT_INFO_TYPE_DFID_NAME) {
+                const char* name = reinterpret_cast<const char*>(handle->f_handle + handle->handle_bytes);
+                if (std::strcmp(name, ".") != 0) {
+                    path += (path == "/" ? "" : "/") + std::string(name);
+                }
+            }
+            record(path);
+        }
+    }
+#endif
+}
+
+std::optional<std::string> ChangeJournal::resolveHandle(void* handle) const {
+    for (int mountFd : mountFds_) {
+        const int dirFd = ::open_by_handle_at(mountFd, static_cast<file_handle*>(handle), O_PATH | O_CLOEXEC);
+        if (dirFd < 0) {
+            continue;
+        }
+        std::error_code ec;
+        const fs::path resolved = fs::read_symlink(std::format("/proc/self/fd/{}", dirFd), ec);
+        ::close(dirFd);
+        if (!ec) {
+            return resolved.generic_string();
+        }
+    }
+    return std::nullopt;
+}
+
+void ChangeJournal::drainInotify() {
+    alignas(inotify_event) char buffer[64 * 1024];
+    while (true) {
+        const ssize_t length = ::read(fd_, buffer, sizeof(buffer));
+        if (length <= 0) {
+            return;
+        }
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            if (event->mask & IN_Q_OVERFLOW) {
+                reset("the inotify event queue overflowed");
+                continue;
+            }
+            auto watch = watches_.find(event->wd);
+            if (watch == watches_.end()) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                watches_.erase(watch);
+                continue;
+            }
+            const std::string path = event->len > 0 ? watch->second + "/" + event->name : watch->second;
+            record(path);
+            if (!(event->mask & IN_ISDIR)) {
+                continue;
+            }
+            if (event->mask & IN_MOVED_FROM) {
+                unwatchTree(path);
+            } else if ((event->mask & (IN_CREATE | IN_MOVED_TO)) && !watchTree(path) && coveredSince_) {
+                // Directories without a watch would go unnoticed from now on.
+                coveredSince_.reset();
+                onError_(std::format("Change journal: inotify watch limit reached below {}; incremental runs walk the "
+                                     "backup directories until the daemon restarts", path));
+            }
+        }
+    }
+}
+
+#else
+
+std::expected<void, std::string> ChangeJournal::start([[maybe_unused]] const std::vector<std::string>& roots) {
+    return std::unexpected("Change journals need Linux (fanotify or inotify)");
+}
+
+void ChangeJournal::stop() {}
+
+void ChangeJournal::drain() {}
+
+#endif
+
+void ChangeJournal::record(const std::string& path) {
+    if (!coveredSince_ || std::ranges::none_of(roots_, [&path](const std::string& root) { return isWithin(path, root); })) {
+        return;
+    }
+    changes_[path] = Clock::now();
+    if (changes_.size() > maxPaths_) {
+        reset(std::format("more than {} changed paths", maxPaths_));
+    }
+}
+
+void ChangeJournal::reset(const std::string& reason) {
+    changes_.clear();
+    if (coveredSince_) {
+        coveredSince_ = Clock::now();
+        onError_(std::format("Change journal reset: {}; the next incremental run walks the backup directories", reason));
+    }
+}
+
+std::optional<std::vector<std::string>> ChangeJournal::changedSince(Clock::time_point since) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    drain();
+    if (!coveredSince_ || since < *coveredSince_) {
+        return std::nullopt;
+    }
+    std::vector<std::string> paths;
+    for (const auto& [path, seen] : changes_) {
+        if (seen >= since - kEventSlack) {
+            paths.push_back(path);
+        }
+    }
+    std::ranges::sort(paths);
+    return paths;
+}
+
+void ChangeJournal::forgetBefore(Clock::time_point time) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::erase_if(changes_, [time](const auto& change) { return change.second < time - kEventSlack; });
+}
@@ -0,0 +1,544 @@
+/**
+ * @file chunk_repository.cpp
+ * @brief Content-addressed chunk repository transfer mode for SecureVault.
+ *
+ * Splits artifacts with content-defined chunking (see content_chunker.hpp) so that an
+ * insertion early in a file only changes the chunks around it.
+ */
+
+#include "chunk_repository.hpp"
+#include "content_chunker.hpp"
+#include "digest.hpp"
+#include <bit>
+#include <fstream>
+#include <iostream>
+#include <format>
+#include <map>
+#include <sstream>
+#include <system_error>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t kReadBlockSize = 1 << 20;
+
+std::string joinGroup(const std::string& base, const std::string& group) {
+    return group.empty() ? base : base + "/" + group;
+}
+
+std::string packPath(const std::string& packId) {
+    return std::format("repo/packs/pack-{}.pack", packId);
+}
+
+std::expected<Json::Value, std::string> readManifest(const fs::path& file) {
+    std::ifstream in(file);
+    Json::Value manifest;
+    Json::Reader reader;
+    if (!in || !reader.parse(in, manifest) || !manifest["chunks"].isArray()) {
+        return std::unexpected(std::format("Failed to parse snapshot manifest {}", file.string()));
+    }
+    return manifest;
+}
+
+} // namespace
+
+class RepositoryTransferStrategy::PackBuilder {
+public:
+    explicit PackBuilder(RepositoryTransferStrategy& owner) : owner_(owner) {}
+
+    size_t size() const { return data_.size(); }
+
+    /**
+     * @brief Appends a chunk unless the pending pack already holds it.
+     *
+     * @return bool True if the chunk was added.
+     */
+    bool add(const std::string& id, std::span<const char> chunk) {
+        if (pendingIds_.contains(id)) {
+            return false;
+        }
+        pendingIds_.emplace(id);
+        pending_.push_back({id, data_.size(), chunk.size()});
+        data_.insert(data_.end(), chunk.begin(), chunk.end());
+        return true;
+    }
+
+    /**
+     * @brief Uploads the pending pack and records its chunks in the index.
+     *
+     * Chunks are added to the index only after the pack upload succeeded, so the cached
+     * index never claims a chunk the remote does not have.
+     */
+    std::expected<void, std::string> flush() {
+        if (data_.empty()) {
+            return {};
+        }
+
+        Sha256 packDigest;
+        packDigest.update(data_);
+        const std::string packId = packDigest.hexDigest();
+        const fs::path stagingFile = fs::path(owner_.stateFolder_) / std::format("pack-{}.pack", packId);
+
+        {
+            std::ofstream out(stagingFile, std::ios::binary | std::ios::trunc);
+            out.write(data_.data(), static_cast<std::streamsize>(data_.size()));
+            out.close();
+            if (!out) {
+                std::error_code ec;
+                fs::remove(stagingFile, ec);
+                return std::unexpected(std::format("Failed to stage pack file: {}", stagingFile.string()));
+            }
+        }
+
+        auto uploadResult = owner_.inner_->transfer(stagingFile.string(), "repo/packs");
+        std::error_code ec;
+        fs::remove(stagingFile, ec);
+        if (!uploadResult) {
+            return std::unexpected(std::format("Failed to upload pack {}: {}", packId, uploadResult.error()));
+        }
+
+        std::ofstream indexOut(owner_.indexFile_, std::ios::app);
+        for (const auto& chunk : pending_) {
+            owner_.index_[chunk.id] = ChunkLocation{packId, chunk.offset, chunk.length};
+            indexOut << chunk.id << ' ' << packId << ' ' << chunk.offset << ' ' << chunk.length << '\n';
+        }
+
+        data_.clear();
+        pending_.clear();
+        pendingIds_.clear();
+        ++packsUploaded_;
+        return {};
+    }
+
+    size_t packsUploaded() const { return packsUploaded_; }
+
+private:
+    struct PendingChunk {
+        std::string id;
+        uint64_t offset;
+        uint64_t length;
+    };
+
+    RepositoryTransferStrategy& owner_;
+    std::vector<char> data_;
+    std::vector<PendingChunk> pending_;
+    std::unordered_set<std::string> pendingIds_;
+    size_t packsUploaded_ = 0;
+};
+
+RepositoryTransferStrategy::RepositoryTransferStrategy(std::unique_ptr<TransferStrategy> inner,
+                                                       const Json::Value& config,
+                                                       const std::string& stateFolder)
+    : inner_(std::move(inner)),
+      stateFolder_(stateFolder),
+      avgChunkSize_(std::bit_ceil(std::max<size_t>(config.get("avg_chunk_size", 1048576).asUInt(), 4096))),
+      packSize_(std::max<size_t>(config.get("pack_size", 16777216).asUInt(), avgChunkSize_)) {
+    Sha256 nameDigest;
+    const std::string innerName = inner_->name();
+    nameDigest.update(innerName);
+    indexFile_ = (fs::path(stateFolder_) / std::format("chunk_index-{}.txt", nameDigest.hexDigest().substr(0, 16))).string();
+    snapshotFolder_ = (fs::path(stateFolder_) / std::format("repo_snapshots-{}", nameDigest.hexDigest().substr(0, 16))).string();
+}
+
+std::string RepositoryTransferStrategy::name() const {
+    return std::format("repository on {}", inner_->name());
+}
+
+void RepositoryTransferStrategy::attachMetrics(TransferMetrics* metrics) {
+    metrics_ = metrics;
+    inner_->attachMetrics(metrics);
+}
+
+void RepositoryTransferStrategy::loadIndex() {
+    if (indexLoaded_) {
+        return;
+    }
+    indexLoaded_ = true;
+
+    std::ifstream in(indexFile_);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string id;
+        ChunkLocation location;
+        if (fields >> id >> location.pack >> location.offset >> location.length) {
+            index_[id] = std::move(location);
+        }
+    }
+}
+
+/**
+ * Chunks are cut as soon as a full maximum-size window is buffered, so boundaries are the same
+ * as when the whole file is read at once.
+ */
+class RepositoryTransferStrategy::Upload : public TransferSink {
+public:
+    Upload(RepositoryTransferStrategy& owner, std::string sourceFile, std::string destinationPath)
+        : owner_(owner),
+          sourceFile_(std::move(sourceFile)),
+          destinationPath_(std::move(destinationPath)),
+          chunker_(owner.avgChunkSize_),
+          packs_(owner) {}
+
+    std::expected<void, std::string> write(std::span<const char> data) override {
+        window_.insert(window_.end(), data.begin(), data.end());
+        std::lock_guard<std::mutex> lock(owner_.mutex_);
+        while (window_.size() - start_ >= chunker_.maxSize()) {
+            auto cutResult = cutChunk();
+            if (!cutResult) {
+                return cutResult;
+            }
+        }
+        // Keep the buffered tail small instead of letting consumed bytes pile up.
+        if (start_ >= kReadBlockSize) {
+            window_.erase(window_.begin(), window_.begin() + static_cast<std::ptrdiff_t>(start_));
+            start_ = 0;
+        }
+        return {};
+    }
+
+    std::expected<void, std::string> commit() override {
+        std::lock_guard<std::mutex> lock(owner_.mutex_);
+        while (window_.size() > start_) {
+            auto cutResult = cutChunk();
+            if (!cutResult) {
+                return cutResult;
+            }
+        }
+        auto flushResult = packs_.flush();
+        if (!flushResult) {
+            return std::unexpected(flushResult.error());
+        }
+
+        const std::string artifactName = fs::path(sourceFile_).filename().string();
+        Json::Value manifest;
+        manifest["artifact"] = artifactName;
+        manifest["size"] = Json::UInt64(totalBytes_);
+        manifest["sha256"] = artifactDigest_.hexDigest();
+        manifest["created"] = Json::Int64(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+        Json::Value& chunks = manifest["chunks"];
+        chunks = Json::Value(Json::arrayValue);
+        for (const auto& id : layout_) {
+            const ChunkLocation& location = owner_.index_.at(id);
+            Json::Value entry(Json::arrayValue);
+            entry.append(id);
+            entry.append(location.pack);
+            entry.append(Json::UInt64(location.offset));
+            entry.append(Json::UInt64(location.length));
+            chunks.append(entry);
+        }
+
+        std::error_code ec;
+        const fs::path manifestFile = fs::path(owner_.stateFolder_) / std::format("{}.manifest.json", artifactName);
+        {
+            std::ofstream out(manifestFile, std::ios::trunc);
+            Json::StreamWriterBuilder builder;
+            builder["indentation"] = "";
+            std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+            writer->write(manifest, &out);
+            out.close();
+            if (!out) {
+                fs::remove(manifestFile, ec);
+                return std::unexpected(std::format("Failed to write snapshot manifest: {}", manifestFile.string()));
+            }
+        }
+
+        auto manifestResult = owner_.inner_->transfer(manifestFile.string(), joinGroup("repo/snapshots", destinationPath_));
+        if (!manifestResult) {
+            fs::remove(manifestFile, ec);
+            return std::unexpected(std::format("Failed to upload snapshot manifest: {}", manifestResult.error()));
+        }
+
+        // The kept copy's time bounds the remote one from above, so pruning by it never keeps a
+        // remote manifest whose packs were collected.
+        const fs::path keptDir = fs::path(owner_.snapshotFolder_) / destinationPath_;
+        const fs::path keptFile = keptDir / manifestFile.filename();
+        fs::create_directories(keptDir, ec);
+        if (!ec) {
+            fs::rename(manifestFile, keptFile, ec);
+        }
+        if (!ec) {
+            fs::last_write_time(keptFile, fs::file_time_type::clock::now(), ec);
+        }
+        if (ec) {
+            fs::remove(manifestFile, ec);
+            return std::unexpected(std::format("Failed to keep snapshot manifest {}: {}", keptFile.string(), ec.message()));
+        }
+
+        std::cout << std::format("Repository upload of {}: {} chunk(s), {} of {} bytes new in {} pack(s)",
+                                 artifactName, layout_.size(), newBytes_, totalBytes_, packs_.packsUploaded()) << std::endl;
+        return {};
+    }
+
+private:
+    /**
+     * @brief Cuts the next chunk from the buffered window and queues it if it is new.
+     */
+    std::expected<void, std::string> cutChunk() {
+        const size_t length = chunker_.cut(reinterpret_cast<const uint8_t*>(window_.data() + start_), window_.size() - start_);
+        const std::span<const char> chunk(window_.data() + start_, length);
+        artifactDigest_.update(chunk);
+
+        Sha256 chunkDigest;
+        chunkDigest.update(chunk);
+        std::string id = chunkDigest.hexDigest();
+        if (!owner_.index_.contains(id) && packs_.add(id, chunk)) {
+            newBytes_ += length;
+        }
+        layout_.push_back(std::move(id));
+        start_ += length;
+        totalBytes_ += length;
+
+        if (packs_.size() >= owner_.packSize_) {
+            auto flushResult = packs_.flush();
+            if (!flushResult) {
+                return std::unexpected(flushResult.error());
+            }
+        }
+        return {};
+    }
+
+    RepositoryTransferStrategy& owner_;
+    std::string sourceFile_;
+    std::string destinationPath_;
+    Chunker chunker_;
+    PackBuilder packs_;
+    Sha256 artifactDigest_;
+    std::vector<std::string> layout_; ///< Chunk ids in file order.
+    std::vector<char> window_; ///< Written bytes not yet cut into chunks (from start_).
+    size_t start_ = 0;
+    uint64_t totalBytes_ = 0;
+    uint64_t newBytes_ = 0;
+};
+
+std::expected<void, std::string> RepositoryTransferStrategy::transfer(const std::string& sourceFile, const std::string& destinationPath) {
+    return streamFile(sourceFile, destinationPath, kReadBlockSize);
+}
+
+std::expected<std::unique_ptr<TransferSink>, std::string> RepositoryTransferStrategy::openSink(const std::string& sourceFile,
+                                                                                                const std::string& destinationPath) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::error_code ec;
+        fs::create_directories(stateFolder_, ec);
+        if (ec) {
+            return std::unexpected(std::format("Failed to create repository state directory: {}", ec.message()));
+        }
+        loadIndex();
+    }
+    return std::make_unique<Upload>(*this, sourceFile, destinationPath);
+}
+
+std::expected<size_t, std::string> RepositoryTransferStrategy::pruneRemote(const std::vector<std::string>& directories,
+                                                                           std::chrono::system_clock::time_point threshold) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::vector<std::string> expired;
+    std::vector<fs::path> expiredCopies;
+    for (const auto& directory : directories) {
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(fs::path(snapshotFolder_) / directory, ec)) {
+            std::error_code entryEc;
+            if (!entry.is_regular_file(entryEc) || std::chrono::file_clock::to_sys(entry.last_write_time(entryEc)) >= threshold || entryEc) {
+                continue;
+            }
+            expired.push_back(joinGroup("repo/snapshots", directory) + "/" + entry.path().filename().string());
+            expiredCopies.push_back(entry.path());
+        }
+    }
+
+    auto removed = inner_->removeRemote(expired);
+    if (!removed) {
+        // Without single-file removal, manifests age out remotely and every pack is kept.
+        std::vector<std::string> snapshotDirs;
+        snapshotDirs.reserve(directories.size());
+        for (const auto& directory : directories) {
+            snapshotDirs.push_back(joinGroup("repo/snapshots", directory));
+        }
+        std::cerr << std::format("Warning: Keeping all packs of {}: {}", name(), removed.error()) << std::endl;
+        return inner_->pruneRemote(snapshotDirs, threshold);
+    }
+    for (const auto& copy : expiredCopies) {
+        std::error_code ec;
+        fs::remove(copy, ec);
+    }
+
+    auto packs = collectPacks();
+    if (!packs) {
+        return std::unexpected(std::format("Failed to remove unreferenced packs: {}", packs.error()));
+    }
+    return *removed + *packs;
+}
+
+std::expected<size_t, std::string> RepositoryTransferStrategy::collectPacks() {
+    loadIndex();
+
+    std::unordered_set<std::string> referenced;
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(snapshotFolder_, ec); !ec && it != fs::recursive_directory_iterator();
+         it.increment(ec)) {
+        if (!it->is_regular_file()) {
+            continue;
+        }
+        auto manifest = readManifest(it->path());
+        if (!manifest) {
+            // An unreadable manifest could reference any pack.
+            return std::unexpected(manifest.error());
+        }
+        for (const auto& chunk : (*manifest)["chunks"]) {
+            referenced.insert(chunk[1].asString());
+        }
+    }
+    if (ec && ec != std::errc::no_such_file_or_directory) {
+        return std::unexpected(std::format("Failed to read kept manifests: {}", ec.message()));
+    }
+
+    std::unordered_set<std::string> unreferenced;
+    for (const auto& [id, location] : index_) {
+        if (!referenced.contains(location.pack)) {
+            unreferenced.insert(location.pack);
+        }
+    }
+    if (unreferenced.empty()) {
+        return 0;
+    }
+
+    std::vector<std::string> paths;
+    paths.reserve(unreferenced.size());
+    for (const auto& pack : unreferenced) {
+        paths.push_back(packPath(pack));
+    }
+    auto removed = inner_->removeRemote(paths);
+    if (!removed) {
+        return std::unexpected(removed.error());
+    }
+
+    // Chunks of removed packs are uploaded again when they reappear.
+    std::erase_if(index_, [&](const auto& entry) { return unreferenced.contains(entry.second.pack); });
+    const std::string tempFile = indexFile_ + ".tmp";
+    {
+        std::ofstream out(tempFile, std::ios::trunc);
+        for (const auto& [id, location] : index_) {
+            out << id << ' ' << location.pack << ' ' << location.offset << ' ' << location.length << '\n';
+        }
+        out.close();
+        if (!out) {
+            fs::remove(tempFile, ec);
+            return std::unexpected(std::format("Failed to write chunk index {}", tempFile));
+        }
+    }
+    fs::rename(tempFile, indexFile_, ec);
+    if (ec) {
+        return std::unexpected(std::format("Failed to replace chunk index {}: {}", indexFile_, ec.message()));
+    }
+    std::cout << std::format("Repository {}: removed {} unreferenced pack(s)", name(), *removed) << std::endl;
+    return *removed;
+}
+
+std::expected<void, std::string> RepositoryTransferStrategy::fetch(const std::string& remotePath, const std::string& localFile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::error_code ec;
+    fs::create_directories(stateFolder_, ec);
+    if (ec) {
+        return std::unexpected(std::format("Failed to create repository state directory: {}", ec.message()));
+    }
+
+    const fs::path artifact(remotePath);
+    const std::string group = artifact.parent_path().generic_string();
+    const std::string artifactName = artifact.filename().string();
+    const fs::path manifestFile = fs::path(stateFolder_) / std::format("fetch-{}.manifest.json", artifactName);
+    auto manifestResult = inner_->fetch(joinGroup("repo/snapshots", group) + "/" + artifactName + ".manifest.json", manifestFile.string());
+    if (!manifestResult) {
+        return std::unexpected(std::format("Failed to download snapshot manifest of {}: {}", remotePath, manifestResult.error()));
+    }
+    auto manifest = readManifest(manifestFile);
+    fs::remove(manifestFile, ec);
+    if (!manifest) {
+        return std::unexpected(manifest.error());
+    }
+
+    // Output offsets of every chunk, grouped by pack so each pack is downloaded once.
+    struct Placement {
+        std::string id;
+        uint64_t packOffset;
+        uint64_t length;
+        uint64_t outputOffset;
+    };
+    std::map<std::string, std::vector<Placement>> byPack;
+    uint64_t size = 0;
+    for (const auto& chunk : (*manifest)["chunks"]) {
+        const uint64_t length = chunk[3].asUInt64();
+        byPack[chunk[1].asString()].push_back({chunk[0].asString(), chunk[2].asUInt64(), length, size});
+        size += length;
+    }
+    if (size != (*manifest)["size"].asUInt64()) {
+        return std::unexpected(std::format("Snapshot manifest of {} is inconsistent: chunks add up to {} of {} bytes", remotePath, size,
+                                           (*manifest)["size"].asUInt64()));
+    }
+
+    const std::string partFile = localFile + ".part";
+    auto fail = [&](std::string error) -> std::expected<void, std::string> {
+        std::error_code removeEc;
+        fs::remove(partFile, removeEc);
+        return std::unexpected(std::move(error));
+    };
+    {
+        std::ofstream create(partFile, std::ios::binary | std::ios::trunc);
+    }
+    fs::resize_file(partFile, size, ec);
+    if (ec) {
+        return fail(std::format("Failed to create {}: {}", partFile, ec.message()));
+    }
+    std::fstream output(partFile, std::ios::binary | std::ios::in | std::ios::out);
+
+    std::vector<char> buffer;
+    for (const auto& [packId, placements] : byPack) {
+        const fs::path packFile = fs::path(stateFolder_) / std::format("fetch-{}.pack", packId);
+        auto packResult = inner_->fetch(packPath(packId), packFile.string());
+        if (!packResult) {
+            return fail(std::format("Failed to download pack {}: {}", packId, packResult.error()));
+        }
+        std::ifstream pack(packFile, std::ios::binary);
+        for (const auto& placement : placements) {
+            buffer.resize(placement.length);
+            pack.seekg(static_cast<std::streamoff>(placement.packOffset));
+            pack.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            Sha256 chunkDigest;
+            chunkDigest.update(std::span<const char>(buffer.data(), static_cast<size_t>(pack.gcount())));
+            if (!pack || chunkDigest.hexDigest() != placement.id) {
+                pack.close();
+                fs::remove(packFile, ec);
+                return fail(std::format("Chunk {} in pack {} is missing or damaged", placement.id, packId));
+            }
+            output.seekp(static_cast<std::streamoff>(placement.outputOffset));
+            output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        }
+        pack.close();
+        fs::remove(packFile, ec);
+        if (!output) {
+            return fail(std::format("Failed to write {}", partFile));
+        }
+    }
+
+    output.flush();
+    output.seekg(0);
+    Sha256 artifactDigest;
+    buffer.resize(kReadBlockSize);
+    while (output.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || output.gcount() > 0) {
+        artifactDigest.update(std::span<const char>(buffer.data(), static_cast<size_t>(output.gcount())));
+    }
+    output.close();
+    if (artifactDigest.hexDigest() != (*manifest)["sha256"].asString()) {
+        return fail(std::format("Reassembled {} does not match its snapshot digest", remotePath));
+    }
+    fs::rename(partFile, localFile, ec);
+    if (ec) {
+        return fail(std::format("Failed to move {} into place: {}", partFile, ec.message()));
+    }
+    std::cout << std::format("Repository restore of {}: {} chunk(s) from {} pack(s), {} bytes", artifactName,
+                             (*manifest)["chunks"].size(), byPack.size(), size) << std::endl;
+    return {};
+}
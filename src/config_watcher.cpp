@@ -0,0 +1,105 @@
+/**
+ * @file config_watcher.cpp
+ * @brief Notices changes of the configuration file while the daemon runs.
+ */
+
+#include "config_watcher.hpp"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <format>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+ConfigWatcher::ConfigWatcher(std::string path, std::function<void()> onChange)
+    : path_(std::move(path)), onChange_(std::move(onChange)) {}
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+#ifdef __linux__
+
+std::expected<void, std::string> ConfigWatcher::start() {
+    const fs::path file = fs::absolute(path_);
+    fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0) {
+        return std::unexpected(std::format("inotify_init1: {}", std::strerror(errno)));
+    }
+    // Watching the directory also covers the file being replaced by a rename.
+    if (::inotify_add_watch(fd_, file.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR) < 0) {
+        const std::string error = std::format("Cannot watch {}: {}", file.parent_path().string(), std::strerror(errno));
+        ::close(fd_);
+        fd_ = -1;
+        return std::unexpected(error);
+    }
+    stopFd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    reader_ = std::thread([this]() { readLoop(); });
+    return {};
+}
+
+void ConfigWatcher::stop() {
+    if (reader_.joinable()) {
+        const uint64_t one = 1;
+        [[maybe_unused]] const auto written = ::write(stopFd_, &one, sizeof(one));
+        reader_.join();
+    }
+    for (int* fd : {&fd_, &stopFd_}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void ConfigWatcher::readLoop() {
+    const std::string name = fs::path(path_).filename().string();
+    pollfd fds[2] = {{fd_, POLLIN, 0}, {stopFd_, POLLIN, 0}};
+    bool changed = false;
+    while (true) {
+        // With a change seen, wait only until the file has been quiet for the settle time.
+        const int ready = ::poll(fds, 2, changed ? static_cast<int>(settle_.count()) : -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        if (ready == 0) {
+            changed = false;
+            onChange_();
+            continue;
+        }
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = ::read(fd_, buffer, sizeof(buffer))) > 0) {
+            for (ssize_t offset = 0; offset < length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+                if ((event->mask & IN_Q_OVERFLOW) || (event->len > 0 && name == event->name)) {
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+#else
+
+std::expected<void, std::string> ConfigWatcher::start() {
+    return std::unexpected("Watching the configuration file needs Linux (inotify)");
+}
+
+void ConfigWatcher::stop() {}
+
+#endif
@@ -0,0 +1,65 @@
+/**
+ * @file content_chunker.cpp
+ * @brief FastCDC-style content-defined chunking for the chunk repository.
+ */
+
+#include "content_chunker.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+
+namespace {
+
+const std::array<uint64_t, 256>& gearTable() {
+    static const std::array<uint64_t, 256> table = [] {
+        std::array<uint64_t, 256> values{};
+        uint64_t seed = 0;
+        for (auto& value : values) {
+            // splitmix64: a fixed table keeps chunk boundaries stable across runs and hosts.
+            seed += 0x9e3779b97f4a7c15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            value = z ^ (z >> 31);
+        }
+        return values;
+    }();
+    return table;
+}
+
+uint64_t highBitMask(int bits) {
+    return bits <= 0 ? 0 : (~0ULL) << (64 - bits);
+}
+
+} // namespace
+
+Chunker::Chunker(size_t averageSize)
+    : minSize_(averageSize / 4), averageSize_(averageSize), maxSize_(averageSize * 4) {
+    const int bits = static_cast<int>(std::bit_width(averageSize)) - 1;
+    strictMask_ = highBitMask(bits + 2);
+    looseMask_ = highBitMask(bits - 2);
+}
+
+size_t Chunker::cut(const uint8_t* data, size_t size) const {
+    if (size <= minSize_) {
+        return size;
+    }
+    const size_t limit = std::min(size, maxSize_);
+    const size_t normal = std::min(limit, averageSize_);
+    const auto& gear = gearTable();
+    uint64_t hash = 0;
+    size_t i = minSize_;
+    for (; i < normal; ++i) {
+        hash = (hash << 1) + gear[data[i]];
+        if ((hash & strictMask_) == 0) {
+            return i + 1;
+        }
+    }
+    for (; i < limit; ++i) {
+        hash = (hash << 1) + gear[data[i]];
+        if ((hash & looseMask_) == 0) {
+            return i + 1;
+        }
+    }
+    return limit;
+}
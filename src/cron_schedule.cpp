@@ -0,0 +1,300 @@
+/**
+ * @file cron_schedule.cpp
+ * @brief Cron expressions evaluated in local time.
+ */
+
+#include "cron_schedule.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <ctime>
+#include <format>
+#include <limits>
+#include <sstream>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr std::array<std::string_view, 12> kMonthNames = {"jan", "feb", "mar", "apr", "may", "jun",
+                                                          "jul", "aug", "sep", "oct", "nov", "dec"};
+constexpr std::array<std::string_view, 7> kWeekdayNames = {"sun", "mon", "tue", "wed", "thu", "fri", "sat"};
+
+std::tm toLocal(std::time_t time) {
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &time);
+#else
+    localtime_r(&time, &local);
+#endif
+    return local;
+}
+
+/**
+ * @brief Returns the wall-clock reading of a broken-down local time, counted on a calendar without
+ *        daylight-saving transitions.
+ */
+std::chrono::sys_seconds wallClock(const std::tm& local) {
+    const std::chrono::year_month_day date{std::chrono::year{local.tm_year + 1900},
+                                           std::chrono::month{static_cast<unsigned>(local.tm_mon + 1)},
+                                           std::chrono::day{static_cast<unsigned>(local.tm_mday)}};
+    return std::chrono::sys_days{date} + std::chrono::hours{local.tm_hour} + std::chrono::minutes{local.tm_min} +
+           std::chrono::seconds{local.tm_sec};
+}
+
+/**
+ * @brief Returns the earliest instant whose local wall clock reads a given time.
+ *
+ * A reading skipped when clocks go forward maps to the first instant after the gap; a reading
+ * repeated when clocks go back maps to its first occurrence.
+ */
+std::time_t toInstant(std::chrono::sys_seconds wall) {
+    const auto day = std::chrono::floor<std::chrono::days>(wall);
+    const std::chrono::year_month_day date{day};
+    const std::chrono::hh_mm_ss clock{wall - day};
+    std::tm fields{};
+    fields.tm_year = static_cast<int>(date.year()) - 1900;
+    fields.tm_mon = static_cast<int>(static_cast<unsigned>(date.month())) - 1;
+    fields.tm_mday = static_cast<int>(static_cast<unsigned>(date.day()));
+    fields.tm_hour = static_cast<int>(clock.hours().count());
+    fields.tm_min = static_cast<int>(clock.minutes().count());
+    fields.tm_sec = static_cast<int>(clock.seconds().count());
+
+    // Interpreting the reading as standard and as daylight time yields every instant showing it.
+    std::time_t earliest = std::numeric_limits<std::time_t>::max();
+    std::time_t low = std::numeric_limits<std::time_t>::max();
+    std::time_t high = std::numeric_limits<std::time_t>::min();
+    for (const int isDst : {0, 1}) {
+        std::tm local = fields;
+        local.tm_isdst = isDst;
+        const std::time_t time = std::mktime(&local);
+        if (time == static_cast<std::time_t>(-1)) {
+            continue;
+        }
+        if (wallClock(toLocal(time)) == wall) {
+            earliest = std::min(earliest, time);
+        }
+        low = std::min(low, time);
+        high = std::max(high, time);
+    }
+    if (earliest != std::numeric_limits<std::time_t>::max() || low > high) {
+        return earliest;
+    }
+
+    // The reading falls in a gap: find the transition, the first instant whose clock reads later.
+    for (int hours = 0; hours < 48 && wallClock(toLocal(low)) > wall; ++hours) {
+        low -= 3600;
+    }
+    for (int hours = 0; hours < 48 && wallClock(toLocal(high)) <= wall; ++hours) {
+        high += 3600;
+    }
+    while (low + 1 < high) {
+        const std::time_t middle = low + (high - low) / 2;
+        if (wallClock(toLocal(middle)) > wall) {
+            high = middle;
+        } else {
+            low = middle;
+        }
+    }
+    return high;
+}
+
+/**
+ * @brief Parses one value of a field: a number or, where names are given, a name.
+ */
+std::expected<int, std::string> parseValue(std::string_view text, int nameBase, const std::string_view* names, size_t nameCount) {
+    int value = 0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec == std::errc() && end == text.data() + text.size()) {
+        return value;
+    }
+    std::string lower(text);
+    std::ranges::transform(lower, lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    for (size_t i = 0; i < nameCount; ++i) {
+        if (lower == names[i]) {
+            return nameBase + static_cast<int>(i);
+        }
+    }
+    return std::unexpected(std::format("invalid value '{}'", text));
+}
+
+/**
+ * @brief Parses a field into the set of matching values in [low, high].
+ */
+std::expected<std::vector<bool>, std::string> parseField(std::string_view field, int low, int high, int nameBase = 0,
+                                                        const std::string_view* names = nullptr, size_t nameCount = 0) {
+    std::vector<bool> matches(static_cast<size_t>(high) + 1, false);
+    while (!field.empty()) {
+        const size_t comma = field.find(',');
+        std::string_view item = field.substr(0, comma);
+        field = comma == std::string_view::npos ? std::string_view() : field.substr(comma + 1);
+
+        int step = 1;
+        if (const size_t slash = item.find('/'); slash != std::string_view::npos) {
+            auto parsed = parseValue(item.substr(slash + 1), 0, nullptr, 0);
+            if (!parsed || *parsed < 1) {
+                return std::unexpected(std::format("invalid step in '{}'", item));
+            }
+            step = *parsed;
+            item = item.substr(0, slash);
+        }
+        int first = low;
+        int last = high;
+        if (item != "*" && item != "?") {
+            const size_t dash = item.find('-', 1);
+            auto from = parseValue(item.substr(0, dash), nameBase, names, nameCount);
+            if (!from) {
+                return std::unexpected(from.error());
+            }
+            first = *from;
+            last = *from;
+            if (dash != std::string_view::npos) {
+                auto to = parseValue(item.substr(dash + 1), nameBase, names, nameCount);
+                if (!to) {
+                    return std::unexpected(to.error());
+                }
+                last = *to;
+            } else if (step > 1) {
+                // "5/15" means every 15 starting at 5, as in most cron implementations.
+                last = high;
+            }
+        }
+        if (first < low || last > high || first > last) {
+            return std::unexpected(std::format("'{}' is outside {}-{}", item, low, high));
+        }
+        for (int value = first; value <= last; value += step) {
+            matches[static_cast<size_t>(value)] = true;
+        }
+    }
+    return matches;
+}
+
+template <size_t N>
+std::bitset<N> toBits(const std::vector<bool>& values) {
+    std::bitset<N> bits;
+    for (size_t i = 0; i < N && i < values.size(); ++i) {
+        bits[i] = values[i];
+    }
+    return bits;
+}
+
+} // namespace
+
+std::expected<CronSchedule, std::string> CronSchedule::parse(const std::string& expression) {
+    std::string text = expression;
+    if (text == "@hourly") {
+        text = "0 * * * *";
+    } else if (text == "@daily" || text == "@midnight") {
+        text = "0 0 * * *";
+    } else if (text == "@weekly") {
+        text = "0 0 * * 0";
+    } else if (text == "@monthly") {
+        text = "0 0 1 * *";
+    } else if (text == "@yearly" || text == "@annually") {
+        text = "0 0 1 1 *";
+    }
+
+    std::vector<std::string> fields;
+    std::istringstream in(text);
+    for (std::string field; in >> field;) {
+        fields.push_back(field);
+    }
+    if (fields.size() == 5) {
+        fields.insert(fields.begin(), "0");
+    }
+    if (fields.size() != 6) {
+        return std::unexpected(std::format("Invalid cron expression '{}': expected 5 or 6 fields", expression));
+    }
+
+    CronSchedule schedule;
+    schedule.expression_ = expression;
+    auto fail = [&expression](const char* name, const std::string& error) {
+        return std::unexpected(std::format("Invalid cron expression '{}': {} field: {}", expression, name, error));
+    };
+    auto seconds = parseField(fields[0], 0, 59);
+    if (!seconds) {
+        return fail("seconds", seconds.error());
+    }
+    auto minutes = parseField(fields[1], 0, 59);
+    if (!minutes) {
+        return fail("minute", minutes.error());
+    }
+    auto hours = parseField(fields[2], 0, 23);
+    if (!hours) {
+        return fail("hour", hours.error());
+    }
+    auto days = parseField(fields[3], 1, 31);
+    if (!days) {
+        return fail("day-of-month", days.error());
+    }
+    auto months = parseField(fields[4], 1, 12, 1, kMonthNames.data(), kMonthNames.size());
+    if (!months) {
+        return fail("month", months.error());
+    }
+    auto weekdays = parseField(fields[5], 0, 7, 0, kWeekdayNames.data(), kWeekdayNames.size());
+    if (!weekdays) {
+        return fail("day-of-week", weekdays.error());
+    }
+    if ((*weekdays)[7]) {
+        (*weekdays)[0] = true;
+    }
+    schedule.seconds_ = toBits<60>(*seconds);
+    schedule.minutes_ = toBits<60>(*minutes);
+    schedule.hours_ = toBits<24>(*hours);
+    schedule.days_ = toBits<32>(*days);
+    schedule.months_ = toBits<13>(*months);
+    schedule.weekdays_ = toBits<7>(*weekdays);
+    // As in Vixie cron, a field starting with `*` (including `*/2`) leaves the other one in charge.
+    schedule.anyDay_ = fields[3].starts_with('*') || fields[3].starts_with('?');
+    schedule.anyWeekday_ = fields[5].starts_with('*') || fields[5].starts_with('?');
+    return schedule;
+}
+
+std::chrono::system_clock::time_point CronSchedule::next(std::chrono::system_clock::time_point after) const {
+    // Search wall-clock readings, then map the match to an instant, so a reading skipped when
+    // clocks go forward still runs and a repeated one runs once.
+    const std::time_t afterTime = std::chrono::system_clock::to_time_t(after);
+    std::chrono::sys_seconds wall = wallClock(toLocal(afterTime)) + std::chrono::seconds{1};
+    const std::chrono::year lastYear =
+        std::chrono::year_month_day{std::chrono::floor<std::chrono::days>(wall)}.year() + std::chrono::years{5};
+    // Advance the coarsest field that does not match, resetting the finer ones.
+    while (true) {
+        const auto day = std::chrono::floor<std::chrono::days>(wall);
+        const std::chrono::year_month_day date{day};
+        if (date.year() > lastYear) {
+            break;
+        }
+        const std::chrono::hh_mm_ss clock{wall - day};
+        if (!months_[static_cast<unsigned>(date.month())]) {
+            wall = std::chrono::sys_days{(date.year() / date.month() + std::chrono::months{1}) / 1};
+            continue;
+        }
+        const bool dayMatches = days_[static_cast<unsigned>(date.day())];
+        const bool weekdayMatches = weekdays_[std::chrono::weekday{day}.c_encoding()];
+        const bool dayRuns = anyDay_ ? weekdayMatches : anyWeekday_ ? dayMatches : dayMatches || weekdayMatches;
+        if (!dayRuns) {
+            wall = day + std::chrono::days{1};
+            continue;
+        }
+        if (!hours_[static_cast<size_t>(clock.hours().count())]) {
+            wall = day + clock.hours() + std::chrono::hours{1};
+            continue;
+        }
+        if (!minutes_[static_cast<size_t>(clock.minutes().count())]) {
+            wall = day + clock.hours() + clock.minutes() + std::chrono::minutes{1};
+            continue;
+        }
+        if (!seconds_[static_cast<size_t>(clock.seconds().count())]) {
+            wall += std::chrono::seconds{1};
+            continue;
+        }
+        const std::time_t time = toInstant(wall);
+        if (time > afterTime) {
+            return std::chrono::system_clock::from_time_t(time);
+        }
+        // The reading repeats after clocks went back and its first occurrence already passed.
+        wall += std::chrono::seconds{1};
+    }
+    return std::chrono::system_clock::time_point::max();
+}
@@ -1,4 +1,5 @@
 #include "backup.hpp"
+#include "load_monitor.hpp"
 #include <iostream>
 #include <fstream>
 #include <chrono>
@@ -221,7 +222,8 @@ std::expected<void, std::string> runCommandWithRedirect(
 
 std::expected<std::string, std::string> compressSqlDump(const std::string& label,
                                                         const fs::path& tempSqlPath,
-                                                        const std::string& outputPath) {
+                                                        const std::string& outputPath,
+                                                        LoadMonitor* loadMonitor) {
     std::ifstream inFile(tempSqlPath, std::ios::binary);
     if (!inFile.is_open()) {
         return std::unexpected(std::format("Failed to open temporary SQL dump for {}", label));
@@ -234,12 +236,21 @@ std::expected<std::string, std::string> compressSqlDump(const std::string& label
     }
 
     char buf[8192];
+    int level = Z_DEFAULT_COMPRESSION;
     while (inFile) {
         inFile.read(buf, sizeof(buf));
         const std::streamsize bytesRead = inFile.gcount();
         if (bytesRead <= 0) {
             continue;
         }
+        if (loadMonitor) {
+            // Under high load the dump is compressed more cheaply and read at a limited rate.
+            const int wanted = loadMonitor->compressionLevel(Z_DEFAULT_COMPRESSION);
+            if (wanted != level && gzsetparams(outFile, wanted, Z_DEFAULT_STRATEGY) == Z_OK) {
+                level = wanted;
+            }
+            loadMonitor->pace(static_cast<uint64_t>(bytesRead));
+        }
 
         const int written = gzwrite(outFile, buf, static_cast<unsigned int>(bytesRead));
         if (written == 0 || written != bytesRead) {
@@ -321,7 +332,7 @@ std::expected<std::string, std::string> MySQLBackupStrategy::execute(const std::
     }
 
     std::cout << "\nCompressing database backup..." << std::endl;
-    auto compressed = compressSqlDump("MySQL", tempSqlPath, outputPath);
+    auto compressed = compressSqlDump("MySQL", tempSqlPath, outputPath, loadMonitor_);
     if (!compressed) {
         return std::unexpected(compressed.error());
     }
@@ -391,7 +402,7 @@ std::expected<std::string, std::string> PostgreSQLBackupStrategy::execute(const
     }
 
     std::cout << "\nCompressing database backup..." << std::endl;
-    auto compressed = compressSqlDump("PostgreSQL", tempSqlPath, outputPath);
+    auto compressed = compressSqlDump("PostgreSQL", tempSqlPath, outputPath, loadMonitor_);
     if (!compressed) {
         return std::unexpected(compressed.error());
     }
@@ -0,0 +1,168 @@
+/**
+ * @file digest.cpp
+ * @brief SHA-256 implementation (FIPS 180-4) for SecureVault integrity checks.
+ */
+
+#include "digest.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr std::array<uint32_t, 64> kRoundConstants = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+constexpr uint32_t rotr(uint32_t value, int bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+} // namespace
+
+Sha256::Sha256()
+    : state_{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19},
+      buffer_{} {}
+
+void Sha256::update(std::span<const char> data) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(data.data());
+    size_t remaining = data.size();
+    totalBytes_ += remaining;
+
+    if (bufferSize_ > 0) {
+        const size_t take = std::min(remaining, buffer_.size() - bufferSize_);
+        std::memcpy(buffer_.data() + bufferSize_, bytes, take);
+        bufferSize_ += take;
+        bytes += take;
+        remaining -= take;
+        if (bufferSize_ < buffer_.size()) {
+            return;
+        }
+        processBlock(buffer_.data());
+        bufferSize_ = 0;
+    }
+
+    while (remaining >= buffer_.size()) {
+        processBlock(bytes);
+        bytes += buffer_.size();
+        remaining -= buffer_.size();
+    }
+
+    if (remaining > 0) {
+        std::memcpy(buffer_.data(), bytes, remaining);
+        bufferSize_ = remaining;
+    }
+}
+
+std::array<uint8_t, 32> Sha256::digest() {
+    const uint64_t bitLength = totalBytes_ * 8;
+
+    buffer_[bufferSize_++] = 0x80;
+    if (bufferSize_ > 56) {
+        std::memset(buffer_.data() + bufferSize_, 0, buffer_.size() - bufferSize_);
+        processBlock(buffer_.data());
+        bufferSize_ = 0;
+    }
+    std::memset(buffer_.data() + bufferSize_, 0, 56 - bufferSize_);
+    for (int i = 0; i < 8; ++i) {
+        buffer_[63 - i] = static_cast<uint8_t>(bitLength >> (8 * i));
+    }
+    processBlock(buffer_.data());
+    bufferSize_ = 0;
+
+    std::array<uint8_t, 32> out{};
+    for (size_t i = 0; i < state_.size(); ++i) {
+        out[i * 4] = static_cast<uint8_t>(state_[i] >> 24);
+        out[i * 4 + 1] = static_cast<uint8_t>(state_[i] >> 16);
+        out[i * 4 + 2] = static_cast<uint8_t>(state_[i] >> 8);
+        out[i * 4 + 3] = static_cast<uint8_t>(state_[i]);
+    }
+    return out;
+}
+
+std::string Sha256::hexDigest() {
+    const auto bytes = digest();
+    return toHex(bytes);
+}
+
+std::string Sha256::toHex(std::span<const uint8_t> bytes) {
+    static constexpr char kHexDigits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(bytes.size() * 2);
+    for (uint8_t byte : bytes) {
+        hex.push_back(kHexDigits[byte >> 4]);
+        hex.push_back(kHexDigits[byte & 0x0f]);
+    }
+    return hex;
+}
+
+std::array<uint8_t, 32> Sha256::fromHex(std::string_view hex) {
+    std::array<uint8_t, 32> bytes{};
+    if (hex.size() != bytes.size() * 2) {
+        return bytes;
+    }
+    auto nibble = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        const int high = nibble(hex[i * 2]);
+        const int low = nibble(hex[i * 2 + 1]);
+        if (high < 0 || low < 0) {
+            return {};
+        }
+        bytes[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+    return bytes;
+}
+
+void Sha256::processBlock(const uint8_t* block) {
+    std::array<uint32_t, 64> w{};
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (static_cast<uint32_t>(block[i * 4]) << 24) |
+               (static_cast<uint32_t>(block[i * 4 + 1]) << 16) |
+               (static_cast<uint32_t>(block[i * 4 + 2]) << 8) |
+               static_cast<uint32_t>(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; ++i) {
+        const uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3];
+    uint32_t e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+    for (int i = 0; i < 64; ++i) {
+        const uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+        const uint32_t ch = (e & f) ^ (~e & g);
+        const uint32_t temp1 = h + s1 + ch + kRoundConstants[i] + w[i];
+        const uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+        const uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+        const uint32_t temp2 = s0 + maj;
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = c;
+        c = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+    state_[4] += e;
+    state_[5] += f;
+    state_[6] += g;
+    state_[7] += h;
+}
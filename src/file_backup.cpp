@@ -7,10 +7,21 @@
  */
 
 #include "file_backup.hpp"
+#include "archive_index.hpp"
+#include "catalog.hpp"
+#include "change_journal.hpp"
+#include "digest.hpp"
+#include "frame_archive.hpp"
+#include "load_monitor.hpp"
+#include "file_util.hpp"
 #include <filesystem>
 #include <archive.h>
 #include <archive_entry.h>
 #include <fstream>
+#include <algorithm>
+#include <map>
+#include <unordered_set>
+#include <optional>
 #include <chrono>
 #include <format>
 #include <thread>
@@ -33,32 +44,109 @@ extern volatile std::sig_atomic_t gShutdownFlag;
  *
  * @param excludeExtensions Extensions to exclude.
  * @param lastBackupFile Path to last backup timestamp file.
+ * @param frameSize Uncompressed bytes per gzip frame (0 writes a single gzip stream).
+ * @param levelsFile Path to the per-level reference time file.
  */
-TarGzFileBackupStrategy::TarGzFileBackupStrategy(const std::vector<std::string>& excludeExtensions, const std::string& lastBackupFile)
-    : excludeExtensions(excludeExtensions), lastBackupFile(lastBackupFile) {}
+TarGzFileBackupStrategy::TarGzFileBackupStrategy(const std::vector<std::string>& excludeExtensions, const std::string& lastBackupFile,
+                                                 uint64_t frameSize, const std::string& levelsFile)
+    : excludeExtensions(excludeExtensions), lastBackupFile(lastBackupFile), frameSize(frameSize), levelsFile(levelsFile) {}
+
+TarGzFileBackupStrategy::~TarGzFileBackupStrategy() = default;
+
+namespace {
 
 /**
- * @brief Counts files to back up.
+ * @brief Reads the levels file: one "<level> <epoch seconds>" line per level.
+ */
+std::map<int, int64_t> readLevels(const std::string& levelsFile) {
+    std::map<int, int64_t> levels;
+    std::ifstream file(levelsFile);
+    int level;
+    int64_t started;
+    while (file >> level >> started) {
+        levels[level] = started;
+    }
+    return levels;
+}
+
+} // namespace
+
+/**
+ * @brief Returns the time after which a file counts as changed for a backup level.
  *
- * @param sourceDirs Directories to scan.
- * @param fullBackup If true, ignores last backup time.
- * @return size_t Number of files to process.
+ * Level N compares against the most recent backup of any level below N, as dump(8) does; with
+ * no such backup it backs up everything.
+ *
+ * @param level Dump level or kSinceLastRun.
+ * @return std::chrono::system_clock::time_point Reference time.
  */
-size_t TarGzFileBackupStrategy::countFiles(const std::vector<std::string>& sourceDirs, bool fullBackup) {
-    size_t count = 0;
-    std::chrono::system_clock::time_point lastBackupTime = std::chrono::system_clock::time_point();
+std::chrono::system_clock::time_point TarGzFileBackupStrategy::referenceTime(int level) const {
+    using Clock = std::chrono::system_clock;
+    if (level == 0) {
+        return Clock::time_point::min();
+    }
+    if (level > 0 && !levelsFile.empty()) {
+        std::optional<int64_t> reference;
+        for (const auto& [recorded, started] : readLevels(levelsFile)) {
+            if (recorded < level && (!reference || started > *reference)) {
+                reference = started;
+            }
+        }
+        if (!reference) {
+            std::println(stderr, "Warning: No backup below level {} is recorded in {}; backing up everything.", level, levelsFile);
+            return Clock::time_point::min();
+        }
+        return Clock::from_time_t(static_cast<std::time_t>(*reference));
+    }
 
-    if (!fullBackup && fs::exists(lastBackupFile)) {
+    Clock::time_point lastBackupTime = Clock::time_point::min();
+    if (fs::exists(lastBackupFile)) {
         std::ifstream file(lastBackupFile);
         std::string timestamp;
         if (std::getline(file, timestamp) && !timestamp.empty()) {
             try {
-                lastBackupTime = std::chrono::system_clock::from_time_t(std::stol(timestamp));
+                lastBackupTime = Clock::from_time_t(std::stol(timestamp));
             } catch (const std::exception& e) {
                 std::println(stderr, "Warning: Invalid timestamp in {}: {}. Using default time (full backup).", lastBackupFile, e.what());
             }
         }
     }
+    return lastBackupTime;
+}
+
+/**
+ * @brief Records the start time of a completed backup as its level's reference.
+ *
+ * @param level Dump level.
+ * @param started Start time of the backup.
+ */
+void TarGzFileBackupStrategy::recordLevel(int level, std::chrono::system_clock::time_point started) const {
+    if (level < 0 || levelsFile.empty()) {
+        return;
+    }
+    auto levels = readLevels(levelsFile);
+    levels[level] = static_cast<int64_t>(std::chrono::system_clock::to_time_t(started));
+    std::string contents;
+    for (const auto& [recorded, time] : levels) {
+        contents += std::format("{} {}\n", recorded, time);
+    }
+    auto result = writeFileAtomically(levelsFile, contents);
+    if (!result) {
+        std::println(stderr, "Warning: Failed to record backup level {}: {}", level, result.error());
+    }
+}
+
+/**
+ * @brief Counts files to back up.
+ *
+ * @param sourceDirs Directories to scan.
+ * @param since Files modified after this time are backed up.
+ * @param manifest Receives the files skipped as unchanged (may be null).
+ * @return size_t Number of files to process.
+ */
+size_t TarGzFileBackupStrategy::countFiles(const std::vector<std::string>& sourceDirs, std::chrono::system_clock::time_point since,
+                                           FileManifest* manifest) {
+    size_t count = 0;
 
     auto isExcluded = [this](const std::string& ext) {
         return !ext.empty() && std::ranges::find(excludeExtensions, ext) != excludeExtensions.end();
@@ -77,8 +165,17 @@ size_t TarGzFileBackupStrategy::countFiles(const std::vector<std::string>& sourc
                     if (isExcluded(ext)) continue;
                     auto lastWrite = fs::last_write_time(*it);
                     auto fileTime = std::chrono::system_clock::now() - (std::chrono::system_clock::now() - std::chrono::file_clock::to_sys(lastWrite));
-                    if (fullBackup || fileTime > lastBackupTime) {
+                    if (fileTime > since) {
                         ++count;
+                    } else if (manifest) {
+                        // Unchanged files are part of this run's state even though they are not archived.
+                        ManifestEntry entry;
+                        entry.sourcePath = fs::absolute(it->path()).lexically_normal().generic_string();
+                        entry.archivePath = (fs::path(dir).filename() / fs::relative(it->path(), dir)).lexically_normal().generic_string();
+                        entry.size = it->file_size();
+                        entry.mtime = std::chrono::duration_cast<std::chrono::seconds>(
+                            std::chrono::file_clock::to_sys(lastWrite).time_since_epoch()).count();
+                        manifest->add(std::move(entry));
                     }
                 }
             }
@@ -89,25 +186,166 @@ size_t TarGzFileBackupStrategy::countFiles(const std::vector<std::string>& sourc
     return count;
 }
 
+/**
+ * @brief Lists the files to back up from the change journal instead of walking the directories.
+ *
+ * Every changed path that is not below another changed path is looked at: a directory is walked,
+ * a file is checked. Files of the previous run's list that lie below no changed path are carried
+ * over unchanged without touching the disk.
+ *
+ * @param sourceDirs Directories to back up.
+ * @param since Files modified after this time are backed up.
+ * @param manifest Receives the files skipped as unchanged.
+ * @return Files to archive for each source directory, or nothing if the journal cannot tell.
+ */
+std::optional<std::vector<std::vector<fs::path>>> TarGzFileBackupStrategy::journalCandidates(
+    const std::vector<std::string>& sourceDirs, std::chrono::system_clock::time_point since, FileManifest* manifest) {
+    if (!changeJournal_ || since == std::chrono::system_clock::time_point::min() ||
+        lastStateStarted == std::chrono::system_clock::time_point{}) {
+        return std::nullopt;
+    }
+    // Carried-over files are as the previous run saw them, so changes since its start count too.
+    auto changed = changeJournal_->changedSince(std::min(since, lastStateStarted));
+    if (!changed) {
+        return std::nullopt;
+    }
+
+    auto isBelow = [](const std::string& path, const std::string& dir) {
+        return path.size() >= dir.size() && path.compare(0, dir.size(), dir) == 0 &&
+               (path.size() == dir.size() || path[dir.size()] == '/' || dir.ends_with('/'));
+    };
+    auto isExcluded = [this](const std::string& ext) {
+        return !ext.empty() && std::ranges::find(excludeExtensions, ext) != excludeExtensions.end();
+    };
+
+    // The journal reports resolved paths; the file list uses the directories as configured.
+    struct Root {
+        std::string absolute;
+        std::string real;
+    };
+    std::vector<Root> roots;
+    for (const auto& dir : sourceDirs) {
+        std::error_code ec;
+        const fs::path real = fs::canonical(dir, ec);
+        if (ec) {
+            roots.push_back({});
+            continue;
+        }
+        roots.push_back({fs::absolute(dir).lexically_normal().generic_string(), real.generic_string()});
+        if (roots.back().absolute.size() > 1 && roots.back().absolute.ends_with('/')) {
+            roots.back().absolute.pop_back();
+        }
+    }
+
+    const std::unordered_set<std::string> changedSet(changed->begin(), changed->end());
+    // Whether a path or one of its parents up to the root changed.
+    auto isCovered = [&changedSet](const std::string& path, const std::string& root) {
+        for (fs::path current(path);; current = current.parent_path()) {
+            const std::string text = current.generic_string();
+            if (changedSet.contains(text)) {
+                return true;
+            }
+            if (text.size() <= root.size() || !current.has_relative_path()) {
+                return false;
+            }
+        }
+    };
+
+    std::vector<std::vector<fs::path>> candidates(sourceDirs.size());
+    auto consider = [&](size_t index, const fs::directory_entry& entry) {
+        std::error_code ec;
+        if (!entry.is_regular_file(ec) || isExcluded(entry.path().extension().string())) {
+            return;
+        }
+        const auto lastWrite = entry.last_write_time(ec);
+        if (ec) {
+            return;
+        }
+        if (std::chrono::file_clock::to_sys(lastWrite) > since) {
+            candidates[index].push_back(entry.path());
+        } else if (manifest) {
+            ManifestEntry unchanged;
+            unchanged.sourcePath = fs::absolute(entry.path()).lexically_normal().generic_string();
+            unchanged.archivePath =
+                (fs::path(sourceDirs[index]).filename() / fs::relative(entry.path(), sourceDirs[index], ec)).lexically_normal().generic_string();
+            unchanged.size = entry.file_size(ec);
+            unchanged.mtime = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::file_clock::to_sys(lastWrite).time_since_epoch()).count();
+            manifest->add(std::move(unchanged));
+        }
+    };
+
+    for (const auto& path : *changed) {
+        for (size_t i = 0; i < roots.size(); ++i) {
+            const Root& root = roots[i];
+            if (root.real.empty() || !isBelow(path, root.real)) {
+                continue;
+            }
+            // Paths below another changed path are handled with it.
+            if (path.size() > root.real.size() && isCovered(fs::path(path).parent_path().generic_string(), root.real)) {
+                break;
+            }
+            const fs::path local = fs::path(sourceDirs[i]) / fs::path(path).lexically_relative(root.real);
+            std::error_code ec;
+            if (fs::is_directory(fs::symlink_status(local, ec))) {
+                for (auto it = fs::recursive_directory_iterator(local, fs::directory_options::skip_permission_denied, ec);
+                     !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+                    consider(i, *it);
+                }
+            } else {
+                fs::directory_entry entry(local, ec);
+                if (!ec) {
+                    consider(i, entry);
+                }
+            }
+            break;
+        }
+    }
+
+    if (manifest) {
+        for (const auto& previous : lastState) {
+            for (size_t i = 0; i < roots.size(); ++i) {
+                const Root& root = roots[i];
+                if (root.real.empty() || !isBelow(previous.sourcePath, root.absolute)) {
+                    continue;
+                }
+                const std::string real = root.real + previous.sourcePath.substr(root.absolute.size());
+                if (!isCovered(real, root.real) && !isExcluded(fs::path(previous.sourcePath).extension().string())) {
+                    manifest->add(previous);
+                }
+                break;
+            }
+        }
+    }
+    return candidates;
+}
+
 /**
  * @brief Backs up a directory in a thread.
  *
  * @param dir Directory to back up.
  * @param outputFile Output .tar.gz file path (unused, kept for interface).
- * @param fullBackup If true, full backup.
+ * @param since Files modified after this time are backed up.
  * @param archive Shared archive object.
  * @param processedFiles Processed file counter.
  * @param totalFiles Total files for progress.
  * @param mutex Thread-safe archive mutex.
+ * @param writeFailed Shared error flag for archive write failures.
+ * @param frames Frame writer of a framed archive, or null.
+ * @param manifest Receives the archived files.
+ * @param files Files of the directory to consider instead of walking it (may be null).
  */
 void TarGzFileBackupStrategy::backupDirectory(const std::string& dir,
                                               [[maybe_unused]] const std::string& outputFile,
-                                              bool fullBackup,
+                                              std::chrono::system_clock::time_point since,
                                               struct archive* archive,
                                               std::atomic<size_t>& processedFiles,
                                               size_t totalFiles,
                                               std::mutex& mutex,
-                                              std::atomic<bool>& writeFailed) {
+                                              std::atomic<bool>& writeFailed,
+                                              FrameWriter* frames,
+                                              FileManifest* manifest,
+                                              const std::vector<fs::path>* files) {
     std::ofstream logFile("backup_files.log", std::ios::app);
     auto now = std::chrono::system_clock::now();
     auto timeT = std::chrono::system_clock::to_time_t(now);
@@ -120,65 +358,61 @@ void TarGzFileBackupStrategy::backupDirectory(const std::string& dir,
         return;
     }
 
-    std::chrono::system_clock::time_point lastBackupTime = std::chrono::system_clock::time_point();
-    if (!fullBackup && fs::exists(lastBackupFile)) {
-        std::ifstream file(lastBackupFile);
-        std::string timestamp;
-        if (std::getline(file, timestamp) && !timestamp.empty()) {
-            try {
-                lastBackupTime = std::chrono::system_clock::from_time_t(std::stol(timestamp));
-            } catch (const std::exception& e) {
-                logFile << std::format("[{}] Warning: Invalid timestamp in {}: {}\n", timeBuf, lastBackupFile, e.what());
-            }
-        }
-    }
-
     auto isExcluded = [this](const std::string& ext) {
         return !ext.empty() && std::ranges::find(excludeExtensions, ext) != excludeExtensions.end();
     };
 
     try {
-        for (auto it = fs::recursive_directory_iterator(dir, fs::directory_options::skip_permission_denied);
-             it != fs::recursive_directory_iterator(); ++it) {
+        // Returns false once the directory should not be processed any further.
+        auto backupFile = [&](const fs::directory_entry& entry) {
             if (writeFailed) {
-                break;
+                return false;
             }
 
             if (gShutdownFlag) {
                 logFile << std::format("[{}] Warning: Backup interrupted by signal, stopping directory processing: {}\n", timeBuf, dir);
                 std::cerr << "Warning: Backup interrupted by signal, stopping directory processing: " << dir << std::endl;
-                break;
+                return false;
             }
 
-            if (!it->is_regular_file()) continue;
+            if (!entry.is_regular_file()) return true;
 
-            std::string path = it->path().string();
-            auto ext = it->path().extension().string();
-            if (isExcluded(ext)) continue;
+            std::string path = entry.path().string();
+            auto ext = entry.path().extension().string();
+            if (isExcluded(ext)) return true;
 
-            auto lastWrite = fs::last_write_time(*it);
+            auto lastWrite = fs::last_write_time(entry);
             auto fileTime = std::chrono::system_clock::now() - (std::chrono::system_clock::now() - std::chrono::file_clock::to_sys(lastWrite));
-            if (!fullBackup && fileTime <= lastBackupTime) continue;
+            if (fileTime <= since) return true;
 
             std::error_code relEc;
-            fs::path relativePath = fs::relative(it->path(), dir, relEc);
+            fs::path relativePath = fs::relative(entry.path(), dir, relEc);
             if (relEc || relativePath.empty()) {
                 logFile << std::format("[{}] Warning: Failed to create relative path for {}, skipping.\n", timeBuf, path);
-                continue;
+                return true;
             }
 
             fs::path archivePath = (fs::path(dir).filename() / relativePath).lexically_normal();
             if (archivePath.is_absolute() ||
                 std::ranges::find(archivePath, fs::path("..")) != archivePath.end()) {
                 logFile << std::format("[{}] Warning: Unsafe archive path derived from {}, skipping.\n", timeBuf, path);
-                continue;
+                return true;
             }
 
             const std::string archivePathString = archivePath.generic_string();
 
+            ManifestEntry manifestEntry;
+            manifestEntry.sourcePath = fs::absolute(entry.path()).lexically_normal().generic_string();
+            manifestEntry.archivePath = archivePathString;
+            manifestEntry.size = entry.file_size();
+            manifestEntry.mtime = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::file_clock::to_sys(lastWrite).time_since_epoch()).count();
+            manifestEntry.stored = true;
+            Sha256 hasher;
+
             struct archive_entry* ae = archive_entry_new();
             archive_entry_set_pathname(ae, archivePathString.c_str());
-            archive_entry_set_size(ae, it->file_size());
+            archive_entry_set_size(ae, manifestEntry.size);
             archive_entry_set_filetype(ae, AE_IFREG);
             archive_entry_set_perm(ae, 0644);
 
@@ -187,7 +421,7 @@ void TarGzFileBackupStrategy::backupDirectory(const std::string& dir,
                 std::string errorMsg = std::format("Failed to open file: {} (error: {})", path, strerror(errno));
                 logFile << std::format("[{}] {}\n", timeBuf, errorMsg);
                 archive_entry_free(ae);
-                continue;
+                return true;
             }
 
             {
@@ -197,9 +431,17 @@ void TarGzFileBackupStrategy::backupDirectory(const std::string& dir,
                     file.close();
                     logFile << std::format("[{}] Warning: Backup interrupted by signal, stopping directory processing: {}\n", timeBuf, dir);
                     std::cerr << "Warning: Backup interrupted by signal, stopping directory processing: " << dir << std::endl;
-                    return;
+                    return false;
                 }
 
+                if (frames) {
+                    if (loadMonitor_) {
+                        frames->setCompressionLevel(loadMonitor_->compressionLevel(Z_DEFAULT_COMPRESSION));
+                    }
+                    frames->startEntry();
+                    manifestEntry.archiveOffset = frames->position();
+                    manifestEntry.frame = frames->frameNumber();
+                }
                 if (archive_write_header(archive, ae) != ARCHIVE_OK) {
                     logFile << std::format("[{}] Failed to write archive header for {} (error: {})\n",
                                            timeBuf,
@@ -208,7 +450,7 @@ void TarGzFileBackupStrategy::backupDirectory(const std::string& dir,
                     writeFailed = true;
                     archive_entry_free(ae);
                     file.close();
-                    break;
+                    return false;
                 }
 
                 char buf[8192];
@@ -218,6 +460,10 @@ void TarGzFileBackupStrategy::backupDirectory(const std::string& dir,
                     if (bytesRead <= 0) {
                         continue;
                     }
+                    hasher.update(std::span<const char>(buf, static_cast<size_t>(bytesRead)));
+                    if (loadMonitor_) {
+                        loadMonitor_->pace(static_cast<uint64_t>(bytesRead));
+                    }
 
                     std::streamsize totalWritten = 0;
                     while (totalWritten < bytesRead) {
@@ -244,24 +490,53 @@ void TarGzFileBackupStrategy::backupDirectory(const std::string& dir,
                     logFile << std::format("[{}] Failed while reading file: {}\n", timeBuf, path);
                     writeFailed = true;
                 }
+
+                // Writes the entry's block padding now, so it stays in the entry's frame.
+                if (!writeFailed && archive_write_finish_entry(archive) != ARCHIVE_OK) {
+                    logFile << std::format("[{}] Failed to finish archive entry for {} (error: {})\n",
+                                           timeBuf,
+                                           archivePathString,
+                                           archive_error_string(archive));
+                    writeFailed = true;
+                }
             }
             archive_entry_free(ae);
             file.close();
 
             if (writeFailed) {
-                break;
+                return false;
             }
+            manifestEntry.sha256 = hasher.digest();
+            manifest->add(std::move(manifestEntry));
 
             if (gShutdownFlag) {
                 logFile << std::format("[{}] Warning: Backup interrupted by signal, stopping directory processing: {}\n", timeBuf, dir);
                 std::cerr << "Warning: Backup interrupted by signal, stopping directory processing: " << dir << std::endl;
-                break;
+                return false;
             }
 
             processedFiles++;
             float progress = std::min(static_cast<float>(processedFiles) / totalFiles * 100, 100.0f);
             std::print("\rProgress: {:.2f}% ({}/{} files)", progress, processedFiles.load(), totalFiles);
             logFile << std::format("[{}] Backed up: {}\n", timeBuf, path);
+            return true;
+        };
+
+        if (files) {
+            for (const auto& file : *files) {
+                std::error_code entryEc;
+                fs::directory_entry entry(file, entryEc);
+                if (!entryEc && !backupFile(entry)) {
+                    break;
+                }
+            }
+        } else {
+            for (auto it = fs::recursive_directory_iterator(dir, fs::directory_options::skip_permission_denied);
+                 it != fs::recursive_directory_iterator(); ++it) {
+                if (!backupFile(*it)) {
+                    break;
+                }
+            }
         }
     } catch (const fs::filesystem_error& e) {
         logFile << std::format("[{}] Warning: Failed to access directory {}: {}, skipping.\n", timeBuf, dir, e.what());
@@ -274,14 +549,20 @@ void TarGzFileBackupStrategy::backupDirectory(const std::string& dir,
  *
  * @param sourceDirs Directories to back up.
  * @param outputFile Output .tar.gz file path.
- * @param fullBackup If true, full backup.
- * @return std::expected<void, std::string> Success or error.
+ * @param level Dump level (0 for a full backup) or kSinceLastRun.
+ * @param manifest Receives every file present in the source tree, or null.
+ * @return std::expected<std::chrono::system_clock::time_point, std::string> Start time or error.
  */
-std::expected<void, std::string> TarGzFileBackupStrategy::execute(const std::vector<std::string>& sourceDirs,
-                                                                  const std::string& outputFile,
-                                                                  bool fullBackup) {
+std::expected<std::chrono::system_clock::time_point, std::string> TarGzFileBackupStrategy::execute(const std::vector<std::string>& sourceDirs,
+                                                                                                   const std::string& outputFile,
+                                                                                                   int level,
+                                                                                                   FileManifest* manifest) {
     std::ofstream logFile("backup_files.log", std::ios::app);
-    auto now = std::chrono::system_clock::now();
+    const auto started = std::chrono::system_clock::now();
+    pendingFinished.reset();
+    pendingState.reset();
+    const auto since = referenceTime(level);
+    auto now = started;
     auto timeT = std::chrono::system_clock::to_time_t(now);
     char timeBuf[32];
     std::strftime(timeBuf, sizeof(timeBuf), "%Y-%m-%d %H:%M:%S", std::localtime(&timeT));
@@ -291,33 +572,94 @@ std::expected<void, std::string> TarGzFileBackupStrategy::execute(const std::vec
     fs::create_directories(outputPath.parent_path());
     logFile << std::format("[{}] Created output directory: {}\n", timeBuf, outputPath.parent_path().string());
 
-    std::println("Counting files...");
-    size_t totalFiles = countFiles(sourceDirs, fullBackup);
+    // With a change journal, the unchanged files are also kept as the next run's file list.
+    FileManifest seen;
+    FileManifest* unchanged = changeJournal_ ? &seen : manifest;
+    auto rememberState = [&](const std::vector<ManifestEntry>& stored) {
+        if (!changeJournal_) {
+            return;
+        }
+        auto entries = seen.take();
+        if (manifest) {
+            for (const auto& entry : entries) {
+                manifest->add(entry);
+            }
+        }
+        std::vector<ManifestEntry> state;
+        state.reserve(stored.size() + entries.size());
+        for (const auto& entry : stored) {
+            ManifestEntry kept;
+            kept.sourcePath = entry.sourcePath;
+            kept.archivePath = entry.archivePath;
+            kept.size = entry.size;
+            kept.mtime = entry.mtime;
+            state.push_back(std::move(kept));
+        }
+        state.insert(state.end(), std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+        // A file counted as unchanged but written anyway keeps its archived size and time.
+        std::ranges::stable_sort(state, {}, &ManifestEntry::sourcePath);
+        auto duplicates = std::ranges::unique(state, {}, &ManifestEntry::sourcePath);
+        state.erase(duplicates.begin(), duplicates.end());
+        pendingState = std::move(state);
+    };
+
+    std::optional<std::vector<std::vector<fs::path>>> journalFiles;
+    if (level != 0) {
+        journalFiles = journalCandidates(sourceDirs, since, unchanged);
+    }
+    size_t totalFiles = 0;
+    if (journalFiles) {
+        for (const auto& files : *journalFiles) {
+            totalFiles += files.size();
+        }
+        logFile << std::format("[{}] Change journal: {} changed file(s), directories not walked\n", timeBuf, totalFiles);
+    } else {
+        std::println("Counting files...");
+        totalFiles = countFiles(sourceDirs, since, unchanged);
+    }
     if (totalFiles == 0) {
         logFile << std::format("[{}] Warning: No files to back up.\n", timeBuf);
         std::cerr << "Warning: No files to back up." << std::endl;
-        return {};
+        rememberState({});
+        return started;
     }
 
     std::atomic<size_t> processedFiles(0);
     std::atomic<bool> writeFailed(false);
     std::mutex archiveMutex;
+    FileManifest archived;
 
     struct archive* a = archive_write_new();
-    archive_write_add_filter_gzip(a);
     archive_write_set_format_pax_restricted(a);
-    int result = archive_write_open_filename(a, outputFile.c_str());
-    if (result != ARCHIVE_OK) {
-        std::string errorMsg = std::format("Failed to open archive file: {} (error: {})", outputFile, archive_error_string(a));
-        archive_write_free(a);
-        logFile << std::format("[{}] {}\n", timeBuf, errorMsg);
-        return std::unexpected(errorMsg);
+    std::unique_ptr<FrameWriter> frames;
+    if (frameSize > 0) {
+        // Entry-aligned gzip members plus a .frames index; still a plain .tar.gz for other tools.
+        frames = std::make_unique<FrameWriter>(outputFile, frameSize);
+        auto openResult = frames->open(a);
+        if (!openResult) {
+            archive_write_free(a);
+            logFile << std::format("[{}] {}\n", timeBuf, openResult.error());
+            return std::unexpected(openResult.error());
+        }
+    } else {
+        archive_write_add_filter_gzip(a);
+        int result = archive_write_open_filename(a, outputFile.c_str());
+        if (result != ARCHIVE_OK) {
+            std::string errorMsg = std::format("Failed to open archive file: {} (error: {})", outputFile, archive_error_string(a));
+            archive_write_free(a);
+            logFile << std::format("[{}] {}\n", timeBuf, errorMsg);
+            return std::unexpected(errorMsg);
+        }
     }
 
     std::vector<std::thread> threads;
-    for (const auto& dir : sourceDirs) {
-        threads.emplace_back([this, &dir, &outputFile, fullBackup, a, &processedFiles, totalFiles, &archiveMutex, &writeFailed]() {
-            this->backupDirectory(dir, outputFile, fullBackup, a, processedFiles, totalFiles, archiveMutex, writeFailed);
+    FrameWriter* frameWriter = frames.get();
+    for (size_t i = 0; i < sourceDirs.size(); ++i) {
+        const std::vector<fs::path>* files = journalFiles ? &(*journalFiles)[i] : nullptr;
+        threads.emplace_back([this, &dir = sourceDirs[i], &outputFile, since, a, &processedFiles, totalFiles, &archiveMutex, &writeFailed,
+                              frameWriter, &archived, files]() {
+            this->backupDirectory(dir, outputFile, since, a, processedFiles, totalFiles, archiveMutex, writeFailed, frameWriter,
+                                  &archived, files);
         });
     }
 
@@ -342,17 +684,70 @@ std::expected<void, std::string> TarGzFileBackupStrategy::execute(const std::vec
         return std::unexpected("Backup failed due to archive write errors");
     }
 
-    archive_write_close(a);
+    if (archive_write_close(a) != ARCHIVE_OK) {
+        std::string errorMsg = std::format("Failed to close archive file: {} (error: {})", outputFile, archive_error_string(a));
+        archive_write_free(a);
+        logFile << std::format("[{}] {}\n", timeBuf, errorMsg);
+        return std::unexpected(errorMsg);
+    }
     archive_write_free(a);
+    if (frames) {
+        auto indexResult = frames->finish();
+        if (!indexResult) {
+            logFile << std::format("[{}] {}\n", timeBuf, indexResult.error());
+            return std::unexpected(indexResult.error());
+        }
+    }
+    // The entry index lets the archive be listed and searched without decompressing it.
+    auto entries = archived.take();
+    if (manifest) {
+        for (const auto& entry : entries) {
+            manifest->add(entry);
+        }
+    }
+    std::vector<ManifestEntry> storedEntries;
+    if (changeJournal_) {
+        storedEntries = entries;
+    }
+    auto archiveIndexResult = writeArchiveIndex(outputFile, std::move(entries));
+    if (!archiveIndexResult) {
+        logFile << std::format("[{}] {}\n", timeBuf, archiveIndexResult.error());
+        return std::unexpected(archiveIndexResult.error());
+    }
     logFile << std::format("[{}] File backup completed: {}\n", timeBuf, outputFile);
     logFile.close();
     std::println("\nFile backup completed.");
 
-    now = std::chrono::system_clock::now();
-    timeT = std::chrono::system_clock::to_time_t(now);
-    std::ofstream lastBackup(lastBackupFile);
-    lastBackup << timeT;
-    lastBackup.close();
+    pendingFinished = std::chrono::system_clock::now();
+    rememberState(storedEntries);
+
+    return started;
+}
 
-    return {};
+/**
+ * @brief Records the last backup's level, last-run time and file list.
+ *
+ * @param level Dump level passed to execute().
+ * @param started Start time returned by execute().
+ */
+void TarGzFileBackupStrategy::recordCompleted(int level, std::chrono::system_clock::time_point started) {
+    if (pendingFinished) {
+        std::ofstream lastBackup(lastBackupFile);
+        lastBackup << std::chrono::system_clock::to_time_t(*pendingFinished);
+        lastBackup.close();
+        pendingFinished.reset();
+    }
+    // Levels reference the start, so files changed while this run was scanning are picked up next time.
+    recordLevel(level, started);
+    if (pendingState && changeJournal_) {
+        lastState = std::move(*pendingState);
+        lastStateStarted = started;
+        // Later runs compare against this run or a recorded level, never anything older.
+        auto oldest = started;
+        for (const auto& [recorded, levelStarted] : readLevels(levelsFile)) {
+            oldest = std::min(oldest, std::chrono::system_clock::from_time_t(static_cast<std::time_t>(levelStarted)));
+        }
+        changeJournal_->forgetBefore(oldest);
+    }
+    pendingState.reset();
 }
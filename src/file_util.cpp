@@ -0,0 +1,87 @@
+/**
+ * @file file_util.cpp
+ * @brief Durable file replacement for state, index and report files.
+ */
+
+#include "file_util.hpp"
+#include <filesystem>
+#include <format>
+#include <fstream>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+std::expected<void, std::string> writeFileAtomically(const std::string& path, const std::string& contents) {
+    std::error_code ec;
+    const fs::path target(path);
+    if (target.has_parent_path()) {
+        fs::create_directories(target.parent_path(), ec);
+        if (ec) {
+            return std::unexpected(std::format("Failed to create directory for {}: {}", path, ec.message()));
+        }
+    }
+
+    // Readers such as node_exporter must never see a half-written file.
+    const fs::path temporary = target.string() + ".tmp";
+#ifndef _WIN32
+    const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        return std::unexpected(std::format("Failed to write {}: {}", temporary.string(), std::strerror(errno)));
+    }
+    size_t written = 0;
+    while (written < contents.size()) {
+        const ssize_t result = ::write(fd, contents.data() + written, contents.size() - written);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(result);
+    }
+    // The data has to be on disk before the rename publishes it; otherwise a crash can leave
+    // the new name pointing at an empty file.
+    bool ok = written == contents.size() && ::fsync(fd) == 0;
+    int error = errno;
+    if (::close(fd) != 0 && ok) {
+        ok = false;
+        error = errno;
+    }
+    if (!ok) {
+        fs::remove(temporary, ec);
+        return std::unexpected(std::format("Failed to write {}: {}", temporary.string(), std::strerror(error)));
+    }
+#else
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out << contents;
+        out.flush();
+        if (!out) {
+            fs::remove(temporary, ec);
+            return std::unexpected(std::format("Failed to write {}", temporary.string()));
+        }
+    }
+#endif
+    fs::rename(temporary, target, ec);
+    if (ec) {
+        const std::string renameError = ec.message();
+        fs::remove(temporary, ec);
+        return std::unexpected(std::format("Failed to replace {}: {}", path, renameError));
+    }
+#ifndef _WIN32
+    // Persist the directory entry as well, so the rename survives a crash.
+    const fs::path directory = target.has_parent_path() ? target.parent_path() : fs::path(".");
+    const int directoryFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (directoryFd >= 0) {
+        ::fsync(directoryFd);
+        ::close(directoryFd);
+    }
+#endif
+    return {};
+}
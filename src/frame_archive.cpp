@@ -0,0 +1,321 @@
+/**
+ * @file frame_archive.cpp
+ * @brief Framed gzip output for libarchive and frame index handling.
+ */
+
+#include "frame_archive.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <sstream>
+
+namespace {
+
+constexpr const char* kFrameIndexHeader = "securevault-frames 1";
+constexpr size_t kDeflateBufferSize = 256 * 1024;
+
+} // namespace
+
+std::string frameIndexPath(const std::string& archivePath) {
+    return archivePath + ".frames";
+}
+
+std::expected<std::vector<ArchiveFrame>, std::string> readFrameIndex(const std::string& archivePath) {
+    std::ifstream in(frameIndexPath(archivePath));
+    if (!in) {
+        return std::unexpected(std::format("No frame index for {}", archivePath));
+    }
+    std::string line;
+    if (!std::getline(in, line) || line != kFrameIndexHeader) {
+        return std::unexpected(std::format("Unsupported frame index for {}", archivePath));
+    }
+
+    std::vector<ArchiveFrame> frames;
+    uint64_t expectedCompressed = 0;
+    uint64_t expectedUncompressed = 0;
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        std::istringstream fields(line);
+        ArchiveFrame frame;
+        fields >> frame.compressedOffset >> frame.compressedSize >> frame.uncompressedOffset >> frame.uncompressedSize
+               >> std::hex >> frame.crc32 >> std::dec >> frame.entries;
+        if (fields.fail() || frame.compressedOffset != expectedCompressed || frame.uncompressedOffset != expectedUncompressed) {
+            return std::unexpected(std::format("Malformed frame index for {} at frame {}", archivePath, frames.size()));
+        }
+        expectedCompressed += frame.compressedSize;
+        expectedUncompressed += frame.uncompressedSize;
+        frames.push_back(frame);
+    }
+    if (frames.empty()) {
+        return std::unexpected(std::format("Empty frame index for {}", archivePath));
+    }
+    return frames;
+}
+
+la_ssize_t readFrameBlock(struct archive* a, void* data, const void** buffer) {
+    auto* source = static_cast<FrameSource*>(data);
+    auto block = source->reader->next();
+    if (!block) {
+        source->error = block.error();
+        archive_set_error(a, EIO, "%s", source->error.c_str());
+        return -1;
+    }
+    *buffer = block->data();
+    return static_cast<la_ssize_t>(block->size());
+}
+
+FrameReader::FrameReader(std::ifstream& archive, const ArchiveFrame& frame)
+    : archive_(archive), frame_(frame), remainingInput_(frame.compressedSize), in_(kDeflateBufferSize), out_(kDeflateBufferSize) {
+    std::memset(&stream_, 0, sizeof(stream_));
+    ready_ = inflateInit2(&stream_, 15 + 16) == Z_OK;
+    archive_.clear();
+    archive_.seekg(static_cast<std::streamoff>(frame_.compressedOffset));
+}
+
+FrameReader::~FrameReader() {
+    if (ready_) {
+        inflateEnd(&stream_);
+    }
+}
+
+std::expected<std::span<const char>, std::string> FrameReader::next() {
+    if (!ready_) {
+        return std::unexpected("Failed to initialize zlib");
+    }
+    stream_.next_out = out_.data();
+    stream_.avail_out = static_cast<uInt>(out_.size());
+    while (!ended_ && stream_.avail_out == out_.size()) {
+        if (stream_.avail_in == 0) {
+            if (remainingInput_ == 0) {
+                return std::unexpected(std::format("Frame at offset {} is truncated", frame_.compressedOffset));
+            }
+            const size_t wanted = static_cast<size_t>(std::min<uint64_t>(remainingInput_, in_.size()));
+            archive_.read(reinterpret_cast<char*>(in_.data()), static_cast<std::streamsize>(wanted));
+            if (static_cast<size_t>(archive_.gcount()) != wanted) {
+                return std::unexpected(std::format("Frame at offset {} is truncated", frame_.compressedOffset));
+            }
+            remainingInput_ -= wanted;
+            stream_.next_in = in_.data();
+            stream_.avail_in = static_cast<uInt>(wanted);
+        }
+        const int rc = inflate(&stream_, Z_NO_FLUSH);
+        if (rc == Z_STREAM_END) {
+            ended_ = true;
+        } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+            return std::unexpected(std::format("Frame at offset {} is corrupt: {}", frame_.compressedOffset,
+                                               stream_.msg ? stream_.msg : zError(rc)));
+        }
+    }
+
+    const size_t length = out_.size() - stream_.avail_out;
+    produced_ += length;
+    crc_ = static_cast<uint32_t>(::crc32(crc_, out_.data(), static_cast<uInt>(length)));
+    if (produced_ > frame_.uncompressedSize) {
+        return std::unexpected(std::format("Frame at offset {} does not match the frame index", frame_.compressedOffset));
+    }
+    if (length == 0) {
+        if (remainingInput_ != 0 || stream_.avail_in != 0 || produced_ != frame_.uncompressedSize) {
+            return std::unexpected(std::format("Frame at offset {} does not match the frame index", frame_.compressedOffset));
+        }
+        if (crc_ != frame_.crc32) {
+            return std::unexpected(std::format("Frame at offset {} fails its CRC check", frame_.compressedOffset));
+        }
+    }
+    return std::span<const char>(reinterpret_cast<const char*>(out_.data()), length);
+}
+
+FrameWriter::FrameWriter(std::string path, uint64_t frameSize)
+    : path_(std::move(path)), frameSize_(frameSize), buffer_(kDeflateBufferSize) {
+    std::memset(&stream_, 0, sizeof(stream_));
+}
+
+FrameWriter::~FrameWriter() {
+    if (deflateReady_) {
+        deflateEnd(&stream_);
+    }
+}
+
+std::expected<void, std::string> FrameWriter::open(struct archive* a) {
+    output_.open(path_, std::ios::binary | std::ios::trunc);
+    if (!output_) {
+        return std::unexpected(std::format("Failed to open archive file: {} (error: {})", path_, std::strerror(errno)));
+    }
+    if (deflateInit2(&stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return std::unexpected("Failed to initialize zlib");
+    }
+    deflateReady_ = true;
+
+    // Unblocked output: libarchive hands every header and data block straight to the callback,
+    // so an entry boundary in the tar stream is also a boundary in what the writer has seen.
+    archive_write_add_filter_none(a);
+    archive_write_set_bytes_per_block(a, 0);
+    if (archive_write_open2(a, this, nullptr, writeCallback, closeCallback, nullptr) != ARCHIVE_OK) {
+        return std::unexpected(std::format("Failed to open archive file: {} (error: {})", path_, archive_error_string(a)));
+    }
+    return {};
+}
+
+void FrameWriter::startEntry() {
+    if (frameOpen_ && current_.uncompressedSize >= frameSize_ && error_.empty()) {
+        auto result = endFrame();
+        if (!result) {
+            error_ = result.error();
+        }
+    }
+    ++current_.entries;
+}
+
+la_ssize_t FrameWriter::writeCallback(struct archive* a, void* data, const void* buffer, size_t length) {
+    auto* self = static_cast<FrameWriter*>(data);
+    auto result = self->compress(buffer, length);
+    if (!result) {
+        if (self->error_.empty()) {
+            self->error_ = result.error();
+        }
+        archive_set_error(a, EIO, "%s", self->error_.c_str());
+        return -1;
+    }
+    return static_cast<la_ssize_t>(length);
+}
+
+int FrameWriter::closeCallback(struct archive* a, void* data) {
+    auto* self = static_cast<FrameWriter*>(data);
+    if (self->closed_) {
+        return ARCHIVE_OK;
+    }
+    self->closed_ = true;
+    if (self->frameOpen_ && self->error_.empty()) {
+        auto result = self->endFrame();
+        if (!result) {
+            self->error_ = result.error();
+        }
+    }
+    self->output_.close();
+    if (self->output_.fail() && self->error_.empty()) {
+        self->error_ = std::format("Failed to write archive file: {}", self->path_);
+    }
+    if (!self->error_.empty()) {
+        archive_set_error(a, EIO, "%s", self->error_.c_str());
+        return ARCHIVE_FATAL;
+    }
+    return ARCHIVE_OK;
+}
+
+std::expected<void, std::string> FrameWriter::compress(const void* buffer, size_t length) {
+    if (!error_.empty()) {
+        return std::unexpected(error_);
+    }
+    frameOpen_ = true;
+    current_.crc32 = static_cast<uint32_t>(::crc32(current_.crc32, static_cast<const Bytef*>(buffer), static_cast<uInt>(length)));
+    current_.uncompressedSize += length;
+
+    stream_.next_in = static_cast<Bytef*>(const_cast<void*>(buffer));
+    stream_.avail_in = static_cast<uInt>(length);
+    while (stream_.avail_in > 0) {
+        stream_.next_out = buffer_.data();
+        stream_.avail_out = static_cast<uInt>(buffer_.size());
+        if (deflate(&stream_, Z_NO_FLUSH) == Z_STREAM_ERROR) {
+            return std::unexpected("Compression failed");
+        }
+        const size_t produced = buffer_.size() - stream_.avail_out;
+        output_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(produced));
+        current_.compressedSize += produced;
+    }
+    if (!output_) {
+        return std::unexpected(std::format("Failed to write archive file: {} (error: {})", path_, std::strerror(errno)));
+    }
+    return {};
+}
+
+std::expected<void, std::string> FrameWriter::endFrame() {
+    stream_.next_in = nullptr;
+    stream_.avail_in = 0;
+    int rc = Z_OK;
+    while (rc != Z_STREAM_END) {
+        stream_.next_out = buffer_.data();
+        stream_.avail_out = static_cast<uInt>(buffer_.size());
+        rc = deflate(&stream_, Z_FINISH);
+        if (rc == Z_STREAM_ERROR) {
+            return std::unexpected("Compression failed");
+        }
+        const size_t produced = buffer_.size() - stream_.avail_out;
+        output_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(produced));
+        current_.compressedSize += produced;
+    }
+    if (!output_) {
+        return std::unexpected(std::format("Failed to write archive file: {} (error: {})", path_, std::strerror(errno)));
+    }
+    deflateReset(&stream_);
+    if (level_ != appliedLevel_ && deflateParams(&stream_, level_, Z_DEFAULT_STRATEGY) == Z_OK) {
+        appliedLevel_ = level_;
+    }
+
+    frames_.push_back(current_);
+    ArchiveFrame next;
+    next.compressedOffset = current_.compressedOffset + current_.compressedSize;
+    next.uncompressedOffset = current_.uncompressedOffset + current_.uncompressedSize;
+    current_ = next;
+    frameOpen_ = false;
+    return {};
+}
+
+std::expected<ArchiveFrame, std::string> FrameWriter::appendFrame(std::ifstream& source, const ArchiveFrame& frame) {
+    if (!error_.empty()) {
+        return std::unexpected(error_);
+    }
+    if (frameOpen_) {
+        auto result = endFrame();
+        if (!result) {
+            error_ = result.error();
+            return std::unexpected(error_);
+        }
+    }
+
+    source.clear();
+    source.seekg(static_cast<std::streamoff>(frame.compressedOffset));
+    uint64_t remaining = frame.compressedSize;
+    while (remaining > 0) {
+        const size_t wanted = static_cast<size_t>(std::min<uint64_t>(remaining, buffer_.size()));
+        source.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(wanted));
+        if (static_cast<size_t>(source.gcount()) != wanted) {
+            error_ = std::format("Source frame at offset {} is truncated", frame.compressedOffset);
+            return std::unexpected(error_);
+        }
+        output_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(wanted));
+        remaining -= wanted;
+    }
+    if (!output_) {
+        error_ = std::format("Failed to write archive file: {} (error: {})", path_, std::strerror(errno));
+        return std::unexpected(error_);
+    }
+
+    ArchiveFrame placed = frame;
+    placed.compressedOffset = current_.compressedOffset;
+    placed.uncompressedOffset = current_.uncompressedOffset;
+    frames_.push_back(placed);
+    current_ = ArchiveFrame{};
+    current_.compressedOffset = placed.compressedOffset + placed.compressedSize;
+    current_.uncompressedOffset = placed.uncompressedOffset + placed.uncompressedSize;
+    return placed;
+}
+
+std::expected<void, std::string> FrameWriter::finish() {
+    if (!error_.empty()) {
+        return std::unexpected(error_);
+    }
+    const std::string indexPath = frameIndexPath(path_);
+    std::ofstream index(indexPath, std::ios::trunc);
+    index << kFrameIndexHeader << '\n';
+    for (const auto& frame : frames_) {
+        index << std::format("{} {} {} {} {:08x} {}\n", frame.compressedOffset, frame.compressedSize, frame.uncompressedOffset,
+                             frame.uncompressedSize, frame.crc32, frame.entries);
+    }
+    index.close();
+    if (!index) {
+        return std::unexpected(std::format("Failed to write frame index: {}", indexPath));
+    }
+    return {};
+}
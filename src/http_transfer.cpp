@@ -0,0 +1,653 @@
+/**
+ * @file http_transfer.cpp
+ * @brief WebDAV / HTTP PUT transfer strategy on a shared libcurl multi handle.
+ */
+
+#include "http_transfer.hpp"
+#include "transfer_metrics.hpp"
+#include <curl/curl.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <format>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t kSinkQueueLimit = 8 * 1024 * 1024; ///< Bytes buffered per streaming PUT before write() blocks.
+
+using EasyHandle = std::unique_ptr<CURL, decltype(&curl_easy_cleanup)>;
+using HeaderList = std::unique_ptr<curl_slist, decltype(&curl_slist_free_all)>;
+
+size_t discardBody(char*, size_t size, size_t items, void*) {
+    return size * items;
+}
+
+size_t readFromStream(char* buffer, size_t size, size_t items, void* userdata) {
+    auto* input = static_cast<std::ifstream*>(userdata);
+    input->read(buffer, static_cast<std::streamsize>(size * items));
+    if (input->bad()) {
+        return CURL_READFUNC_ABORT;
+    }
+    return static_cast<size_t>(input->gcount());
+}
+
+size_t writeToStream(char* buffer, size_t size, size_t items, void* userdata) {
+    auto* output = static_cast<std::ofstream*>(userdata);
+    output->write(buffer, static_cast<std::streamsize>(size * items));
+    return *output ? size * items : 0;
+}
+
+bool isSuccess(long status) {
+    return status >= 200 && status < 300;
+}
+
+std::string normalizeRemote(std::string path) {
+    std::replace(path.begin(), path.end(), '\\', '/');
+    std::string normalized;
+    std::stringstream ss(path);
+    std::string segment;
+    while (std::getline(ss, segment, '/')) {
+        if (segment.empty() || segment == ".") {
+            continue;
+        }
+        normalized += (normalized.empty() ? "" : "/") + segment;
+    }
+    return normalized;
+}
+
+} // namespace
+
+/**
+ * Requests are handed over through a queue and run by curl_multi_perform on one thread; that
+ * thread is also the only one allowed to unpause a streaming upload.
+ */
+class HttpTransferStrategy::Driver {
+public:
+    explicit Driver(long connections) : multi_(curl_multi_init()) {
+        if (!multi_) {
+            throw std::runtime_error("Failed to create curl multi handle");
+        }
+        curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS, connections);
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    ~Driver() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        curl_multi_wakeup(multi_);
+        thread_.join();
+        curl_multi_cleanup(multi_);
+    }
+
+    /**
+     * @brief Queues a request; onDone runs on the driver thread when it completes.
+     */
+    std::future<CURLcode> submit(CURL* easy, std::function<void()> onDone = {}) {
+        Pending pending{easy, std::promise<CURLcode>(), std::move(onDone)};
+        auto future = pending.promise.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_.push_back(std::move(pending));
+        }
+        curl_multi_wakeup(multi_);
+        return future;
+    }
+
+    void unpause(CURL* easy) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            unpause_.push_back(easy);
+        }
+        curl_multi_wakeup(multi_);
+    }
+
+private:
+    struct Pending {
+        CURL* easy;
+        std::promise<CURLcode> promise;
+        std::function<void()> onDone;
+    };
+
+    void run() {
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (auto& pending : pending_) {
+                    CURL* easy = pending.easy;
+                    curl_multi_add_handle(multi_, easy);
+                    active_.emplace(easy, std::move(pending));
+                }
+                pending_.clear();
+                for (CURL* easy : unpause_) {
+                    // A request may already have finished (and been freed) before its unpause arrived.
+                    if (active_.contains(easy)) {
+                        curl_easy_pause(easy, CURLPAUSE_CONT);
+                    }
+                }
+                unpause_.clear();
+                if (stopping_ && active_.empty()) {
+                    break;
+                }
+            }
+
+            int running = 0;
+            curl_multi_perform(multi_, &running);
+            int queued = 0;
+            while (CURLMsg* message = curl_multi_info_read(multi_, &queued)) {
+                if (message->msg != CURLMSG_DONE) {
+                    continue;
+                }
+                CURL* easy = message->easy_handle;
+                const CURLcode result = message->data.result;
+                curl_multi_remove_handle(multi_, easy);
+                auto node = active_.extract(easy);
+                if (node) {
+                    if (node.mapped().onDone) {
+                        node.mapped().onDone();
+                    }
+                    node.mapped().promise.set_value(result);
+                }
+            }
+            curl_multi_poll(multi_, nullptr, 0, 1000, nullptr);
+        }
+    }
+
+    CURLM* multi_;
+    std::thread thread_;
+    std::mutex mutex_; ///< Guards pending_, unpause_ and stopping_.
+    std::vector<Pending> pending_;
+    std::vector<CURL*> unpause_;
+    bool stopping_ = false;
+    std::unordered_map<CURL*, Pending> active_; ///< Requests on the multi handle (driver thread only).
+};
+
+/**
+ * Once the stream fails or is suspended, the request is dropped and later writes are ignored;
+ * commit() then uploads from the local file, resuming from whatever the server stored.
+ */
+class HttpTransferStrategy::Upload : public TransferSink {
+public:
+    Upload(HttpTransferStrategy& owner, CURL* easy, std::string url, std::string artifact, uint64_t size)
+        : owner_(owner), easy_(easy, curl_easy_cleanup), url_(std::move(url)), artifact_(std::move(artifact)), size_(size) {
+        curl_easy_setopt(easy, CURLOPT_UPLOAD, 1L);
+        curl_easy_setopt(easy, CURLOPT_INFILESIZE_LARGE, static_cast<curl_off_t>(size));
+        curl_easy_setopt(easy, CURLOPT_READFUNCTION, &Upload::read);
+        curl_easy_setopt(easy, CURLOPT_READDATA, this);
+        future_ = owner_.driver_->submit(easy, [this]() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+            cv_.notify_all();
+        });
+    }
+
+    ~Upload() override {
+        if (future_.valid()) {
+            abort();
+            future_.wait();
+        }
+    }
+
+    std::expected<void, std::string> write(std::span<const char> data) override {
+        if (!future_.valid()) {
+            return {};
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&]() { return done_ || queuedBytes_ < kSinkQueueLimit; });
+        if (done_) {
+            lock.unlock();
+            auto result = collect();
+            streamResult_ = std::unexpected(result ? std::string("server answered before the body was complete") : result.error());
+            return {};
+        }
+        chunks_.emplace_back(data.begin(), data.end());
+        queuedBytes_ += data.size();
+        if (paused_) {
+            paused_ = false;
+            owner_.driver_->unpause(easy_.get());
+        }
+        return {};
+    }
+
+    void suspend() override {
+        if (!future_.valid()) {
+            return;
+        }
+        // A paused PUT would keep its connection (or HTTP/2 stream) busy until the upload resumes.
+        abort();
+        suspended_ = true;
+        streamResult_ = collect();
+    }
+
+    std::expected<void, std::string> commit() override {
+        if (future_.valid()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                finished_ = true;
+                if (paused_) {
+                    paused_ = false;
+                    owner_.driver_->unpause(easy_.get());
+                }
+            }
+            streamResult_ = collect();
+        }
+        if (streamResult_) {
+            std::cout << "Transferred file to remote: " << url_ << std::endl;
+            return {};
+        }
+        if (!suspended_) {
+            std::cerr << "Warning: Streaming upload to " << url_ << " failed (" << streamResult_.error()
+                      << "), uploading from the local file" << std::endl;
+            if (TransferMetrics* metrics = owner_.metrics_.load()) {
+                metrics->addRetry(artifact_);
+            }
+        }
+        return owner_.uploadFile(artifact_, url_, size_, true);
+    }
+
+private:
+    /**
+     * @brief Makes the read callback fail the request the next time curl asks for data.
+     */
+    void abort() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            aborted_ = true;
+        }
+        owner_.driver_->unpause(easy_.get());
+    }
+
+    /**
+     * @brief Waits for the request and returns whether the server stored the upload.
+     */
+    std::expected<void, std::string> collect() {
+        const CURLcode code = future_.get();
+        if (code != CURLE_OK) {
+            return std::unexpected(curl_easy_strerror(code));
+        }
+        long status = 0;
+        curl_easy_getinfo(easy_.get(), CURLINFO_RESPONSE_CODE, &status);
+        if (!isSuccess(status)) {
+            return std::unexpected(std::format("HTTP {}", status));
+        }
+        return {};
+    }
+
+    static size_t read(char* buffer, size_t size, size_t items, void* userdata) {
+        auto* self = static_cast<Upload*>(userdata);
+        std::lock_guard<std::mutex> lock(self->mutex_);
+        if (self->aborted_) {
+            return CURL_READFUNC_ABORT;
+        }
+        if (self->chunks_.empty()) {
+            if (self->finished_) {
+                return 0;
+            }
+            self->paused_ = true;
+            return CURL_READFUNC_PAUSE;
+        }
+
+        const size_t capacity = size * items;
+        size_t copied = 0;
+        while (copied < capacity && !self->chunks_.empty()) {
+            auto& front = self->chunks_.front();
+            const size_t length = std::min(capacity - copied, front.size() - self->frontOffset_);
+            std::copy_n(front.data() + self->frontOffset_, length, buffer + copied);
+            copied += length;
+            self->frontOffset_ += length;
+            if (self->frontOffset_ == front.size()) {
+                self->chunks_.pop_front();
+                self->frontOffset_ = 0;
+            }
+        }
+        self->queuedBytes_ -= copied;
+        self->cv_.notify_all();
+        return copied;
+    }
+
+    HttpTransferStrategy& owner_;
+    EasyHandle easy_;
+    std::string url_;
+    std::string artifact_;
+    uint64_t size_;
+    std::future<CURLcode> future_; ///< Valid while the streaming request is in flight.
+    std::expected<void, std::string> streamResult_; ///< Outcome of the streaming request once it ended.
+    bool suspended_ = false; ///< suspend() dropped the request.
+    std::mutex mutex_; ///< Guards the fields below, shared with the driver thread.
+    std::condition_variable cv_;
+    std::deque<std::vector<char>> chunks_; ///< Written blocks not yet handed to curl.
+    size_t frontOffset_ = 0; ///< Bytes of chunks_.front() already handed to curl.
+    size_t queuedBytes_ = 0;
+    bool paused_ = false; ///< curl is paused waiting for data.
+    bool finished_ = false; ///< commit() was called; an empty queue means end of body.
+    bool aborted_ = false; ///< The request is being dropped.
+    bool done_ = false; ///< The request completed.
+};
+
+HttpTransferStrategy::HttpTransferStrategy(const Json::Value& config)
+    : baseUrl_(config.get("url", "").asString()),
+      user_(config.get("user", "").asString()),
+      password_(config.get("password", "").asString()),
+      authMask_(config.get("auth", "basic").asString() == "digest" ? CURLAUTH_DIGEST
+                : config.get("auth", "basic").asString() == "any" ? CURLAUTH_ANY
+                                                                  : CURLAUTH_BASIC),
+      webdav_(config.get("webdav", config.get("type", "").asString() == "webdav").asBool()),
+      http2_(config.get("http2", true).asBool()),
+      resume_(config.get("resume", true).asBool()),
+      retries_(std::max(config.get("retries", 2).asInt(), 0)),
+      caFile_(config.get("ca_file", "").asString()),
+      verifyPeer_(config.get("verify_peer", true).asBool()) {
+    while (!baseUrl_.empty() && baseUrl_.back() == '/') {
+        baseUrl_.pop_back();
+    }
+    if (baseUrl_.empty()) {
+        throw std::runtime_error("HTTP destination requires a url");
+    }
+
+    static std::once_flag curlInit;
+    std::call_once(curlInit, []() { curl_global_init(CURL_GLOBAL_DEFAULT); });
+    driver_ = std::make_unique<Driver>(std::max<long>(config.get("connections", 2).asInt(), 1));
+}
+
+HttpTransferStrategy::~HttpTransferStrategy() = default;
+
+std::string HttpTransferStrategy::name() const {
+    return baseUrl_;
+}
+
+std::string HttpTransferStrategy::urlFor(const std::string& remotePath) const {
+    std::string url = baseUrl_;
+    std::stringstream ss(normalizeRemote(remotePath));
+    std::string segment;
+    while (std::getline(ss, segment, '/')) {
+        char* escaped = curl_easy_escape(nullptr, segment.c_str(), static_cast<int>(segment.size()));
+        url += "/";
+        url += escaped ? escaped : segment.c_str();
+        curl_free(escaped);
+    }
+    return url;
+}
+
+void* HttpTransferStrategy::newRequest(const std::string& url) const {
+    CURL* easy = curl_easy_init();
+    if (!easy) {
+        return nullptr;
+    }
+    curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, discardBody);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT, 30L);
+    // Wait for an existing connection to offer a stream instead of opening a new one.
+    curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+    if (http2_) {
+        curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    }
+    if (!user_.empty()) {
+        curl_easy_setopt(easy, CURLOPT_USERNAME, user_.c_str());
+        curl_easy_setopt(easy, CURLOPT_PASSWORD, password_.c_str());
+        curl_easy_setopt(easy, CURLOPT_HTTPAUTH, authMask_);
+    }
+    if (!caFile_.empty()) {
+        curl_easy_setopt(easy, CURLOPT_CAINFO, caFile_.c_str());
+    }
+    if (!verifyPeer_) {
+        curl_easy_setopt(easy, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(easy, CURLOPT_SSL_VERIFYHOST, 0L);
+    }
+    return easy;
+}
+
+std::expected<long, std::string> HttpTransferStrategy::perform(void* easy, const std::string& artifact) {
+    const CURLcode code = driver_->submit(easy).get();
+    if (code != CURLE_OK) {
+        return std::unexpected(curl_easy_strerror(code));
+    }
+
+    if (TransferMetrics* metrics = metrics_.load()) {
+        long newConnections = 0;
+        curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &newConnections);
+        if (newConnections > 0) {
+            curl_off_t handshake = 0;
+            curl_easy_getinfo(easy, CURLINFO_APPCONNECT_TIME_T, &handshake);
+            if (handshake == 0) {
+                curl_easy_getinfo(easy, CURLINFO_CONNECT_TIME_T, &handshake);
+            }
+            metrics->recordHandshake(name(), artifact, std::chrono::microseconds(handshake));
+        } else {
+            metrics->recordSessionReuse(name());
+        }
+    }
+
+    long status = 0;
+    curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &status);
+    return status;
+}
+
+std::expected<void, std::string> HttpTransferStrategy::ensureCollection(const std::string& directory, const std::string& artifact) {
+    std::string prefix;
+    std::stringstream ss(normalizeRemote(directory));
+    std::string segment;
+    while (std::getline(ss, segment, '/')) {
+        prefix += (prefix.empty() ? "" : "/") + segment;
+        {
+            std::lock_guard<std::mutex> lock(collectionsMutex_);
+            if (knownCollections_.contains(prefix)) {
+                continue;
+            }
+        }
+
+        EasyHandle easy(static_cast<CURL*>(newRequest(urlFor(prefix) + "/")), curl_easy_cleanup);
+        if (!easy) {
+            return std::unexpected("Failed to create HTTP request");
+        }
+        curl_easy_setopt(easy.get(), CURLOPT_CUSTOMREQUEST, "MKCOL");
+        auto status = perform(easy.get(), artifact);
+        if (!status) {
+            return std::unexpected(std::format("MKCOL {} failed: {}", prefix, status.error()));
+        }
+        // 405 Method Not Allowed is the WebDAV answer for an existing collection.
+        if (!isSuccess(*status) && *status != 405 && *status != 301) {
+            return std::unexpected(std::format("MKCOL {} failed with HTTP {}", prefix, *status));
+        }
+        std::lock_guard<std::mutex> lock(collectionsMutex_);
+        knownCollections_.insert(prefix);
+    }
+    return {};
+}
+
+std::expected<uint64_t, std::string> HttpTransferStrategy::remoteSize(const std::string& url, const std::string& artifact) {
+    EasyHandle easy(static_cast<CURL*>(newRequest(url)), curl_easy_cleanup);
+    if (!easy) {
+        return std::unexpected("Failed to create HTTP request");
+    }
+    curl_easy_setopt(easy.get(), CURLOPT_NOBODY, 1L);
+    auto status = perform(easy.get(), artifact);
+    if (!status) {
+        return std::unexpected(status.error());
+    }
+    if (*status == 404) {
+        return 0;
+    }
+    if (!isSuccess(*status)) {
+        return std::unexpected(std::format("HEAD {} failed with HTTP {}", url, *status));
+    }
+    curl_off_t length = -1;
+    curl_easy_getinfo(easy.get(), CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+    return length > 0 ? static_cast<uint64_t>(length) : 0;
+}
+
+std::expected<long, std::string> HttpTransferStrategy::putFile(const std::string& sourceFile, const std::string& url, uint64_t offset, uint64_t size) {
+    std::ifstream input(sourceFile, std::ios::binary);
+    if (!input) {
+        return std::unexpected("Failed to open local file");
+    }
+    input.seekg(static_cast<std::streamoff>(offset));
+
+    EasyHandle easy(static_cast<CURL*>(newRequest(url)), curl_easy_cleanup);
+    if (!easy) {
+        return std::unexpected("Failed to create HTTP request");
+    }
+    HeaderList headers(nullptr, curl_slist_free_all);
+    if (offset > 0) {
+        const std::string range = std::format("Content-Range: bytes {}-{}/{}", offset, size - 1, size);
+        headers.reset(curl_slist_append(nullptr, range.c_str()));
+        curl_easy_setopt(easy.get(), CURLOPT_HTTPHEADER, headers.get());
+    }
+    curl_easy_setopt(easy.get(), CURLOPT_UPLOAD, 1L);
+    curl_easy_setopt(easy.get(), CURLOPT_INFILESIZE_LARGE, static_cast<curl_off_t>(size - offset));
+    curl_easy_setopt(easy.get(), CURLOPT_READFUNCTION, readFromStream);
+    curl_easy_setopt(easy.get(), CURLOPT_READDATA, &input);
+    return perform(easy.get(), sourceFile);
+}
+
+std::expected<std::unique_ptr<TransferSink>, std::string> HttpTransferStrategy::openSink(const std::string& sourceFile,
+                                                                                          const std::string& destinationPath) {
+    std::error_code ec;
+    const uint64_t size = fs::file_size(sourceFile, ec);
+    if (ec) {
+        return std::unexpected(std::format("Failed to stat local file: {}", ec.message()));
+    }
+    if (webdav_) {
+        auto collectionResult = ensureCollection(destinationPath, sourceFile);
+        if (!collectionResult) {
+            return std::unexpected(collectionResult.error());
+        }
+    }
+
+    const std::string url = urlFor(destinationPath + "/" + fs::path(sourceFile).filename().string());
+    CURL* easy = static_cast<CURL*>(newRequest(url));
+    if (!easy) {
+        return std::unexpected("Failed to create HTTP request");
+    }
+    return std::make_unique<Upload>(*this, easy, url, sourceFile, size);
+}
+
+std::expected<void, std::string> HttpTransferStrategy::transfer(const std::string& sourceFile, const std::string& destinationPath) {
+    std::error_code ec;
+    const uint64_t size = fs::file_size(sourceFile, ec);
+    if (ec) {
+        return std::unexpected(std::format("Failed to stat local file: {}", ec.message()));
+    }
+    if (webdav_) {
+        auto collectionResult = ensureCollection(destinationPath, sourceFile);
+        if (!collectionResult) {
+            return std::unexpected(collectionResult.error());
+        }
+    }
+
+    return uploadFile(sourceFile, urlFor(destinationPath + "/" + fs::path(sourceFile).filename().string()), size, false);
+}
+
+std::expected<void, std::string> HttpTransferStrategy::uploadFile(const std::string& sourceFile, const std::string& url, uint64_t size, bool resumeFirst) {
+    bool rangeAllowed = resume_;
+    std::string lastError;
+    for (int attempt = 0; attempt <= retries_; ++attempt) {
+        uint64_t offset = 0;
+        if (attempt > 0) {
+            std::cerr << "Warning: Upload to " << url << " failed (" << lastError << "), retrying ("
+                      << attempt << "/" << retries_ << ")" << std::endl;
+            if (TransferMetrics* metrics = metrics_.load()) {
+                metrics->addRetry(sourceFile);
+            }
+        }
+        if (rangeAllowed && (attempt > 0 || resumeFirst)) {
+            auto existing = remoteSize(url, sourceFile);
+            if (existing && *existing < size) {
+                offset = *existing;
+            }
+        }
+
+        auto status = putFile(sourceFile, url, offset, size);
+        if (status && isSuccess(*status) && offset > 0) {
+            // Servers that ignore Content-Range would have replaced the file with the tail only.
+            auto stored = remoteSize(url, sourceFile);
+            if (!stored || *stored != size) {
+                rangeAllowed = false;
+                lastError = "server does not apply partial PUTs";
+                continue;
+            }
+        }
+        if (status && isSuccess(*status)) {
+            std::cout << "Transferred file to remote: " << url << (offset > 0 ? std::format(" (resumed at {} bytes)", offset) : "")
+                      << std::endl;
+            return {};
+        }
+
+        if (!status) {
+            lastError = status.error();
+            continue;
+        }
+        lastError = std::format("HTTP {}", *status);
+        if (offset > 0 && *status >= 400 && *status < 500 && *status != 401 && *status != 403) {
+            // The server rejected the range; the next attempt sends the whole file.
+            rangeAllowed = false;
+            continue;
+        }
+        if (*status >= 400 && *status < 500 && *status != 408 && *status != 429) {
+            break;
+        }
+    }
+    return std::unexpected(std::format("Upload to {} failed: {}", url, lastError));
+}
+
+std::expected<void, std::string> HttpTransferStrategy::fetch(const std::string& remotePath, const std::string& localFile) {
+    const std::string url = urlFor(remotePath);
+    EasyHandle easy(static_cast<CURL*>(newRequest(url)), curl_easy_cleanup);
+    if (!easy) {
+        return std::unexpected("Failed to create HTTP request");
+    }
+    std::ofstream output(localFile, std::ios::binary | std::ios::trunc);
+    if (!output) {
+        return std::unexpected(std::format("Failed to create local file: {}", localFile));
+    }
+    curl_easy_setopt(easy.get(), CURLOPT_WRITEFUNCTION, writeToStream);
+    curl_easy_setopt(easy.get(), CURLOPT_WRITEDATA, &output);
+    auto status = perform(easy.get(), localFile);
+    output.close();
+    if (!status || !isSuccess(*status) || !output) {
+        std::error_code ec;
+        fs::remove(localFile, ec);
+        if (!status) {
+            return std::unexpected(std::format("Download of {} failed: {}", url, status.error()));
+        }
+        if (!isSuccess(*status)) {
+            return std::unexpected(std::format("Download of {} failed with HTTP {}", url, *status));
+        }
+        return std::unexpected(std::format("Failed to write local file: {}", localFile));
+    }
+    return {};
+}
+
+std::expected<size_t, std::string> HttpTransferStrategy::removeRemote(const std::vector<std::string>& remotePaths) {
+    size_t removed = 0;
+    for (const auto& remotePath : remotePaths) {
+        const std::string url = urlFor(remotePath);
+        EasyHandle easy(static_cast<CURL*>(newRequest(url)), curl_easy_cleanup);
+        if (!easy) {
+            return std::unexpected("Failed to create HTTP request");
+        }
+        curl_easy_setopt(easy.get(), CURLOPT_CUSTOMREQUEST, "DELETE");
+        auto status = perform(easy.get(), remotePath);
+        if (!status) {
+            return std::unexpected(std::format("DELETE {} failed: {}", url, status.error()));
+        }
+        if (*status == 404) {
+            continue;
+        }
+        if (!isSuccess(*status)) {
+            return std::unexpected(std::format("DELETE {} failed with HTTP {}", url, *status));
+        }
+        ++removed;
+    }
+    return removed;
+}
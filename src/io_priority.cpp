@@ -0,0 +1,24 @@
+/**
+ * @file io_priority.cpp
+ * @brief Scheduling priority helpers for background work.
+ */
+
+#include "io_priority.hpp"
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+void enterBackgroundPriority() {
+#ifdef __linux__
+    constexpr int kIoprioWhoProcess = 1;
+    constexpr int kIoprioClassIdle = 3;
+    constexpr int kIoprioClassShift = 13;
+    // On Linux both settings apply to the calling thread when given its thread id.
+    const auto tid = static_cast<pid_t>(::syscall(SYS_gettid));
+    ::syscall(SYS_ioprio_set, kIoprioWhoProcess, tid, kIoprioClassIdle << kIoprioClassShift);
+    ::setpriority(PRIO_PROCESS, static_cast<id_t>(tid), 19);
+#endif
+}
@@ -0,0 +1,414 @@
+/**
+ * @file job_scheduler.cpp
+ * @brief Cron-driven scheduler running several jobs concurrently within shared slots.
+ */
+
+#include "job_scheduler.hpp"
+#include "load_monitor.hpp"
+#include "file_util.hpp"
+#include <algorithm>
+#include <ctime>
+#include <filesystem>
+#include <format>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string formatTime(std::chrono::system_clock::time_point time) {
+    const std::time_t timeT = std::chrono::system_clock::to_time_t(time);
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &timeT);
+#else
+    localtime_r(&timeT, &local);
+#endif
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &local);
+    return buffer;
+}
+
+} // namespace
+
+std::expected<ScheduledJob, std::string> ScheduledJob::fromJson(const Json::Value& job) {
+    ScheduledJob result;
+    result.name = job.get("name", "").asString();
+    if (result.name.empty()) {
+        return std::unexpected("Scheduler job without a name");
+    }
+    auto schedule = CronSchedule::parse(job.get("cron", "").asString());
+    if (!schedule) {
+        return std::unexpected(std::format("Job {}: {}", result.name, schedule.error()));
+    }
+    result.schedule = std::move(*schedule);
+
+    const Json::Value& slots = job["slots"];
+    if (slots.isObject()) {
+        for (const auto& pool : slots.getMemberNames()) {
+            result.slots[pool] = slots[pool].asUInt();
+        }
+    } else {
+        result.slots = {{"cpu", 1}, {"io", 1}};
+    }
+
+    const std::string overlap = job.get("overlap", "skip").asString();
+    if (overlap == "queue") {
+        result.overlap = Overlap::Queue;
+    } else if (overlap != "skip") {
+        return std::unexpected(std::format("Job {}: invalid overlap policy '{}' (use skip or queue)", result.name, overlap));
+    }
+    const std::string missed = job.get("missed", "skip").asString();
+    if (missed == "run_once") {
+        result.missed = Missed::RunOnce;
+    } else if (missed != "skip") {
+        return std::unexpected(std::format("Job {}: invalid missed-run policy '{}' (use skip or run_once)", result.name, missed));
+    }
+    result.grace = std::chrono::seconds(job.get("grace_seconds", 300).asInt64());
+    result.deferUnderLoad = job.get("defer_under_load", true).asBool();
+    return result;
+}
+
+JobScheduler::JobScheduler(const Json::Value& schedulerConfig, std::string stateFile, Logger onMessage, Logger onError)
+    : stateFile_(std::move(stateFile)),
+      onMessage_(std::move(onMessage)),
+      onError_(std::move(onError)),
+      capacity_(readCapacity(schedulerConfig)) {}
+
+std::map<std::string, unsigned> JobScheduler::readCapacity(const Json::Value& schedulerConfig) {
+    std::map<std::string, unsigned> capacity{{"cpu", 2}, {"io", 1}};
+    const Json::Value& slots = schedulerConfig["slots"];
+    if (slots.isObject()) {
+        for (const auto& pool : slots.getMemberNames()) {
+            capacity[pool] = std::max(1u, slots[pool].asUInt());
+        }
+    }
+    return capacity;
+}
+
+std::expected<void, std::string> JobScheduler::fitSlots(ScheduledJob& job, const std::map<std::string, unsigned>& capacity) {
+    for (auto& [pool, units] : job.slots) {
+        auto poolCapacity = capacity.find(pool);
+        if (poolCapacity == capacity.end()) {
+            return std::unexpected(std::format("Job {} uses unknown slot pool '{}'", job.name, pool));
+        }
+        units = std::min(units, poolCapacity->second);
+    }
+    return {};
+}
+
+JobScheduler::~JobScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    for (auto& state : jobs_) {
+        if (state.thread.joinable()) {
+            state.thread.join();
+        }
+    }
+}
+
+std::expected<void, std::string> JobScheduler::addJob(ScheduledJob job) {
+    if (std::ranges::any_of(jobs_, [&job](const JobState& state) { return state.job.name == job.name; })) {
+        return std::unexpected(std::format("Duplicate scheduler job name: {}", job.name));
+    }
+    auto fitted = fitSlots(job, capacity_);
+    if (!fitted) {
+        return fitted;
+    }
+    jobs_.emplace_back().job = std::move(job);
+    return {};
+}
+
+std::expected<void, std::string> JobScheduler::reconfigure(const Json::Value& schedulerConfig, std::vector<ScheduledJob> jobs) {
+    auto capacity = readCapacity(schedulerConfig);
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (std::ranges::any_of(jobs.begin(), jobs.begin() + static_cast<std::ptrdiff_t>(i),
+                                [&](const ScheduledJob& other) { return other.name == jobs[i].name; })) {
+            return std::unexpected(std::format("Duplicate scheduler job name: {}", jobs[i].name));
+        }
+        auto fitted = fitSlots(jobs[i], capacity);
+        if (!fitted) {
+            return fitted;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto now = Clock::now();
+    std::list<JobState> replaced;
+    for (auto& job : jobs) {
+        JobState& state = replaced.emplace_back();
+        auto previous = std::ranges::find_if(jobs_, [&job](const JobState& old) { return old.job.name == job.name; });
+        if (previous != jobs_.end() && previous->job.schedule.expression() == job.schedule.expression()) {
+            state.next = previous->next;
+        } else {
+            state.next = job.schedule.next(now);
+            onMessage_(std::format("Job {} ({}) next runs at {}", job.name, job.schedule.expression(), formatTime(state.next)));
+        }
+        state.job = std::move(job);
+    }
+    for (auto& state : jobs_) {
+        if (state.thread.joinable()) {
+            state.thread.join();
+        }
+    }
+    capacity_ = std::move(capacity);
+    jobs_ = std::move(replaced);
+    return {};
+}
+
+void JobScheduler::whenIdle(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idleTasks_.push_back(std::move(task));
+    }
+    wake_.notify();
+}
+
+void JobScheduler::run(const volatile std::sig_atomic_t& stopFlag) {
+    loadState();
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto startup = Clock::now();
+    for (auto& state : jobs_) {
+        state.next = state.job.schedule.next(startup);
+        auto last = lastRuns_.find(state.job.name);
+        if (last == lastRuns_.end()) {
+            continue;
+        }
+        // Runs due between the last started run and now were missed while the daemon was down.
+        Clock::time_point missed = state.job.schedule.next(Clock::from_time_t(static_cast<std::time_t>(last->second)));
+        if (missed > startup) {
+            continue;
+        }
+        const Clock::time_point first = missed;
+        Clock::time_point latest = missed;
+        size_t count = 0;
+        while (missed <= startup && count < 10000) {
+            latest = missed;
+            ++count;
+            missed = state.job.schedule.next(missed);
+        }
+        lastRuns_[state.job.name] = static_cast<int64_t>(Clock::to_time_t(latest));
+        if (state.job.missed == ScheduledJob::Missed::RunOnce) {
+            onMessage_(std::format("Job {} missed {} run(s) since {}; running it once now", state.job.name, count, formatTime(first)));
+            start(state, latest);
+        } else {
+            onError_(std::format("Job {} missed {} run(s) since {}; skipped until {}", state.job.name, count, formatTime(first),
+                                 formatTime(state.next)));
+        }
+    }
+    saveState();
+    for (const auto& state : jobs_) {
+        onMessage_(std::format("Job {} ({}) next runs at {}", state.job.name, state.job.schedule.expression(), formatTime(state.next)));
+    }
+
+    wake_.receiveSignalWakeups();
+    while (!stopFlag) {
+        const auto now = Clock::now();
+        for (auto& state : jobs_) {
+            if (!state.running && state.thread.joinable()) {
+                state.thread.join();
+                if (state.pending) {
+                    state.pending = false;
+                    start(state, now);
+                }
+            }
+        }
+        if (!idleTasks_.empty() && std::ranges::none_of(jobs_, &JobState::running)) {
+            auto tasks = std::move(idleTasks_);
+            idleTasks_.clear();
+            lock.unlock();
+            for (auto& task : tasks) {
+                task();
+            }
+            lock.lock();
+            continue;
+        }
+        Clock::time_point wakeUp = Clock::time_point::max();
+        for (auto& state : jobs_) {
+            if (state.next <= now) {
+                dispatch(state, state.next, now);
+                state.next = state.job.schedule.next(now);
+            }
+            wakeUp = std::min(wakeUp, state.next);
+        }
+        lock.unlock();
+        const WakeEvent::Reason reason = wake_.waitUntil(wakeUp);
+        lock.lock();
+        if (reason == WakeEvent::Reason::ClockChanged) {
+            // Due times computed before the clock was set back would now lie too far ahead.
+            const auto current = Clock::now();
+            for (auto& state : jobs_) {
+                state.next = std::min(state.next, state.job.schedule.next(current));
+            }
+            onMessage_("System clock was changed; next run times recomputed");
+        }
+    }
+
+    stopping_ = true;
+    const auto running = std::ranges::count_if(jobs_, &JobState::running);
+    if (running > 0) {
+        onMessage_(std::format("Waiting for {} running job(s) to finish", running));
+    }
+    lock.unlock();
+    changed_.notify_all();
+    for (auto& state : jobs_) {
+        if (state.thread.joinable()) {
+            state.thread.join();
+        }
+    }
+}
+
+void JobScheduler::dispatch(JobState& state, Clock::time_point due, Clock::time_point now) {
+    const ScheduledJob& job = state.job;
+    lastRuns_[job.name] = static_cast<int64_t>(Clock::to_time_t(due));
+    saveState();
+    // A run noticed long after its time (e.g., after a suspend) is a missed run.
+    if (now - due > job.grace && job.missed == ScheduledJob::Missed::Skip) {
+        onError_(std::format("Job {} missed its run at {}; skipped", job.name, formatTime(due)));
+        return;
+    }
+    if (state.running) {
+        if (job.overlap == ScheduledJob::Overlap::Skip) {
+            onError_(std::format("Job {} is still running or waiting for slots; skipped its run at {}", job.name, formatTime(due)));
+        } else if (state.pending) {
+            onError_(std::format("Job {} is still running with a run queued; merged its run at {} into it", job.name, formatTime(due)));
+        } else {
+            state.pending = true;
+            onMessage_(std::format("Job {} is still running or waiting for slots; queued its run at {}", job.name, formatTime(due)));
+        }
+        return;
+    }
+    start(state, due);
+}
+
+void JobScheduler::start(JobState& state, Clock::time_point due) {
+    if (state.thread.joinable()) {
+        state.thread.join();
+    }
+    state.running = true;
+    state.thread = std::thread([this, &state, due]() {
+        const ScheduledJob& job = state.job;
+        if (waitForLowLoad(job) && acquireSlots(job)) {
+            onMessage_(std::format("Job {} started (scheduled for {})", job.name, formatTime(due)));
+            const auto started = std::chrono::steady_clock::now();
+            std::expected<void, std::string> result;
+            try {
+                result = job.run();
+            } catch (const std::exception& e) {
+                result = std::unexpected(std::string(e.what()));
+            }
+            releaseSlots(job);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            if (result) {
+                onMessage_(std::format("Job {} finished in {:.0f} s", job.name, seconds));
+            } else {
+                onError_(std::format("Job {} failed after {:.0f} s: {}", job.name, seconds, result.error()));
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            state.running = false;
+        }
+        changed_.notify_all();
+        wake_.notify();
+    });
+}
+
+void JobScheduler::wake() {
+    wake_.notify();
+}
+
+bool JobScheduler::waitForLowLoad(const ScheduledJob& job) {
+    if (!loadMonitor_ || !job.deferUnderLoad) {
+        return true;
+    }
+    auto reason = loadMonitor_->highLoad();
+    if (!reason) {
+        return true;
+    }
+    onMessage_(std::format("Job {} delayed by high load ({})", job.name, *reason));
+    const auto giveUp = std::chrono::steady_clock::now() + loadMonitor_->maxDelay();
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (std::chrono::steady_clock::now() >= giveUp) {
+            onError_(std::format("Job {} starting despite high load after waiting {} min", job.name,
+                                 std::chrono::duration_cast<std::chrono::minutes>(loadMonitor_->maxDelay()).count()));
+            return true;
+        }
+        changed_.wait_for(lock, loadMonitor_->checkInterval(), [this]() { return stopping_; });
+        lock.unlock();
+        reason = loadMonitor_->highLoad();
+        lock.lock();
+        if (!reason) {
+            onMessage_(std::format("Job {} starting, load is back to normal", job.name));
+            return true;
+        }
+    }
+    return false;
+}
+
+bool JobScheduler::acquireSlots(const ScheduledJob& job) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // All units are taken at once, so two jobs never hold part of what the other needs.
+    auto fits = [&]() {
+        return std::ranges::all_of(job.slots, [this](const auto& slot) {
+            return used_[slot.first] + slot.second <= capacity_[slot.first];
+        });
+    };
+    if (!fits() && !stopping_) {
+        onMessage_(std::format("Job {} is waiting for free slots", job.name));
+    }
+    changed_.wait(lock, [&]() { return stopping_ || fits(); });
+    if (stopping_) {
+        return false;
+    }
+    for (const auto& [pool, units] : job.slots) {
+        used_[pool] += units;
+    }
+    return true;
+}
+
+void JobScheduler::releaseSlots(const ScheduledJob& job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [pool, units] : job.slots) {
+            used_[pool] -= units;
+        }
+    }
+    changed_.notify_all();
+}
+
+void JobScheduler::loadState() {
+    std::ifstream in(stateFile_);
+    if (!in) {
+        return;
+    }
+    Json::Value root;
+    Json::Reader reader;
+    if (!reader.parse(in, root) || !root["last_runs"].isObject()) {
+        onError_(std::format("Ignoring unreadable scheduler state {}", stateFile_));
+        return;
+    }
+    for (const auto& name : root["last_runs"].getMemberNames()) {
+        lastRuns_[name] = root["last_runs"][name].asInt64();
+    }
+}
+
+void JobScheduler::saveState() {
+    Json::Value root;
+    Json::Value& lastRuns = root["last_runs"] = Json::Value(Json::objectValue);
+    for (const auto& [name, time] : lastRuns_) {
+        lastRuns[name] = static_cast<Json::Int64>(time);
+    }
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "  ";
+    std::error_code ec;
+    fs::create_directories(fs::path(stateFile_).parent_path(), ec);
+    auto result = writeFileAtomically(stateFile_, Json::writeString(writer, root));
+    if (!result) {
+        onError_(std::format("Failed to write scheduler state: {}", result.error()));
+    }
+}
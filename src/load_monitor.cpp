@@ -0,0 +1,160 @@
+/**
+ * @file load_monitor.cpp
+ * @brief Host load detection from pressure stall information (PSI) and the load average.
+ */
+
+#include "load_monitor.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Share of a limit every signal must fall below before load counts as normal again.
+constexpr double kRecoveryFactor = 0.8;
+
+#ifdef __linux__
+/**
+ * @brief Reads the "some avg10" value of a PSI file, if the kernel provides it.
+ */
+std::optional<double> readPressure(const char* path) {
+    std::ifstream in(path);
+    std::string line;
+    if (!in || !std::getline(in, line)) {
+        return std::nullopt;
+    }
+    double avg10 = 0;
+    if (std::sscanf(line.c_str(), "some avg10=%lf", &avg10) != 1) {
+        return std::nullopt;
+    }
+    return avg10;
+}
+#endif
+
+} // namespace
+
+LoadMonitor::LoadMonitor(const Json::Value& loadConfig, Logger onMessage)
+    : cpuLimit_(loadConfig.get("cpu_pressure", 0).asDouble()),
+      ioLimit_(loadConfig.get("io_pressure", 0).asDouble()),
+      memoryLimit_(loadConfig.get("memory_pressure", 0).asDouble()),
+      loadLimit_(loadConfig.get("load_per_cpu", 0).asDouble()),
+      checkInterval_(std::max<int64_t>(1, loadConfig.get("check_seconds", 10).asInt64())),
+      maxDelay_(loadConfig.get("max_delay_minutes", 60).asInt64() * 60),
+      throttledRate_(loadConfig.get("throttled_rate_mb", 20).asUInt64() * 1024 * 1024),
+      throttledLevel_(std::clamp(loadConfig.get("throttled_compression_level", 1).asInt(), 1, 9)),
+      throttledWorkers_(std::max(1u, loadConfig.get("throttled_threads", 1).asUInt())),
+      onMessage_(std::move(onMessage)) {}
+
+LoadSample LoadMonitor::sample() {
+    LoadSample sample;
+#ifdef __linux__
+    sample.cpuPressure = readPressure("/proc/pressure/cpu");
+    sample.ioPressure = readPressure("/proc/pressure/io");
+    sample.memoryPressure = readPressure("/proc/pressure/memory");
+#endif
+#ifndef _WIN32
+    double load[1];
+    if (::getloadavg(load, 1) == 1) {
+        sample.loadPerCpu = load[0] / std::max(1u, std::thread::hardware_concurrency());
+    }
+#endif
+    return sample;
+}
+
+void LoadMonitor::refresh() {
+    const int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+    int64_t due = nextCheck_.load();
+    // One caller samples per interval; the others keep using the current state.
+    if (now < due || !nextCheck_.compare_exchange_strong(due, now + std::chrono::nanoseconds(checkInterval_).count())) {
+        return;
+    }
+
+    const LoadSample current = sample();
+    std::vector<std::string> over;
+    bool belowRecovery = true;
+    auto check = [&](const char* name, const std::optional<double>& value, double limit, const char* unit) {
+        if (!value || limit <= 0) {
+            return;
+        }
+        if (*value > limit) {
+            over.push_back(std::format("{} {:.1f}{} (limit {}{})", name, *value, unit, limit, unit));
+        }
+        if (*value >= limit * kRecoveryFactor) {
+            belowRecovery = false;
+        }
+    };
+    check("cpu pressure", current.cpuPressure, cpuLimit_, "%");
+    check("io pressure", current.ioPressure, ioLimit_, "%");
+    check("memory pressure", current.memoryPressure, memoryLimit_, "%");
+    check("load per CPU", current.loadPerCpu, loadLimit_, "");
+
+    std::string message;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const bool wasHigh = high_.load();
+        if (!over.empty()) {
+            reason_.clear();
+            for (const auto& item : over) {
+                reason_ += (reason_.empty() ? "" : ", ") + item;
+            }
+        }
+        if (!wasHigh && !over.empty()) {
+            high_ = true;
+            paceStart_ = std::chrono::steady_clock::now();
+            pacedBytes_ = 0;
+            message = std::format("High load ({}): throttling background work", reason_);
+        } else if (wasHigh && belowRecovery) {
+            high_ = false;
+            reason_.clear();
+            message = "Load is back to normal: background work at full speed";
+        }
+    }
+    if (!message.empty() && onMessage_) {
+        onMessage_(message);
+    }
+}
+
+std::optional<std::string> LoadMonitor::highLoad() {
+    refresh();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!high_) {
+        return std::nullopt;
+    }
+    return reason_;
+}
+
+bool LoadMonitor::throttled() {
+    refresh();
+    return high_;
+}
+
+void LoadMonitor::pace(uint64_t bytes) {
+    if (throttledRate_ == 0 || !throttled()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    const auto now = std::chrono::steady_clock::now();
+    auto due = paceStart_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                std::chrono::duration<double>(static_cast<double>(pacedBytes_ + bytes) / static_cast<double>(throttledRate_)));
+    // Time spent not reading (e.g., compressing) is not saved up for a later burst.
+    if (due + std::chrono::seconds(1) < now) {
+        paceStart_ = now;
+        pacedBytes_ = 0;
+        due = now;
+    }
+    pacedBytes_ += bytes;
+    lock.unlock();
+    std::this_thread::sleep_until(due);
+}
+
+int LoadMonitor::compressionLevel(int normal) {
+    return throttled() ? std::min(normal < 0 ? 6 : normal, throttledLevel_) : normal;
+}
+
+unsigned LoadMonitor::workers(unsigned normal) {
+    return throttled() ? std::min(normal, throttledWorkers_) : normal;
+}
@@ -11,6 +11,7 @@ TelegramNotificationStrategy::TelegramNotificationStrategy(const Json::Value& co
     : botToken(config["bot_token"].asString()), chatId(config["chat_id"].asString()) {}
 
 std::expected<void, std::string> TelegramNotificationStrategy::notify(const std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex_);
     CURL* curl = curl_easy_init();
     if (!curl) {
         return std::unexpected("Failed to initialize CURL");
@@ -36,6 +37,7 @@ EmailNotificationStrategy::EmailNotificationStrategy(const Json::Value& config)
     : emailTo(config["email_to"].asString()), smtpServer(config["smtp_server"].asString()) {}
 
 std::expected<void, std::string> EmailNotificationStrategy::notify(const std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex_);
     std::println("Simulated email sent to {} via {}: {}", emailTo, smtpServer, message);
     return {};
 }
\ No newline at end of file
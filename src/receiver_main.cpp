@@ -0,0 +1,667 @@
+/**
+ * @file receiver_main.cpp
+ * @brief securevault-receiver: accepts artifact uploads over the SecureVault streaming protocol.
+ *
+ * Usage:
+ *   securevault-receiver --listen [host:]port --root <dir> (--token <t> | --token-file <f>)
+ *                        (--cert <pem> --key <pem> | --insecure-plaintext)
+ *                        [--max-connections <n>] [--idle-timeout <seconds>]
+ *
+ * Each upload is written with pwrite into a hidden temporary file next to its destination and
+ * renamed into place after its digest was checked and the file was synced on Commit, so readers
+ * never observe partial or damaged artifacts.
+ */
+
+#include "receiver_protocol.hpp"
+#include <openssl/crypto.h>
+#include <openssl/ssl.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t kMaxDataPayload = (1u << 30) + 8; ///< Largest Data frame accepted (1 GiB of file bytes).
+constexpr size_t kReceiveBufferSize = 4 << 20;
+constexpr auto kAuthTimeout = std::chrono::seconds(10); ///< Time a new connection gets to finish TLS and Hello.
+
+std::atomic<bool> stopRequested{false};
+
+void handleStopSignal(int) {
+    stopRequested = true;
+}
+
+struct Options {
+    std::string listenHost;
+    std::string listenPort = "7878";
+    fs::path root;
+    std::string token;
+    std::string certFile;
+    std::string keyFile;
+    bool insecurePlaintext = false;
+    size_t maxConnections = 64;
+    std::chrono::seconds idleTimeout{300};
+};
+
+/**
+ * @brief State of one in-flight upload, shared by every connection attached to it.
+ */
+struct PendingUpload {
+    int fd = -1;
+    fs::path tempPath;
+    fs::path finalPath;
+    uint64_t size = 0;
+    std::atomic<uint64_t> received{0}; ///< Bytes written; equals size only once every byte arrived, as ranges never overlap.
+    std::mutex rangesMutex;
+    std::map<uint64_t, uint64_t> ranges; ///< Claimed byte ranges, start to end, merged when adjacent.
+
+    ~PendingUpload() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    /**
+     * @brief Claims [offset, offset + length) for one Data frame.
+     *
+     * @return bool False if any byte of the range was claimed before.
+     */
+    bool claim(uint64_t offset, uint64_t length) {
+        if (length == 0) {
+            return true;
+        }
+        const uint64_t end = offset + length;
+        std::lock_guard<std::mutex> lock(rangesMutex);
+        auto next = ranges.lower_bound(offset);
+        if (next != ranges.end() && next->first < end) {
+            return false;
+        }
+        auto previous = next == ranges.begin() ? ranges.end() : std::prev(next);
+        if (previous != ranges.end() && previous->second > offset) {
+            return false;
+        }
+        uint64_t start = offset;
+        uint64_t stop = end;
+        if (previous != ranges.end() && previous->second == offset) {
+            start = previous->first;
+            ranges.erase(previous);
+        }
+        if (next != ranges.end() && next->first == end) {
+            stop = next->second;
+            ranges.erase(next);
+        }
+        ranges[start] = stop;
+        return true;
+    }
+};
+
+class UploadRegistry {
+public:
+    uint64_t add(std::shared_ptr<PendingUpload> upload) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const uint64_t id = nextId_++;
+        uploads_[id] = std::move(upload);
+        return id;
+    }
+
+    std::shared_ptr<PendingUpload> find(uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = uploads_.find(id);
+        return it == uploads_.end() ? nullptr : it->second;
+    }
+
+    std::shared_ptr<PendingUpload> remove(uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = uploads_.find(id);
+        if (it == uploads_.end()) {
+            return nullptr;
+        }
+        auto upload = std::move(it->second);
+        uploads_.erase(it);
+        return upload;
+    }
+
+    bool reservePath(const fs::path& path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return activePaths_.insert(path.string()).second;
+    }
+
+    void releasePath(const fs::path& path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        activePaths_.erase(path.string());
+    }
+
+private:
+    std::mutex mutex_;
+    uint64_t nextId_ = 1;
+    std::unordered_map<uint64_t, std::shared_ptr<PendingUpload>> uploads_;
+    std::unordered_set<std::string> activePaths_;
+};
+
+/**
+ * @brief Resolves a client-supplied relative path below root, rejecting escapes.
+ */
+std::expected<fs::path, std::string> resolveUploadPath(const fs::path& root, const std::string& relative) {
+    const fs::path requested(relative);
+    if (relative.empty() || requested.is_absolute() || requested.has_root_name()) {
+        return std::unexpected("Upload path must be relative");
+    }
+    for (const auto& part : requested) {
+        if (part == ".." || part == ".") {
+            return std::unexpected("Upload path must not contain '.' or '..' components");
+        }
+    }
+    if (!requested.has_filename()) {
+        return std::unexpected("Upload path must name a file");
+    }
+    return root / requested;
+}
+
+std::expected<void, std::string> syncDirectory(const fs::path& directory) {
+    const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::unexpected(std::format("Failed to open directory {}: {}", directory.string(), std::strerror(errno)));
+    }
+    const int result = ::fsync(fd);
+    const int savedErrno = errno;
+    ::close(fd);
+    if (result != 0) {
+        return std::unexpected(std::format("Failed to sync directory {}: {}", directory.string(), std::strerror(savedErrno)));
+    }
+    return {};
+}
+
+/**
+ * @brief Serves one client connection until it closes or violates the protocol.
+ */
+class ConnectionHandler {
+public:
+    ConnectionHandler(StreamConnection& connection, UploadRegistry& registry, const Options& options)
+        : connection_(connection), registry_(registry), options_(options), buffer_(kReceiveBufferSize) {}
+
+    ~ConnectionHandler() {
+        // Uploads opened here but never committed are abandoned; attached streams keep the
+        // descriptor alive until they finish, but the temporary file is gone.
+        for (uint64_t id : owned_) {
+            if (auto upload = registry_.remove(id)) {
+                std::error_code ec;
+                fs::remove(upload->tempPath, ec);
+                registry_.releasePath(upload->finalPath);
+                std::cerr << "Discarded incomplete upload: " << upload->finalPath.string() << std::endl;
+            }
+        }
+    }
+
+    void run() {
+        auto hello = handleHello();
+        if (!hello) {
+            reply(FrameType::Error, hello.error());
+            return;
+        }
+        connection_.setTimeout(options_.idleTimeout);
+        while (!stopRequested) {
+            auto header = connection_.readFrameHeader();
+            if (!header) {
+                return;
+            }
+            auto result = dispatch(header->first, header->second);
+            if (!result) {
+                std::cerr << "Receiver error: " << result.error() << std::endl;
+                reply(FrameType::Error, result.error());
+                return;
+            }
+        }
+    }
+
+private:
+    void reply(FrameType type, std::string_view message = {}) {
+        (void)connection_.sendFrame(type, std::span<const char>(message.data(), message.size()));
+    }
+
+    std::expected<void, std::string> handleHello() {
+        auto header = connection_.readFrameHeader();
+        if (!header) {
+            return std::unexpected(header.error());
+        }
+        if (header->first != FrameType::Hello) {
+            return std::unexpected("Expected Hello");
+        }
+        auto payload = connection_.readPayload(header->second);
+        if (!payload) {
+            return std::unexpected(payload.error());
+        }
+        if (payload->size() < 4 || readU32(payload->data()) != kReceiverProtocolMagic) {
+            return std::unexpected("Protocol mismatch");
+        }
+        const std::string_view token(payload->data() + 4, payload->size() - 4);
+        if (token.size() != options_.token.size() ||
+            CRYPTO_memcmp(token.data(), options_.token.data(), token.size()) != 0) {
+            return std::unexpected("Authentication failed");
+        }
+        return connection_.sendFrame(FrameType::Ok, {});
+    }
+
+    std::expected<void, std::string> dispatch(FrameType type, uint32_t length) {
+        if (type == FrameType::Data) {
+            return handleData(length);
+        }
+        auto payload = connection_.readPayload(length);
+        if (!payload) {
+            return std::unexpected(payload.error());
+        }
+        switch (type) {
+        case FrameType::Begin:
+            return handleBegin(*payload);
+        case FrameType::Attach:
+            return handleAttach(*payload);
+        case FrameType::End:
+            return connection_.sendFrame(FrameType::Ok, {});
+        case FrameType::Commit:
+            return handleCommit(*payload);
+        default:
+            return std::unexpected(std::format("Unexpected frame type {}", static_cast<int>(type)));
+        }
+    }
+
+    std::expected<void, std::string> handleBegin(const std::vector<char>& payload) {
+        if (current_) {
+            return std::unexpected("Connection already has an open upload");
+        }
+        if (payload.size() < 10 || payload.size() != 10u + readU16(payload.data() + 8)) {
+            return std::unexpected("Malformed Begin frame");
+        }
+        const uint64_t size = readU64(payload.data());
+        auto finalPath = resolveUploadPath(options_.root, std::string(payload.data() + 10, payload.size() - 10));
+        if (!finalPath) {
+            return std::unexpected(finalPath.error());
+        }
+        if (!registry_.reservePath(*finalPath)) {
+            return std::unexpected("Another upload to this path is in progress");
+        }
+
+        std::error_code ec;
+        fs::create_directories(finalPath->parent_path(), ec);
+        if (ec) {
+            registry_.releasePath(*finalPath);
+            return std::unexpected(std::format("Failed to create directory: {}", ec.message()));
+        }
+
+        auto upload = std::make_shared<PendingUpload>();
+        upload->finalPath = *finalPath;
+        upload->size = size;
+        upload->tempPath = finalPath->parent_path() /
+                           std::format(".{}.partial-{}", finalPath->filename().string(), ::getpid());
+        upload->fd = ::open(upload->tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (upload->fd < 0) {
+            registry_.releasePath(*finalPath);
+            return std::unexpected(std::format("Failed to create {}: {}", upload->tempPath.string(), std::strerror(errno)));
+        }
+#ifdef __linux__
+        // Reserve space up front so a full disk fails the Begin, not the last Data frame.
+        if (size > 0 && ::posix_fallocate(upload->fd, 0, static_cast<off_t>(size)) != 0) {
+            fs::remove(upload->tempPath, ec);
+            registry_.releasePath(*finalPath);
+            return std::unexpected("Not enough space for upload");
+        }
+#endif
+
+        current_ = upload;
+        currentId_ = registry_.add(std::move(upload));
+        owned_.insert(currentId_);
+
+        std::vector<char> reply;
+        appendU64(reply, currentId_);
+        return connection_.sendFrame(FrameType::Ok, reply);
+    }
+
+    std::expected<void, std::string> handleAttach(const std::vector<char>& payload) {
+        if (current_) {
+            return std::unexpected("Connection already has an open upload");
+        }
+        if (payload.size() != 8) {
+            return std::unexpected("Malformed Attach frame");
+        }
+        currentId_ = readU64(payload.data());
+        current_ = registry_.find(currentId_);
+        if (!current_) {
+            return std::unexpected("Unknown upload id");
+        }
+        return connection_.sendFrame(FrameType::Ok, {});
+    }
+
+    std::expected<void, std::string> handleData(uint32_t length) {
+        if (!current_) {
+            return std::unexpected("Data frame without an open upload");
+        }
+        if (length < 8 || length > kMaxDataPayload) {
+            return std::unexpected("Malformed Data frame");
+        }
+        std::array<char, 8> offsetBytes{};
+        auto readResult = connection_.readExact(offsetBytes);
+        if (!readResult) {
+            return readResult;
+        }
+        uint64_t offset = readU64(offsetBytes.data());
+        uint64_t remaining = length - 8;
+        if (offset > current_->size || remaining > current_->size - offset) {
+            return std::unexpected("Data frame outside the announced size");
+        }
+        if (!current_->claim(offset, remaining)) {
+            return std::unexpected("Data frame overlaps bytes already received");
+        }
+
+        while (remaining > 0) {
+            const size_t want = static_cast<size_t>(std::min<uint64_t>(remaining, buffer_.size()));
+            auto chunkResult = connection_.readExact(std::span<char>(buffer_.data(), want));
+            if (!chunkResult) {
+                return chunkResult;
+            }
+            size_t written = 0;
+            while (written < want) {
+                const ssize_t result = ::pwrite(current_->fd, buffer_.data() + written, want - written,
+                                                static_cast<off_t>(offset + written));
+                if (result < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return std::unexpected(std::format("Failed to write upload: {}", std::strerror(errno)));
+                }
+                written += static_cast<size_t>(result);
+            }
+            offset += want;
+            remaining -= want;
+            current_->received += want;
+        }
+        return {};
+    }
+
+    std::expected<void, std::string> handleCommit(const std::vector<char>& payload) {
+        if (payload.size() != 8 + 32) {
+            return std::unexpected("Malformed Commit frame");
+        }
+        if (!current_ || !owned_.contains(currentId_)) {
+            return std::unexpected("Commit must be sent on the connection that began the upload");
+        }
+
+        auto upload = registry_.remove(currentId_);
+        owned_.erase(currentId_);
+        current_.reset();
+        if (!upload) {
+            return std::unexpected("Upload was discarded");
+        }
+        registry_.releasePath(upload->finalPath);
+
+        auto discard = [&](std::string message) -> std::expected<void, std::string> {
+            std::error_code ec;
+            fs::remove(upload->tempPath, ec);
+            return std::unexpected(std::move(message));
+        };
+
+        const uint64_t size = readU64(payload.data());
+        if (size != upload->size || upload->received != upload->size) {
+            return discard(std::format("Size mismatch: announced {}, committed {}, received {}",
+                                       upload->size, size, upload->received.load()));
+        }
+        const int readFd = ::open(upload->tempPath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (readFd < 0) {
+            return discard(std::format("Failed to reopen upload: {}", std::strerror(errno)));
+        }
+        auto digest = digestFile(readFd, upload->size, std::thread::hardware_concurrency());
+        ::close(readFd);
+        if (!digest) {
+            return discard(digest.error());
+        }
+        if (!std::equal(digest->begin(), digest->end(), reinterpret_cast<const uint8_t*>(payload.data() + 8))) {
+            return discard(std::format("Digest mismatch: stored {} differs from the sender's", Sha256::toHex(*digest)));
+        }
+        if (::fsync(upload->fd) != 0) {
+            return discard(std::format("Failed to sync upload: {}", std::strerror(errno)));
+        }
+        if (::rename(upload->tempPath.c_str(), upload->finalPath.c_str()) != 0) {
+            return discard(std::format("Failed to rename upload: {}", std::strerror(errno)));
+        }
+        auto syncResult = syncDirectory(upload->finalPath.parent_path());
+        if (!syncResult) {
+            return syncResult;
+        }
+
+        std::cout << "Received: " << upload->finalPath.string() << " (" << upload->size << " bytes)" << std::endl;
+        return connection_.sendFrame(FrameType::Ok, {});
+    }
+
+    StreamConnection& connection_;
+    UploadRegistry& registry_;
+    const Options& options_;
+    std::vector<char> buffer_;
+    std::shared_ptr<PendingUpload> current_;
+    uint64_t currentId_ = 0;
+    std::unordered_set<uint64_t> owned_;
+};
+
+void serveConnection(int fd, ssl_ctx_st* tls, UploadRegistry& registry, const Options& options) {
+    // Until Hello is accepted, a silent or slow peer only holds its slot for a few seconds.
+    const timeval authTimeout{static_cast<time_t>(kAuthTimeout.count()), 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &authTimeout, sizeof(authTimeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &authTimeout, sizeof(authTimeout));
+    ssl_st* ssl = nullptr;
+    if (tls) {
+        ssl = SSL_new(tls);
+        if (!ssl || SSL_set_fd(ssl, fd) != 1 || SSL_accept(ssl) != 1) {
+            std::cerr << "TLS handshake failed: " << lastTlsError() << std::endl;
+            if (ssl) {
+                SSL_free(ssl);
+            }
+            ::close(fd);
+            return;
+        }
+    }
+    StreamConnection connection(fd, ssl);
+    ConnectionHandler(connection, registry, options).run();
+}
+
+std::expected<int, std::string> openListener(const Options& options) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo* addresses = nullptr;
+    const int gaiResult = ::getaddrinfo(options.listenHost.empty() ? nullptr : options.listenHost.c_str(),
+                                        options.listenPort.c_str(), &hints, &addresses);
+    if (gaiResult != 0) {
+        return std::unexpected(std::format("Failed to resolve listen address: {}", gai_strerror(gaiResult)));
+    }
+
+    int fd = -1;
+    std::string bindError = "no addresses";
+    for (addrinfo* address = addresses; address; address = address->ai_next) {
+        fd = ::socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+        if (fd < 0) {
+            bindError = std::strerror(errno);
+            continue;
+        }
+        const int enable = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+        if (::bind(fd, address->ai_addr, address->ai_addrlen) == 0 && ::listen(fd, 64) == 0) {
+            break;
+        }
+        bindError = std::strerror(errno);
+        ::close(fd);
+        fd = -1;
+    }
+    ::freeaddrinfo(addresses);
+    if (fd < 0) {
+        return std::unexpected(std::format("Failed to listen: {}", bindError));
+    }
+    return fd;
+}
+
+std::expected<Options, std::string> parseArguments(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::expected<std::string, std::string> {
+            if (i + 1 >= argc) {
+                return std::unexpected(std::format("Missing value for {}", arg));
+            }
+            return std::string(argv[++i]);
+        };
+
+        if (arg == "--insecure-plaintext") {
+            options.insecurePlaintext = true;
+            continue;
+        }
+        auto parameter = value();
+        if (!parameter) {
+            return std::unexpected(parameter.error());
+        }
+        if (arg == "--listen") {
+            const size_t colon = parameter->rfind(':');
+            if (colon == std::string::npos) {
+                options.listenPort = *parameter;
+            } else {
+                options.listenHost = parameter->substr(0, colon);
+                options.listenPort = parameter->substr(colon + 1);
+            }
+        } else if (arg == "--root") {
+            options.root = *parameter;
+        } else if (arg == "--token") {
+            options.token = *parameter;
+        } else if (arg == "--token-file") {
+            std::ifstream tokenFile(*parameter);
+            if (!tokenFile || !std::getline(tokenFile, options.token)) {
+                return std::unexpected(std::format("Failed to read token file: {}", *parameter));
+            }
+        } else if (arg == "--cert") {
+            options.certFile = *parameter;
+        } else if (arg == "--key") {
+            options.keyFile = *parameter;
+        } else if (arg == "--max-connections") {
+            options.maxConnections = std::max<size_t>(1, std::strtoul(parameter->c_str(), nullptr, 10));
+        } else if (arg == "--idle-timeout") {
+            options.idleTimeout = std::chrono::seconds(std::strtoul(parameter->c_str(), nullptr, 10));
+        } else {
+            return std::unexpected(std::format("Unknown option: {}", arg));
+        }
+    }
+
+    if (options.root.empty() || options.token.empty()) {
+        return std::unexpected("--root and --token (or --token-file) are required");
+    }
+    if (!options.insecurePlaintext && (options.certFile.empty() || options.keyFile.empty())) {
+        return std::unexpected("--cert and --key are required unless --insecure-plaintext is given");
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    auto options = parseArguments(argc, argv);
+    if (!options) {
+        std::cerr << options.error() << "\n"
+                  << "Usage: securevault-receiver --listen [host:]port --root <dir> (--token <t> | --token-file <f>)\n"
+                  << "                            (--cert <pem> --key <pem> | --insecure-plaintext)\n"
+                  << "                            [--max-connections <n>] [--idle-timeout <seconds>]" << std::endl;
+        return 2;
+    }
+
+    std::error_code ec;
+    fs::create_directories(options->root, ec);
+    if (ec) {
+        std::cerr << "Failed to create root directory: " << ec.message() << std::endl;
+        return 1;
+    }
+
+    ssl_ctx_st* tls = nullptr;
+    if (!options->insecurePlaintext) {
+        auto context = createServerTlsContext(options->certFile, options->keyFile);
+        if (!context) {
+            std::cerr << context.error() << std::endl;
+            return 1;
+        }
+        tls = *context;
+    } else {
+        std::cerr << "Warning: serving without TLS; use only on trusted networks" << std::endl;
+    }
+
+    auto listener = openListener(*options);
+    if (!listener) {
+        std::cerr << listener.error() << std::endl;
+        freeTlsContext(tls);
+        return 1;
+    }
+
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
+
+    std::cout << "securevault-receiver listening on " << (options->listenHost.empty() ? "*" : options->listenHost)
+              << ":" << options->listenPort << ", root " << options->root.string() << std::endl;
+
+    UploadRegistry registry;
+    std::mutex clientsMutex;
+    std::condition_variable clientsDone;
+    std::unordered_set<int> clients;
+
+    while (!stopRequested) {
+        pollfd listenPoll{*listener, POLLIN, 0};
+        if (::poll(&listenPoll, 1, 500) <= 0) {
+            continue;
+        }
+        const int client = ::accept4(*listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            if (clients.size() >= options->maxConnections) {
+                std::cerr << "Refusing connection: " << options->maxConnections << " connections already open" << std::endl;
+                ::close(client);
+                continue;
+            }
+            clients.insert(client);
+        }
+        std::thread([&, client]() {
+            serveConnection(client, tls, registry, *options);
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            clients.erase(client);
+            clientsDone.notify_all();
+        }).detach();
+    }
+
+    std::cout << "Shutting down receiver" << std::endl;
+    ::close(*listener);
+    {
+        // Unblock connection threads waiting in recv; their uploads are discarded.
+        std::unique_lock<std::mutex> lock(clientsMutex);
+        for (int client : clients) {
+            ::shutdown(client, SHUT_RDWR);
+        }
+        clientsDone.wait(lock, [&]() { return clients.empty(); });
+    }
+    freeTlsContext(tls);
+    return 0;
+}
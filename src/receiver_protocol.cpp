@@ -0,0 +1,510 @@
+/**
+ * @file receiver_protocol.cpp
+ * @brief Socket, TLS and framing primitives for the SecureVault receiver protocol.
+ */
+
+#include "receiver_protocol.hpp"
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <mutex>
+#include <thread>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <csignal>
+#include <ctime>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+namespace {
+
+constexpr size_t kCopyBufferSize = 1 << 20;
+
+/**
+ * @brief Blocks SIGPIPE in the calling thread while it writes to a socket.
+ *
+ * TLS and sendfile writes cannot pass MSG_NOSIGNAL, so a peer reset would raise SIGPIPE and end
+ * the process. The signal is held and discarded instead, leaving the process-wide disposition
+ * untouched.
+ */
+class SigpipeBlock {
+public:
+    SigpipeBlock() {
+        sigset_t pending;
+        sigemptyset(&pending);
+        sigpending(&pending);
+        // A SIGPIPE pending from before belongs to someone else and must not be swallowed.
+        alreadyPending_ = sigismember(&pending, SIGPIPE) == 1;
+        if (!alreadyPending_) {
+            sigset_t block;
+            sigemptyset(&block);
+            sigaddset(&block, SIGPIPE);
+            pthread_sigmask(SIG_BLOCK, &block, &previous_);
+        }
+    }
+
+    ~SigpipeBlock() {
+        if (alreadyPending_) {
+            return;
+        }
+        sigset_t block;
+        sigemptyset(&block);
+        sigaddset(&block, SIGPIPE);
+        const timespec noWait{0, 0};
+        while (sigtimedwait(&block, nullptr, &noWait) > 0) {
+        }
+        pthread_sigmask(SIG_SETMASK, &previous_, nullptr);
+    }
+
+    SigpipeBlock(const SigpipeBlock&) = delete;
+    SigpipeBlock& operator=(const SigpipeBlock&) = delete;
+
+private:
+    sigset_t previous_{};
+    bool alreadyPending_ = false;
+};
+
+std::expected<void, std::string> sendFileRangeCopying(StreamConnection& connection, int fileFd, uint64_t offset, uint64_t length) {
+    std::vector<char> buffer(static_cast<size_t>(std::min<uint64_t>(length, kCopyBufferSize)));
+    while (length > 0) {
+        const size_t want = static_cast<size_t>(std::min<uint64_t>(length, buffer.size()));
+        const ssize_t bytesRead = ::pread(fileFd, buffer.data(), want, static_cast<off_t>(offset));
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return std::unexpected(std::format("Failed to read local file: {}", std::strerror(errno)));
+        }
+        if (bytesRead == 0) {
+            return std::unexpected("Local file shrank during transfer");
+        }
+        auto writeResult = connection.writeAll(std::span<const char>(buffer.data(), static_cast<size_t>(bytesRead)));
+        if (!writeResult) {
+            return writeResult;
+        }
+        offset += static_cast<uint64_t>(bytesRead);
+        length -= static_cast<uint64_t>(bytesRead);
+    }
+    return {};
+}
+
+} // namespace
+
+StreamConnection::StreamConnection(int fd, ssl_st* ssl) : fd_(fd), ssl_(ssl) {}
+
+StreamConnection::~StreamConnection() {
+    if (ssl_) {
+        SSL_shutdown(ssl_);
+        SSL_free(ssl_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+std::expected<std::unique_ptr<StreamConnection>, std::string> StreamConnection::connect(const std::string& host,
+                                                                                        int port,
+                                                                                        ssl_ctx_st* tls,
+                                                                                        bool verifyHost) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    const std::string service = std::to_string(port);
+    const int gaiResult = ::getaddrinfo(host.c_str(), service.c_str(), &hints, &addresses);
+    if (gaiResult != 0) {
+        return std::unexpected(std::format("Failed to resolve {}: {}", host, gai_strerror(gaiResult)));
+    }
+
+    int fd = -1;
+    std::string connectError = "no addresses";
+    for (addrinfo* address = addresses; address; address = address->ai_next) {
+        fd = ::socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+        if (fd < 0) {
+            connectError = std::strerror(errno);
+            continue;
+        }
+        if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0) {
+            break;
+        }
+        connectError = std::strerror(errno);
+        ::close(fd);
+        fd = -1;
+    }
+    ::freeaddrinfo(addresses);
+    if (fd < 0) {
+        return std::unexpected(std::format("Failed to connect to {}:{}: {}", host, port, connectError));
+    }
+
+    const int noDelay = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+#ifdef SO_NOSIGPIPE
+    const int noSigpipe = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigpipe, sizeof(noSigpipe));
+#endif
+
+    if (!tls) {
+        return std::make_unique<StreamConnection>(fd, nullptr);
+    }
+
+    SSL* ssl = SSL_new(tls);
+    if (!ssl) {
+        ::close(fd);
+        return std::unexpected(std::format("Failed to create TLS session: {}", lastTlsError()));
+    }
+    auto connection = std::make_unique<StreamConnection>(fd, ssl);
+    SSL_set_fd(ssl, fd);
+    SSL_set_tlsext_host_name(ssl, host.c_str());
+    if (verifyHost) {
+        SSL_set1_host(ssl, host.c_str());
+    }
+    if (SSL_connect(ssl) != 1) {
+        return std::unexpected(std::format("TLS handshake with {}:{} failed: {}", host, port, lastTlsError()));
+    }
+    return connection;
+}
+
+void StreamConnection::setTimeout(std::chrono::milliseconds timeout) {
+    const timeval value{static_cast<time_t>(timeout.count() / 1000), static_cast<suseconds_t>(timeout.count() % 1000 * 1000)};
+    ::setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &value, sizeof(value));
+    ::setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &value, sizeof(value));
+}
+
+std::expected<void, std::string> StreamConnection::writeAll(std::span<const char> data) {
+    SigpipeBlock sigpipeBlock;
+    size_t written = 0;
+    while (written < data.size()) {
+        if (ssl_) {
+            const size_t chunk = std::min<size_t>(data.size() - written, 1 << 30);
+            const int result = SSL_write(ssl_, data.data() + written, static_cast<int>(chunk));
+            if (result <= 0) {
+                return std::unexpected(std::format("TLS write failed: {}", lastTlsError()));
+            }
+            written += static_cast<size_t>(result);
+        } else {
+            const ssize_t result = ::send(fd_, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return std::unexpected(std::format("Socket write failed: {}", std::strerror(errno)));
+            }
+            written += static_cast<size_t>(result);
+        }
+    }
+    return {};
+}
+
+std::expected<void, std::string> StreamConnection::readExact(std::span<char> data) {
+    size_t received = 0;
+    while (received < data.size()) {
+        if (ssl_) {
+            const size_t chunk = std::min<size_t>(data.size() - received, 1 << 30);
+            const int result = SSL_read(ssl_, data.data() + received, static_cast<int>(chunk));
+            if (result <= 0) {
+                return std::unexpected(SSL_get_error(ssl_, result) == SSL_ERROR_ZERO_RETURN
+                                           ? std::string("Connection closed by peer")
+                                           : std::format("TLS read failed: {}", lastTlsError()));
+            }
+            received += static_cast<size_t>(result);
+        } else {
+            const ssize_t result = ::recv(fd_, data.data() + received, data.size() - received, 0);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return std::unexpected("Connection timed out");
+                }
+                return std::unexpected(std::format("Socket read failed: {}", std::strerror(errno)));
+            }
+            if (result == 0) {
+                return std::unexpected("Connection closed by peer");
+            }
+            received += static_cast<size_t>(result);
+        }
+    }
+    return {};
+}
+
+std::expected<void, std::string> StreamConnection::sendFrame(FrameType type, std::span<const char> payload) {
+    std::vector<char> frame;
+    frame.reserve(5 + payload.size());
+    frame.push_back(static_cast<char>(type));
+    appendU32(frame, static_cast<uint32_t>(payload.size()));
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    return writeAll(frame);
+}
+
+std::expected<void, std::string> StreamConnection::sendFileRange(int fileFd, uint64_t offset, uint64_t length) {
+    std::vector<char> header;
+    header.push_back(static_cast<char>(FrameType::Data));
+    appendU32(header, static_cast<uint32_t>(8 + length));
+    appendU64(header, offset);
+    auto headerResult = writeAll(header);
+    if (!headerResult) {
+        return headerResult;
+    }
+
+#if defined(__linux__)
+    SigpipeBlock sigpipeBlock;
+    if (!ssl_) {
+        off_t position = static_cast<off_t>(offset);
+        uint64_t remaining = length;
+        while (remaining > 0) {
+            const ssize_t sent = ::sendfile(fd_, fileFd, &position, static_cast<size_t>(std::min<uint64_t>(remaining, 1 << 30)));
+            if (sent < 0) {
+                if (errno == EINTR || errno == EAGAIN) {
+                    continue;
+                }
+                return std::unexpected(std::format("sendfile failed: {}", std::strerror(errno)));
+            }
+            if (sent == 0) {
+                return std::unexpected("Local file shrank during transfer");
+            }
+            remaining -= static_cast<uint64_t>(sent);
+        }
+        return {};
+    }
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(OPENSSL_NO_KTLS)
+    if (BIO_get_ktls_send(SSL_get_wbio(ssl_))) {
+        uint64_t position = offset;
+        uint64_t remaining = length;
+        while (remaining > 0) {
+            const ossl_ssize_t sent = SSL_sendfile(ssl_, fileFd, static_cast<off_t>(position),
+                                                   static_cast<size_t>(std::min<uint64_t>(remaining, 1 << 30)), 0);
+            if (sent <= 0) {
+                return std::unexpected(std::format("SSL_sendfile failed: {}", lastTlsError()));
+            }
+            position += static_cast<uint64_t>(sent);
+            remaining -= static_cast<uint64_t>(sent);
+        }
+        return {};
+    }
+#endif
+#endif
+    return sendFileRangeCopying(*this, fileFd, offset, length);
+}
+
+std::expected<std::pair<FrameType, uint32_t>, std::string> StreamConnection::readFrameHeader() {
+    std::array<char, 5> header{};
+    auto readResult = readExact(header);
+    if (!readResult) {
+        return std::unexpected(readResult.error());
+    }
+    return std::make_pair(static_cast<FrameType>(header[0]), readU32(header.data() + 1));
+}
+
+std::expected<std::vector<char>, std::string> StreamConnection::readPayload(uint32_t length) {
+    if (length > kMaxControlPayload) {
+        return std::unexpected(std::format("Control frame too large: {} bytes", length));
+    }
+    std::vector<char> payload(length);
+    auto readResult = readExact(payload);
+    if (!readResult) {
+        return std::unexpected(readResult.error());
+    }
+    return payload;
+}
+
+std::expected<std::vector<char>, std::string> StreamConnection::expectOk() {
+    auto header = readFrameHeader();
+    if (!header) {
+        return std::unexpected(header.error());
+    }
+    auto payload = readPayload(header->second);
+    if (!payload) {
+        return std::unexpected(payload.error());
+    }
+    if (header->first == FrameType::Error) {
+        return std::unexpected(std::format("Receiver error: {}", std::string(payload->begin(), payload->end())));
+    }
+    if (header->first != FrameType::Ok) {
+        return std::unexpected(std::format("Unexpected reply frame type {}", static_cast<int>(header->first)));
+    }
+    return payload;
+}
+
+void appendU16(std::vector<char>& out, uint16_t value) {
+    out.push_back(static_cast<char>(value >> 8));
+    out.push_back(static_cast<char>(value));
+}
+
+void appendU32(std::vector<char>& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>(value >> shift));
+    }
+}
+
+void appendU64(std::vector<char>& out, uint64_t value) {
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>(value >> shift));
+    }
+}
+
+void UploadDigest::update(std::span<const char> data) {
+    while (!data.empty()) {
+        const size_t length = static_cast<size_t>(std::min<uint64_t>(data.size(), kDigestBlockSize - blockBytes_));
+        block_.update(data.first(length));
+        blockBytes_ += length;
+        data = data.subspan(length);
+        if (blockBytes_ == kDigestBlockSize) {
+            const auto blockDigest = block_.digest();
+            outer_.update(std::span<const char>(reinterpret_cast<const char*>(blockDigest.data()), blockDigest.size()));
+            block_ = Sha256();
+            blockBytes_ = 0;
+        }
+    }
+}
+
+std::array<uint8_t, 32> UploadDigest::finish() {
+    if (blockBytes_ > 0) {
+        const auto blockDigest = block_.digest();
+        outer_.update(std::span<const char>(reinterpret_cast<const char*>(blockDigest.data()), blockDigest.size()));
+    }
+    return outer_.digest();
+}
+
+std::expected<std::array<uint8_t, 32>, std::string> digestFile(int fileFd, uint64_t size, unsigned threads) {
+    const uint64_t blocks = (size + kDigestBlockSize - 1) / kDigestBlockSize;
+    std::vector<std::array<uint8_t, 32>> blockDigests(blocks);
+    std::atomic<uint64_t> nextBlock{0};
+    std::atomic<bool> failed{false};
+    std::string error;
+    std::mutex errorMutex;
+
+    auto worker = [&]() {
+        std::vector<char> buffer(kCopyBufferSize);
+        for (uint64_t block = nextBlock++; block < blocks && !failed; block = nextBlock++) {
+            Sha256 digest;
+            uint64_t offset = block * kDigestBlockSize;
+            const uint64_t end = std::min(size, offset + kDigestBlockSize);
+            while (offset < end) {
+                const ssize_t bytesRead = ::pread(fileFd, buffer.data(), static_cast<size_t>(std::min<uint64_t>(end - offset, buffer.size())),
+                                                  static_cast<off_t>(offset));
+                if (bytesRead < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (bytesRead <= 0) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    error = bytesRead < 0 ? std::format("Failed to read file for digest: {}", std::strerror(errno)) : "File shrank while hashing";
+                    failed = true;
+                    return;
+                }
+                digest.update(std::span<const char>(buffer.data(), static_cast<size_t>(bytesRead)));
+                offset += static_cast<uint64_t>(bytesRead);
+            }
+            blockDigests[block] = digest.digest();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    const uint64_t threadCount = std::clamp<uint64_t>(threads, 1, std::max<uint64_t>(blocks, 1));
+    for (uint64_t i = 1; i < threadCount; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    if (failed) {
+        return std::unexpected(error);
+    }
+
+    Sha256 outer;
+    for (const auto& blockDigest : blockDigests) {
+        outer.update(std::span<const char>(reinterpret_cast<const char*>(blockDigest.data()), blockDigest.size()));
+    }
+    return outer.digest();
+}
+
+uint16_t readU16(const char* data) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+    return static_cast<uint16_t>((bytes[0] << 8) | bytes[1]);
+}
+
+uint32_t readU32(const char* data) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+    return (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+           (static_cast<uint32_t>(bytes[2]) << 8) | static_cast<uint32_t>(bytes[3]);
+}
+
+uint64_t readU64(const char* data) {
+    return (static_cast<uint64_t>(readU32(data)) << 32) | readU32(data + 4);
+}
+
+namespace {
+
+void configureCommonTls(SSL_CTX* context) {
+    SSL_CTX_set_min_proto_version(context, TLS1_2_VERSION);
+    // AEAD suites only; AES-GCM where AES-NI exists, ChaCha20-Poly1305 elsewhere.
+    SSL_CTX_set_ciphersuites(context, "TLS_AES_128_GCM_SHA256:TLS_CHACHA20_POLY1305_SHA256:TLS_AES_256_GCM_SHA384");
+    SSL_CTX_set_cipher_list(context, "ECDHE+AESGCM:ECDHE+CHACHA20");
+#ifdef SSL_OP_ENABLE_KTLS
+    SSL_CTX_set_options(context, SSL_OP_ENABLE_KTLS);
+#endif
+}
+
+} // namespace
+
+std::expected<ssl_ctx_st*, std::string> createClientTlsContext(const std::string& caFile, bool verifyPeer) {
+    SSL_CTX* context = SSL_CTX_new(TLS_client_method());
+    if (!context) {
+        return std::unexpected(std::format("Failed to create TLS context: {}", lastTlsError()));
+    }
+    configureCommonTls(context);
+    if (verifyPeer) {
+        const int loaded = caFile.empty()
+            ? SSL_CTX_set_default_verify_paths(context)
+            : SSL_CTX_load_verify_locations(context, caFile.c_str(), nullptr);
+        if (loaded != 1) {
+            SSL_CTX_free(context);
+            return std::unexpected(std::format("Failed to load TLS trust store: {}", lastTlsError()));
+        }
+        SSL_CTX_set_verify(context, SSL_VERIFY_PEER, nullptr);
+    } else {
+        SSL_CTX_set_verify(context, SSL_VERIFY_NONE, nullptr);
+    }
+    return context;
+}
+
+std::expected<ssl_ctx_st*, std::string> createServerTlsContext(const std::string& certFile, const std::string& keyFile) {
+    SSL_CTX* context = SSL_CTX_new(TLS_server_method());
+    if (!context) {
+        return std::unexpected(std::format("Failed to create TLS context: {}", lastTlsError()));
+    }
+    configureCommonTls(context);
+    if (SSL_CTX_use_certificate_chain_file(context, certFile.c_str()) != 1 ||
+        SSL_CTX_use_PrivateKey_file(context, keyFile.c_str(), SSL_FILETYPE_PEM) != 1 ||
+        SSL_CTX_check_private_key(context) != 1) {
+        const std::string error = lastTlsError();
+        SSL_CTX_free(context);
+        return std::unexpected(std::format("Failed to load TLS certificate or key: {}", error));
+    }
+    return context;
+}
+
+void freeTlsContext(ssl_ctx_st* context) {
+    SSL_CTX_free(context);
+}
+
+std::string lastTlsError() {
+    const unsigned long code = ERR_get_error();
+    if (code == 0) {
+        return std::strerror(errno);
+    }
+    char buf[256];
+    ERR_error_string_n(code, buf, sizeof(buf));
+    return buf;
+}
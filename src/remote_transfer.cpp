@@ -1,4 +1,6 @@
 #include "remote_transfer.hpp"
+#include "digest.hpp"
+#include "transfer_metrics.hpp"
 #include <libssh/libssh.h>
 #include <libssh/sftp.h>
 #include <filesystem>
@@ -8,11 +10,30 @@
 #include <sstream>
 #include <algorithm>
 #include <fcntl.h>
+#include <chrono>
+#include <deque>
+#include <unordered_set>
+
+// Asynchronous SFTP writes (sftp_aio_*) appeared in libssh 0.11.
+#if LIBSSH_VERSION_INT >= SSH_VERSION_INT(0, 11, 0)
+#define SECUREVAULT_SFTP_AIO 1
+#endif
 
 namespace fs = std::filesystem;
 
 namespace {
 
+// Pooled sessions idle for longer than this are assumed to have been dropped by the server.
+constexpr auto kSessionIdleTimeout = std::chrono::minutes(5);
+
+/**
+ * @brief Regular file found in a remote directory listing.
+ */
+struct RemoteEntry {
+    std::string name; ///< File name within the listed directory.
+    std::chrono::system_clock::time_point modified; ///< Remote modification time.
+};
+
 std::string normalizeRemotePath(std::string path) {
     std::replace(path.begin(), path.end(), '\\', '/');
     while (path.size() > 1 && path.back() == '/') {
@@ -68,12 +89,21 @@ std::expected<void, std::string> verifyHostKey(ssh_session ssh) {
     return std::unexpected(std::format("SSH host key verification failed: {}", knownHostStatusToString(knownState)));
 }
 
-std::expected<void, std::string> ensureRemoteDirectories(sftp_session sftp, const std::string& directory) {
+/**
+ * @brief Creates every missing segment of a remote directory path.
+ *
+ * Segments listed in known are assumed to exist and skipped; "already exists" replies count as
+ * success. Returns every prefix of the path, all of which exist once the call succeeds.
+ */
+std::expected<std::vector<std::string>, std::string> ensureRemoteDirectories(sftp_session sftp,
+                                                                            const std::string& directory,
+                                                                            const std::unordered_set<std::string>& known) {
     std::string normalized = normalizeRemotePath(directory);
     if (normalized.empty()) {
         return std::unexpected("Remote destination directory is empty");
     }
 
+    std::vector<std::string> prefixes;
     std::string current = normalized.starts_with('/') ? "/" : "";
     std::stringstream ss(normalized);
     std::string segment;
@@ -86,7 +116,11 @@ std::expected<void, std::string> ensureRemoteDirectories(sftp_session sftp, cons
             current += "/";
         }
         current += segment;
+        prefixes.push_back(current);
 
+        if (known.contains(current)) {
+            continue;
+        }
         if (sftp_mkdir(sftp, current.c_str(), 0700) == SSH_ERROR) {
             const int sftpError = sftp_get_error(sftp);
             if (sftpError != SSH_FX_FILE_ALREADY_EXISTS) {
@@ -95,157 +129,625 @@ std::expected<void, std::string> ensureRemoteDirectories(sftp_session sftp, cons
         }
     }
 
-    return {};
+    return prefixes;
+}
+
+/**
+ * @brief Lists the regular files of a remote directory in a single pass.
+ *
+ * The SFTP READDIR reply already carries attributes for a batch of entries, so no extra
+ * stat round trip is needed per file. A missing directory yields an empty listing.
+ */
+std::expected<std::vector<RemoteEntry>, std::string> listRemoteDirectory(sftp_session sftp, const std::string& directory) {
+    sftp_dir dir = sftp_opendir(sftp, directory.c_str());
+    if (!dir) {
+        const int sftpError = sftp_get_error(sftp);
+        if (sftpError == SSH_FX_NO_SUCH_FILE) {
+            return std::vector<RemoteEntry>{};
+        }
+        return std::unexpected(std::format("Failed to open remote directory '{}', SFTP error {}", directory, sftpError));
+    }
+
+    std::vector<RemoteEntry> entries;
+    while (sftp_attributes attributes = sftp_readdir(sftp, dir)) {
+        if (attributes->type == SSH_FILEXFER_TYPE_REGULAR && attributes->name) {
+            entries.push_back({attributes->name, std::chrono::system_clock::from_time_t(static_cast<std::time_t>(attributes->mtime))});
+        }
+        sftp_attributes_free(attributes);
+    }
+
+    const bool complete = sftp_dir_eof(dir) == 1;
+    sftp_closedir(dir);
+    if (!complete) {
+        return std::unexpected(std::format("Failed to list remote directory '{}', SFTP error {}", directory, sftp_get_error(sftp)));
+    }
+    return entries;
+}
+
+std::string quoteShellArgument(const std::string& value) {
+    std::string quoted = "'";
+    for (char ch : value) {
+        if (ch == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted.push_back(ch);
+        }
+    }
+    quoted.push_back('\'');
+    return quoted;
+}
+
+/**
+ * @brief Runs a command over an SSH exec channel and returns its standard output.
+ *
+ * Fails if the channel cannot be opened (e.g., SFTP-only accounts) or the command exits non-zero.
+ */
+std::expected<std::string, std::string> runRemoteCommand(ssh_session ssh, const std::string& command) {
+    ssh_channel channel = ssh_channel_new(ssh);
+    if (!channel) {
+        return std::unexpected(std::format("Failed to create SSH channel: {}", ssh_get_error(ssh)));
+    }
+    if (ssh_channel_open_session(channel) != SSH_OK) {
+        const std::string error = ssh_get_error(ssh);
+        ssh_channel_free(channel);
+        return std::unexpected(std::format("Failed to open SSH channel: {}", error));
+    }
+    if (ssh_channel_request_exec(channel, command.c_str()) != SSH_OK) {
+        const std::string error = ssh_get_error(ssh);
+        ssh_channel_close(channel);
+        ssh_channel_free(channel);
+        return std::unexpected(std::format("Failed to execute remote command: {}", error));
+    }
+
+    std::string output;
+    char buf[256];
+    int bytesRead = 0;
+    while ((bytesRead = ssh_channel_read(channel, buf, sizeof(buf), 0)) > 0) {
+        output.append(buf, static_cast<size_t>(bytesRead));
+    }
+
+    ssh_channel_send_eof(channel);
+    ssh_channel_close(channel);
+    const int exitStatus = ssh_channel_get_exit_status(channel);
+    ssh_channel_free(channel);
+
+    if (bytesRead < 0) {
+        return std::unexpected(std::format("Failed to read remote command output: {}", ssh_get_error(ssh)));
+    }
+    if (exitStatus != 0) {
+        return std::unexpected(std::format("Remote command exited with status {}", exitStatus));
+    }
+    return output;
 }
 
 } // namespace
 
-SFTPTransferStrategy::SFTPTransferStrategy(const Json::Value& config)
+struct SFTPTransferStrategy::Session {
+    ssh_session ssh = nullptr; ///< Connected and authenticated SSH session.
+    sftp_session sftp = nullptr; ///< Initialized SFTP channel on ssh.
+    size_t maxWriteLength = 0; ///< Largest write the server accepts, queried on first pipelined upload.
+    std::chrono::steady_clock::time_point lastUsed = std::chrono::steady_clock::now(); ///< Last time the session was released.
+
+    ~Session() {
+        if (sftp) {
+            sftp_free(sftp);
+        }
+        if (ssh) {
+            ssh_disconnect(ssh);
+            ssh_free(ssh);
+        }
+    }
+};
+
+SFTPTransferStrategy::SFTPTransferStrategy(const Json::Value& config, const std::string& stateFolder)
     : host_(config.get("host", "").asString()),
       user_(config.get("user", "").asString()),
       password_(config.get("password", "").asString()),
       port_(config.get("port", 22).asInt()),
       remote_dir_(config.isMember("remote_dir")
                       ? config["remote_dir"].asString()
-                      : config.get("remote_path", "").asString()) {}
-
-std::expected<void, std::string> SFTPTransferStrategy::transfer(const std::string& local_file, const std::string& remote_path) {
-    if (host_.empty() || user_.empty() || port_ <= 0) {
-        return std::unexpected("Invalid SFTP configuration: host, user, or port missing");
+                      : config.get("remote_path", "").asString()),
+      identityFile_(config.get("identity_file", "").asString()),
+      knownHostsFile_(config.get("known_hosts", "").asString()),
+      chunkSize_(std::max<size_t>(config.get("chunk_size", 32768).asUInt(), 1024)),
+      pipelineDepth_(std::clamp<size_t>(config.get("pipeline_depth", 1).asUInt(), 1, 256)),
+      verifyUpload_(config.get("verify_upload", true) != Json::Value(false)),
+      requireVerification_(config.get("verify_upload", true) == Json::Value("required")) {
+    if (!stateFolder.empty()) {
+        Sha256 nameDigest;
+        const std::string destination = std::format("{}@{}:{}", user_, host_, port_);
+        nameDigest.update(destination);
+        dirCacheFile_ = (fs::path(stateFolder) / std::format("remote_dirs-{}.txt", nameDigest.hexDigest().substr(0, 16))).string();
     }
+}
 
-    std::ifstream input_file(local_file, std::ios::binary);
-    if (!input_file) {
-        return std::unexpected("Failed to open local file");
+SFTPTransferStrategy::~SFTPTransferStrategy() = default;
+
+std::expected<void, std::string> SFTPTransferStrategy::ensureDirectory(Session& session, const std::string& directory) {
+    std::unordered_set<std::string> known;
+    {
+        std::lock_guard<std::mutex> lock(dirCacheMutex_);
+        if (!dirCacheLoaded_ && !dirCacheFile_.empty()) {
+            std::ifstream in(dirCacheFile_);
+            std::string line;
+            while (std::getline(in, line)) {
+                if (!line.empty()) {
+                    knownDirs_.insert(line);
+                }
+            }
+        }
+        dirCacheLoaded_ = true;
+        if (knownDirs_.contains(directory)) {
+            return {};
+        }
+        known = knownDirs_;
     }
 
-    std::string destinationDir = remote_path.empty()
-        ? remote_dir_
-        : joinRemotePath(remote_dir_, remote_path);
-    destinationDir = normalizeRemotePath(destinationDir);
-    if (destinationDir.empty()) {
-        return std::unexpected("No remote destination directory configured");
+    auto prefixes = ensureRemoteDirectories(session.sftp, directory, known);
+    if (!prefixes) {
+        invalidateDirectoryCache();
+        return std::unexpected(prefixes.error());
     }
 
-    ssh_session ssh = ssh_new();
-    sftp_session sftp = nullptr;
-    sftp_file file = nullptr;
-    auto cleanup = [&]() {
-        if (file) {
-            sftp_close(file);
-            file = nullptr;
+    std::lock_guard<std::mutex> lock(dirCacheMutex_);
+    knownDirs_.insert(prefixes->begin(), prefixes->end());
+    if (!dirCacheFile_.empty()) {
+        std::error_code ec;
+        fs::create_directories(fs::path(dirCacheFile_).parent_path(), ec);
+        std::ofstream out(dirCacheFile_, std::ios::trunc);
+        for (const auto& knownDir : knownDirs_) {
+            out << knownDir << '\n';
         }
-        if (sftp) {
-            sftp_free(sftp);
-            sftp = nullptr;
-        }
-        if (ssh) {
-            ssh_disconnect(ssh);
-            ssh_free(ssh);
-            ssh = nullptr;
+    }
+    return {};
+}
+
+void SFTPTransferStrategy::invalidateDirectoryCache() {
+    std::lock_guard<std::mutex> lock(dirCacheMutex_);
+    knownDirs_.clear();
+    dirCacheLoaded_ = true;
+    if (!dirCacheFile_.empty()) {
+        std::error_code ec;
+        fs::remove(dirCacheFile_, ec);
+    }
+}
+
+std::expected<std::unique_ptr<SFTPTransferStrategy::Session>, std::string> SFTPTransferStrategy::acquireSession(const std::string& artifact) {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex_);
+        while (!idleSessions_.empty()) {
+            std::unique_ptr<Session> session = std::move(idleSessions_.back());
+            idleSessions_.pop_back();
+            if (std::chrono::steady_clock::now() - session->lastUsed < kSessionIdleTimeout &&
+                ssh_is_connected(session->ssh)) {
+                if (TransferMetrics* metrics = metrics_.load()) {
+                    metrics->recordSessionReuse(name());
+                }
+                return session;
+            }
         }
-    };
+    }
+
+    const auto handshakeStart = std::chrono::steady_clock::now();
 
-    if (!ssh) {
+    auto session = std::make_unique<Session>();
+    session->ssh = ssh_new();
+    if (!session->ssh) {
         return std::unexpected("Failed to create SSH session");
     }
+    ssh_session ssh = session->ssh;
 
     if (ssh_options_set(ssh, SSH_OPTIONS_HOST, host_.c_str()) != SSH_OK ||
         ssh_options_set(ssh, SSH_OPTIONS_PORT, &port_) != SSH_OK ||
         ssh_options_set(ssh, SSH_OPTIONS_USER, user_.c_str()) != SSH_OK) {
-        const std::string error = ssh_get_error(ssh);
-        cleanup();
-        return std::unexpected(std::format("Failed to configure SSH session: {}", error));
+        return std::unexpected(std::format("Failed to configure SSH session: {}", ssh_get_error(ssh)));
+    }
+    if (!identityFile_.empty() && ssh_options_set(ssh, SSH_OPTIONS_ADD_IDENTITY, identityFile_.c_str()) != SSH_OK) {
+        return std::unexpected(std::format("Failed to set SSH identity: {}", ssh_get_error(ssh)));
+    }
+    if (!knownHostsFile_.empty() && ssh_options_set(ssh, SSH_OPTIONS_KNOWNHOSTS, knownHostsFile_.c_str()) != SSH_OK) {
+        return std::unexpected(std::format("Failed to set known_hosts file: {}", ssh_get_error(ssh)));
     }
 
     if (ssh_connect(ssh) != SSH_OK) {
-        const std::string error = ssh_get_error(ssh);
-        cleanup();
-        return std::unexpected(std::format("SSH connection failed: {}", error));
+        return std::unexpected(std::format("SSH connection failed: {}", ssh_get_error(ssh)));
     }
 
     auto hostVerify = verifyHostKey(ssh);
     if (!hostVerify) {
-        cleanup();
         return std::unexpected(hostVerify.error());
     }
 
     if (password_.empty()) {
         if (ssh_userauth_publickey_auto(ssh, nullptr, nullptr) != SSH_AUTH_SUCCESS) {
-            const std::string error = ssh_get_error(ssh);
-            cleanup();
-            return std::unexpected(std::format("SSH public key authentication failed: {}", error));
+            return std::unexpected(std::format("SSH public key authentication failed: {}", ssh_get_error(ssh)));
         }
     } else {
         if (ssh_userauth_password(ssh, nullptr, password_.c_str()) != SSH_AUTH_SUCCESS) {
-            const std::string error = ssh_get_error(ssh);
-            cleanup();
-            return std::unexpected(std::format("SSH password authentication failed: {}", error));
+            return std::unexpected(std::format("SSH password authentication failed: {}", ssh_get_error(ssh)));
         }
     }
 
-    sftp = sftp_new(ssh);
-    if (!sftp) {
-        const std::string error = ssh_get_error(ssh);
-        cleanup();
-        return std::unexpected(std::format("Failed to create SFTP session: {}", error));
+    session->sftp = sftp_new(ssh);
+    if (!session->sftp) {
+        return std::unexpected(std::format("Failed to create SFTP session: {}", ssh_get_error(ssh)));
     }
-    if (sftp_init(sftp) != SSH_OK) {
-        const std::string error = ssh_get_error(ssh);
-        cleanup();
-        return std::unexpected(std::format("SFTP initialization failed: {}", error));
+    if (sftp_init(session->sftp) != SSH_OK) {
+        return std::unexpected(std::format("SFTP initialization failed: {}", ssh_get_error(ssh)));
+    }
+    if (TransferMetrics* metrics = metrics_.load()) {
+        metrics->recordHandshake(name(), artifact, std::chrono::steady_clock::now() - handshakeStart);
+    }
+
+    return session;
+}
+
+void SFTPTransferStrategy::releaseSession(std::unique_ptr<Session> session) {
+    session->lastUsed = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(poolMutex_);
+    idleSessions_.push_back(std::move(session));
+}
+
+class SFTPTransferStrategy::Upload : public TransferSink {
+public:
+    Upload(SFTPTransferStrategy& owner, std::unique_ptr<Session> session, sftp_file file, std::string sourceFile, std::string remoteFile)
+        : owner_(owner), session_(std::move(session)), file_(file), sourceFile_(std::move(sourceFile)), remoteFile_(std::move(remoteFile)) {}
+
+    ~Upload() override {
+        // An uncommitted upload leaves the session in an unknown state; drop it with the file.
+        discardPending();
+        if (file_) {
+            sftp_close(file_);
+        }
+        if (TransferMetrics* metrics = owner_.metrics_.load()) {
+            metrics->addStall(sourceFile_, stall_);
+        }
+    }
+
+    std::expected<void, std::string> write(std::span<const char> data) override {
+        if (!file_) {
+            return std::unexpected(std::format("Remote file '{}' is no longer open", remoteFile_));
+        }
+
+        auto writeResult = owner_.pipelineDepth_ > 1 ? writePipelined(data) : writeSynchronous(data);
+        if (!writeResult) {
+            return writeResult;
+        }
+        if (owner_.verifyUpload_) {
+            digest_.update(data);
+        }
+        return {};
     }
 
-    auto mkdirResult = ensureRemoteDirectories(sftp, destinationDir);
+    std::expected<void, std::string> commit() override {
+        if (!file_) {
+            return std::unexpected(std::format("Remote file '{}' is no longer open", remoteFile_));
+        }
+
+        auto drainResult = drainPending(0);
+        if (!drainResult) {
+            return drainResult;
+        }
+
+        const int closeResult = sftp_close(file_);
+        file_ = nullptr;
+        if (closeResult != SSH_OK) {
+            return std::unexpected(std::format("Failed to finalize remote file '{}': {}", remoteFile_, ssh_get_error(session_->ssh)));
+        }
+
+        if (owner_.verifyUpload_) {
+            auto verifyResult = verifyRemoteDigest();
+            if (!verifyResult) {
+                return std::unexpected(verifyResult.error());
+            }
+            if (TransferMetrics* metrics = owner_.metrics_.load()) {
+                metrics->recordVerification(sourceFile_, verifyResult->first, verifyResult->second);
+            }
+        }
+
+        owner_.releaseSession(std::move(session_));
+        std::cout << "Transferred file to remote: " << remoteFile_ << std::endl;
+        return {};
+    }
+
+private:
+    std::expected<void, std::string> fail(const char* action) {
+        const std::string error = ssh_get_error(session_->ssh);
+        discardPending();
+        sftp_close(file_);
+        file_ = nullptr;
+        return std::unexpected(std::format("Failed to {} remote file '{}': {}", action, remoteFile_, error));
+    }
+
+    std::expected<void, std::string> writeSynchronous(std::span<const char> data) {
+        size_t totalWritten = 0;
+        while (totalWritten < data.size()) {
+            // A synchronous write returns only after the server acknowledged it.
+            const auto waitStart = std::chrono::steady_clock::now();
+            const ssize_t written = sftp_write(file_, data.data() + totalWritten, data.size() - totalWritten);
+            stall_ += std::chrono::steady_clock::now() - waitStart;
+            if (written < 0) {
+                return fail("write");
+            }
+            totalWritten += static_cast<size_t>(written);
+        }
+        return {};
+    }
+
+#ifdef SECUREVAULT_SFTP_AIO
+    /**
+     * @brief Issues write requests without waiting for each reply, keeping pipelineDepth_ in flight.
+     *
+     * On high-latency links a synchronous write costs one round trip per chunk_size bytes;
+     * pipelining hides that latency the way OpenSSH's sftp client does.
+     */
+    std::expected<void, std::string> writePipelined(std::span<const char> data) {
+        if (session_->maxWriteLength == 0) {
+            sftp_limits_t limits = sftp_limits(session_->sftp);
+            session_->maxWriteLength = limits && limits->max_write_length > 0 ? limits->max_write_length : 32768;
+            sftp_limits_free(limits);
+        }
+        const size_t requestSize = std::min(owner_.chunkSize_, session_->maxWriteLength);
+
+        while (!data.empty()) {
+            auto drainResult = drainPending(owner_.pipelineDepth_ - 1);
+            if (!drainResult) {
+                return drainResult;
+            }
+            const size_t length = std::min(data.size(), requestSize);
+            sftp_aio aio = nullptr;
+            if (sftp_aio_begin_write(file_, data.data(), length, &aio) == SSH_ERROR) {
+                return fail("write");
+            }
+            pending_.push_back(aio);
+            pendingLengths_.push_back(length);
+            data = data.subspan(length);
+        }
+        return {};
+    }
+
+    /**
+     * @brief Waits for acknowledgements until at most limit write requests remain in flight.
+     */
+    std::expected<void, std::string> drainPending(size_t limit) {
+        while (pending_.size() > limit) {
+            sftp_aio aio = pending_.front();
+            pending_.pop_front();
+            const size_t expected = pendingLengths_.front();
+            pendingLengths_.pop_front();
+            // sftp_aio_wait_write releases the request whatever the outcome.
+            const auto waitStart = std::chrono::steady_clock::now();
+            const ssize_t written = sftp_aio_wait_write(&aio);
+            stall_ += std::chrono::steady_clock::now() - waitStart;
+            if (written != static_cast<ssize_t>(expected)) {
+                return fail("write");
+            }
+        }
+        return {};
+    }
+
+    void discardPending() {
+        for (sftp_aio aio : pending_) {
+            sftp_aio_free(aio);
+        }
+        pending_.clear();
+        pendingLengths_.clear();
+    }
+#else
+    std::expected<void, std::string> writePipelined(std::span<const char> data) {
+        return writeSynchronous(data);
+    }
+
+    std::expected<void, std::string> drainPending(size_t) {
+        return {};
+    }
+
+    void discardPending() {}
+#endif
+
+    /**
+     * @brief Compares the digest computed while streaming with one computed by the remote host.
+     *
+     * The remote hash runs over an exec channel on the same SSH session, so the artifact never
+     * crosses the network again. Hosts without a shell or sha256sum cannot be checked; the upload
+     * is then reported as unverified, or fails if verification is required.
+     *
+     * @return The check outcome with the reason for an unverified upload, or an error.
+     */
+    std::expected<std::pair<RemoteVerification, std::string>, std::string> verifyRemoteDigest() {
+        const std::string localDigest = digest_.hexDigest();
+        auto output = runRemoteCommand(session_->ssh, std::format("sha256sum -- {}", quoteShellArgument(remoteFile_)));
+        if (!output) {
+            if (owner_.requireVerification_) {
+                return std::unexpected(std::format("Remote integrity check required but unavailable for '{}': {}", remoteFile_,
+                                                   output.error()));
+            }
+            std::cerr << "Warning: Remote integrity check unavailable for " << remoteFile_ << ": " << output.error() << std::endl;
+            return std::pair(RemoteVerification::Unverified, output.error());
+        }
+
+        const std::string remoteDigest = output->substr(0, output->find_first_of(" \t\n"));
+        if (remoteDigest != localDigest) {
+            return std::unexpected(std::format("Remote integrity check failed for '{}': local sha256 {}, remote {}",
+                                               remoteFile_, localDigest, remoteDigest.empty() ? "<empty>" : remoteDigest));
+        }
+        return std::pair(RemoteVerification::Verified, std::string());
+    }
+
+    SFTPTransferStrategy& owner_;
+    std::unique_ptr<Session> session_;
+    sftp_file file_;
+    std::string sourceFile_;
+    std::string remoteFile_;
+    Sha256 digest_; ///< Digest of the bytes written so far.
+    std::chrono::duration<double> stall_{}; ///< Time spent waiting for write acknowledgements.
+#ifdef SECUREVAULT_SFTP_AIO
+    std::deque<sftp_aio> pending_; ///< Write requests awaiting acknowledgement, oldest first.
+    std::deque<size_t> pendingLengths_; ///< Byte count of each entry in pending_.
+#endif
+};
+
+std::string SFTPTransferStrategy::name() const {
+    return std::format("sftp://{}:{}{}", host_, port_, normalizeRemotePath(remote_dir_));
+}
+
+std::expected<std::unique_ptr<TransferSink>, std::string> SFTPTransferStrategy::openSink(const std::string& local_file,
+                                                                                          const std::string& remote_path) {
+    if (host_.empty() || user_.empty() || port_ <= 0) {
+        return std::unexpected("Invalid SFTP configuration: host, user, or port missing");
+    }
+
+    std::string destinationDir = remote_path.empty()
+        ? remote_dir_
+        : joinRemotePath(remote_dir_, remote_path);
+    destinationDir = normalizeRemotePath(destinationDir);
+    if (destinationDir.empty()) {
+        return std::unexpected("No remote destination directory configured");
+    }
+
+    auto sessionResult = acquireSession(local_file);
+    if (!sessionResult) {
+        return std::unexpected(sessionResult.error());
+    }
+    std::unique_ptr<Session> session = std::move(*sessionResult);
+
+    auto mkdirResult = ensureDirectory(*session, destinationDir);
     if (!mkdirResult) {
-        cleanup();
         return std::unexpected(mkdirResult.error());
     }
 
     const std::string remote_file = joinRemotePath(destinationDir, fs::path(local_file).filename().string());
-    file = sftp_open(sftp, remote_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    sftp_file file = sftp_open(session->sftp, remote_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (!file && sftp_get_error(session->sftp) == SSH_FX_NO_SUCH_FILE) {
+        // The cache claimed a directory that is gone (e.g., removed remotely); rebuild and retry once.
+        if (TransferMetrics* metrics = metrics_.load()) {
+            metrics->addRetry(local_file);
+        }
+        invalidateDirectoryCache();
+        mkdirResult = ensureDirectory(*session, destinationDir);
+        if (!mkdirResult) {
+            return std::unexpected(mkdirResult.error());
+        }
+        file = sftp_open(session->sftp, remote_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    }
     if (!file) {
-        const std::string error = ssh_get_error(ssh);
-        cleanup();
-        return std::unexpected(std::format("Failed to open remote file '{}': {}", remote_file, error));
+        invalidateDirectoryCache();
+        return std::unexpected(std::format("Failed to open remote file '{}': {}", remote_file, ssh_get_error(session->ssh)));
     }
 
-    char buf[8192];
-    while (input_file) {
-        input_file.read(buf, sizeof(buf));
-        std::streamsize bytesRead = input_file.gcount();
-        if (bytesRead <= 0) {
-            continue;
+    return std::make_unique<Upload>(*this, std::move(session), file, local_file, remote_file);
+}
+
+std::expected<void, std::string> SFTPTransferStrategy::transfer(const std::string& local_file, const std::string& remote_path) {
+    return streamFile(local_file, remote_path, chunkSize_);
+}
+
+std::expected<size_t, std::string> SFTPTransferStrategy::pruneRemote(const std::vector<std::string>& directories,
+                                                                     std::chrono::system_clock::time_point threshold) {
+    if (host_.empty() || user_.empty() || port_ <= 0) {
+        return std::unexpected("Invalid SFTP configuration: host, user, or port missing");
+    }
+
+    auto sessionResult = acquireSession("");
+    if (!sessionResult) {
+        return std::unexpected(sessionResult.error());
+    }
+    std::unique_ptr<Session> session = std::move(*sessionResult);
+
+    size_t removed = 0;
+    for (const auto& directory : directories) {
+        const std::string remoteDir = normalizeRemotePath(joinRemotePath(remote_dir_, directory));
+        auto listing = listRemoteDirectory(session->sftp, remoteDir);
+        if (!listing) {
+            invalidateDirectoryCache();
+            return std::unexpected(listing.error());
         }
 
-        std::streamsize totalWritten = 0;
-        while (totalWritten < bytesRead) {
-            const int written = sftp_write(file,
-                                           buf + totalWritten,
-                                           static_cast<size_t>(bytesRead - totalWritten));
-            if (written < 0) {
-                const std::string error = ssh_get_error(ssh);
-                cleanup();
-                return std::unexpected(std::format("Failed to write remote file '{}': {}", remote_file, error));
+        for (const auto& entry : *listing) {
+            if (entry.modified >= threshold) {
+                continue;
+            }
+            const std::string remoteFile = joinRemotePath(remoteDir, entry.name);
+            if (sftp_unlink(session->sftp, remoteFile.c_str()) != SSH_OK) {
+                const int sftpError = sftp_get_error(session->sftp);
+                if (sftpError == SSH_FX_NO_SUCH_FILE) {
+                    continue;
+                }
+                return std::unexpected(std::format("Failed to remove remote backup '{}', SFTP error {}", remoteFile, sftpError));
             }
-            totalWritten += written;
+            ++removed;
         }
     }
 
-    if (input_file.bad()) {
-        cleanup();
-        return std::unexpected("Failed while reading local file for transfer");
+    releaseSession(std::move(session));
+    return removed;
+}
+
+std::expected<void, std::string> SFTPTransferStrategy::fetch(const std::string& remotePath, const std::string& localFile) {
+    if (host_.empty() || user_.empty() || port_ <= 0) {
+        return std::unexpected("Invalid SFTP configuration: host, user, or port missing");
+    }
+
+    auto sessionResult = acquireSession(localFile);
+    if (!sessionResult) {
+        return std::unexpected(sessionResult.error());
     }
+    std::unique_ptr<Session> session = std::move(*sessionResult);
 
-    if (sftp_close(file) != SSH_OK) {
-        file = nullptr;
-        const std::string error = ssh_get_error(ssh);
-        cleanup();
-        return std::unexpected(std::format("Failed to finalize remote file '{}': {}", remote_file, error));
+    const std::string remoteFile = normalizeRemotePath(joinRemotePath(remote_dir_, remotePath));
+    sftp_file file = sftp_open(session->sftp, remoteFile.c_str(), O_RDONLY, 0);
+    if (!file) {
+        const int sftpError = sftp_get_error(session->sftp);
+        releaseSession(std::move(session));
+        return std::unexpected(std::format("Failed to open remote file '{}', SFTP error {}", remoteFile, sftpError));
     }
-    file = nullptr;
 
-    cleanup();
-    std::cout << "Transferred file to remote: " << remote_file << std::endl;
+    std::ofstream output(localFile, std::ios::binary | std::ios::trunc);
+    std::vector<char> buffer(chunkSize_);
+    ssize_t bytesRead = 0;
+    while (output && (bytesRead = sftp_read(file, buffer.data(), buffer.size())) > 0) {
+        output.write(buffer.data(), bytesRead);
+    }
+    sftp_close(file);
+    output.close();
+    if (bytesRead < 0) {
+        std::error_code ec;
+        fs::remove(localFile, ec);
+        return std::unexpected(std::format("Failed to read remote file '{}': {}", remoteFile, ssh_get_error(session->ssh)));
+    }
+    releaseSession(std::move(session));
+    if (!output) {
+        std::error_code ec;
+        fs::remove(localFile, ec);
+        return std::unexpected(std::format("Failed to write local file: {}", localFile));
+    }
     return {};
 }
+
+std::expected<size_t, std::string> SFTPTransferStrategy::removeRemote(const std::vector<std::string>& remotePaths) {
+    if (host_.empty() || user_.empty() || port_ <= 0) {
+        return std::unexpected("Invalid SFTP configuration: host, user, or port missing");
+    }
+
+    auto sessionResult = acquireSession("");
+    if (!sessionResult) {
+        return std::unexpected(sessionResult.error());
+    }
+    std::unique_ptr<Session> session = std::move(*sessionResult);
+
+    size_t removed = 0;
+    for (const auto& remotePath : remotePaths) {
+        const std::string remoteFile = normalizeRemotePath(joinRemotePath(remote_dir_, remotePath));
+        if (sftp_unlink(session->sftp, remoteFile.c_str()) != SSH_OK) {
+            const int sftpError = sftp_get_error(session->sftp);
+            if (sftpError == SSH_FX_NO_SUCH_FILE) {
+                continue;
+            }
+            return std::unexpected(std::format("Failed to remove remote file '{}', SFTP error {}", remoteFile, sftpError));
+        }
+        ++removed;
+    }
+
+    releaseSession(std::move(session));
+    return removed;
+}
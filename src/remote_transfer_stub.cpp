@@ -1,16 +1,57 @@
 #include "remote_transfer.hpp"
 
-SFTPTransferStrategy::SFTPTransferStrategy(const Json::Value& config)
+struct SFTPTransferStrategy::Session {};
+
+SFTPTransferStrategy::SFTPTransferStrategy(const Json::Value& config, const std::string& stateFolder)
     : host_(config.get("host", "").asString()),
       user_(config.get("user", "").asString()),
       password_(config.get("password", "").asString()),
       port_(config.get("port", 22).asInt()),
       remote_dir_(config.isMember("remote_dir")
                       ? config["remote_dir"].asString()
-                      : config.get("remote_path", "").asString()) {}
+                      : config.get("remote_path", "").asString()),
+      identityFile_(config.get("identity_file", "").asString()),
+      knownHostsFile_(config.get("known_hosts", "").asString()),
+      chunkSize_(config.get("chunk_size", 32768).asUInt()),
+      pipelineDepth_(config.get("pipeline_depth", 1).asUInt()),
+      verifyUpload_(config.get("verify_upload", true) != Json::Value(false)),
+      requireVerification_(config.get("verify_upload", true) == Json::Value("required")) {
+    (void)stateFolder;
+}
+
+SFTPTransferStrategy::~SFTPTransferStrategy() = default;
 
 std::expected<void, std::string> SFTPTransferStrategy::transfer(const std::string& local_file, const std::string& remote_path) {
     (void)local_file;
     (void)remote_path;
     return std::unexpected("SFTP support is disabled in this build because libssh was not found");
 }
+
+std::string SFTPTransferStrategy::name() const {
+    return "sftp://" + host_;
+}
+
+std::expected<std::unique_ptr<TransferSink>, std::string> SFTPTransferStrategy::openSink(const std::string& local_file,
+                                                                                          const std::string& remote_path) {
+    (void)local_file;
+    (void)remote_path;
+    return std::unexpected("SFTP support is disabled in this build because libssh was not found");
+}
+
+std::expected<size_t, std::string> SFTPTransferStrategy::pruneRemote(const std::vector<std::string>& directories,
+                                                                     std::chrono::system_clock::time_point threshold) {
+    (void)directories;
+    (void)threshold;
+    return std::unexpected("SFTP support is disabled in this build because libssh was not found");
+}
+
+std::expected<void, std::string> SFTPTransferStrategy::fetch(const std::string& remotePath, const std::string& localFile) {
+    (void)remotePath;
+    (void)localFile;
+    return std::unexpected("SFTP support is disabled in this build because libssh was not found");
+}
+
+std::expected<size_t, std::string> SFTPTransferStrategy::removeRemote(const std::vector<std::string>& remotePaths) {
+    (void)remotePaths;
+    return std::unexpected("SFTP support is disabled in this build because libssh was not found");
+}
@@ -0,0 +1,258 @@
+/**
+ * @file restore_engine.cpp
+ * @brief Frame-parallel archive extraction with on-the-fly hashing.
+ */
+
+#include "restore_engine.hpp"
+#include "digest.hpp"
+#include "frame_archive.hpp"
+#include "io_priority.hpp"
+#include "load_monitor.hpp"
+#include <archive.h>
+#include <archive_entry.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t kReadBlockSize = 1 << 20;
+
+/**
+ * @brief Restores the current entry's data below targetDir, hashing it as it is written.
+ */
+std::expected<RestoredEntry, std::string> restoreEntry(struct archive* a, struct archive_entry* entry, const fs::path& targetDir) {
+    RestoredEntry restored;
+    restored.archivePath = archive_entry_pathname(entry);
+    const fs::path relative = fs::path(restored.archivePath).lexically_normal();
+    if (relative.empty() || relative.is_absolute() || std::ranges::find(relative, fs::path("..")) != relative.end()) {
+        return std::unexpected(std::format("Unsafe path in archive: {}", restored.archivePath));
+    }
+    const fs::path target = targetDir / relative;
+    restored.restoredPath = target.string();
+
+    std::error_code ec;
+    fs::create_directories(target.parent_path(), ec);
+    if (ec) {
+        return std::unexpected(std::format("Failed to create directory for {}: {}", restored.restoredPath, ec.message()));
+    }
+    std::ofstream out(target, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return std::unexpected(std::format("Failed to create {}", restored.restoredPath));
+    }
+
+    Sha256 hasher;
+    const void* block = nullptr;
+    size_t length = 0;
+    la_int64_t offset = 0;
+    while (true) {
+        const int rc = archive_read_data_block(a, &block, &length, &offset);
+        if (rc == ARCHIVE_EOF) {
+            break;
+        }
+        if (rc < ARCHIVE_WARN) {
+            return std::unexpected(std::format("Failed to read {} from archive: {}", restored.archivePath, archive_error_string(a)));
+        }
+        const std::span<const char> data(static_cast<const char*>(block), length);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        hasher.update(data);
+        restored.size += length;
+    }
+    out.close();
+    if (!out) {
+        return std::unexpected(std::format("Failed to write {}", restored.restoredPath));
+    }
+    restored.sha256 = hasher.hexDigest();
+    return restored;
+}
+
+/**
+ * @brief Restores the selected entries from an open libarchive reader into summary.
+ *
+ * @return std::expected<void, std::string> Success, or an error if the archive stream itself is unreadable.
+ */
+std::expected<void, std::string> restoreEntries(struct archive* a, const fs::path& targetDir, const RestoreEngine::EntryFilter& filter,
+                                                const RestoreEngine::EntryHandler& onEntry, RestoreSummary& summary, std::mutex& mutex) {
+    struct archive_entry* entry;
+    while (true) {
+        const int rc = archive_read_next_header(a, &entry);
+        if (rc == ARCHIVE_EOF) {
+            return {};
+        }
+        if (rc < ARCHIVE_WARN) {
+            return std::unexpected(std::format("Bad archive header: {}", archive_error_string(a)));
+        }
+        const char* name = archive_entry_pathname(entry);
+        if (archive_entry_filetype(entry) != AE_IFREG || (filter && !filter(name ? name : ""))) {
+            if (archive_read_data_skip(a) < ARCHIVE_WARN) {
+                return std::unexpected(std::format("Bad archive entry {}: {}", name ? name : "", archive_error_string(a)));
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            ++summary.skipped;
+            continue;
+        }
+
+        auto restored = restoreEntry(a, entry, targetDir);
+        if (!restored) {
+            std::lock_guard<std::mutex> lock(mutex);
+            summary.errors.push_back(restored.error());
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++summary.entries;
+            summary.bytes += restored->size;
+        }
+        if (onEntry) {
+            onEntry(*restored);
+        }
+    }
+}
+
+} // namespace
+
+RestoreEngine::RestoreEngine(unsigned threads, bool background, LoadMonitor* loadMonitor)
+    : threads_(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())),
+      background_(background),
+      loadMonitor_(loadMonitor) {}
+
+std::expected<RestoreSummary, std::string> RestoreEngine::extract(const std::string& archivePath, const std::string& targetDir,
+                                                                 const EntryFilter& filter, const EntryHandler& onEntry) const {
+    auto summary = extract({ArchiveSelection{archivePath, {}, filter}}, targetDir, onEntry);
+    // A sequentially read archive either restores or fails as a whole.
+    if (summary && summary->frames == 0 && !summary->errors.empty()) {
+        return std::unexpected(summary->errors.front());
+    }
+    return summary;
+}
+
+std::expected<RestoreSummary, std::string> RestoreEngine::extract(const std::vector<ArchiveSelection>& archives, const std::string& targetDir,
+                                                                 const EntryHandler& onEntry) const {
+    const auto start = std::chrono::steady_clock::now();
+    std::error_code ec;
+    fs::create_directories(targetDir, ec);
+    if (ec) {
+        return std::unexpected(std::format("Failed to create restore directory {}: {}", targetDir, ec.message()));
+    }
+
+    // One work item per selected frame; an archive without a frame index is a single item, since
+    // its gzip stream can only be decompressed from the start.
+    struct WorkItem {
+        size_t archive;
+        std::optional<ArchiveFrame> frame;
+        size_t frameNumber = 0;
+    };
+    std::vector<WorkItem> items;
+    for (size_t i = 0; i < archives.size(); ++i) {
+        auto frames = readFrameIndex(archives[i].archivePath);
+        if (!frames) {
+            items.push_back({i, std::nullopt});
+            continue;
+        }
+        if (archives[i].frames.empty()) {
+            for (size_t number = 0; number < frames->size(); ++number) {
+                items.push_back({i, (*frames)[number], number});
+            }
+            continue;
+        }
+        for (uint32_t number : archives[i].frames) {
+            if (number < frames->size()) {
+                items.push_back({i, (*frames)[number], number});
+            }
+        }
+    }
+
+    RestoreSummary summary;
+    std::mutex mutex;
+    std::atomic<size_t> nextItem{0};
+    std::vector<std::thread> workers;
+    // Workers run even for a single item, so lowering their priority does not affect the caller.
+    const unsigned workerCount = static_cast<unsigned>(std::clamp<size_t>(items.size(), 1, threads_));
+    for (unsigned i = 0; i < workerCount; ++i) {
+        workers.emplace_back([&, i]() {
+            if (background_) {
+                enterBackgroundPriority();
+            }
+            std::map<size_t, std::ifstream> files;
+            for (;;) {
+                // Under high load the pool shrinks: surplus workers pause before taking more work.
+                while (loadMonitor_ && i >= loadMonitor_->workers(workerCount) && nextItem < items.size()) {
+                    std::this_thread::sleep_for(loadMonitor_->checkInterval());
+                }
+                const size_t index = nextItem++;
+                if (index >= items.size()) {
+                    break;
+                }
+                const WorkItem& item = items[index];
+                const ArchiveSelection& selection = archives[item.archive];
+                if (!item.frame) {
+                    struct archive* a = archive_read_new();
+                    archive_read_support_filter_gzip(a);
+                    archive_read_support_format_tar(a);
+                    std::expected<void, std::string> result;
+                    if (archive_read_open_filename(a, selection.archivePath.c_str(), kReadBlockSize) != ARCHIVE_OK) {
+                        result = std::unexpected(std::format("Failed to open archive {}: {}", selection.archivePath, archive_error_string(a)));
+                    } else {
+                        result = restoreEntries(a, targetDir, selection.filter, onEntry, summary, mutex);
+                    }
+                    archive_read_free(a);
+                    if (!result) {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        summary.errors.push_back(result.error());
+                    }
+                    continue;
+                }
+
+                auto [file, opened] = files.try_emplace(item.archive, selection.archivePath, std::ios::binary);
+                if (!file->second) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    summary.errors.push_back(std::format("Failed to open archive {}", selection.archivePath));
+                    continue;
+                }
+                FrameReader reader(file->second, *item.frame);
+                FrameSource source{&reader, {}};
+                struct archive* a = archive_read_new();
+                archive_read_support_format_tar(a);
+                std::expected<void, std::string> result;
+                if (archive_read_open(a, &source, nullptr, readFrameBlock, nullptr) != ARCHIVE_OK) {
+                    result = std::unexpected(source.error.empty() ? archive_error_string(a) : source.error);
+                } else {
+                    result = restoreEntries(a, targetDir, selection.filter, onEntry, summary, mutex);
+                }
+                archive_read_free(a);
+                // The frame is only known to be intact once its end (and CRC) was reached.
+                while (result) {
+                    auto block = reader.next();
+                    if (!block) {
+                        result = std::unexpected(block.error());
+                    } else if (block->empty()) {
+                        break;
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                ++summary.frames;
+                if (!result) {
+                    const std::string prefix = archives.size() > 1 ? selection.archivePath + " frame" : "Frame";
+                    summary.errors.push_back(std::format("{} {}: {}", prefix, item.frameNumber,
+                                                         source.error.empty() ? result.error() : source.error));
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    summary.duration = std::chrono::steady_clock::now() - start;
+    return summary;
+}
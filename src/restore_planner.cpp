@@ -0,0 +1,94 @@
+/**
+ * @file restore_planner.cpp
+ * @brief Point-in-time restore plans built from the backup catalog.
+ */
+
+#include "restore_planner.hpp"
+#include "frame_archive.hpp"
+#include <algorithm>
+#include <format>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_set>
+
+std::expected<uint32_t, std::string> runAt(const std::vector<CatalogRun>& runs, int64_t time) {
+    const CatalogRun* found = nullptr;
+    for (const auto& run : runs) {
+        if (run.started <= time && (!found || run.started >= found->started)) {
+            found = &run;
+        }
+    }
+    if (!found) {
+        return std::unexpected("No backup run was started at or before the requested time");
+    }
+    return found->sequence;
+}
+
+std::expected<RestorePlan, std::string> planRestore(const Catalog& catalog, uint32_t run, const std::string& prefix) {
+    auto runs = catalog.runs();
+    if (!runs) {
+        return std::unexpected(runs.error());
+    }
+    if (runs->empty()) {
+        return std::unexpected("The catalog has no runs");
+    }
+    if (run == 0) {
+        run = runs->back().sequence;
+    }
+    if (std::ranges::find(*runs, run, &CatalogRun::sequence) == runs->end()) {
+        return std::unexpected(std::format("Run {} is not in the catalog", run));
+    }
+    auto state = catalog.snapshot(run, prefix);
+    if (!state) {
+        return std::unexpected(state.error());
+    }
+    std::map<uint32_t, std::string> archivePaths;
+    for (const auto& listed : *runs) {
+        for (const auto& artifact : listed.artifacts) {
+            if (artifact.artifactClass == "sys") {
+                archivePaths[listed.sequence] = artifact.path;
+            }
+        }
+    }
+
+    struct Source {
+        std::set<uint32_t> frames;
+        bool wholeArchive = false;
+        std::shared_ptr<std::unordered_set<std::string>> names = std::make_shared<std::unordered_set<std::string>>();
+    };
+    RestorePlan plan;
+    plan.run = run;
+    std::map<uint32_t, Source> sources;
+    for (const auto& file : *state) {
+        if (!archivePaths.contains(file.storedRun)) {
+            return std::unexpected(std::format("No archive for run {}, which holds {}", file.storedRun, file.sourcePath));
+        }
+        Source& source = sources[file.storedRun];
+        source.names->insert(file.archivePath);
+        if (file.frame == ManifestEntry::kNoFrame) {
+            source.wholeArchive = true;
+        } else {
+            source.frames.insert(file.frame);
+        }
+        plan.expectedSha256[file.archivePath] = file.sha256;
+        ++plan.files;
+        plan.bytes += file.size;
+    }
+
+    for (auto& [storedRun, source] : sources) {
+        RestoreEngine::ArchiveSelection selection;
+        selection.archivePath = archivePaths.at(storedRun);
+        // Without frame numbers (or a frame index) the archive has to be read from the start.
+        auto index = readFrameIndex(selection.archivePath);
+        if (!index || source.wholeArchive) {
+            plan.frames += index ? index->size() : 1;
+        } else {
+            selection.frames.assign(source.frames.begin(), source.frames.end());
+            plan.frames += selection.frames.size();
+        }
+        selection.filter = [names = source.names](const std::string& name) { return names->contains(name); };
+        plan.archives.push_back(std::move(selection));
+    }
+    return plan;
+}
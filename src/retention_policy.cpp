@@ -0,0 +1,94 @@
+/**
+ * @file retention_policy.cpp
+ * @brief Grandfather-father-son retention over catalog runs.
+ */
+
+#include "retention_policy.hpp"
+#include <ctime>
+#include <unordered_set>
+
+namespace {
+
+struct PeriodRule {
+    const char* name; ///< Reason recorded for runs kept by this rule.
+    const char* format; ///< strftime pattern identifying the period.
+    unsigned count; ///< Periods to keep.
+};
+
+std::string periodKey(int64_t started, const char* format) {
+    const auto timeT = static_cast<std::time_t>(started);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), format, std::localtime(&timeT));
+    return buffer;
+}
+
+} // namespace
+
+RetentionPolicy RetentionPolicy::fromJson(const Json::Value& retentionConfig) {
+    RetentionPolicy policy;
+    policy.hourly = retentionConfig.get("keep_hourly", 0).asUInt();
+    policy.daily = retentionConfig.get("keep_daily", 0).asUInt();
+    policy.weekly = retentionConfig.get("keep_weekly", 0).asUInt();
+    policy.monthly = retentionConfig.get("keep_monthly", 0).asUInt();
+    policy.yearly = retentionConfig.get("keep_yearly", 0).asUInt();
+    return policy;
+}
+
+bool RetentionPolicy::enabled() const {
+    return hourly > 0 || daily > 0 || weekly > 0 || monthly > 0 || yearly > 0;
+}
+
+RetentionPlan planRetention(const std::vector<CatalogRun>& runs, const RetentionPolicy& policy) {
+    RetentionPlan plan;
+    if (runs.empty()) {
+        return plan;
+    }
+    plan.kept.emplace(runs.back().sequence, "latest");
+
+    const PeriodRule rules[] = {
+        {"hourly", "%Y-%m-%d %H", policy.hourly},
+        {"daily", "%Y-%m-%d", policy.daily},
+        {"weekly", "%G-W%V", policy.weekly},
+        {"monthly", "%Y-%m", policy.monthly},
+        {"yearly", "%Y", policy.yearly},
+    };
+    for (const auto& rule : rules) {
+        unsigned periods = 0;
+        std::string lastKey;
+        // Newest first: the first run seen in each period is that period's newest.
+        for (auto it = runs.rbegin(); it != runs.rend() && periods < rule.count; ++it) {
+            const std::string key = periodKey(it->started, rule.format);
+            if (key == lastKey) {
+                continue;
+            }
+            lastKey = key;
+            ++periods;
+            plan.kept.emplace(it->sequence, rule.name);
+        }
+    }
+
+    // Keep every run whose archive a kept run still refers to. A run's dependencies already
+    // list every archive its files live in, so runs kept only as dependencies add nothing.
+    std::unordered_set<uint32_t> known;
+    for (const auto& run : runs) {
+        known.insert(run.sequence);
+    }
+    const std::map<uint32_t, std::string> selected = plan.kept;
+    for (const auto& run : runs) {
+        if (!selected.contains(run.sequence)) {
+            continue;
+        }
+        for (uint32_t dependency : run.dependsOn) {
+            if (known.contains(dependency)) {
+                plan.kept.emplace(dependency, "dependency");
+            }
+        }
+    }
+
+    for (const auto& run : runs) {
+        if (!plan.kept.contains(run.sequence)) {
+            plan.pruned.push_back(run.sequence);
+        }
+    }
+    return plan;
+}
@@ -0,0 +1,310 @@
+/**
+ * @file securevault_transfer.cpp
+ * @brief Client side of the securevault-receiver streaming protocol.
+ */
+
+#include "securevault_transfer.hpp"
+#include "receiver_protocol.hpp"
+#include "transfer_metrics.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string remotePathFor(const std::string& sourceFile, const std::string& destinationPath) {
+    const std::string fileName = fs::path(sourceFile).filename().string();
+    return destinationPath.empty() ? fileName : (fs::path(destinationPath) / fileName).generic_string();
+}
+
+/**
+ * @brief Sends [offset, offset + length) of a file as Data frames of at most chunkSize bytes.
+ */
+std::expected<void, std::string> sendRange(StreamConnection& connection, int fileFd, uint64_t offset, uint64_t length, size_t chunkSize) {
+    while (length > 0) {
+        const uint64_t frameLength = std::min<uint64_t>(length, chunkSize);
+        auto sendResult = connection.sendFileRange(fileFd, offset, frameLength);
+        if (!sendResult) {
+            return sendResult;
+        }
+        offset += frameLength;
+        length -= frameLength;
+    }
+    auto endResult = connection.sendFrame(FrameType::End, {});
+    if (!endResult) {
+        return endResult;
+    }
+    auto reply = connection.expectOk();
+    if (!reply) {
+        return std::unexpected(reply.error());
+    }
+    return {};
+}
+
+std::expected<void, std::string> commitUpload(StreamConnection& connection, uint64_t size, const std::array<uint8_t, 32>& digest) {
+    std::vector<char> payload;
+    appendU64(payload, size);
+    payload.insert(payload.end(), digest.begin(), digest.end());
+    auto commitResult = connection.sendFrame(FrameType::Commit, payload);
+    if (!commitResult) {
+        return commitResult;
+    }
+    auto reply = connection.expectOk();
+    if (!reply) {
+        return std::unexpected(reply.error());
+    }
+    return {};
+}
+
+} // namespace
+
+class SecureVaultTransferStrategy::Upload : public TransferSink {
+public:
+    Upload(std::unique_ptr<StreamConnection> connection, uint64_t size, size_t chunkSize, std::string label)
+        : connection_(std::move(connection)), size_(size), chunkSize_(chunkSize), label_(std::move(label)) {}
+
+    std::expected<void, std::string> write(std::span<const char> data) override {
+        if (offset_ + data.size() > size_) {
+            return std::unexpected("Streamed data exceeds the announced artifact size");
+        }
+        while (!data.empty()) {
+            const size_t length = std::min(data.size(), chunkSize_);
+            std::vector<char> header;
+            header.push_back(static_cast<char>(FrameType::Data));
+            appendU32(header, static_cast<uint32_t>(8 + length));
+            appendU64(header, offset_);
+            auto headerResult = connection_->writeAll(header);
+            if (!headerResult) {
+                return headerResult;
+            }
+            auto dataResult = connection_->writeAll(data.first(length));
+            if (!dataResult) {
+                return dataResult;
+            }
+            digest_.update(data.first(length));
+            offset_ += length;
+            data = data.subspan(length);
+        }
+        return {};
+    }
+
+    std::expected<void, std::string> commit() override {
+        auto endResult = connection_->sendFrame(FrameType::End, {});
+        if (!endResult) {
+            return endResult;
+        }
+        auto reply = connection_->expectOk();
+        if (!reply) {
+            return std::unexpected(reply.error());
+        }
+        if (offset_ != size_) {
+            return std::unexpected(std::format("Streamed {} of {} announced bytes", offset_, size_));
+        }
+        auto commitResult = commitUpload(*connection_, size_, digest_.finish());
+        if (!commitResult) {
+            return commitResult;
+        }
+        std::cout << "Transferred file to receiver: " << label_ << std::endl;
+        return {};
+    }
+
+private:
+    std::unique_ptr<StreamConnection> connection_;
+    uint64_t size_;
+    size_t chunkSize_;
+    std::string label_;
+    uint64_t offset_ = 0;
+    UploadDigest digest_; ///< Digest of the bytes written so far, sent with Commit.
+};
+
+SecureVaultTransferStrategy::SecureVaultTransferStrategy(const Json::Value& config)
+    : host_(config.get("host", "").asString()),
+      port_(config.get("port", 7878).asInt()),
+      token_(config.get("token", "").asString()),
+      tls_(config.get("tls", true).asBool()),
+      verifyPeer_(config.get("verify_peer", true).asBool()),
+      streams_(std::clamp(config.get("streams", 4).asInt(), 1, 64)),
+      chunkSize_(std::clamp<size_t>(config.get("chunk_size", 16777216).asUInt(), 65536, 1u << 30)) {
+    if (tls_) {
+        auto context = createClientTlsContext(config.get("ca_file", "").asString(), verifyPeer_);
+        if (!context) {
+            throw std::runtime_error(context.error());
+        }
+        tlsContext_ = *context;
+    }
+}
+
+SecureVaultTransferStrategy::~SecureVaultTransferStrategy() {
+    if (tlsContext_) {
+        freeTlsContext(tlsContext_);
+    }
+}
+
+std::string SecureVaultTransferStrategy::name() const {
+    return std::format("securevault://{}:{}", host_, port_);
+}
+
+std::expected<std::unique_ptr<StreamConnection>, std::string> SecureVaultTransferStrategy::connect() {
+    if (host_.empty() || port_ <= 0 || token_.empty()) {
+        return std::unexpected("Invalid receiver configuration: host, port, or token missing");
+    }
+
+    const auto handshakeStart = std::chrono::steady_clock::now();
+    auto connection = StreamConnection::connect(host_, port_, tlsContext_, verifyPeer_);
+    if (!connection) {
+        return std::unexpected(connection.error());
+    }
+
+    std::vector<char> hello;
+    appendU32(hello, kReceiverProtocolMagic);
+    hello.insert(hello.end(), token_.begin(), token_.end());
+    auto helloResult = (*connection)->sendFrame(FrameType::Hello, hello);
+    if (!helloResult) {
+        return std::unexpected(helloResult.error());
+    }
+    auto reply = (*connection)->expectOk();
+    if (!reply) {
+        return std::unexpected(reply.error());
+    }
+    if (TransferMetrics* metrics = metrics_.load()) {
+        metrics->recordHandshake(name(), "", std::chrono::steady_clock::now() - handshakeStart);
+    }
+    return std::move(*connection);
+}
+
+std::expected<std::pair<std::unique_ptr<StreamConnection>, uint64_t>, std::string> SecureVaultTransferStrategy::begin(const std::string& remotePath,
+                                                                                                                       uint64_t size) {
+    auto connection = connect();
+    if (!connection) {
+        return std::unexpected(connection.error());
+    }
+
+    std::vector<char> payload;
+    appendU64(payload, size);
+    appendU16(payload, static_cast<uint16_t>(remotePath.size()));
+    payload.insert(payload.end(), remotePath.begin(), remotePath.end());
+    auto beginResult = (*connection)->sendFrame(FrameType::Begin, payload);
+    if (!beginResult) {
+        return std::unexpected(beginResult.error());
+    }
+    auto reply = (*connection)->expectOk();
+    if (!reply) {
+        return std::unexpected(reply.error());
+    }
+    if (reply->size() != 8) {
+        return std::unexpected("Malformed Begin reply from receiver");
+    }
+    return std::make_pair(std::move(*connection), readU64(reply->data()));
+}
+
+std::expected<std::unique_ptr<TransferSink>, std::string> SecureVaultTransferStrategy::openSink(const std::string& sourceFile,
+                                                                                                 const std::string& destinationPath) {
+    std::error_code ec;
+    const uint64_t size = fs::file_size(sourceFile, ec);
+    if (ec) {
+        return std::unexpected(std::format("Failed to stat local file: {}", ec.message()));
+    }
+
+    const std::string remotePath = remotePathFor(sourceFile, destinationPath);
+    auto opened = begin(remotePath, size);
+    if (!opened) {
+        return std::unexpected(opened.error());
+    }
+    return std::make_unique<Upload>(std::move(opened->first), size, chunkSize_, std::format("{}/{}", name(), remotePath));
+}
+
+std::expected<void, std::string> SecureVaultTransferStrategy::transfer(const std::string& sourceFile, const std::string& destinationPath) {
+    const int fileFd = ::open(sourceFile.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fileFd < 0) {
+        return std::unexpected("Failed to open local file");
+    }
+    struct FileCloser {
+        int fd;
+        ~FileCloser() { ::close(fd); }
+    } fileCloser{fileFd};
+
+    struct stat fileStat {};
+    if (::fstat(fileFd, &fileStat) != 0) {
+        return std::unexpected(std::format("Failed to stat local file: {}", std::strerror(errno)));
+    }
+    const uint64_t size = static_cast<uint64_t>(fileStat.st_size);
+    ::posix_fadvise(fileFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    const std::string remotePath = remotePathFor(sourceFile, destinationPath);
+    auto opened = begin(remotePath, size);
+    if (!opened) {
+        return std::unexpected(opened.error());
+    }
+    StreamConnection& primary = *opened->first;
+    const uint64_t uploadId = opened->second;
+
+    // Small files do not benefit from extra connections; keep at least one chunk per stream.
+    const uint64_t streamCount = std::clamp<uint64_t>(size / chunkSize_, 1, static_cast<uint64_t>(streams_));
+    const uint64_t rangeSize = (size + streamCount - 1) / streamCount;
+
+    std::vector<std::string> errors(streamCount);
+    std::vector<std::thread> workers;
+    for (uint64_t stream = 1; stream < streamCount; ++stream) {
+        workers.emplace_back([&, stream]() {
+            auto connection = connect();
+            if (!connection) {
+                errors[stream] = connection.error();
+                return;
+            }
+            std::vector<char> attach;
+            appendU64(attach, uploadId);
+            auto attachResult = (*connection)->sendFrame(FrameType::Attach, attach);
+            auto reply = attachResult ? (*connection)->expectOk() : std::unexpected(attachResult.error());
+            if (!reply) {
+                errors[stream] = reply.error();
+                return;
+            }
+            const uint64_t offset = stream * rangeSize;
+            const uint64_t length = offset < size ? std::min(rangeSize, size - offset) : 0;
+            auto sendResult = sendRange(**connection, fileFd, offset, length, chunkSize_);
+            if (!sendResult) {
+                errors[stream] = sendResult.error();
+            }
+        });
+    }
+
+    // The file is hashed while it is sent; the ranges are usually still in the page cache.
+    std::expected<std::array<uint8_t, 32>, std::string> digest = std::unexpected("");
+    std::thread hasher([&]() { digest = digestFile(fileFd, size, std::thread::hardware_concurrency()); });
+
+    auto primaryResult = sendRange(primary, fileFd, 0, std::min(rangeSize, size), chunkSize_);
+    if (!primaryResult) {
+        errors[0] = primaryResult.error();
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    hasher.join();
+    if (!digest) {
+        return std::unexpected(std::format("Transfer to {} failed: {}", name(), digest.error()));
+    }
+
+    for (const auto& error : errors) {
+        if (!error.empty()) {
+            // Dropping the primary connection makes the receiver discard the partial upload.
+            return std::unexpected(std::format("Transfer to {} failed: {}", name(), error));
+        }
+    }
+
+    auto commitResult = commitUpload(primary, size, *digest);
+    if (!commitResult) {
+        return std::unexpected(std::format("Transfer to {} failed: {}", name(), commitResult.error()));
+    }
+
+    std::cout << "Transferred file to receiver: " << name() << "/" << remotePath
+              << " (" << streamCount << " stream(s))" << std::endl;
+    return {};
+}
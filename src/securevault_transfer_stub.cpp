@@ -0,0 +1,29 @@
+#include "securevault_transfer.hpp"
+
+SecureVaultTransferStrategy::SecureVaultTransferStrategy(const Json::Value& config)
+    : host_(config.get("host", "").asString()),
+      port_(config.get("port", 7878).asInt()),
+      token_(config.get("token", "").asString()),
+      tls_(config.get("tls", true).asBool()),
+      verifyPeer_(config.get("verify_peer", true).asBool()),
+      streams_(config.get("streams", 4).asInt()),
+      chunkSize_(config.get("chunk_size", 16777216).asUInt()) {}
+
+SecureVaultTransferStrategy::~SecureVaultTransferStrategy() = default;
+
+std::string SecureVaultTransferStrategy::name() const {
+    return "securevault://" + host_;
+}
+
+std::expected<std::unique_ptr<TransferSink>, std::string> SecureVaultTransferStrategy::openSink(const std::string& sourceFile,
+                                                                                                 const std::string& destinationPath) {
+    (void)sourceFile;
+    (void)destinationPath;
+    return std::unexpected("Receiver transfers are disabled in this build because OpenSSL was not found");
+}
+
+std::expected<void, std::string> SecureVaultTransferStrategy::transfer(const std::string& sourceFile, const std::string& destinationPath) {
+    (void)sourceFile;
+    (void)destinationPath;
+    return std::unexpected("Receiver transfers are disabled in this build because OpenSSL was not found");
+}
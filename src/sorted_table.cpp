@@ -0,0 +1,132 @@
+/**
+ * @file sorted_table.cpp
+ * @brief File mapping and glob matching for sorted tables.
+ */
+
+#include "sorted_table.hpp"
+#include <cerrno>
+
+#ifdef _WIN32
+#include <fstream>
+#include <sstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+    if (data_) {
+        ::munmap(data_, size_);
+    }
+#endif
+}
+
+std::expected<void, std::string> MappedFile::open(const std::string& path) {
+#ifdef _WIN32
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return std::unexpected(std::format("Failed to open {}", path));
+    }
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    buffer_ = contents.str();
+    return {};
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::unexpected(std::format("Failed to open {}: {}", path, std::strerror(errno)));
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return std::unexpected(std::format("Failed to map {}: empty or unreadable file", path));
+    }
+    void* data = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return std::unexpected(std::format("Failed to map {}: {}", path, std::strerror(errno)));
+    }
+    data_ = data;
+    size_ = static_cast<size_t>(info.st_size);
+    return {};
+#endif
+}
+
+std::string_view MappedFile::bytes() const {
+#ifdef _WIN32
+    return buffer_;
+#else
+    return std::string_view(static_cast<const char*>(data_), size_);
+#endif
+}
+
+bool globMatch(std::string_view pattern, std::string_view text) {
+    size_t p = 0;
+    size_t t = 0;
+    size_t starPattern = std::string_view::npos;
+    size_t starText = 0;
+    while (t < text.size()) {
+        bool matched = false;
+        size_t nextPattern = p + 1;
+        if (p < pattern.size()) {
+            if (pattern[p] == '*') {
+                starPattern = p++;
+                starText = t;
+                continue;
+            }
+            if (pattern[p] == '?') {
+                matched = true;
+            } else if (pattern[p] == '[') {
+                size_t q = p + 1;
+                const bool negate = q < pattern.size() && (pattern[q] == '!' || pattern[q] == '^');
+                if (negate) {
+                    ++q;
+                }
+                bool inClass = false;
+                bool first = true;
+                while (q < pattern.size() && (first || pattern[q] != ']')) {
+                    first = false;
+                    if (q + 2 < pattern.size() && pattern[q + 1] == '-' && pattern[q + 2] != ']') {
+                        inClass = inClass || (text[t] >= pattern[q] && text[t] <= pattern[q + 2]);
+                        q += 3;
+                    } else {
+                        inClass = inClass || text[t] == pattern[q];
+                        ++q;
+                    }
+                }
+                if (q < pattern.size()) {
+                    matched = inClass != negate;
+                    nextPattern = q + 1;
+                } else {
+                    matched = text[t] == '['; // Unterminated class: literal '['.
+                }
+            } else {
+                const bool escaped = pattern[p] == '\\' && p + 1 < pattern.size();
+                if (escaped) {
+                    nextPattern = p + 2;
+                }
+                matched = text[t] == pattern[escaped ? p + 1 : p];
+            }
+        }
+        if (matched) {
+            p = nextPattern;
+            ++t;
+        } else if (starPattern != std::string_view::npos) {
+            p = starPattern + 1;
+            t = ++starText;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+std::string_view globPrefix(std::string_view pattern) {
+    return pattern.substr(0, pattern.find_first_of("*?[\\"));
+}
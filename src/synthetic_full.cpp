@@ -0,0 +1,241 @@
+/**
+ * @file synthetic_full.cpp
+ * @brief Assembling full archives from the frames of earlier archives.
+ */
+
+#include "synthetic_full.hpp"
+#include "digest.hpp"
+#include "frame_archive.hpp"
+#include <archive.h>
+#include <archive_entry.h>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t kReadBlockSize = 1 << 20;
+
+/**
+ * @brief Files of the state stored by one run.
+ */
+struct SourceFiles {
+    std::unordered_multimap<std::string, const FileVersion*> pending; ///< Not yet written, by entry name.
+    std::map<uint32_t, std::vector<const FileVersion*>> byFrame; ///< By frame holding the entry header.
+};
+
+ManifestEntry toManifestEntry(const FileVersion& version) {
+    ManifestEntry entry;
+    entry.sourcePath = version.sourcePath;
+    entry.archivePath = version.archivePath;
+    entry.size = version.size;
+    entry.mtime = version.mtime;
+    entry.stored = true;
+    entry.sha256 = Sha256::fromHex(version.sha256);
+    return entry;
+}
+
+void markWritten(SourceFiles& files, const FileVersion* version) {
+    auto [first, last] = files.pending.equal_range(version->archivePath);
+    for (auto it = first; it != last; ++it) {
+        if (it->second == version) {
+            files.pending.erase(it);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Recompresses the pending entries found by an open reader into the output archive.
+ */
+std::expected<void, std::string> rewriteEntries(struct archive* in, struct archive* out, FrameWriter& frames, SourceFiles& files,
+                                                SynthesisSummary& summary) {
+    std::vector<char> buffer(kReadBlockSize);
+    struct archive_entry* entry;
+    while (true) {
+        const int rc = archive_read_next_header(in, &entry);
+        if (rc == ARCHIVE_EOF) {
+            return {};
+        }
+        if (rc < ARCHIVE_WARN) {
+            return std::unexpected(std::format("Bad archive header: {}", archive_error_string(in)));
+        }
+        const char* name = archive_entry_pathname(entry);
+        auto pending = name ? files.pending.find(name) : files.pending.end();
+        if (archive_entry_filetype(entry) != AE_IFREG || pending == files.pending.end()) {
+            if (archive_read_data_skip(in) < ARCHIVE_WARN) {
+                return std::unexpected(std::format("Bad archive entry {}: {}", name ? name : "", archive_error_string(in)));
+            }
+            continue;
+        }
+
+        ManifestEntry written = toManifestEntry(*pending->second);
+        frames.startEntry();
+        written.archiveOffset = frames.position();
+        written.frame = frames.frameNumber();
+        if (archive_write_header(out, entry) != ARCHIVE_OK) {
+            return std::unexpected(std::format("Failed to write archive header for {} (error: {})", name, archive_error_string(out)));
+        }
+        while (true) {
+            const la_ssize_t length = archive_read_data(in, buffer.data(), buffer.size());
+            if (length == 0) {
+                break;
+            }
+            if (length < 0) {
+                return std::unexpected(std::format("Failed to read {} from archive: {}", name, archive_error_string(in)));
+            }
+            if (archive_write_data(out, buffer.data(), static_cast<size_t>(length)) != length) {
+                return std::unexpected(std::format("Failed to write archive data for {} (error: {})", name, archive_error_string(out)));
+            }
+            summary.bytesRewritten += static_cast<uint64_t>(length);
+        }
+        if (archive_write_finish_entry(out) != ARCHIVE_OK) {
+            return std::unexpected(std::format("Failed to finish archive entry for {} (error: {})", name, archive_error_string(out)));
+        }
+        summary.entries.push_back(std::move(written));
+        files.pending.erase(pending);
+    }
+}
+
+/**
+ * @brief Appends the pending files of one source archive to the output archive.
+ */
+std::expected<void, std::string> appendSource(const std::string& archivePath, struct archive* out, FrameWriter& frames,
+                                              SourceFiles& files, SynthesisSummary& summary) {
+    auto index = readFrameIndex(archivePath);
+    if (!index) {
+        // Without a frame index the whole archive is filtered entry by entry.
+        struct archive* in = archive_read_new();
+        archive_read_support_filter_all(in);
+        archive_read_support_format_tar(in);
+        std::expected<void, std::string> result;
+        if (archive_read_open_filename(in, archivePath.c_str(), kReadBlockSize) != ARCHIVE_OK) {
+            result = std::unexpected(std::format("Failed to open archive {}: {}", archivePath, archive_error_string(in)));
+        } else {
+            result = rewriteEntries(in, out, frames, files, summary);
+        }
+        archive_read_free(in);
+        ++summary.framesRewritten;
+        return result;
+    }
+
+    std::ifstream archive(archivePath, std::ios::binary);
+    if (!archive) {
+        return std::unexpected(std::format("Failed to open archive {}", archivePath));
+    }
+    const std::vector<ArchiveFrame>& sourceFrames = *index;
+    for (uint32_t number = 0; number < sourceFrames.size(); ++number) {
+        const ArchiveFrame& frame = sourceFrames[number];
+        auto live = files.byFrame.find(number);
+        if (live == files.byFrame.end()) {
+            ++summary.framesSkipped;
+            continue;
+        }
+
+        // The last frame also holds the source's end-of-archive marker, so it is never copied.
+        if (number + 1 < sourceFrames.size() && live->second.size() == frame.entries) {
+            auto placed = frames.appendFrame(archive, frame);
+            if (!placed) {
+                return std::unexpected(placed.error());
+            }
+            const uint32_t placedNumber = frames.frameNumber() - 1;
+            for (const FileVersion* version : live->second) {
+                ManifestEntry copied = toManifestEntry(*version);
+                copied.archiveOffset = version->archiveOffset - frame.uncompressedOffset + placed->uncompressedOffset;
+                copied.frame = placedNumber;
+                summary.entries.push_back(std::move(copied));
+                markWritten(files, version);
+            }
+            ++summary.framesCopied;
+            summary.bytesCopied += frame.compressedSize;
+            continue;
+        }
+
+        FrameReader reader(archive, frame);
+        FrameSource source{&reader, {}};
+        struct archive* in = archive_read_new();
+        archive_read_support_format_tar(in);
+        std::expected<void, std::string> result;
+        if (archive_read_open(in, &source, nullptr, readFrameBlock, nullptr) != ARCHIVE_OK) {
+            result = std::unexpected(source.error.empty() ? archive_error_string(in) : source.error);
+        } else {
+            result = rewriteEntries(in, out, frames, files, summary);
+        }
+        archive_read_free(in);
+        // The frame is only known to be intact once its end (and CRC) was reached.
+        while (result) {
+            auto block = reader.next();
+            if (!block) {
+                result = std::unexpected(block.error());
+            } else if (block->empty()) {
+                break;
+            }
+        }
+        if (!result) {
+            return std::unexpected(std::format("Frame {} of {}: {}", number, archivePath, source.error.empty() ? result.error() : source.error));
+        }
+        ++summary.framesRewritten;
+    }
+    return {};
+}
+
+} // namespace
+
+std::expected<SynthesisSummary, std::string> synthesizeFullArchive(const std::vector<FileVersion>& state,
+                                                                   const std::map<uint32_t, std::string>& archives,
+                                                                   const std::string& outputFile, uint64_t frameSize) {
+    std::map<uint32_t, SourceFiles> sources;
+    for (const auto& version : state) {
+        if (!archives.contains(version.storedRun)) {
+            return std::unexpected(std::format("No archive for run {}, which holds {}", version.storedRun, version.sourcePath));
+        }
+        auto& files = sources[version.storedRun];
+        files.pending.emplace(version.archivePath, &version);
+        files.byFrame[version.frame].push_back(&version);
+    }
+
+    std::error_code ec;
+    fs::create_directories(fs::path(outputFile).parent_path(), ec);
+    struct archive* out = archive_write_new();
+    archive_write_set_format_pax_restricted(out);
+    FrameWriter frames(outputFile, frameSize);
+    auto opened = frames.open(out);
+    if (!opened) {
+        archive_write_free(out);
+        return std::unexpected(opened.error());
+    }
+
+    SynthesisSummary summary;
+    summary.entries.reserve(state.size());
+    std::expected<void, std::string> result;
+    // Oldest run first, so the entries keep roughly the order of the original full backup.
+    for (auto& [run, files] : sources) {
+        result = appendSource(archives.at(run), out, frames, files, summary);
+        if (result && !files.pending.empty()) {
+            result = std::unexpected(std::format("{} file(s) of run {} are missing from {} (e.g. {})", files.pending.size(), run,
+                                                 archives.at(run), files.pending.begin()->second->sourcePath));
+        }
+        if (!result) {
+            break;
+        }
+    }
+
+    if (result && archive_write_close(out) != ARCHIVE_OK) {
+        result = std::unexpected(std::format("Failed to close archive file: {} (error: {})", outputFile, archive_error_string(out)));
+    }
+    if (result) {
+        result = frames.finish();
+    }
+    if (!result) {
+        archive_write_close(out);
+        archive_write_free(out);
+        fs::remove(outputFile, ec);
+        fs::remove(frameIndexPath(outputFile), ec);
+        return std::unexpected(result.error());
+    }
+    archive_write_free(out);
+    return summary;
+}
@@ -0,0 +1,209 @@
+#include "transfer_metrics.hpp"
+#include <format>
+#include <sstream>
+
+namespace {
+
+std::string escapeLabel(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+        }
+        if (c == '\n') {
+            escaped += "\\n";
+            continue;
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+} // namespace
+
+void TransferMetrics::beginArtifact(const std::string& artifact, const std::string& artifactClass) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [it, inserted] = artifacts_.try_emplace(artifact);
+    if (inserted) {
+        order_.push_back(artifact);
+    }
+    it->second.artifact = artifact;
+    it->second.artifactClass = artifactClass;
+}
+
+void TransferMetrics::finishArtifact(const std::string& artifact, uint64_t bytes, std::chrono::duration<double> duration,
+                                     std::chrono::duration<double> readTime, std::chrono::duration<double> sinkTime,
+                                     const std::string& error) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = artifacts_.find(artifact);
+    if (it == artifacts_.end()) {
+        return;
+    }
+    it->second.bytes = bytes;
+    it->second.duration = duration;
+    it->second.readTime = readTime;
+    it->second.sinkTime = sinkTime;
+    it->second.success = error.empty();
+    it->second.error = error;
+}
+
+void TransferMetrics::addStall(const std::string& artifact, std::chrono::duration<double> stall) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = artifacts_.find(artifact);
+    if (it != artifacts_.end()) {
+        it->second.stallTime += stall;
+    }
+}
+
+void TransferMetrics::addRetry(const std::string& artifact) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = artifacts_.find(artifact);
+    if (it != artifacts_.end()) {
+        ++it->second.retries;
+    }
+}
+
+void TransferMetrics::recordVerification(const std::string& artifact, RemoteVerification verification, const std::string& note) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = artifacts_.find(artifact);
+    if (it != artifacts_.end()) {
+        it->second.verification = verification;
+        it->second.verificationNote = note;
+    }
+}
+
+void TransferMetrics::recordHandshake(const std::string& destination, const std::string& artifact, std::chrono::duration<double> handshake) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& session = sessions_[destination];
+    ++session.established;
+    session.handshakeTime += handshake;
+    auto it = artifacts_.find(artifact);
+    if (it != artifacts_.end()) {
+        it->second.handshakeTime += handshake;
+    }
+}
+
+void TransferMetrics::recordSessionReuse(const std::string& destination) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++sessions_[destination].reused;
+}
+
+Json::Value TransferMetrics::toJson() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Json::Value root;
+    Json::Value& artifacts = root["artifacts"];
+    artifacts = Json::arrayValue;
+    for (const auto& name : order_) {
+        const auto& metrics = artifacts_.at(name);
+        Json::Value entry;
+        entry["artifact"] = metrics.artifact;
+        entry["class"] = metrics.artifactClass;
+        entry["bytes"] = static_cast<Json::UInt64>(metrics.bytes);
+        entry["duration_seconds"] = metrics.duration.count();
+        entry["mib_per_second"] = metrics.duration.count() > 0
+            ? static_cast<double>(metrics.bytes) / (1024.0 * 1024.0) / metrics.duration.count()
+            : 0.0;
+        entry["read_seconds"] = metrics.readTime.count();
+        entry["sink_seconds"] = metrics.sinkTime.count();
+        entry["stall_seconds"] = metrics.stallTime.count();
+        entry["handshake_seconds"] = metrics.handshakeTime.count();
+        entry["retries"] = metrics.retries;
+        if (metrics.verification != RemoteVerification::NotChecked) {
+            entry["remote_verification"] = metrics.verification == RemoteVerification::Verified ? "verified" : "unverified";
+        }
+        if (!metrics.verificationNote.empty()) {
+            entry["verification_note"] = metrics.verificationNote;
+        }
+        entry["success"] = metrics.success;
+        if (!metrics.error.empty()) {
+            entry["error"] = metrics.error;
+        }
+        artifacts.append(entry);
+    }
+
+    Json::Value& sessions = root["sessions"];
+    sessions = Json::objectValue;
+    for (const auto& [destination, session] : sessions_) {
+        Json::Value entry;
+        entry["established"] = session.established;
+        entry["reused"] = session.reused;
+        entry["handshake_seconds"] = session.handshakeTime.count();
+        sessions[destination] = entry;
+    }
+    return root;
+}
+
+std::string TransferMetrics::toPrometheus(bool runSucceeded) const {
+    struct ClassTotals {
+        uint64_t bytes = 0;
+        double seconds = 0;
+        double stall = 0;
+        unsigned retries = 0;
+        unsigned failures = 0;
+        unsigned unverified = 0;
+    };
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, ClassTotals> classes;
+    for (const auto& [name, metrics] : artifacts_) {
+        auto& totals = classes[metrics.artifactClass];
+        totals.bytes += metrics.bytes;
+        totals.seconds += metrics.duration.count();
+        totals.stall += metrics.stallTime.count();
+        totals.retries += metrics.retries;
+        totals.failures += metrics.success ? 0 : 1;
+        totals.unverified += metrics.verification == RemoteVerification::Unverified ? 1 : 0;
+    }
+
+    std::ostringstream out;
+    auto family = [&](const char* name, const char* type, const char* help) {
+        out << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' ' << type << '\n';
+    };
+
+    family("securevault_last_run_timestamp_seconds", "gauge", "Completion time of the last backup run.");
+    out << "securevault_last_run_timestamp_seconds "
+        << std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count() << '\n';
+    family("securevault_last_run_success", "gauge", "1 if the last backup run succeeded.");
+    out << "securevault_last_run_success " << (runSucceeded ? 1 : 0) << '\n';
+
+    family("securevault_transfer_bytes", "gauge", "Bytes uploaded in the last run.");
+    for (const auto& [name, totals] : classes) {
+        out << std::format("securevault_transfer_bytes{{class=\"{}\"}} {}\n", escapeLabel(name), totals.bytes);
+    }
+    family("securevault_transfer_duration_seconds", "gauge", "Upload time in the last run.");
+    for (const auto& [name, totals] : classes) {
+        out << std::format("securevault_transfer_duration_seconds{{class=\"{}\"}} {:.3f}\n", escapeLabel(name), totals.seconds);
+    }
+    family("securevault_transfer_throughput_bytes_per_second", "gauge", "Effective upload throughput in the last run.");
+    for (const auto& [name, totals] : classes) {
+        const double rate = totals.seconds > 0 ? static_cast<double>(totals.bytes) / totals.seconds : 0.0;
+        out << std::format("securevault_transfer_throughput_bytes_per_second{{class=\"{}\"}} {:.0f}\n", escapeLabel(name), rate);
+    }
+    family("securevault_transfer_stall_seconds", "gauge", "Time spent waiting on network round trips in the last run.");
+    for (const auto& [name, totals] : classes) {
+        out << std::format("securevault_transfer_stall_seconds{{class=\"{}\"}} {:.3f}\n", escapeLabel(name), totals.stall);
+    }
+    family("securevault_transfer_retries", "gauge", "Retried transfer operations in the last run.");
+    for (const auto& [name, totals] : classes) {
+        out << std::format("securevault_transfer_retries{{class=\"{}\"}} {}\n", escapeLabel(name), totals.retries);
+    }
+    family("securevault_transfer_failures", "gauge", "Artifacts that failed to upload in the last run.");
+    for (const auto& [name, totals] : classes) {
+        out << std::format("securevault_transfer_failures{{class=\"{}\"}} {}\n", escapeLabel(name), totals.failures);
+    }
+    family("securevault_transfer_unverified", "gauge", "Uploads the destination could not integrity-check in the last run.");
+    for (const auto& [name, totals] : classes) {
+        out << std::format("securevault_transfer_unverified{{class=\"{}\"}} {}\n", escapeLabel(name), totals.unverified);
+    }
+
+    family("securevault_transfer_sessions", "gauge", "Connections used in the last run.");
+    for (const auto& [destination, session] : sessions_) {
+        out << std::format("securevault_transfer_sessions{{destination=\"{}\",kind=\"established\"}} {}\n", escapeLabel(destination), session.established);
+        out << std::format("securevault_transfer_sessions{{destination=\"{}\",kind=\"reused\"}} {}\n", escapeLabel(destination), session.reused);
+    }
+    family("securevault_transfer_handshake_seconds", "gauge", "Connection setup time in the last run.");
+    for (const auto& [destination, session] : sessions_) {
+        out << std::format("securevault_transfer_handshake_seconds{{destination=\"{}\"}} {:.3f}\n", escapeLabel(destination), session.handshakeTime.count());
+    }
+    return out.str();
+}
@@ -0,0 +1,274 @@
+#include "transfer_scheduler.hpp"
+#include "transfer_metrics.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+struct TransferScheduler::Active {
+    TransferJob job;
+    std::unique_ptr<TransferSink> sink; ///< Open streaming upload, once started.
+    std::ifstream input; ///< Local artifact positioned after the bytes already sent.
+    uint64_t sent = 0; ///< Bytes written to sink so far.
+    std::chrono::steady_clock::duration elapsed{}; ///< Upload time excluding pauses.
+    std::chrono::steady_clock::duration readTime{}; ///< Time spent reading the local file.
+    std::chrono::steady_clock::duration sinkTime{}; ///< Time blocked in the destination.
+    unsigned pauses = 0; ///< Times the upload yielded to a higher-priority artifact.
+    bool started = false;
+};
+
+TransferScheduler::TransferScheduler(TransferStrategy& strategy, const Json::Value& transferConfig, CompletionHandler onComplete,
+                                     TransferMetrics* metrics)
+    : strategy_(strategy),
+      onComplete_(std::move(onComplete)),
+      metrics_(metrics),
+      priorities_{{"db", 100}, {"sys", 10}},
+      bytesPerSecond_(transferConfig.get("expected_mbps", 0.0).asDouble() * 1024.0 * 1024.0),
+      preempt_(transferConfig.get("preempt", true).asBool()),
+      chunkSize_(std::max<size_t>(transferConfig.get("chunk_size", 1048576).asUInt(), 4096)) {
+    const Json::Value& priorities = transferConfig["priorities"];
+    if (priorities.isObject()) {
+        for (const auto& artifactClass : priorities.getMemberNames()) {
+            priorities_[artifactClass] = priorities[artifactClass].asInt();
+        }
+    }
+    const int windowMinutes = transferConfig.get("window_minutes", 0).asInt();
+    if (windowMinutes > 0) {
+        deadline_ = std::chrono::steady_clock::now() + std::chrono::minutes(windowMinutes);
+    }
+    worker_ = std::thread([this]() { workerLoop(); });
+}
+
+TransferScheduler::~TransferScheduler() {
+    finish();
+}
+
+bool TransferScheduler::runsBefore(const TransferJob& lhs, const TransferJob& rhs) {
+    if (lhs.priority != rhs.priority) {
+        return lhs.priority > rhs.priority;
+    }
+    if (lhs.size != rhs.size) {
+        return lhs.size < rhs.size;
+    }
+    return lhs.sequence < rhs.sequence;
+}
+
+void TransferScheduler::submit(const std::string& file, const std::string& destination, const std::string& artifactClass) {
+    TransferJob job;
+    job.file = file;
+    job.destination = destination;
+    job.artifactClass = artifactClass;
+    auto priority = priorities_.find(artifactClass);
+    job.priority = priority != priorities_.end() ? priority->second : 0;
+    std::error_code ec;
+    job.size = fs::file_size(file, ec);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closed_) {
+            return;
+        }
+        job.sequence = nextSequence_++;
+        queue_.push_back(std::move(job));
+    }
+    wake_.notify_one();
+}
+
+std::vector<TransferOutcome> TransferScheduler::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+    }
+    wake_.notify_one();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    return outcomes_;
+}
+
+std::vector<std::string> TransferScheduler::forecastMisses() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return forecastLocked();
+}
+
+std::vector<std::string> TransferScheduler::forecastLocked() const {
+    if (!deadline_) {
+        return {};
+    }
+    // Prefer measured throughput once there is enough of it to be meaningful.
+    double rate = bytesPerSecond_;
+    const double busySeconds = std::chrono::duration<double>(busyTime_).count();
+    if (busySeconds >= 1.0 && bytesDone_ > 0) {
+        rate = static_cast<double>(bytesDone_) / busySeconds;
+    }
+    if (rate <= 0) {
+        return {};
+    }
+
+    std::vector<const TransferJob*> ordered;
+    for (const auto& job : queue_) {
+        ordered.push_back(&job);
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const TransferJob* lhs, const TransferJob* rhs) { return runsBefore(*lhs, *rhs); });
+
+    std::vector<std::string> misses;
+    const auto now = std::chrono::steady_clock::now();
+    double secondsAhead = static_cast<double>(startedRemaining_) / rate;
+    for (const TransferJob* job : ordered) {
+        secondsAhead += static_cast<double>(job->size) / rate;
+        const auto eta = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(secondsAhead));
+        if (eta > *deadline_) {
+            const auto late = std::chrono::duration_cast<std::chrono::minutes>(eta - *deadline_).count();
+            misses.push_back(std::format("{} ({} MiB, class {}) is expected to finish about {} min after the transfer window closes",
+                                         job->file, job->size / (1024 * 1024), job->artifactClass, late));
+        }
+    }
+    return misses;
+}
+
+void TransferScheduler::workerLoop() {
+    // Paused uploads form a stack: each was preempted by a strictly more important job.
+    std::vector<std::unique_ptr<Active>> paused;
+    while (true) {
+        std::unique_ptr<Active> active;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [&]() { return closed_ || !queue_.empty() || !paused.empty(); });
+            auto best = std::min_element(queue_.begin(), queue_.end(), runsBefore);
+            if (!paused.empty() && (best == queue_.end() || best->priority <= paused.back()->job.priority)) {
+                active = std::move(paused.back());
+                paused.pop_back();
+            } else if (best != queue_.end()) {
+                active = std::make_unique<Active>();
+                active->job = std::move(*best);
+                queue_.erase(best);
+                startedRemaining_ += active->job.size;
+            } else {
+                break;
+            }
+        }
+
+        if (!advance(*active)) {
+            ++active->pauses;
+            active->sink->suspend();
+            paused.push_back(std::move(active));
+        }
+    }
+}
+
+bool TransferScheduler::advance(Active& active) {
+    const auto sliceStart = std::chrono::steady_clock::now();
+    auto account = [&](uint64_t bytes) {
+        const auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        bytesDone_ += bytes;
+        busyTime_ += now - sliceStart;
+        startedRemaining_ -= std::min(startedRemaining_, bytes);
+    };
+
+    if (!active.started) {
+        active.started = true;
+        if (metrics_) {
+            metrics_->beginArtifact(active.job.file, active.job.artifactClass);
+        }
+        if (!strategy_.supportsStreaming()) {
+            // Destinations without streaming support upload the whole artifact in one call.
+            auto result = strategy_.transfer(active.job.file, active.job.destination);
+            active.sent = result ? active.job.size : 0;
+            active.elapsed = std::chrono::steady_clock::now() - sliceStart;
+            active.sinkTime = active.elapsed;
+            account(active.sent);
+            complete(active, std::move(result));
+            return true;
+        }
+        auto sink = strategy_.openSink(active.job.file, active.job.destination);
+        if (!sink) {
+            active.elapsed = std::chrono::steady_clock::now() - sliceStart;
+            complete(active, std::unexpected(sink.error()));
+            return true;
+        }
+        active.sink = std::move(*sink);
+        active.input.open(active.job.file, std::ios::binary);
+        if (!active.input) {
+            complete(active, std::unexpected("Failed to open local file"));
+            return true;
+        }
+    }
+
+    uint64_t sliceBytes = 0;
+    while (true) {
+        // A fresh block per read, handed to the sink, so queueing sinks need not copy it.
+        std::vector<char> buffer(chunkSize_);
+        auto stepStart = std::chrono::steady_clock::now();
+        active.input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        const std::streamsize bytesRead = active.input.gcount();
+        auto stepEnd = std::chrono::steady_clock::now();
+        active.readTime += stepEnd - stepStart;
+        if (bytesRead > 0) {
+            buffer.resize(static_cast<size_t>(bytesRead));
+            auto writeResult = active.sink->writeBuffer(std::move(buffer));
+            stepStart = stepEnd;
+            stepEnd = std::chrono::steady_clock::now();
+            active.sinkTime += stepEnd - stepStart;
+            if (!writeResult) {
+                active.elapsed += std::chrono::steady_clock::now() - sliceStart;
+                account(sliceBytes);
+                complete(active, std::move(writeResult));
+                return true;
+            }
+            active.sent += static_cast<uint64_t>(bytesRead);
+            sliceBytes += static_cast<uint64_t>(bytesRead);
+        }
+
+        if (!active.input) {
+            std::expected<void, std::string> result = active.input.bad()
+                ? std::unexpected("Failed to read local file")
+                : active.sink->commit();
+            active.sinkTime += std::chrono::steady_clock::now() - stepEnd;
+            active.elapsed += std::chrono::steady_clock::now() - sliceStart;
+            account(sliceBytes);
+            complete(active, std::move(result));
+            return true;
+        }
+
+        if (preempt_) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const bool yield = std::any_of(queue_.begin(), queue_.end(), [&](const TransferJob& queued) {
+                return queued.priority > active.job.priority;
+            });
+            if (yield) {
+                break;
+            }
+        }
+    }
+
+    active.elapsed += std::chrono::steady_clock::now() - sliceStart;
+    account(sliceBytes);
+    return false;
+}
+
+void TransferScheduler::complete(Active& active, std::expected<void, std::string> result) {
+    active.sink.reset();
+    TransferOutcome outcome;
+    outcome.job = active.job;
+    outcome.result = std::move(result);
+    outcome.elapsed = active.elapsed;
+    outcome.pauses = active.pauses;
+    outcome.missedWindow = deadline_ && std::chrono::steady_clock::now() > *deadline_;
+    if (metrics_) {
+        metrics_->finishArtifact(active.job.file, active.sent, active.elapsed, active.readTime, active.sinkTime,
+                                 outcome.result ? std::string() : outcome.result.error());
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Failed uploads leave their unsent remainder in the estimate; drop it.
+        startedRemaining_ -= std::min(startedRemaining_, active.job.size - std::min(active.job.size, active.sent));
+        outcomes_.push_back(outcome);
+    }
+    if (onComplete_) {
+        onComplete_(outcome);
+    }
+}
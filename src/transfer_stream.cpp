@@ -0,0 +1,409 @@
+/**
+ * @file transfer_stream.cpp
+ * @brief Streaming transfer helpers and the multi-destination fan-out stage for SecureVault.
+ *
+ * The fan-out stage reads every artifact once into shared, immutable buffers and hands
+ * them to one worker per destination, so local read I/O stays constant as destinations
+ * are added.
+ */
+
+#include "transfer_stream.hpp"
+#include "transfer_metrics.hpp"
+#include <fstream>
+#include <iostream>
+#include <format>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/**
+ * @brief Sink that spools a stream to a temporary file for destinations that cannot stream.
+ *
+ * The fan-out stage still reads the artifact once; the spool hands the copy to the
+ * destination's transfer() on commit and removes it afterwards.
+ */
+class SpoolSink : public TransferSink {
+public:
+    SpoolSink(TransferStrategy& destination, fs::path spoolDir, const std::string& sourceFile, std::string destinationPath)
+        : destination_(destination),
+          spoolDir_(std::move(spoolDir)),
+          spoolFile_(spoolDir_ / fs::path(sourceFile).filename()),
+          destinationPath_(std::move(destinationPath)),
+          output_(spoolFile_, std::ios::binary | std::ios::trunc) {}
+
+    ~SpoolSink() override {
+        output_.close();
+        std::error_code ec;
+        fs::remove_all(spoolDir_, ec);
+    }
+
+    bool isOpen() const { return output_.is_open(); }
+
+    std::expected<void, std::string> write(std::span<const char> data) override {
+        output_.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!output_) {
+            return std::unexpected(std::format("Failed to write spool file: {}", spoolFile_.string()));
+        }
+        return {};
+    }
+
+    std::expected<void, std::string> commit() override {
+        output_.close();
+        if (!output_) {
+            return std::unexpected(std::format("Failed to write spool file: {}", spoolFile_.string()));
+        }
+        return destination_.transfer(spoolFile_.string(), destinationPath_);
+    }
+
+private:
+    TransferStrategy& destination_;
+    fs::path spoolDir_;
+    fs::path spoolFile_;
+    std::string destinationPath_;
+    std::ofstream output_;
+};
+
+/**
+ * @brief Opens a streaming sink on a destination, spooling for ones that cannot stream.
+ */
+std::expected<std::unique_ptr<TransferSink>, std::string> openDestinationSink(TransferStrategy& destination,
+                                                                              const std::string& sourceFile,
+                                                                              const std::string& destinationPath) {
+    if (destination.supportsStreaming()) {
+        return destination.openSink(sourceFile, destinationPath);
+    }
+
+    static std::atomic<uint64_t> spoolCounter{0};
+    std::error_code ec;
+    const fs::path spoolDir = fs::temp_directory_path(ec) /
+        std::format("securevault-spool-{}-{}", std::chrono::steady_clock::now().time_since_epoch().count(), spoolCounter++);
+    if (ec || !fs::create_directories(spoolDir, ec) || ec) {
+        return std::unexpected(std::format("Failed to create spool directory {}: {}", spoolDir.string(), ec.message()));
+    }
+    auto sink = std::make_unique<SpoolSink>(destination, spoolDir, sourceFile, destinationPath);
+    if (!sink->isOpen()) {
+        return std::unexpected(std::format("Failed to create spool file in {}", spoolDir.string()));
+    }
+    return sink;
+}
+
+} // namespace
+
+std::expected<void, std::string> TransferStrategy::streamFile(const std::string& sourceFile,
+                                                              const std::string& destinationPath,
+                                                              size_t chunkSize) {
+    std::ifstream input(sourceFile, std::ios::binary);
+    if (!input) {
+        return std::unexpected("Failed to open local file");
+    }
+
+    auto sink = openSink(sourceFile, destinationPath);
+    if (!sink) {
+        return std::unexpected(sink.error());
+    }
+
+    while (input) {
+        std::vector<char> buffer(chunkSize);
+        input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        const std::streamsize bytesRead = input.gcount();
+        if (bytesRead <= 0) {
+            continue;
+        }
+
+        buffer.resize(static_cast<size_t>(bytesRead));
+        auto writeResult = (*sink)->writeBuffer(std::move(buffer));
+        if (!writeResult) {
+            return std::unexpected(writeResult.error());
+        }
+    }
+
+    if (input.bad()) {
+        return std::unexpected("Failed while reading local file for transfer");
+    }
+
+    return (*sink)->commit();
+}
+
+class FanOutTransferStrategy::Upload : public TransferSink {
+public:
+    using Buffer = std::shared_ptr<const std::vector<char>>;
+
+    Upload(FanOutTransferStrategy& owner, std::string sourceFile, std::string destinationPath)
+        : owner_(owner), sourceFile_(std::move(sourceFile)), destinationPath_(std::move(destinationPath)) {
+        for (const auto& destination : owner_.destinations_) {
+            auto lane = std::make_unique<Lane>();
+            lane->destination = destination.get();
+            auto sink = openDestinationSink(*destination, sourceFile_, destinationPath_);
+            if (sink) {
+                lane->sink = std::move(*sink);
+                lane->worker = std::thread([this, raw = lane.get()]() { run(*raw); });
+            } else {
+                lane->failed = true;
+                lane->error = sink.error();
+            }
+            lanes_.push_back(std::move(lane));
+        }
+    }
+
+    ~Upload() override {
+        // Abandon uncommitted streams: wake the workers, let them discard their queues.
+        close(false);
+    }
+
+    std::expected<void, std::string> write(std::span<const char> data) override {
+        dispatch(std::make_shared<const std::vector<char>>(data.begin(), data.end()));
+        return {};
+    }
+
+    std::expected<void, std::string> writeBuffer(std::vector<char>&& data) override {
+        dispatch(std::make_shared<const std::vector<char>>(std::move(data)));
+        return {};
+    }
+
+    /**
+     * @brief Queues a shared buffer for every destination that is still streaming.
+     *
+     * Blocks while the slowest healthy destination has queueDepth_ buffers pending, which
+     * bounds memory to queueDepth_ * chunkSize_ per destination.
+     */
+    void dispatch(const Buffer& buffer) {
+        for (auto& lane : lanes_) {
+            if (!lane->worker.joinable()) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(lane->mutex);
+            lane->cv.wait(lock, [&]() { return lane->failed || lane->queue.size() < owner_.queueDepth_; });
+            if (lane->failed) {
+                continue;
+            }
+            lane->queue.push_back(buffer);
+            lane->cv.notify_all();
+        }
+    }
+
+    void suspend() override {
+        for (auto& lane : lanes_) {
+            if (!lane->worker.joinable()) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(lane->mutex);
+            lane->suspendRequested = true;
+            lane->cv.notify_all();
+        }
+    }
+
+    std::expected<void, std::string> commit() override {
+        close(true);
+
+        std::vector<std::string> failures;
+        for (auto& lane : lanes_) {
+            const std::string label = lane->destination->name();
+            for (int attempt = 0; lane->failed && attempt < owner_.retries_; ++attempt) {
+                std::cerr << "Warning: Transfer to " << label << " failed (" << lane->error
+                          << "), retrying (" << attempt + 1 << "/" << owner_.retries_ << ")" << std::endl;
+                if (TransferMetrics* metrics = owner_.metrics_.load()) {
+                    metrics->addRetry(sourceFile_);
+                }
+                auto retryResult = lane->destination->transfer(sourceFile_, destinationPath_);
+                if (retryResult) {
+                    lane->failed = false;
+                } else {
+                    lane->error = retryResult.error();
+                }
+            }
+
+            if (lane->failed) {
+                failures.push_back(std::format("{}: {}", label, lane->error));
+            }
+        }
+
+        if (!failures.empty()) {
+            std::string joined;
+            for (const auto& failure : failures) {
+                joined += (joined.empty() ? "" : "; ") + failure;
+            }
+            return std::unexpected(std::format("{} of {} destination(s) failed: {}", failures.size(), lanes_.size(), joined));
+        }
+        return {};
+    }
+
+private:
+    /**
+     * @brief Per-destination stream state, owned by exactly one worker thread.
+     */
+    struct Lane {
+        TransferStrategy* destination = nullptr;
+        std::unique_ptr<TransferSink> sink;
+        std::deque<Buffer> queue;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool closed = false;
+        bool commitRequested = false;
+        bool suspendRequested = false; ///< Suspend the sink once the queue drains.
+        bool failed = false;
+        std::string error;
+        std::thread worker;
+    };
+
+    void run(Lane& lane) {
+        while (true) {
+            Buffer buffer;
+            {
+                std::unique_lock<std::mutex> lock(lane.mutex);
+                lane.cv.wait(lock, [&]() { return !lane.queue.empty() || lane.closed || lane.suspendRequested; });
+                if (lane.queue.empty() && lane.suspendRequested && !lane.closed) {
+                    lane.suspendRequested = false;
+                    lock.unlock();
+                    lane.sink->suspend();
+                    continue;
+                }
+                if (lane.queue.empty()) {
+                    break;
+                }
+                buffer = std::move(lane.queue.front());
+                lane.queue.pop_front();
+                lane.cv.notify_all();
+            }
+
+            auto writeResult = lane.sink->write(*buffer);
+            if (!writeResult) {
+                std::lock_guard<std::mutex> lock(lane.mutex);
+                lane.failed = true;
+                lane.error = writeResult.error();
+                lane.queue.clear();
+                lane.cv.notify_all();
+                break;
+            }
+        }
+
+        // Commit outside the lane lock: it may take as long as the final upload, and dispatch()
+        // must not block on it.
+        std::unique_ptr<TransferSink> sink;
+        bool commit = false;
+        {
+            std::lock_guard<std::mutex> lock(lane.mutex);
+            sink = std::move(lane.sink);
+            commit = !lane.failed && lane.commitRequested;
+        }
+        if (commit) {
+            auto commitResult = sink->commit();
+            if (!commitResult) {
+                std::lock_guard<std::mutex> lock(lane.mutex);
+                lane.failed = true;
+                lane.error = commitResult.error();
+            }
+        }
+    }
+
+    void close(bool commit) {
+        for (auto& lane : lanes_) {
+            {
+                std::lock_guard<std::mutex> lock(lane->mutex);
+                lane->closed = true;
+                lane->commitRequested = commit;
+                if (!commit) {
+                    lane->queue.clear();
+                }
+            }
+            lane->cv.notify_all();
+        }
+        for (auto& lane : lanes_) {
+            if (lane->worker.joinable()) {
+                lane->worker.join();
+            }
+        }
+    }
+
+    FanOutTransferStrategy& owner_;
+    std::string sourceFile_;
+    std::string destinationPath_;
+    std::vector<std::unique_ptr<Lane>> lanes_;
+};
+
+FanOutTransferStrategy::FanOutTransferStrategy(std::vector<std::unique_ptr<TransferStrategy>> destinations, const Json::Value& config)
+    : destinations_(std::move(destinations)),
+      chunkSize_(std::max<size_t>(config.get("chunk_size", 1048576).asUInt(), 4096)),
+      queueDepth_(std::max<size_t>(config.get("queue_depth", 8).asUInt(), 1)),
+      retries_(std::max(config.get("retries", 2).asInt(), 0)) {}
+
+std::string FanOutTransferStrategy::name() const {
+    std::string label;
+    for (const auto& destination : destinations_) {
+        label += (label.empty() ? "" : ", ") + destination->name();
+    }
+    return std::format("fan-out [{}]", label);
+}
+
+void FanOutTransferStrategy::attachMetrics(TransferMetrics* metrics) {
+    metrics_ = metrics;
+    for (auto& destination : destinations_) {
+        destination->attachMetrics(metrics);
+    }
+}
+
+std::expected<std::unique_ptr<TransferSink>, std::string> FanOutTransferStrategy::openSink(const std::string& sourceFile,
+                                                                                            const std::string& destinationPath) {
+    return std::make_unique<Upload>(*this, sourceFile, destinationPath);
+}
+
+std::expected<void, std::string> FanOutTransferStrategy::transfer(const std::string& sourceFile, const std::string& destinationPath) {
+    std::ifstream input(sourceFile, std::ios::binary);
+    if (!input) {
+        return std::unexpected("Failed to open local file");
+    }
+
+    Upload upload(*this, sourceFile, destinationPath);
+    while (input) {
+        auto buffer = std::make_shared<std::vector<char>>(chunkSize_);
+        input.read(buffer->data(), static_cast<std::streamsize>(buffer->size()));
+        const std::streamsize bytesRead = input.gcount();
+        if (bytesRead <= 0) {
+            continue;
+        }
+        buffer->resize(static_cast<size_t>(bytesRead));
+        upload.dispatch(std::move(buffer));
+    }
+
+    if (input.bad()) {
+        return std::unexpected("Failed while reading local file for transfer");
+    }
+
+    return upload.commit();
+}
+
+std::expected<size_t, std::string> FanOutTransferStrategy::pruneRemote(const std::vector<std::string>& directories,
+                                                                       std::chrono::system_clock::time_point threshold) {
+    size_t removed = 0;
+    std::string errors;
+    for (const auto& destination : destinations_) {
+        auto result = destination->pruneRemote(directories, threshold);
+        if (result) {
+            removed += *result;
+        } else {
+            errors += (errors.empty() ? "" : "; ") + std::format("{}: {}", destination->name(), result.error());
+        }
+    }
+    if (!errors.empty()) {
+        return std::unexpected(errors);
+    }
+    return removed;
+}
+
+std::expected<void, std::string> FanOutTransferStrategy::fetch(const std::string& remotePath, const std::string& localFile) {
+    std::string errors;
+    for (const auto& destination : destinations_) {
+        auto result = destination->fetch(remotePath, localFile);
+        if (result) {
+            return {};
+        }
+        errors += (errors.empty() ? "" : "; ") + std::format("{}: {}", destination->name(), result.error());
+    }
+    return std::unexpected(errors);
+}
@@ -0,0 +1,122 @@
+/**
+ * @file trash_collector.cpp
+ * @brief Deferred, rate-limited deletion of expired artifacts.
+ */
+
+#include "trash_collector.hpp"
+#include "io_priority.hpp"
+#include <chrono>
+#include <format>
+
+namespace fs = std::filesystem;
+
+TrashCollector::TrashCollector(std::string trashFolder, const Json::Value& trashConfig, ErrorHandler onError)
+    : trashFolder_(std::move(trashFolder)),
+      rate_(trashConfig.get("rate_mb", 1024).asUInt64() * 1024 * 1024),
+      truncateStep_(trashConfig.get("truncate_step_mb", 1024).asUInt64() * 1024 * 1024),
+      onError_(std::move(onError)) {
+    std::error_code ec;
+    fs::create_directories(trashFolder_, ec);
+    for (const auto& entry : fs::directory_iterator(trashFolder_, ec)) {
+        queue_.push_back(entry.path());
+    }
+    worker_ = std::thread(&TrashCollector::workerLoop, this);
+}
+
+TrashCollector::~TrashCollector() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    worker_.join();
+}
+
+std::expected<bool, std::string> TrashCollector::moveToTrash(const std::string& path) {
+    std::error_code ec;
+    if (!fs::exists(path, ec)) {
+        return false;
+    }
+    fs::path target;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        target = trashFolder_ / std::format("{}-{}-{}", std::chrono::system_clock::now().time_since_epoch().count(), counter_++,
+                                            fs::path(path).filename().string());
+    }
+    fs::rename(path, target, ec);
+    if (ec) {
+        // Not on the trash filesystem: delete in place rather than copying it across.
+        std::error_code removeEc;
+        fs::remove(path, removeEc);
+        if (removeEc) {
+            return std::unexpected(std::format("Failed to remove {}: {}", path, removeEc.message()));
+        }
+        return true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(target);
+    }
+    wake_.notify_one();
+    return true;
+}
+
+void TrashCollector::workerLoop() {
+    enterBackgroundPriority();
+    while (true) {
+        fs::path next;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            next = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        if (!purge(next)) {
+            return;
+        }
+    }
+}
+
+bool TrashCollector::purge(const fs::path& file) {
+    std::error_code ec;
+    if (fs::is_directory(file, ec)) {
+        fs::remove_all(file, ec);
+        if (ec) {
+            onError_(std::format("Failed to delete {} from the trash: {}", file.string(), ec.message()));
+        }
+        return true;
+    }
+    uint64_t size = fs::file_size(file, ec);
+    if (ec) {
+        return true; // Already gone.
+    }
+    // Shrinking from the end frees a bounded number of extents per step.
+    while (truncateStep_ > 0 && size > truncateStep_) {
+        size -= truncateStep_;
+        fs::resize_file(file, size, ec);
+        if (ec) {
+            break; // Fall back to a plain unlink.
+        }
+        if (!pace(truncateStep_)) {
+            return false;
+        }
+    }
+    fs::remove(file, ec);
+    if (ec) {
+        onError_(std::format("Failed to delete {} from the trash: {}", file.string(), ec.message()));
+        return true;
+    }
+    return pace(size);
+}
+
+bool TrashCollector::pace(uint64_t bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (rate_ > 0) {
+        const auto delay = std::chrono::duration<double>(static_cast<double>(bytes) / static_cast<double>(rate_));
+        wake_.wait_for(lock, delay, [this] { return stopping_; });
+    }
+    return !stopping_;
+}
@@ -0,0 +1,154 @@
+/**
+ * @file wake_event.cpp
+ * @brief Sleeps until a wall-clock deadline, an explicit wake-up or a change of the system clock.
+ */
+
+#include "wake_event.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace {
+
+/// Eventfd written by notifyFromSignal(), or -1.
+std::atomic<int> gSignalWakeFd{-1};
+
+} // namespace
+
+WakeEvent::WakeEvent()
+    : timerFd_(::timerfd_create(CLOCK_REALTIME, TFD_CLOEXEC | TFD_NONBLOCK)),
+      eventFd_(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {}
+
+WakeEvent::~WakeEvent() {
+    int expected = eventFd_;
+    gSignalWakeFd.compare_exchange_strong(expected, -1);
+    if (timerFd_ >= 0) {
+        ::close(timerFd_);
+    }
+    if (eventFd_ >= 0) {
+        ::close(eventFd_);
+    }
+}
+
+WakeEvent::Reason WakeEvent::waitUntil(std::chrono::system_clock::time_point deadline) {
+    using namespace std::chrono;
+    const auto now = system_clock::now();
+    if (deadline <= now) {
+        return Reason::Deadline;
+    }
+    // Far deadlines (or none) are re-evaluated once a year, which also keeps the timespec in range.
+    deadline = std::min(deadline, now + hours(24 * 365));
+
+    bool timerArmed = false;
+    if (timerFd_ >= 0) {
+        const auto sinceEpoch = deadline.time_since_epoch();
+        const auto wholeSeconds = duration_cast<seconds>(sinceEpoch);
+        itimerspec spec{};
+        spec.it_value.tv_sec = static_cast<time_t>(wholeSeconds.count());
+        spec.it_value.tv_nsec = static_cast<long>(duration_cast<nanoseconds>(sinceEpoch - wholeSeconds).count());
+        timerArmed = ::timerfd_settime(timerFd_, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &spec, nullptr) == 0;
+    }
+    int timeoutMs = -1;
+    if (!timerArmed) {
+        // Without a timer, poll() sleeps for the remaining time (and without an eventfd, in short steps).
+        const auto remaining = duration_cast<milliseconds>(deadline - now).count() + 1;
+        timeoutMs = static_cast<int>(std::min<long long>(remaining, eventFd_ >= 0 ? INT_MAX : 1000));
+    }
+
+    pollfd fds[2] = {{eventFd_, POLLIN, 0}, {timerArmed ? timerFd_ : -1, POLLIN, 0}};
+    int ready = 0;
+    do {
+        ready = ::poll(fds, 2, timeoutMs);
+    } while (ready < 0 && errno == EINTR && timeoutMs < 0);
+    if (ready <= 0) {
+        return Reason::Deadline;
+    }
+
+    Reason reason = Reason::Deadline;
+    uint64_t count = 0;
+    if (fds[0].revents & POLLIN) {
+        while (::read(eventFd_, &count, sizeof(count)) == sizeof(count)) {
+        }
+        reason = Reason::Notified;
+    }
+    if (fds[1].revents & POLLIN) {
+        // A cancelled timer reads as ECANCELED: the clock was set while we slept.
+        if (::read(timerFd_, &count, sizeof(count)) < 0 && errno == ECANCELED) {
+            reason = Reason::ClockChanged;
+        }
+    }
+    return reason;
+}
+
+void WakeEvent::notify() {
+    if (eventFd_ >= 0) {
+        const uint64_t one = 1;
+        [[maybe_unused]] const auto written = ::write(eventFd_, &one, sizeof(one));
+    }
+}
+
+void WakeEvent::receiveSignalWakeups() {
+    gSignalWakeFd.store(eventFd_);
+}
+
+void WakeEvent::notifyFromSignal() {
+    const int fd = gSignalWakeFd.load();
+    if (fd >= 0) {
+        const int savedErrno = errno;
+        const uint64_t one = 1;
+        [[maybe_unused]] const auto written = ::write(fd, &one, sizeof(one));
+        errno = savedErrno;
+    }
+}
+
+#else
+
+WakeEvent::WakeEvent() = default;
+
+WakeEvent::~WakeEvent() = default;
+
+WakeEvent::Reason WakeEvent::waitUntil(std::chrono::system_clock::time_point deadline) {
+    using namespace std::chrono;
+    const auto wallBefore = system_clock::now();
+    const auto steadyBefore = steady_clock::now();
+    if (deadline <= wallBefore) {
+        return Reason::Deadline;
+    }
+    // Waits are short so a flag set by a signal handler (which cannot notify) is seen in time.
+    const auto step = std::min<system_clock::duration>(deadline - wallBefore, seconds(1));
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (changed_.wait_for(lock, step, [this]() { return notified_; })) {
+        notified_ = false;
+        return Reason::Notified;
+    }
+    lock.unlock();
+    // Only a clock set backwards needs reporting; one set forwards makes deadlines pass.
+    const auto wallElapsed = system_clock::now() - wallBefore;
+    const auto steadyElapsed = steady_clock::now() - steadyBefore;
+    if (wallElapsed + seconds(2) < duration_cast<system_clock::duration>(steadyElapsed)) {
+        return Reason::ClockChanged;
+    }
+    return Reason::Deadline;
+}
+
+void WakeEvent::notify() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        notified_ = true;
+    }
+    changed_.notify_all();
+}
+
+void WakeEvent::receiveSignalWakeups() {}
+
+void WakeEvent::notifyFromSignal() {}
+
+#endif
@@ -0,0 +1,186 @@
+/**
+ * @file catalog_test.cpp
+ * @brief Tests for sorted-table lookups and the backup catalog built on them.
+ */
+
+#undef NDEBUG
+#include "catalog.hpp"
+#include "file_util.hpp"
+#include "sorted_table.hpp"
+#include <cassert>
+#include <filesystem>
+#include <iostream>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct TestHeader {
+    char magic[8];
+    uint32_t byteOrder;
+    uint32_t reserved;
+    uint64_t recordCount;
+    uint64_t stringsSize;
+};
+
+struct TestRecord {
+    uint64_t pathOffset;
+    uint32_t pathLength;
+    uint32_t value;
+};
+
+constexpr char kTestMagic[8] = {'S', 'V', 'T', 'E', 'S', 'T', '0', '1'};
+
+ManifestEntry entry(const std::string& path, int64_t mtime, bool stored) {
+    ManifestEntry manifestEntry;
+    manifestEntry.sourcePath = path;
+    manifestEntry.archivePath = path.substr(1);
+    manifestEntry.size = static_cast<uint64_t>(mtime) * 10;
+    manifestEntry.mtime = mtime;
+    manifestEntry.stored = stored;
+    manifestEntry.archiveOffset = stored ? 512 : ManifestEntry::kUnknownOffset;
+    manifestEntry.sha256.fill(static_cast<uint8_t>(mtime));
+    return manifestEntry;
+}
+
+void testGlob() {
+    assert(globMatch("*.conf", "/etc/nginx/nginx.conf"));
+    assert(globMatch("/etc/*", "/etc/a/b"));
+    assert(globMatch("/var/log/?.log", "/var/log/a.log"));
+    assert(!globMatch("/var/log/?.log", "/var/log/ab.log"));
+    assert(globMatch("/home/[a-c]*", "/home/bob"));
+    assert(!globMatch("/home/[a-c]*", "/home/dave"));
+    assert(globMatch("/exact", "/exact"));
+    assert(!globMatch("/exact", "/exact/more"));
+
+    assert(globPrefix("/etc/*.conf") == "/etc/");
+    assert(globPrefix("/var/log/?") == "/var/log/");
+    assert(globPrefix("/home/[ab]") == "/home/");
+    assert(globPrefix("/plain/path") == "/plain/path");
+    assert(globPrefix("*").empty());
+}
+
+void testTableView(const fs::path& directory) {
+    const std::vector<std::string> paths = {"/a", "/a/b", "/a/c", "/b", "/c/d"};
+    std::vector<TestRecord> records;
+    std::string strings;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        records.push_back({strings.size(), static_cast<uint32_t>(paths[i].size()), static_cast<uint32_t>(i * 10)});
+        strings += paths[i];
+    }
+    TestHeader header{};
+    std::copy(std::begin(kTestMagic), std::end(kTestMagic), header.magic);
+    header.byteOrder = kSortedTableByteOrder;
+    header.recordCount = records.size();
+    header.stringsSize = strings.size();
+    const std::string file = (directory / "table.idx").string();
+    assert(writeFileAtomically(file, serializeTable(header, records, strings)));
+
+    TableView<TestHeader, TestRecord> table;
+    assert(table.open(file, kTestMagic));
+    assert(table.count() == paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        assert(table.path(i) == paths[i]);
+        assert(table.lowerBound(paths[i]) == i);
+        assert(table.record(i).value == i * 10);
+    }
+    assert(table.lowerBound("") == 0);
+    assert(table.lowerBound("/a/") == 1);
+    assert(table.lowerBound("/bb") == 4);
+    assert(table.lowerBound("/z") == paths.size());
+
+    // Wrong magic, wrong byte order and truncation are rejected.
+    constexpr char otherMagic[8] = {'S', 'V', 'T', 'E', 'S', 'T', '0', '2'};
+    TableView<TestHeader, TestRecord> other;
+    assert(!other.open(file, otherMagic));
+
+    TestHeader swapped = header;
+    swapped.byteOrder = 0x04030201;
+    assert(writeFileAtomically(file, serializeTable(swapped, records, strings)));
+    TableView<TestHeader, TestRecord> foreign;
+    assert(!foreign.open(file, kTestMagic));
+
+    std::string truncated = serializeTable(header, records, strings);
+    truncated.pop_back();
+    assert(writeFileAtomically(file, truncated));
+    TableView<TestHeader, TestRecord> shortFile;
+    assert(!shortFile.open(file, kTestMagic));
+}
+
+void testCatalog(const fs::path& directory) {
+    Catalog catalog((directory / "catalog").string());
+    assert(!catalog.versions("/a") || catalog.versions("/a")->empty());
+
+    CatalogRun run;
+    run.name = "20260101-000000";
+    run.type = "daily";
+    run.full = true;
+    auto first = catalog.commitRun(run, {entry("/etc/a.conf", 1, true), entry("/etc/b.conf", 1, true), entry("/var/x", 1, true)});
+    assert(first && first->sequence == 1);
+
+    // An incremental run changes a.conf, keeps b.conf and deletes /var/x.
+    run.full = false;
+    auto second = catalog.commitRun(run, {entry("/etc/a.conf", 2, true), entry("/etc/b.conf", 1, false)});
+    assert(second && second->sequence == 2);
+    assert(second->dependsOn == std::vector<uint32_t>{1});
+
+    // A database-only run shares the state of the previous run.
+    auto databaseOnly = catalog.commitRunWithoutFiles(run);
+    assert(databaseOnly && databaseOnly->sequence == 3 && databaseOnly->stateRun == 2);
+
+    auto runs = catalog.runs();
+    assert(runs && runs->size() == 3);
+
+    auto found = catalog.find("/etc/*.conf");
+    assert(found && (*found == std::vector<std::string>{"/etc/a.conf", "/etc/b.conf"}));
+    found = catalog.find("/var/*");
+    assert(found && (*found == std::vector<std::string>{"/var/x"}));
+    found = catalog.find("/nothing*");
+    assert(found && found->empty());
+
+    auto versions = catalog.versions("/etc/a.conf");
+    assert(versions && versions->size() == 2);
+    assert((*versions)[0].storedRun == 1 && (*versions)[0].mtime == 1);
+    assert((*versions)[1].storedRun == 2 && (*versions)[1].mtime == 2);
+    versions = catalog.versions("/etc/b.conf");
+    assert(versions && versions->size() == 1 && versions->front().storedRun == 1);
+
+    auto snapshot = catalog.snapshot(1);
+    assert(snapshot && snapshot->size() == 3);
+    snapshot = catalog.snapshot(3);
+    assert(snapshot && snapshot->size() == 2);
+    assert(snapshot->front().sourcePath == "/etc/a.conf" && snapshot->front().storedRun == 2);
+    assert(snapshot->back().sourcePath == "/etc/b.conf" && snapshot->back().storedRun == 1);
+    snapshot = catalog.snapshot(1, "/var/");
+    assert(snapshot && snapshot->size() == 1 && snapshot->front().archivePath == "var/x");
+
+    // Run 3 still shares run 2's segment, so removing run 2 keeps its versions.
+    assert(catalog.removeRuns({2}));
+    versions = catalog.versions("/etc/a.conf");
+    assert(versions && versions->size() == 2);
+    snapshot = catalog.snapshot(3);
+    assert(snapshot && snapshot->size() == 2);
+
+    // Once no run shares it, the segment goes and lookups skip it.
+    assert(catalog.removeRuns({3}));
+    versions = catalog.versions("/etc/a.conf");
+    assert(versions && versions->size() == 1 && versions->front().run == 1);
+    assert(!catalog.snapshot(3));
+    runs = catalog.runs();
+    assert(runs && runs->size() == 1 && runs->front().sequence == 1);
+}
+
+} // namespace
+
+int main() {
+    const fs::path directory = fs::temp_directory_path() / ("securevault-catalog-test-" + std::to_string(::getpid()));
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    testGlob();
+    testTableView(directory);
+    testCatalog(directory);
+    fs::remove_all(directory);
+    std::cout << "catalog_test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file content_chunker_test.cpp
+ * @brief Tests for content-defined chunk boundaries.
+ */
+
+#undef NDEBUG
+#include "content_chunker.hpp"
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+
+std::vector<uint8_t> randomBytes(size_t size, unsigned seed) {
+    std::mt19937_64 generator(seed);
+    std::vector<uint8_t> bytes(size);
+    for (auto& byte : bytes) {
+        byte = static_cast<uint8_t>(generator());
+    }
+    return bytes;
+}
+
+/**
+ * @brief Returns the end offsets of all chunks of data.
+ */
+std::vector<size_t> boundaries(const Chunker& chunker, const std::vector<uint8_t>& data) {
+    std::vector<size_t> ends;
+    size_t start = 0;
+    while (start < data.size()) {
+        const size_t length = chunker.cut(data.data() + start, data.size() - start);
+        assert(length > 0 && start + length <= data.size());
+        start += length;
+        ends.push_back(start);
+    }
+    return ends;
+}
+
+void testBounds() {
+    const Chunker chunker(8192);
+    assert(chunker.minSize() == 2048);
+    assert(chunker.maxSize() == 32768);
+
+    const auto data = randomBytes(4 << 20, 1);
+    const auto ends = boundaries(chunker, data);
+    size_t previous = 0;
+    for (size_t i = 0; i < ends.size(); ++i) {
+        const size_t length = ends[i] - previous;
+        assert(length <= chunker.maxSize());
+        if (i + 1 < ends.size()) {
+            assert(length > chunker.minSize());
+        }
+        previous = ends[i];
+    }
+    // Normalized chunking keeps the mean close to the target.
+    const size_t average = data.size() / ends.size();
+    assert(average > 8192 / 2 && average < 8192 * 2);
+
+    // Short tails are a single chunk; content without boundaries is cut at the maximum.
+    assert(chunker.cut(data.data(), 100) == 100);
+    assert(chunker.cut(data.data(), chunker.minSize()) == chunker.minSize());
+    const std::vector<uint8_t> zeros(1 << 20, 0);
+    size_t start = 0;
+    for (size_t end : boundaries(chunker, zeros)) {
+        assert(end - start <= chunker.maxSize());
+        start = end;
+    }
+}
+
+void testDeterministic() {
+    const auto data = randomBytes(1 << 20, 2);
+    assert(boundaries(Chunker(4096), data) == boundaries(Chunker(4096), data));
+}
+
+void testInsertionShiftsFewBoundaries() {
+    const Chunker chunker(8192);
+    const auto original = randomBytes(2 << 20, 3);
+    auto edited = original;
+    const auto inserted = randomBytes(100, 4);
+    edited.insert(edited.begin() + 5000, inserted.begin(), inserted.end());
+
+    // Boundaries after the edit reappear shifted by the inserted length.
+    std::set<size_t> shifted;
+    for (size_t end : boundaries(chunker, original)) {
+        shifted.insert(end + inserted.size());
+    }
+    const auto editedEnds = boundaries(chunker, edited);
+    size_t differing = 0;
+    for (size_t end : editedEnds) {
+        if (end > 5000 && !shifted.contains(end)) {
+            ++differing;
+        }
+    }
+    assert(differing <= 2);
+    assert(editedEnds.size() > 100);
+}
+
+} // namespace
+
+int main() {
+    testBounds();
+    testDeterministic();
+    testInsertionShiftsFewBoundaries();
+    std::cout << "content_chunker_test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,180 @@
+/**
+ * @file cron_schedule_test.cpp
+ * @brief Tests for cron expression parsing and next-run computation.
+ */
+
+#undef NDEBUG
+#include "cron_schedule.hpp"
+#include <cassert>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+
+namespace {
+
+using TimePoint = std::chrono::system_clock::time_point;
+
+TimePoint localTime(int year, int month, int day, int hour, int minute, int second = 0) {
+    std::tm local{};
+    local.tm_year = year - 1900;
+    local.tm_mon = month - 1;
+    local.tm_mday = day;
+    local.tm_hour = hour;
+    local.tm_min = minute;
+    local.tm_sec = second;
+    local.tm_isdst = -1;
+    return std::chrono::system_clock::from_time_t(std::mktime(&local));
+}
+
+std::tm fields(TimePoint time) {
+    const std::time_t timeT = std::chrono::system_clock::to_time_t(time);
+    std::tm local{};
+    localtime_r(&timeT, &local);
+    return local;
+}
+
+void expectLocal(TimePoint time, int year, int month, int day, int hour, int minute, int second = 0) {
+    const std::tm local = fields(time);
+    assert(local.tm_year == year - 1900);
+    assert(local.tm_mon == month - 1);
+    assert(local.tm_mday == day);
+    assert(local.tm_hour == hour);
+    assert(local.tm_min == minute);
+    assert(local.tm_sec == second);
+}
+
+CronSchedule parsed(const std::string& expression) {
+    auto schedule = CronSchedule::parse(expression);
+    assert(schedule);
+    return *schedule;
+}
+
+void testParseErrors() {
+    assert(!CronSchedule::parse(""));
+    assert(!CronSchedule::parse("* * * *"));
+    assert(!CronSchedule::parse("* * * * * * *"));
+    assert(!CronSchedule::parse("60 * * * *"));
+    assert(!CronSchedule::parse("* 24 * * *"));
+    assert(!CronSchedule::parse("* * 0 * *"));
+    assert(!CronSchedule::parse("* * * 13 *"));
+    assert(!CronSchedule::parse("* * * * 8"));
+    assert(!CronSchedule::parse("5-1 * * * *"));
+    assert(!CronSchedule::parse("*/0 * * * *"));
+    assert(!CronSchedule::parse("* * * foo *"));
+
+    auto error = CronSchedule::parse("0 25 * * *");
+    assert(!error && error.error().find("hour field") != std::string::npos);
+
+    assert(CronSchedule::parse("0 0 1 jan,JUL mon-fri"));
+    assert(CronSchedule::parse("*/15 * * * * *"));
+    assert(parsed("@daily").expression() == "@daily");
+}
+
+void testFields() {
+    // Steps, ranges with steps, lists and a step after a single value.
+    TimePoint time = localTime(2026, 1, 5, 10, 0);
+    const CronSchedule steps = parsed("10-50/20 * * * *");
+    time = steps.next(time);
+    expectLocal(time, 2026, 1, 5, 10, 10);
+    time = steps.next(time);
+    expectLocal(time, 2026, 1, 5, 10, 30);
+    time = steps.next(time);
+    expectLocal(time, 2026, 1, 5, 10, 50);
+    time = steps.next(time);
+    expectLocal(time, 2026, 1, 5, 11, 10);
+
+    expectLocal(parsed("5/30 * * * *").next(localTime(2026, 1, 5, 10, 6)), 2026, 1, 5, 10, 35);
+    expectLocal(parsed("0 9,17 * * *").next(localTime(2026, 1, 5, 9, 0)), 2026, 1, 5, 17, 0);
+    expectLocal(parsed("*/15 * * * * *").next(localTime(2026, 1, 5, 10, 0, 1)), 2026, 1, 5, 10, 0, 15);
+
+    // next() is strictly after its argument.
+    expectLocal(parsed("0 12 * * *").next(localTime(2026, 1, 5, 12, 0)), 2026, 1, 6, 12, 0);
+
+    // Month and weekday names; 7 is Sunday. 2026-01-05 is a Monday.
+    expectLocal(parsed("0 0 1 feb *").next(localTime(2026, 1, 5, 0, 0)), 2026, 2, 1, 0, 0);
+    expectLocal(parsed("0 0 * * 7").next(localTime(2026, 1, 5, 0, 0)), 2026, 1, 11, 0, 0);
+    expectLocal(parsed("0 0 * * sat").next(localTime(2026, 1, 5, 0, 0)), 2026, 1, 10, 0, 0);
+
+    // Shorthands.
+    expectLocal(parsed("@hourly").next(localTime(2026, 1, 5, 10, 30)), 2026, 1, 5, 11, 0);
+    expectLocal(parsed("@weekly").next(localTime(2026, 1, 5, 10, 30)), 2026, 1, 11, 0, 0);
+    expectLocal(parsed("@monthly").next(localTime(2026, 1, 5, 10, 30)), 2026, 2, 1, 0, 0);
+    expectLocal(parsed("@yearly").next(localTime(2026, 1, 5, 10, 30)), 2027, 1, 1, 0, 0);
+
+    // Leap day, and a date that never occurs.
+    expectLocal(parsed("0 0 29 2 *").next(localTime(2026, 1, 5, 0, 0)), 2028, 2, 29, 0, 0);
+    assert(parsed("0 0 30 2 *").next(localTime(2026, 1, 5, 0, 0)) == TimePoint::max());
+}
+
+void testDayOfMonthOrWeekday() {
+    // Both restricted: either matches. 2026-01-13 is a Tuesday, 2026-01-09 a Friday.
+    const CronSchedule either = parsed("0 0 13 * 5");
+    TimePoint time = either.next(localTime(2026, 1, 1, 0, 0));
+    expectLocal(time, 2026, 1, 2, 0, 0);
+    time = either.next(time);
+    expectLocal(time, 2026, 1, 9, 0, 0);
+    time = either.next(time);
+    expectLocal(time, 2026, 1, 13, 0, 0);
+
+    // A field starting with '*' is unrestricted, so only the other one applies.
+    const CronSchedule mondays = parsed("0 0 */2 * 1");
+    time = mondays.next(localTime(2026, 1, 1, 0, 0));
+    expectLocal(time, 2026, 1, 5, 0, 0);
+    time = mondays.next(time);
+    expectLocal(time, 2026, 1, 12, 0, 0);
+
+    const CronSchedule firsts = parsed("0 0 1 * */2");
+    time = firsts.next(localTime(2026, 1, 1, 0, 0));
+    expectLocal(time, 2026, 2, 1, 0, 0);
+    time = firsts.next(time);
+    expectLocal(time, 2026, 3, 1, 0, 0);
+}
+
+void testDaylightSaving() {
+    setenv("TZ", "Europe/Berlin", 1);
+    tzset();
+    if (fields(localTime(2026, 7, 1, 12, 0)).tm_isdst <= 0) {
+        std::cout << "Skipping daylight-saving tests: no Europe/Berlin time zone data" << std::endl;
+        return;
+    }
+
+    // Clocks go from 02:00 to 03:00 on 2026-03-29: the 02:30 run happens at 03:00 instead.
+    const CronSchedule gap = parsed("30 2 * * *");
+    TimePoint time = gap.next(localTime(2026, 3, 28, 12, 0));
+    expectLocal(time, 2026, 3, 29, 3, 0);
+    time = gap.next(time);
+    expectLocal(time, 2026, 3, 30, 2, 30);
+    expectLocal(gap.next(localTime(2026, 3, 29, 1, 59, 59)), 2026, 3, 29, 3, 0);
+
+    // Every reading in the gap collapses into one run.
+    const CronSchedule inGap = parsed("*/20 2 * * *");
+    time = inGap.next(localTime(2026, 3, 28, 12, 0));
+    expectLocal(time, 2026, 3, 29, 3, 0);
+    expectLocal(inGap.next(time), 2026, 3, 30, 2, 0);
+
+    // Clocks go from 03:00 back to 02:00 on 2026-10-25: repeated readings run once.
+    const CronSchedule repeated = parsed("*/30 2 * * *");
+    time = repeated.next(localTime(2026, 10, 25, 0, 0));
+    expectLocal(time, 2026, 10, 25, 2, 0);
+    assert(fields(time).tm_isdst > 0);
+    time = repeated.next(time);
+    expectLocal(time, 2026, 10, 25, 2, 30);
+    time = repeated.next(time);
+    expectLocal(time, 2026, 10, 26, 2, 0);
+
+    setenv("TZ", "UTC", 1);
+    tzset();
+}
+
+} // namespace
+
+int main() {
+    setenv("TZ", "UTC", 1);
+    tzset();
+    testParseErrors();
+    testFields();
+    testDayOfMonthOrWeekday();
+    testDaylightSaving();
+    std::cout << "cron_schedule_test passed" << std::endl;
+    return 0;
+}
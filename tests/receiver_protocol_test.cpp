@@ -0,0 +1,196 @@
+/**
+ * @file receiver_protocol_test.cpp
+ * @brief Tests for receiver protocol framing and upload digests over a local socket pair.
+ */
+
+#undef NDEBUG
+#include "receiver_protocol.hpp"
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+struct ConnectionPair {
+    std::unique_ptr<StreamConnection> client;
+    std::unique_ptr<StreamConnection> server;
+};
+
+ConnectionPair connectionPair() {
+    int fds[2];
+    const int result = ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    assert(result == 0);
+    return {std::make_unique<StreamConnection>(fds[0], nullptr), std::make_unique<StreamConnection>(fds[1], nullptr)};
+}
+
+std::vector<char> randomBytes(size_t size, unsigned seed) {
+    std::mt19937 generator(seed);
+    std::vector<char> bytes(size);
+    for (auto& byte : bytes) {
+        byte = static_cast<char>(generator());
+    }
+    return bytes;
+}
+
+void testIntegers() {
+    std::vector<char> buffer;
+    appendU16(buffer, 0x0102);
+    appendU32(buffer, 0x03040506);
+    appendU64(buffer, 0x0708090a0b0c0d0eULL);
+    assert(buffer.size() == 14);
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        assert(buffer[i] == static_cast<char>(i + 1));
+    }
+    assert(readU16(buffer.data()) == 0x0102);
+    assert(readU32(buffer.data() + 2) == 0x03040506);
+    assert(readU64(buffer.data() + 6) == 0x0708090a0b0c0d0eULL);
+
+    buffer.clear();
+    appendU64(buffer, ~0ULL);
+    assert(readU64(buffer.data()) == ~0ULL);
+}
+
+void testFrameLayout() {
+    auto [client, server] = connectionPair();
+    const std::string payload = "hello";
+    assert(client->sendFrame(FrameType::Begin, payload));
+
+    // 1-byte type, 4-byte big-endian length, payload.
+    std::array<char, 10> raw{};
+    assert(server->readExact(raw));
+    assert(raw[0] == static_cast<char>(FrameType::Begin));
+    assert(readU32(raw.data() + 1) == payload.size());
+    assert(std::string(raw.data() + 5, 5) == payload);
+}
+
+void testFrameRoundTrip() {
+    auto [client, server] = connectionPair();
+    std::vector<char> begin;
+    appendU64(begin, 42);
+    const std::string path = "sys/backup.tar.gz";
+    appendU16(begin, static_cast<uint16_t>(path.size()));
+    begin.insert(begin.end(), path.begin(), path.end());
+    assert(client->sendFrame(FrameType::Begin, begin));
+    assert(client->sendFrame(FrameType::End, {}));
+
+    auto header = server->readFrameHeader();
+    assert(header && header->first == FrameType::Begin && header->second == begin.size());
+    auto payload = server->readPayload(header->second);
+    assert(payload && *payload == begin);
+    assert(readU64(payload->data()) == 42);
+    assert(std::string(payload->data() + 10, readU16(payload->data() + 8)) == path);
+
+    header = server->readFrameHeader();
+    assert(header && header->first == FrameType::End && header->second == 0);
+    payload = server->readPayload(0);
+    assert(payload && payload->empty());
+}
+
+void testReplies() {
+    auto [client, server] = connectionPair();
+    std::vector<char> id;
+    appendU64(id, 7);
+    assert(server->sendFrame(FrameType::Ok, id));
+    const std::string message = "path escapes the root";
+    assert(server->sendFrame(FrameType::Error, message));
+    assert(server->sendFrame(FrameType::Data, {}));
+
+    auto reply = client->expectOk();
+    assert(reply && reply->size() == 8 && readU64(reply->data()) == 7);
+    reply = client->expectOk();
+    assert(!reply && reply.error().find(message) != std::string::npos);
+    reply = client->expectOk();
+    assert(!reply && reply.error().find("Unexpected reply") != std::string::npos);
+}
+
+void testOversizedControlFrame() {
+    auto [client, server] = connectionPair();
+    // Only the header is sent: the length alone must be rejected before any allocation.
+    std::vector<char> header;
+    header.push_back(static_cast<char>(FrameType::Ok));
+    appendU32(header, kMaxControlPayload + 1);
+    assert(server->writeAll(header));
+    auto reply = client->expectOk();
+    assert(!reply && reply.error().find("too large") != std::string::npos);
+}
+
+void testClosedPeer() {
+    auto [client, server] = connectionPair();
+    server.reset();
+    assert(!client->readFrameHeader());
+}
+
+void testFileRange() {
+    const auto contents = randomBytes(200000, 1);
+    char name[] = "/tmp/securevault-receiver-test-XXXXXX";
+    const int fileFd = ::mkstemp(name);
+    assert(fileFd >= 0);
+    ::unlink(name);
+    assert(::write(fileFd, contents.data(), contents.size()) == static_cast<ssize_t>(contents.size()));
+
+    auto [client, server] = connectionPair();
+    // Large enough to fill the socket buffer, so the reader runs concurrently.
+    std::thread sender([&client, fileFd]() { assert(client->sendFileRange(fileFd, 1000, 150000)); });
+    auto header = server->readFrameHeader();
+    assert(header && header->first == FrameType::Data && header->second == 8 + 150000);
+    std::vector<char> data(header->second);
+    assert(server->readExact(data));
+    sender.join();
+    assert(readU64(data.data()) == 1000);
+    assert(std::equal(data.begin() + 8, data.end(), contents.begin() + 1000));
+    ::close(fileFd);
+}
+
+void testUploadDigest() {
+    // Small files: the digest is SHA-256 over the single block's SHA-256.
+    const auto small = randomBytes(100000, 2);
+    Sha256 block;
+    block.update(small);
+    const auto blockDigest = block.digest();
+    Sha256 outer;
+    outer.update(std::span<const char>(reinterpret_cast<const char*>(blockDigest.data()), blockDigest.size()));
+    UploadDigest whole;
+    whole.update(small);
+    assert(whole.finish() == outer.digest());
+
+    // The multi-threaded file digest matches streaming updates of any size, including across a
+    // block boundary.
+    const auto large = randomBytes(kDigestBlockSize + 12345, 3);
+    char name[] = "/tmp/securevault-receiver-test-XXXXXX";
+    const int fileFd = ::mkstemp(name);
+    assert(fileFd >= 0);
+    ::unlink(name);
+    assert(::write(fileFd, large.data(), large.size()) == static_cast<ssize_t>(large.size()));
+    auto fileDigest = digestFile(fileFd, large.size(), 4);
+    assert(fileDigest);
+    ::close(fileFd);
+
+    UploadDigest pieces;
+    size_t offset = 0;
+    for (size_t step = 1; offset < large.size(); step = step * 7 % 1000003 + 1) {
+        const size_t length = std::min(step * 97, large.size() - offset);
+        pieces.update(std::span<const char>(large).subspan(offset, length));
+        offset += length;
+    }
+    assert(pieces.finish() == *fileDigest);
+}
+
+} // namespace
+
+int main() {
+    testIntegers();
+    testFrameLayout();
+    testFrameRoundTrip();
+    testReplies();
+    testOversizedControlFrame();
+    testClosedPeer();
+    testFileRange();
+    testUploadDigest();
+    std::cout << "receiver_protocol_test passed" << std::endl;
+    return 0;
+}
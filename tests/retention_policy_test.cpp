@@ -0,0 +1,145 @@
+/**
+ * @file retention_policy_test.cpp
+ * @brief Tests for grandfather-father-son run selection.
+ */
+
+#undef NDEBUG
+#include "retention_policy.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+
+namespace {
+
+constexpr int64_t kDay = 86400;
+constexpr int64_t kStart = 1767225600; // 2026-01-01 00:00 UTC, a Thursday.
+
+/**
+ * @brief One run per day at noon; every seventh day is a full, the others depend on it.
+ */
+std::vector<CatalogRun> dailyRuns(int days) {
+    std::vector<CatalogRun> runs;
+    for (int i = 0; i < days; ++i) {
+        CatalogRun run;
+        run.sequence = static_cast<uint32_t>(i + 1);
+        run.started = kStart + i * kDay + 12 * 3600;
+        run.full = i % 7 == 0;
+        if (!run.full) {
+            run.dependsOn = {static_cast<uint32_t>(i / 7 * 7 + 1)};
+        }
+        runs.push_back(run);
+    }
+    return runs;
+}
+
+void expectPartition(const std::vector<CatalogRun>& runs, const RetentionPlan& plan) {
+    assert(plan.kept.size() + plan.pruned.size() == runs.size());
+    assert(std::ranges::is_sorted(plan.pruned));
+    for (uint32_t sequence : plan.pruned) {
+        assert(!plan.kept.contains(sequence));
+    }
+}
+
+void testPolicyFromJson() {
+    Json::Value config;
+    config["keep_daily"] = 7;
+    config["keep_monthly"] = 12;
+    const RetentionPolicy policy = RetentionPolicy::fromJson(config);
+    assert(policy.daily == 7 && policy.monthly == 12);
+    assert(policy.hourly == 0 && policy.weekly == 0 && policy.yearly == 0);
+    assert(policy.enabled());
+    assert(!RetentionPolicy::fromJson(Json::Value()).enabled());
+}
+
+void testEmptyAndLatest() {
+    assert(planRetention({}, RetentionPolicy{}).kept.empty());
+
+    // With nothing selected by period, the newest run and its full are still kept.
+    const auto runs = dailyRuns(10);
+    const RetentionPlan plan = planRetention(runs, RetentionPolicy{});
+    expectPartition(runs, plan);
+    assert(plan.kept.size() == 2);
+    assert(plan.kept.at(10) == "latest");
+    assert(plan.kept.at(8) == "dependency");
+}
+
+void testDaily() {
+    const auto runs = dailyRuns(30);
+    RetentionPolicy policy;
+    policy.daily = 3;
+    const RetentionPlan plan = planRetention(runs, policy);
+    expectPartition(runs, plan);
+    assert(plan.kept.at(30) == "latest");
+    assert(plan.kept.at(29) == "daily" && plan.kept.at(28) == "daily");
+    // Run 29 is a full; run 28 depends on the full of the week before.
+    assert(runs[28].full);
+    assert(plan.kept.at(22) == "dependency");
+    assert(plan.kept.size() == 4);
+}
+
+void testNewestRunOfEachPeriod() {
+    // Two runs a day: the later one represents the day.
+    std::vector<CatalogRun> runs;
+    for (int i = 0; i < 20; ++i) {
+        CatalogRun run;
+        run.sequence = static_cast<uint32_t>(i + 1);
+        run.started = kStart + (i / 2) * kDay + (i % 2 == 0 ? 1 : 20) * 3600;
+        run.full = true;
+        runs.push_back(run);
+    }
+    RetentionPolicy policy;
+    policy.daily = 3;
+    const RetentionPlan plan = planRetention(runs, policy);
+    expectPartition(runs, plan);
+    assert(plan.kept.size() == 3);
+    assert(plan.kept.contains(20) && plan.kept.contains(18) && plan.kept.contains(16));
+}
+
+void testWeeklyMonthlyYearly() {
+    const auto runs = dailyRuns(400);
+    RetentionPolicy policy;
+    policy.weekly = 4;
+    policy.monthly = 3;
+    policy.yearly = 2;
+    const RetentionPlan plan = planRetention(runs, policy);
+    expectPartition(runs, plan);
+
+    // Run 400 is on 2027-02-04, a Thursday; ISO weeks end on Sundays (runs 396, 389, 382).
+    for (uint32_t sequence : {396u, 389u, 382u}) {
+        assert(plan.kept.at(sequence) == "weekly");
+    }
+    // 2026-12-31 (run 365) ends both a month and the second year.
+    assert(plan.kept.at(365) == "monthly");
+    assert(plan.kept.at(400) == "latest");
+    // Only three months are kept: 2026-11-30 (run 334) is not.
+    assert(!plan.kept.contains(334));
+
+    // Every kept run's full is kept, and nothing else is.
+    for (const auto& run : runs) {
+        if (!plan.kept.contains(run.sequence) || run.dependsOn.empty()) {
+            continue;
+        }
+        assert(plan.kept.contains(run.dependsOn.front()));
+    }
+    for (const auto& [sequence, reason] : plan.kept) {
+        if (reason == "dependency") {
+            assert(runs[sequence - 1].full);
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    setenv("TZ", "UTC", 1);
+    tzset();
+    testPolicyFromJson();
+    testEmptyAndLatest();
+    testDaily();
+    testNewestRunOfEachPeriod();
+    testWeeklyMonthlyYearly();
+    std::cout << "retention_policy_test passed" << std::endl;
+    return 0;
+}